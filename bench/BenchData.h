@@ -0,0 +1,173 @@
+// bench/BenchData.h
+//
+// Fixed datasets for gis_bench. Everything is generated from constant
+// seeds, so every run and every build measures the same bytes.
+
+#ifndef BENCHDATA_H
+#define BENCHDATA_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <zlib.h>
+#include "../src/Decoding/ImageDecoder.h"
+#include "../src/Encoding/PngWriter.h"
+#include "../src/Networking/Tiles/TileKey.h"
+#include "../src/Rendering/DecodedTileCache.h"
+
+namespace BenchData {
+
+static const int TILE_SIZE = 256;
+static const int PALETTE_SIZE = 16;
+
+inline uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Colors of a rendered street map: land, parks, water, buildings, roads
+inline std::array<uint32_t, PALETTE_SIZE> mapPalette() {
+    return { 0xfff2efe9, 0xffaad3df, 0xffc8facc, 0xffadd19e, 0xffd9d0c9, 0xffe0dfdf, 0xfff7fabf, 0xfffcd6a4,
+             0xffe892a2, 0xffffffff, 0xffbbbbbb, 0xff999999, 0xff666666, 0xff333333, 0xffdddde8, 0xffb5d0d0 };
+}
+
+// Palette indices of a street-map-like tile: a few flat areas, building
+// blocks and roads, with the large uniform runs real tiles have
+inline std::vector<uint8_t> mapTileIndices(uint64_t seed) {
+    std::vector<uint8_t> indices(TILE_SIZE * TILE_SIZE);
+    uint64_t state = seed;
+    double cx[4], cy[4];
+    uint8_t area[4];
+    for (int i = 0; i < 4; ++i) {
+        cx[i] = static_cast<double>(nextRandom(state) % TILE_SIZE);
+        cy[i] = static_cast<double>(nextRandom(state) % TILE_SIZE);
+        area[i] = static_cast<uint8_t>(nextRandom(state) % 4);
+    }
+    for (int y = 0; y < TILE_SIZE; ++y) {
+        for (int x = 0; x < TILE_SIZE; ++x) {
+            int nearest = 0;
+            double best = 1e18;
+            for (int i = 0; i < 4; ++i) {
+                double d = (x - cx[i]) * (x - cx[i]) + (y - cy[i]) * (y - cy[i]);
+                if (d < best) {
+                    best = d;
+                    nearest = i;
+                }
+            }
+            indices[y * TILE_SIZE + x] = area[nearest];
+        }
+    }
+    for (int b = 0; b < 40; ++b) { // Buildings
+        int x0 = static_cast<int>(nextRandom(state) % (TILE_SIZE - 20));
+        int y0 = static_cast<int>(nextRandom(state) % (TILE_SIZE - 20));
+        int w = 4 + static_cast<int>(nextRandom(state) % 16), h = 4 + static_cast<int>(nextRandom(state) % 16);
+        for (int y = y0; y < y0 + h; ++y) {
+            for (int x = x0; x < x0 + w; ++x) {
+                indices[y * TILE_SIZE + x] = (x == x0 || y == y0 || x == x0 + w - 1 || y == y0 + h - 1) ? 11 : 4;
+            }
+        }
+    }
+    for (int r = 0; r < 6; ++r) { // Roads with casings
+        double angle = (nextRandom(state) % 628) / 100.0;
+        double ox = static_cast<double>(nextRandom(state) % TILE_SIZE);
+        double oy = static_cast<double>(nextRandom(state) % TILE_SIZE);
+        uint8_t fill = static_cast<uint8_t>(6 + r % 4);
+        for (double t = -400; t < 400; t += 0.5) {
+            for (int w = -3; w <= 3; ++w) {
+                int x = static_cast<int>(ox + t * std::cos(angle) - w * std::sin(angle));
+                int y = static_cast<int>(oy + t * std::sin(angle) + w * std::cos(angle));
+                if (x >= 0 && y >= 0 && x < TILE_SIZE && y < TILE_SIZE) {
+                    indices[y * TILE_SIZE + x] = (w == -3 || w == 3) ? 12 : fill;
+                }
+            }
+        }
+    }
+    return indices;
+}
+
+inline void appendChunk(ByteBuffer& png, const char* type, const uint8_t* data, size_t length) {
+    uint8_t header[8] = { static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+                          static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length) };
+    std::memcpy(header + 4, type, 4);
+    png.insert(png.end(), header, header + 8);
+    png.insert(png.end(), data, data + length);
+    uLong crc = crc32(crc32(0, header + 4, 4), data, static_cast<uInt>(length));
+    uint8_t trailer[4] = { static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+                           static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc) };
+    png.insert(png.end(), trailer, trailer + 4);
+}
+
+// 8-bit palette PNG, the format most raster tile servers send
+inline ByteBuffer palettePng(const std::vector<uint8_t>& indices) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    ByteBuffer png(signature, signature + 8);
+    uint8_t ihdr[13] = { 0, 0, 1, 0, 0, 0, 1, 0, 8, 3, 0, 0, 0 }; // 256x256, 8-bit, palette
+    appendChunk(png, "IHDR", ihdr, sizeof(ihdr));
+
+    uint8_t plte[PALETTE_SIZE * 3];
+    std::array<uint32_t, PALETTE_SIZE> palette = mapPalette();
+    for (int i = 0; i < PALETTE_SIZE; ++i) {
+        plte[i * 3] = static_cast<uint8_t>(palette[i] >> 16);
+        plte[i * 3 + 1] = static_cast<uint8_t>(palette[i] >> 8);
+        plte[i * 3 + 2] = static_cast<uint8_t>(palette[i]);
+    }
+    appendChunk(png, "PLTE", plte, sizeof(plte));
+
+    ByteBuffer raw;
+    for (int y = 0; y < TILE_SIZE; ++y) {
+        raw.push_back(0); // Filter: none
+        raw.insert(raw.end(), indices.begin() + y * TILE_SIZE, indices.begin() + (y + 1) * TILE_SIZE);
+    }
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    ByteBuffer compressed(compressedSize);
+    compress2(compressed.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()), 6);
+    appendChunk(png, "IDAT", compressed.data(), compressedSize);
+    appendChunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+// The same tile as 24-bit RGB, as aerial and hillshade sources send
+inline ByteBuffer rgbPng(const std::vector<uint8_t>& indices) {
+    std::array<uint32_t, PALETTE_SIZE> palette = mapPalette();
+    std::vector<uint32_t> argb(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        argb[i] = palette[indices[i]];
+    }
+    ByteBuffer png;
+    PngWriter::encode(argb.data(), TILE_SIZE, TILE_SIZE, TILE_SIZE, false, png);
+    return png;
+}
+
+// The tile as the viewer keeps it after decoding
+inline std::shared_ptr<DecodedTile> decodedMapTile(uint64_t seed) {
+    ByteBuffer png = palettePng(mapTileIndices(seed));
+    std::unique_ptr<ImageDecoder> decoder = ImageDecoder::create(ImageDecoder::Kind::Native);
+    DecodedImage image;
+    ByteBuffer pixels;
+    if (!decoder->decode(png.data(), png.size(), image, pixels)) {
+        return nullptr;
+    }
+    return DecodedTile::fromImage(image, pixels);
+}
+
+// A side x side block of neighbouring tiles at level z, like a cache
+// filled by panning around one area
+inline std::vector<TileKey> tileBlock(int z, int side, int offset = 0) {
+    std::vector<TileKey> keys;
+    int origin = (1 << z) / 2 - side / 2 + offset;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            keys.push_back({ z, origin + x, origin + y });
+        }
+    }
+    return keys;
+}
+
+} // namespace BenchData
+
+#endif // BENCHDATA_H
@@ -0,0 +1,230 @@
+// bench/BenchHarness.h
+//
+// Small microbenchmark harness for gis_bench. Each benchmark is sampled
+// repeatedly: the iteration count is first calibrated so one sample takes
+// at least --min-sample-ms, then --samples timed samples follow (after one
+// discarded warm-up sample). Results are the median time per operation
+// with a distribution-free 95% confidence interval for it, the median
+// absolute deviation and the minimum, plus every sample in the JSON
+// output so compare_bench.py can test differences for significance.
+
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace Bench {
+
+// Keeps the compiler from discarding a computed value
+template <class T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs the measured operation the given number of times
+using Body = std::function<void(uint64_t iterations)>;
+
+// Builds a benchmark's fixed dataset (untimed) and returns its body. Only
+// called for benchmarks the filter selects.
+using Factory = std::function<Body()>;
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0; // Per sample
+    std::vector<double> samples; // Nanoseconds per operation
+    double median = 0.0;
+    double ciLow = 0.0; // 95% confidence interval of the median
+    double ciHigh = 0.0;
+    double mad = 0.0;
+    double min = 0.0;
+};
+
+class Suite {
+public:
+    void add(const std::string& name, Factory factory) { entries.push_back({ name, std::move(factory) }); }
+
+    // Parses the options, runs the selected benchmarks and prints a table.
+    // Returns the process exit code.
+    int run(int argc, char* argv[]) {
+        std::string filter = ".*";
+        std::string jsonPath;
+        bool list = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--list") {
+                list = true;
+            } else if (i + 1 < argc && arg == "--filter") {
+                filter = argv[++i];
+            } else if (i + 1 < argc && arg == "--samples") {
+                samples = std::max(5, std::atoi(argv[++i]));
+            } else if (i + 1 < argc && arg == "--min-sample-ms") {
+                minSampleMs = std::max(1.0, std::atof(argv[++i]));
+            } else if (i + 1 < argc && arg == "--json") {
+                jsonPath = argv[++i];
+            } else {
+                std::fprintf(stderr,
+                             "Usage: %s [--filter regex] [--samples N] [--min-sample-ms ms] [--json file] [--list]\n",
+                             argv[0]);
+                return 1;
+            }
+        }
+
+        std::regex selected;
+        try {
+            selected = std::regex(filter);
+        } catch (const std::regex_error&) {
+            std::fprintf(stderr, "Bad --filter regex: %s\n", filter.c_str());
+            return 1;
+        }
+        std::vector<Result> results;
+        if (!list) {
+            std::printf("%-34s %11s  %-23s %6s %10s\n", "benchmark", "median", "95% CI", "MAD", "iters");
+        }
+        for (const Entry& entry : entries) {
+            if (!std::regex_search(entry.name, selected)) {
+                continue;
+            }
+            if (list) {
+                std::printf("%s\n", entry.name.c_str());
+                continue;
+            }
+            Result result = measure(entry);
+            std::string interval = format(result.ciLow) + " .. " + format(result.ciHigh);
+            std::printf("%-34s %11s  %-23s %5.1f%% %10llu\n", result.name.c_str(), format(result.median).c_str(),
+                        interval.c_str(),
+                        result.median > 0 ? 100.0 * result.mad / result.median : 0.0,
+                        static_cast<unsigned long long>(result.iterations));
+            std::fflush(stdout);
+            results.push_back(std::move(result));
+        }
+        if (!jsonPath.empty() && !writeJson(jsonPath, results)) {
+            std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string name;
+        Factory factory;
+    };
+
+    std::vector<Entry> entries;
+    int samples = 20;
+    double minSampleMs = 20.0;
+
+    static double timeNs(const Body& body, uint64_t iterations) {
+        auto start = Clock::now();
+        body(iterations);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    Result measure(const Entry& entry) const {
+        Result result;
+        result.name = entry.name;
+        Body body = entry.factory();
+
+        // Grow the iteration count until a sample is long enough to time
+        uint64_t iterations = 1;
+        const double targetNs = minSampleMs * 1e6;
+        for (;;) {
+            double ns = timeNs(body, iterations);
+            if (ns >= targetNs || iterations >= (uint64_t(1) << 40)) {
+                break;
+            }
+            double scale = ns > 0 ? 1.2 * targetNs / ns : 10.0;
+            iterations = std::max(iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 10.0)));
+        }
+        result.iterations = iterations;
+
+        timeNs(body, iterations); // Warm-up
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timeNs(body, iterations) / iterations);
+        }
+
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        result.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+        result.min = sorted.front();
+
+        // Order statistics bracketing the median with 95% confidence
+        // (normal approximation to the binomial)
+        double half = 1.96 * std::sqrt(static_cast<double>(n)) / 2.0;
+        size_t low = static_cast<size_t>(std::max(0.0, std::floor(n / 2.0 - half)));
+        size_t high = static_cast<size_t>(std::min(n - 1.0, std::ceil(n / 2.0 + half)));
+        result.ciLow = sorted[low];
+        result.ciHigh = sorted[high];
+
+        std::vector<double> deviations;
+        for (double s : sorted) {
+            deviations.push_back(std::fabs(s - result.median));
+        }
+        std::sort(deviations.begin(), deviations.end());
+        result.mad = deviations[n / 2];
+        return result;
+    }
+
+    static std::string format(double ns) {
+        char text[32];
+        if (ns < 1e3) {
+            std::snprintf(text, sizeof(text), "%.2f ns", ns);
+        } else if (ns < 1e6) {
+            std::snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+        } else {
+            std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+        }
+        return text;
+    }
+
+    bool writeJson(const std::string& path, const std::vector<Result>& results) const {
+        char host[256] = "";
+        gethostname(host, sizeof(host) - 1);
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        std::ofstream out(path);
+        out.precision(6);
+        out << "{\n  \"context\": {\"date\": \"" << date << "\", \"host\": \"" << host
+            << "\", \"cpus\": " << std::thread::hardware_concurrency() << ", \"compiler\": \"" << __VERSION__
+#ifdef NDEBUG
+            << "\", \"assertions\": false"
+#else
+            << "\", \"assertions\": true"
+#endif
+            << ", \"samples\": " << samples << ", \"minSampleMs\": " << minSampleMs << "},\n";
+        out << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"median_ns\": " << r.median << ", \"ci_low_ns\": " << r.ciLow << ", \"ci_high_ns\": "
+                << r.ciHigh << ", \"mad_ns\": " << r.mad << ", \"min_ns\": " << r.min << ", \"samples_ns\": [";
+            for (size_t s = 0; s < r.samples.size(); ++s) {
+                out << (s ? ", " : "") << r.samples[s];
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+};
+
+} // namespace Bench
+
+#endif // BENCHHARNESS_H
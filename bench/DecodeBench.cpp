@@ -0,0 +1,127 @@
+// bench/DecodeBench.cpp
+// Decodes a corpus of cached tiles with every ImageDecoder backend and
+// reports tiles per second on one core. Outputs are checked against the
+// SDL_image backend so a faster backend never changes what is drawn.
+//
+// Usage: gis_decode_bench [tileDir=resources/tiles] [maxTiles=2000] [rounds=3]
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/Decoding/ImageDecoder.h"
+#include "../src/Decoding/PngUnfilter.h"
+#include "../src/Decoding/SdlImageDecoder.h"
+
+namespace fs = std::filesystem;
+
+static std::vector<ByteBuffer> loadCorpus(const fs::path& dir, size_t maxTiles) {
+    std::vector<ByteBuffer> corpus;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; it != end && corpus.size() < maxTiles; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        std::string ext = it->path().extension().string();
+        if (!it->is_regular_file() || (ext != ".png" && ext != ".jpg" && ext != ".webp")) {
+            continue;
+        }
+        std::ifstream in(it->path(), std::ios::binary);
+        ByteBuffer data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!data.empty()) {
+            corpus.push_back(std::move(data));
+        }
+    }
+    return corpus;
+}
+
+// Expands any decoded layout to ARGB so backends can be compared
+static std::vector<uint32_t> toArgb(const DecodedImage& image, const ByteBuffer& pixels) {
+    size_t count = static_cast<size_t>(image.width) * image.height;
+    std::vector<uint32_t> out(count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = image.paletteSize > 0 ? image.palette[pixels[i]]
+                                       : reinterpret_cast<const uint32_t*>(pixels.data())[i];
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    fs::path dir = argc > 1 ? argv[1] : "resources/tiles";
+    size_t maxTiles = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    int imgFlags = IMG_INIT_PNG | IMG_INIT_JPG | IMG_INIT_WEBP;
+    if (!(IMG_Init(imgFlags) & IMG_INIT_PNG)) {
+        std::fprintf(stderr, "IMG_Init failed: %s\n", IMG_GetError());
+        return 1;
+    }
+    SdlImageDecoder::install();
+
+    std::vector<ByteBuffer> corpus = loadCorpus(dir, maxTiles);
+    if (corpus.empty()) {
+        std::fprintf(stderr, "No cached tiles found under %s\n", dir.string().c_str());
+        return 1;
+    }
+    std::printf("%zu tiles from %s, unfilter kernels: %s\n", corpus.size(), dir.string().c_str(),
+                PngUnfilter::simdLevel());
+
+    // SdlImage first: it is the reference the others are checked against
+    const ImageDecoder::Kind kinds[] = { ImageDecoder::Kind::SdlImage, ImageDecoder::Kind::Native,
+                                         ImageDecoder::Kind::Auto };
+    const char* kindNames[] = { "sdl", "native", "auto" };
+    std::vector<std::vector<uint32_t>> reference;
+    const char* bestName = nullptr;
+    double bestRate = 0.0;
+    double sdlRate = 0.0;
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+        ImageDecoder::Kind kind = kinds[k];
+        std::unique_ptr<ImageDecoder> decoder = ImageDecoder::create(kind);
+        DecodedImage image;
+        ByteBuffer pixels;
+
+        // Correctness pass, also warms caches
+        size_t mismatches = 0;
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            bool ok = decoder->decode(corpus[i].data(), corpus[i].size(), image, pixels);
+            std::vector<uint32_t> argb = ok ? toArgb(image, pixels) : std::vector<uint32_t>();
+            if (kind == ImageDecoder::Kind::SdlImage) {
+                reference.push_back(std::move(argb));
+            } else if (argb != reference[i]) {
+                mismatches++;
+            }
+        }
+
+        double best = 0.0;
+        for (int r = 0; r < rounds; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (const ByteBuffer& tile : corpus) {
+                decoder->decode(tile.data(), tile.size(), image, pixels);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::max(best, corpus.size() / seconds);
+        }
+
+        std::printf("%-10s %10.0f tiles/s/core  mismatches=%zu\n", kindNames[k], best, mismatches);
+        if (kind == ImageDecoder::Kind::SdlImage) {
+            sdlRate = best;
+        }
+        if (mismatches == 0 && best > bestRate) {
+            bestRate = best;
+            bestName = kindNames[k];
+        }
+    }
+
+    std::printf("speedup over sdl_image: %.2fx\n", sdlRate > 0 ? bestRate / sdlRate : 0.0);
+    std::printf("recommended \"imageDecoder\": \"%s\"\n", bestName ? bestName : "sdl");
+
+    IMG_Quit();
+    return 0;
+}
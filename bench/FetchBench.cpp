@@ -0,0 +1,215 @@
+// bench/FetchBench.cpp
+//
+// Load test of the TileFetcher download path against a LoopbackTileServer
+// running in the same process, so it needs no network and never touches a
+// real tile server. Reports throughput, end-to-end and upstream latency
+// quantiles, and how the fetcher retried around the injected failures.
+//
+// Usage: gis_fetch_bench [--tiles 2000] [--threads 8] [--inflight 64]
+//                        [--mirrors 2] [--json out.json] [fault options]
+//
+// The cache is written to /tmp/gis_fetch_bench-<uid>, emptied before and
+// after, so every run starts cold (and reuses one shared index segment).
+// With the same options and seed the server makes the same decisions, so
+// two builds can be compared run for run. Each worker still observes the
+// fetcher's politeness delay after a download, which caps throughput at
+// about ten tiles per second per thread.
+
+#include "LoopbackTileServer.h"
+#include "../src/Networking/Tiles/TileFetcher.h"
+#include "../src/Utils/Log.h"
+#include "../src/Utils/Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const int BENCH_ZOOM = 14;
+
+static void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "Usage: %s [--tiles N] [--threads N] [--inflight N] [--mirrors N] [--json file] [fault options]\n"
+                 "Fault options:\n%s",
+                 argv0, FaultProfile::optionsHelp());
+}
+
+static double quantile(std::vector<double> values, double q) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(q * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char* argv[]) {
+    size_t tiles = 2000;
+    size_t threads = 8;
+    size_t inflight = 64;
+    int mirrors = 2;
+    std::string jsonPath;
+    FaultProfile profile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--tiles") {
+                tiles = std::stoul(value);
+            } else if (arg == "--threads") {
+                threads = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--inflight") {
+                inflight = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--mirrors") {
+                mirrors = std::max(1, std::stoi(value));
+            } else if (arg == "--json") {
+                jsonPath = value;
+            } else if (!profile.parseOption(arg, value)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::fprintf(stderr, "Bad value for %s: %s\n", arg.c_str(), value.c_str());
+            return 1;
+        }
+    }
+
+    LoopbackTileServer server(profile);
+    std::string error;
+    if (!server.start(0, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    TileSource source{ "loopback", {}, { TileFormat::Png } };
+    for (int m = 0; m < mirrors; ++m) {
+        source.mirrors.push_back(server.urlTemplate(m));
+    }
+
+    // The fetcher caches below the working directory (TileSource::cacheDir)
+    std::string originalDir = std::filesystem::current_path().string();
+    std::filesystem::path workDir = "/tmp/gis_fetch_bench-" + std::to_string(getuid());
+    std::error_code ec;
+    std::filesystem::remove_all(workDir, ec);
+    if (!std::filesystem::create_directories(workDir, ec) || chdir(workDir.c_str()) != 0) {
+        std::fprintf(stderr, "Cannot use %s as working directory\n", workDir.c_str());
+        return 1;
+    }
+
+    // Distinct tiles in a block around the middle of the zoom level
+    std::vector<TileKey> keys;
+    int side = 1;
+    while (static_cast<size_t>(side) * side < tiles) {
+        side++;
+    }
+    int origin = (1 << BENCH_ZOOM) / 2 - side / 2;
+    for (size_t i = 0; i < tiles; ++i) {
+        keys.push_back({ BENCH_ZOOM, origin + static_cast<int>(i % side), origin + static_cast<int>(i / side) });
+    }
+
+    std::printf("%zu tiles, %zu threads, %zu in flight, %d mirror(s) on 127.0.0.1:%d\n", tiles, threads, inflight,
+                mirrors, server.port());
+
+    Metrics::Histogram& upstreamLatency = Metrics::histogram("gis_upstream_latency_seconds", "");
+    Metrics::Counter& upstreamErrors = Metrics::counter("gis_upstream_errors_total", "");
+    std::vector<double> latenciesMs;
+    size_t failed = 0;
+    double seconds = 0.0;
+    {
+        TileFetcher fetcher(threads, tiles, source);
+
+        struct Pending {
+            std::future<bool> result;
+            Clock::time_point started;
+        };
+        std::deque<Pending> window;
+        size_t next = 0;
+        auto start = Clock::now();
+        while (next < keys.size() || !window.empty()) {
+            while (next < keys.size() && window.size() < inflight) {
+                const TileKey& key = keys[next++];
+                window.push_back({ fetcher.fetchTile(key.z, key.x, key.y), Clock::now() });
+            }
+            // Futures complete out of order; collect whichever are ready
+            bool progressed = false;
+            for (auto it = window.begin(); it != window.end();) {
+                if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    ++it;
+                    continue;
+                }
+                failed += it->result.get() ? 0 : 1;
+                latenciesMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - it->started).count());
+                it = window.erase(it);
+                progressed = true;
+            }
+            if (!progressed) {
+                window.front().result.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } // Flushes the cache writer before the directory goes away
+
+    server.stop();
+    Log::flush();
+    if (chdir(originalDir.c_str()) != 0) {
+        std::perror("chdir");
+    }
+    std::filesystem::remove_all(workDir, ec);
+
+    const LoopbackTileServer::Stats& stats = server.stats();
+    double megabytes = stats.bytesSent.load() / (1024.0 * 1024.0);
+    double p50 = quantile(latenciesMs, 0.50), p90 = quantile(latenciesMs, 0.90), p99 = quantile(latenciesMs, 0.99);
+    double maxMs = latenciesMs.empty() ? 0.0 : *std::max_element(latenciesMs.begin(), latenciesMs.end());
+
+    std::printf("%.2f s  %.0f tiles/s  %.2f MB/s  %zu failed\n", seconds, (tiles - failed) / seconds,
+                megabytes / seconds, failed);
+    std::printf("end to end ms    p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f\n", p50, p90, p99, maxMs);
+    std::printf("upstream ms      p50 %8.1f  p90 %8.1f  p99 %8.1f  (%llu transfers ok, %llu failed)\n",
+                upstreamLatency.quantileMicros(0.50) / 1000.0, upstreamLatency.quantileMicros(0.90) / 1000.0,
+                upstreamLatency.quantileMicros(0.99) / 1000.0,
+                static_cast<unsigned long long>(upstreamLatency.count()),
+                static_cast<unsigned long long>(upstreamErrors.value()));
+    std::printf("server           %llu requests on %llu connections: %llu served, %llu 429, %llu 5xx, "
+                "%llu timed out, %llu reset\n",
+                static_cast<unsigned long long>(stats.requests.load()),
+                static_cast<unsigned long long>(stats.connections.load()),
+                static_cast<unsigned long long>(stats.served.load()),
+                static_cast<unsigned long long>(stats.tooManyRequests.load()),
+                static_cast<unsigned long long>(stats.serverErrors.load()),
+                static_cast<unsigned long long>(stats.timeouts.load()),
+                static_cast<unsigned long long>(stats.resets.load()));
+    std::printf("retries          %llu requests repeated a tile (failover and hedging)\n",
+                static_cast<unsigned long long>(stats.repeated.load()));
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        out << "{\n"
+            << "  \"tiles\": " << tiles << ",\n"
+            << "  \"failed\": " << failed << ",\n"
+            << "  \"seconds\": " << seconds << ",\n"
+            << "  \"tilesPerSecond\": " << (tiles - failed) / seconds << ",\n"
+            << "  \"megabytesPerSecond\": " << megabytes / seconds << ",\n"
+            << "  \"endToEndMs\": { \"p50\": " << p50 << ", \"p90\": " << p90 << ", \"p99\": " << p99
+            << ", \"max\": " << maxMs << " },\n"
+            << "  \"upstreamMs\": { \"p50\": " << upstreamLatency.quantileMicros(0.50) / 1000.0
+            << ", \"p90\": " << upstreamLatency.quantileMicros(0.90) / 1000.0
+            << ", \"p99\": " << upstreamLatency.quantileMicros(0.99) / 1000.0 << " },\n"
+            << "  \"server\": { \"requests\": " << stats.requests << ", \"connections\": " << stats.connections
+            << ", \"served\": " << stats.served << ", \"tooManyRequests\": " << stats.tooManyRequests
+            << ", \"serverErrors\": " << stats.serverErrors << ", \"timeouts\": " << stats.timeouts
+            << ", \"resets\": " << stats.resets << ", \"repeated\": " << stats.repeated << " }\n"
+            << "}\n";
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+    return failed == 0 ? 0 : 2;
+}
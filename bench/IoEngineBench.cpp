@@ -0,0 +1,161 @@
+// bench/IoEngineBench.cpp
+//
+// Compares cache write/read throughput of the per-tile blocking path the
+// fetcher used before (ofstream + rename / ifstream on pool threads) with
+// the batched IoEngine implementations.
+//
+// Usage: gis_io_bench <dir> [tiles=4000] [tileBytes=24000] [batch=64]
+//
+// Run it once with <dir> on an NVMe drive and once on a spinning disk.
+// Between the write and read phases the files are synced and evicted from
+// the page cache (posix_fadvise DONTNEED), so reads measure the device.
+
+#include "../src/Storage/IoEngine.h"
+#include "../src/Utils/ThreadPool.h"
+#include "../src/Utils/Utils.h"
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t LEGACY_THREADS = 8;
+
+static void evictFromPageCache(const std::vector<std::filesystem::path>& paths) {
+    sync();
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+static void report(const char* engine, const char* phase, size_t tiles, size_t bytes, double seconds) {
+    std::printf("%-12s %-6s %8zu tiles %10.0f tiles/s %8.1f MB/s\n",
+                engine, phase, tiles, tiles / seconds, bytes / seconds / (1024.0 * 1024.0));
+}
+
+static void benchLegacy(const std::vector<IoEngine::WriteOp>& ops, size_t totalBytes) {
+    ThreadPool pool(LEGACY_THREADS);
+    std::vector<std::future<bool>> futures;
+
+    auto start = Clock::now();
+    for (const auto& op : ops) {
+        futures.push_back(pool.enqueue([&op]() {
+            std::filesystem::path tmpPath = op.path.string() + ".tmp";
+            std::ofstream out(tmpPath, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(op.data->data()), op.data->size());
+            out.close();
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, op.path, ec);
+            return !ec;
+        }));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    report("legacy", "write", ops.size(), totalBytes, std::chrono::duration<double>(Clock::now() - start).count());
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& op : ops) {
+        paths.push_back(op.path);
+    }
+    evictFromPageCache(paths);
+
+    futures.clear();
+    start = Clock::now();
+    for (const auto& path : paths) {
+        futures.push_back(pool.enqueue([&path]() {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            return !data.empty();
+        }));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    report("legacy", "read", paths.size(), totalBytes, std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+static void benchEngine(IoEngine& engine, const std::vector<IoEngine::WriteOp>& ops,
+                        size_t batchSize, size_t totalBytes) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops.size(); i += batchSize) {
+        std::vector<IoEngine::WriteOp> batch(ops.begin() + i, ops.begin() + std::min(ops.size(), i + batchSize));
+        engine.writeBatch(batch);
+    }
+    report(engine.name(), "write", ops.size(), totalBytes, std::chrono::duration<double>(Clock::now() - start).count());
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& op : ops) {
+        paths.push_back(op.path);
+    }
+    evictFromPageCache(paths);
+
+    size_t failures = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < paths.size(); i += batchSize) {
+        std::vector<std::filesystem::path> batch(paths.begin() + i, paths.begin() + std::min(paths.size(), i + batchSize));
+        for (const auto& result : engine.readBatch(batch)) {
+            failures += result.ok ? 0 : 1;
+        }
+    }
+    report(engine.name(), "read", paths.size(), totalBytes, std::chrono::duration<double>(Clock::now() - start).count());
+    if (failures > 0) {
+        std::printf("  %zu reads failed\n", failures);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <dir> [tiles=4000] [tileBytes=24000] [batch=64]\n", argv[0]);
+        return 1;
+    }
+    std::filesystem::path root = argv[1];
+    size_t tiles = argc > 2 ? std::stoul(argv[2]) : 4000;
+    size_t tileBytes = argc > 3 ? std::stoul(argv[3]) : 24000;
+    size_t batchSize = argc > 4 ? std::stoul(argv[4]) : 64;
+
+    // Deterministic payload shared by every tile
+    auto payload = std::make_shared<ByteBuffer>(tileBytes);
+    for (size_t i = 0; i < tileBytes; ++i) {
+        (*payload)[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+    }
+
+    auto makeOps = [&](const std::string& engineName) {
+        std::filesystem::path dir = root / ("iobench-" + engineName);
+        std::filesystem::remove_all(dir);
+        std::vector<IoEngine::WriteOp> ops;
+        for (size_t i = 0; i < tiles; ++i) {
+            // Same z/x/y.png fan-out as the tile cache
+            std::filesystem::path tileDir = dir / "12" / std::to_string(i / 64);
+            std::filesystem::create_directories(tileDir);
+            ops.push_back({ tileDir / (std::to_string(i % 64) + ".png"), payload });
+        }
+        return ops;
+    };
+
+    size_t totalBytes = tiles * tileBytes;
+    std::printf("%zu tiles of %zu bytes, batch %zu, in %s\n", tiles, tileBytes, batchSize, root.c_str());
+
+    benchLegacy(makeOps("legacy"), totalBytes);
+
+    std::unique_ptr<IoEngine> threadPoolEngine = IoEngine::create(IoEngine::Kind::ThreadPool);
+    benchEngine(*threadPoolEngine, makeOps("threadpool"), batchSize, totalBytes);
+
+    std::unique_ptr<IoEngine> uringEngine = IoEngine::create(IoEngine::Kind::IoUring);
+    if (std::string(uringEngine->name()) == "io_uring") {
+        benchEngine(*uringEngine, makeOps("io_uring"), batchSize, totalBytes);
+    } else {
+        std::printf("io_uring unavailable on this kernel; skipped\n");
+    }
+
+    for (const char* name : { "legacy", "threadpool", "io_uring" }) {
+        std::filesystem::remove_all(root / (std::string("iobench-") + name));
+    }
+    return 0;
+}
@@ -0,0 +1,420 @@
+// bench/LoopbackTileServer.cpp
+#include "LoopbackTileServer.h"
+#include "../src/Encoding/PngWriter.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static const int TILE_SIZE = 256;
+
+// splitmix64: a small, well mixed generator for the fault decisions
+static uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(uint64_t& state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+}
+
+bool FaultProfile::parseOption(const std::string& arg, const std::string& value) {
+    if (arg == "--latency") {
+        size_t colon = value.find(':');
+        latencyMedianMs = std::stod(value.substr(0, colon));
+        latencySigma = colon == std::string::npos ? 0.0 : std::stod(value.substr(colon + 1));
+    } else if (arg == "--bandwidth") {
+        bytesPerSecond = static_cast<uint64_t>(std::stod(value) * 1024.0);
+    } else if (arg == "--429") {
+        rate429 = std::stod(value);
+    } else if (arg == "--5xx") {
+        rate5xx = std::stod(value);
+    } else if (arg == "--timeouts") {
+        timeoutRate = std::stod(value);
+    } else if (arg == "--resets") {
+        resetRate = std::stod(value);
+    } else if (arg == "--tile-kb") {
+        tileBytes = static_cast<size_t>(std::stod(value) * 1024.0);
+    } else if (arg == "--seed") {
+        seed = std::stoull(value);
+    } else {
+        return false;
+    }
+    if (latencyMedianMs < 0.0 || latencySigma < 0.0 ||
+        rate429 + rate5xx + timeoutRate + resetRate > 1.0 + 1e-9) {
+        throw std::invalid_argument("bad value for " + arg);
+    }
+    return true;
+}
+
+const char* FaultProfile::optionsHelp() {
+    return "  --latency ms[:sigma]  response delay, log-normal around the median (default 0)\n"
+           "  --bandwidth KB/s      per connection cap (default unlimited)\n"
+           "  --429 rate            fraction answered 429 Too Many Requests\n"
+           "  --5xx rate            fraction answered 503 Service Unavailable\n"
+           "  --timeouts rate       fraction never answered\n"
+           "  --resets rate         fraction reset halfway through the tile\n"
+           "  --tile-kb N           pad generated tiles to N KB (default: ~2 KB, unpadded)\n"
+           "  --seed N              seed of the fault decisions (default 1)\n";
+}
+
+LoopbackTileServer::LoopbackTileServer(const FaultProfile& profile) : profile(profile) {}
+
+LoopbackTileServer::~LoopbackTileServer() {
+    stop();
+}
+
+bool LoopbackTileServer::start(int port, std::string& error) {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 256) != 0) {
+        error = "Cannot listen on 127.0.0.1:" + std::to_string(port) + ": " + std::strerror(errno);
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    socklen_t length = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+    boundPort = ntohs(addr.sin_port);
+
+    acceptor = std::thread(&LoopbackTileServer::acceptLoop, this);
+    return true;
+}
+
+void LoopbackTileServer::stop() {
+    if (!acceptor.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopped.notify_all();
+    shutdown(listenFd, SHUT_RDWR);
+    acceptor.join();
+    close(listenFd);
+    listenFd = -1;
+
+    // Wake connections blocked in recv or send, then wait for them
+    std::list<Connection> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Connection& connection : connections) {
+            if (!connection.done) {
+                shutdown(connection.fd, SHUT_RDWR);
+            }
+        }
+        remaining.splice(remaining.end(), connections);
+    }
+    for (Connection& connection : remaining) {
+        connection.thread.join();
+    }
+}
+
+std::string LoopbackTileServer::urlTemplate(int mirror) const {
+    return "http://127.0.0.1:" + std::to_string(boundPort) + "/m" + std::to_string(mirror) + "/{z}/{x}/{y}.png";
+}
+
+void LoopbackTileServer::acceptLoop() {
+    while (!stopping) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break; // Listening socket shut down
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        counters.connections++;
+
+        reapConnections();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            close(fd);
+            break;
+        }
+        connections.emplace_back();
+        Connection& connection = connections.back();
+        connection.fd = fd;
+        connection.thread = std::thread(&LoopbackTileServer::serveConnection, this, std::ref(connection));
+    }
+}
+
+void LoopbackTileServer::reapConnections() {
+    std::list<Connection> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = connections.begin(); it != connections.end();) {
+            auto current = it++;
+            if (current->done) {
+                finished.splice(finished.end(), connections, current);
+            }
+        }
+    }
+    for (Connection& connection : finished) {
+        connection.thread.join();
+    }
+}
+
+LoopbackTileServer::Outcome LoopbackTileServer::decide(const TileKey& key, double& latencyMs) {
+    uint32_t attempt;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        attempt = timesRequested[key]++;
+    }
+    if (attempt > 0) {
+        counters.repeated++;
+    }
+
+    uint64_t state = profile.seed;
+    state ^= nextRandom(state) ^ (static_cast<uint64_t>(key.z) << 56) ^ (static_cast<uint64_t>(key.x) << 28) ^
+             static_cast<uint64_t>(key.y);
+    state ^= nextRandom(state) + attempt;
+
+    // Box-Muller for the log-normal latency
+    double u1 = std::max(uniform(state), 1e-12), u2 = uniform(state);
+    double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+    latencyMs = profile.latencyMedianMs * std::exp(profile.latencySigma * normal);
+
+    double u = uniform(state);
+    if ((u -= profile.rate429) < 0.0) {
+        return Outcome::TooMany;
+    }
+    if ((u -= profile.rate5xx) < 0.0) {
+        return Outcome::ServerError;
+    }
+    if ((u -= profile.timeoutRate) < 0.0) {
+        return Outcome::Timeout;
+    }
+    if ((u -= profile.resetRate) < 0.0) {
+        return Outcome::Reset;
+    }
+    return Outcome::Serve;
+}
+
+// A flat color per tile with a grid, so neighbours are told apart at a
+// glance. Padding goes into a private ancillary chunk, which decoders skip.
+std::shared_ptr<const ByteBuffer> LoopbackTileServer::tile(const TileKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tiles.find(key);
+        if (it != tiles.end()) {
+            return it->second;
+        }
+    }
+
+    uint64_t state = (static_cast<uint64_t>(key.z) << 48) ^ (static_cast<uint64_t>(key.x) << 24) ^
+                     static_cast<uint64_t>(key.y);
+    uint32_t background = 0xff000000u | static_cast<uint32_t>(nextRandom(state) & 0x7f7f7f) | 0x606060u;
+    std::vector<uint32_t> pixels(TILE_SIZE * TILE_SIZE);
+    for (int y = 0; y < TILE_SIZE; ++y) {
+        for (int x = 0; x < TILE_SIZE; ++x) {
+            bool line = x % 32 == 0 || y % 32 == 0 || x == y;
+            pixels[y * TILE_SIZE + x] = line ? 0xff404040u : background;
+        }
+    }
+    auto png = std::make_shared<ByteBuffer>();
+    PngWriter::encode(pixels.data(), TILE_SIZE, TILE_SIZE, TILE_SIZE, false, *png);
+
+    if (png->size() + 12 < profile.tileBytes) {
+        size_t length = profile.tileBytes - png->size() - 12;
+        ByteBuffer chunk(12 + length);
+        uint32_t be = htonl(static_cast<uint32_t>(length));
+        std::memcpy(chunk.data(), &be, 4);
+        std::memcpy(chunk.data() + 4, "gpAd", 4);
+        for (size_t i = 0; i < length; ++i) {
+            chunk[8 + i] = static_cast<uint8_t>(nextRandom(state)); // Incompressible, like real imagery
+        }
+        uint32_t crc = htonl(static_cast<uint32_t>(crc32(0, chunk.data() + 4, static_cast<uInt>(4 + length))));
+        std::memcpy(chunk.data() + 8 + length, &crc, 4);
+        png->insert(png->end() - 12, chunk.begin(), chunk.end()); // Before IEND
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return tiles.emplace(key, std::move(png)).first->second;
+}
+
+bool LoopbackTileServer::waitUnlessStopping(double ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !stopped.wait_for(lock, std::chrono::duration<double, std::milli>(ms), [this] { return stopping.load(); });
+}
+
+bool LoopbackTileServer::sendAll(int fd, const uint8_t* data, size_t size, bool paced) {
+    using Clock = std::chrono::steady_clock;
+    size_t chunk = size;
+    if (paced && profile.bytesPerSecond > 0) {
+        chunk = std::max<size_t>(1024, profile.bytesPerSecond / 50); // About 20 ms of data per send
+    }
+    auto start = Clock::now();
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(fd, data + sent, std::min(chunk, size - sent), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+        counters.bytesSent += static_cast<uint64_t>(n);
+        if (paced && profile.bytesPerSecond > 0 && sent < size) {
+            double dueMs = 1000.0 * sent / profile.bytesPerSecond;
+            double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (dueMs > elapsedMs && !waitUnlessStopping(dueMs - elapsedMs)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Parses ".../{z}/{x}/{y}.ext"
+static bool parseTilePath(const std::string& path, TileKey& key) {
+    std::string clean = path.substr(0, path.find('?'));
+    size_t dot = clean.rfind('.');
+    size_t slashY = clean.rfind('/');
+    if (slashY == std::string::npos || slashY == 0) {
+        return false;
+    }
+    size_t slashX = clean.rfind('/', slashY - 1);
+    if (slashX == std::string::npos || slashX == 0) {
+        return false;
+    }
+    size_t slashZ = clean.rfind('/', slashX - 1);
+    if (slashZ == std::string::npos) {
+        return false;
+    }
+    if (dot == std::string::npos || dot < slashY) {
+        dot = clean.size();
+    }
+    try {
+        key.z = std::stoi(clean.substr(slashZ + 1, slashX - slashZ - 1));
+        key.x = std::stoi(clean.substr(slashX + 1, slashY - slashX - 1));
+        key.y = std::stoi(clean.substr(slashY + 1, dot - slashY - 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return key.z >= 0 && key.z <= 30 && key.x >= 0 && key.y >= 0 && key.x < (1 << key.z) && key.y < (1 << key.z);
+}
+
+void LoopbackTileServer::serveConnection(Connection& connection) {
+    int fd = connection.fd;
+    std::string buffer;
+    char readBuffer[4096];
+    bool keepAlive = true;
+
+    while (keepAlive && !stopping) {
+        // Read one request head
+        size_t end;
+        while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(fd, readBuffer, sizeof(readBuffer), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0 || buffer.size() > 65536) {
+                keepAlive = false;
+                break;
+            }
+            buffer.append(readBuffer, static_cast<size_t>(n));
+        }
+        if (!keepAlive) {
+            break;
+        }
+        std::string head = buffer.substr(0, end);
+        buffer.erase(0, end + 4);
+        counters.requests++;
+
+        std::string lower = head;
+        for (char& c : lower) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        keepAlive = lower.find("connection: close") == std::string::npos &&
+                    lower.find(" http/1.0\r\n") == std::string::npos;
+
+        size_t pathStart = head.find(' ');
+        size_t pathEnd = pathStart == std::string::npos ? pathStart : head.find(' ', pathStart + 1);
+        TileKey key{};
+        if (head.compare(0, 4, "GET ") != 0 || pathEnd == std::string::npos ||
+            !parseTilePath(head.substr(pathStart + 1, pathEnd - pathStart - 1), key)) {
+            static const char notFound[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+            keepAlive = sendAll(fd, reinterpret_cast<const uint8_t*>(notFound), sizeof(notFound) - 1, false) &&
+                        keepAlive;
+            continue;
+        }
+
+        double latencyMs = 0.0;
+        Outcome outcome = decide(key, latencyMs);
+        if (latencyMs > 0.0 && !waitUnlessStopping(latencyMs)) {
+            break;
+        }
+
+        char header[256];
+        if (outcome == Outcome::TooMany || outcome == Outcome::ServerError) {
+            (outcome == Outcome::TooMany ? counters.tooManyRequests : counters.serverErrors)++;
+            int n = std::snprintf(header, sizeof(header), "%s\r\nContent-Length: 0\r\n%s\r\n",
+                                  outcome == Outcome::TooMany ? "HTTP/1.1 429 Too Many Requests"
+                                                              : "HTTP/1.1 503 Service Unavailable",
+                                  outcome == Outcome::TooMany ? "Retry-After: 1\r\n" : "");
+            keepAlive = sendAll(fd, reinterpret_cast<const uint8_t*>(header), static_cast<size_t>(n), false) &&
+                        keepAlive;
+            continue;
+        }
+        if (outcome == Outcome::Timeout) {
+            // Hold the connection until the client gives up
+            counters.timeouts++;
+            while (!stopping) {
+                pollfd pfd = { fd, POLLIN, 0 };
+                if (poll(&pfd, 1, 100) > 0 && recv(fd, readBuffer, sizeof(readBuffer), 0) <= 0) {
+                    break;
+                }
+            }
+            break;
+        }
+
+        std::shared_ptr<const ByteBuffer> body = tile(key);
+        int n = std::snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: %zu\r\n"
+                              "Cache-Control: max-age=86400\r\n\r\n",
+                              body->size());
+        if (!sendAll(fd, reinterpret_cast<const uint8_t*>(header), static_cast<size_t>(n), false)) {
+            break;
+        }
+        if (outcome == Outcome::Reset) {
+            counters.resets++;
+            sendAll(fd, body->data(), body->size() / 2, true);
+            linger reset = { 1, 0 }; // Close with RST instead of FIN
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            break;
+        }
+        if (!sendAll(fd, body->data(), body->size(), true)) {
+            break;
+        }
+        counters.served++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    close(fd);
+    connection.done = true;
+}
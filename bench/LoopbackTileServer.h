@@ -0,0 +1,104 @@
+// bench/LoopbackTileServer.h
+//
+// Stand-in for an upstream tile server, for load tests that must not touch
+// the real one. Serves generated tiles on 127.0.0.1 and injects latency,
+// bandwidth limits and failures from a seeded profile.
+#ifndef LOOPBACKTILESERVER_H
+#define LOOPBACKTILESERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "../src/Networking/Tiles/TileKey.h"
+#include "../src/Utils/BufferPool.h"
+
+// What the server does to each request. Rates are probabilities per
+// request and are checked in the order listed; whatever is left is served.
+// Decisions depend only on the seed, the tile and how often that tile has
+// been asked for, so a run is reproducible however requests interleave.
+struct FaultProfile {
+    double latencyMedianMs = 0.0; // Time before the response starts
+    double latencySigma = 0.0;    // Log-normal spread; 0 gives every response the median
+    uint64_t bytesPerSecond = 0;  // Per connection; 0 is unlimited
+    double rate429 = 0.0;         // Too Many Requests, with Retry-After: 1
+    double rate5xx = 0.0;         // 503 Service Unavailable
+    double timeoutRate = 0.0;     // Reads the request and never answers
+    double resetRate = 0.0;       // Sends half the tile, then resets the connection
+    size_t tileBytes = 0;         // Generated tiles are padded to at least this size
+    uint64_t seed = 1;
+
+    // Applies a command line option such as "--latency 40:0.5"; false if
+    // arg is not a fault option. Throws std::invalid_argument on a bad value.
+    bool parseOption(const std::string& arg, const std::string& value);
+    static const char* optionsHelp();
+};
+
+class LoopbackTileServer {
+public:
+    explicit LoopbackTileServer(const FaultProfile& profile);
+    ~LoopbackTileServer();
+
+    LoopbackTileServer(const LoopbackTileServer&) = delete;
+    LoopbackTileServer& operator=(const LoopbackTileServer&) = delete;
+
+    // Listens on 127.0.0.1:port (0 picks a free port) and serves on
+    // background threads until stop()
+    bool start(int port, std::string& error);
+    void stop();
+    int port() const { return boundPort; }
+
+    // Any path ending in /{z}/{x}/{y}.<ext> is served, so each mirror can
+    // get its own prefix
+    std::string urlTemplate(int mirror = 0) const;
+
+    struct Stats {
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> served{0};
+        std::atomic<uint64_t> tooManyRequests{0};
+        std::atomic<uint64_t> serverErrors{0};
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> resets{0};
+        std::atomic<uint64_t> bytesSent{0};
+        std::atomic<uint64_t> repeated{0}; // Requests for a tile asked for before
+    };
+    const Stats& stats() const { return counters; }
+
+private:
+    enum class Outcome { Serve, TooMany, ServerError, Timeout, Reset };
+
+    FaultProfile profile;
+    int listenFd = -1;
+    int boundPort = 0;
+    std::thread acceptor;
+    std::atomic<bool> stopping{false};
+    Stats counters;
+
+    struct Connection {
+        std::thread thread;
+        int fd;
+        bool done = false;
+    };
+
+    std::mutex mutex; // Everything below
+    std::condition_variable stopped;
+    std::list<Connection> connections;
+    std::unordered_map<TileKey, uint32_t, TileKeyHash> timesRequested;
+    std::unordered_map<TileKey, std::shared_ptr<const ByteBuffer>, TileKeyHash> tiles;
+
+    void acceptLoop();
+    void serveConnection(Connection& connection);
+    void reapConnections(); // Joins finished connection threads
+    Outcome decide(const TileKey& key, double& latencyMs);
+    std::shared_ptr<const ByteBuffer> tile(const TileKey& key);
+    bool sendAll(int fd, const uint8_t* data, size_t size, bool paced);
+    bool waitUnlessStopping(double ms); // False once stopping
+};
+
+#endif // LOOPBACKTILESERVER_H
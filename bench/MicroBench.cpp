@@ -0,0 +1,285 @@
+// bench/MicroBench.cpp
+//
+// gis_bench: microbenchmarks of the hot paths, for numbers before and
+// after every performance change.
+//
+// Usage: gis_bench [--filter regex] [--samples 20] [--min-sample-ms 20]
+//                  [--json out.json] [--list]
+//
+// Compare two runs with bench/compare_bench.py before.json after.json.
+// Build in Release and keep the machine otherwise idle. The fetcher
+// benchmarks keep a tile cache of empty files in /tmp/gis_bench-<uid>,
+// removed at the end.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "../src/Networking/Tiles/TileFetcher.h"
+#include "../src/Rendering/TileLayout.h"
+#include "../src/Utils/ThreadPool.h"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#ifdef GIS_BENCH_UI
+// MicroBenchUi.cpp: texture upload and dropdown text wrapping
+void registerUiBenchmarks(Bench::Suite& suite);
+#endif
+
+namespace {
+
+// Sizes of the tile lookup benchmarks; the viewer's fetcher keeps 1024
+const int LOOKUP_SIZES[] = { 1024, 16384, 262144 };
+
+// Tiles a fetcher benchmark can find on disk. Created on first use; the
+// fetcher only checks that they exist.
+std::filesystem::path workDir;
+std::filesystem::path originalDir;
+
+TileSource benchSource() {
+    return TileSource{ "bench", { "http://127.0.0.1:9/{z}/{x}/{y}.png" }, { TileFormat::Png } };
+}
+
+void writeTiles(const std::vector<TileKey>& keys) {
+    if (workDir.empty()) {
+        originalDir = std::filesystem::current_path();
+        workDir = "/tmp/gis_bench-" + std::to_string(getuid());
+        std::filesystem::remove_all(workDir);
+        std::filesystem::create_directories(workDir);
+        std::filesystem::current_path(workDir); // The fetcher caches below the working directory
+    }
+    for (const TileKey& key : keys) {
+        std::filesystem::path dir = benchSource().cacheDir() / std::to_string(key.z) / std::to_string(key.x);
+        std::filesystem::path path = dir / (std::to_string(key.y) + ".png");
+        if (!std::filesystem::exists(path)) {
+            std::filesystem::create_directories(dir);
+            std::ofstream(path) << "x";
+        }
+    }
+}
+
+std::shared_ptr<TileFetcher> fetcherWith(const std::vector<TileKey>& keys, size_t maxCacheSize) {
+    writeTiles(keys);
+    auto fetcher = std::make_shared<TileFetcher>(4, maxCacheSize, benchSource());
+    std::vector<std::future<bool>> futures;
+    for (const TileKey& key : keys) {
+        futures.push_back(fetcher->fetchTile(key.z, key.x, key.y));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    return fetcher;
+}
+
+std::vector<TileKey> shuffled(std::vector<TileKey> keys, size_t limit) {
+    uint64_t state = 42;
+    for (size_t i = keys.size(); i > 1; --i) {
+        std::swap(keys[i - 1], keys[BenchData::nextRandom(state) % i]);
+    }
+    keys.resize(std::min(keys.size(), limit));
+    return keys;
+}
+
+int sideFor(int size) {
+    return static_cast<int>(std::lround(std::sqrt(static_cast<double>(size))));
+}
+
+// TileRenderer::precomputeTilePositions is TileLayout::visibleTiles plus a
+// copy into SDL rects
+void addLayoutBenchmarks(Bench::Suite& suite) {
+    const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& size : sizes) {
+        Viewport vp{ 48.8566, 2.3522, 13.4, size[0], size[1] };
+        suite.add("layout/visibleTiles/" + std::to_string(size[0]) + "x" + std::to_string(size[1]), [vp]() {
+            return [vp](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    Bench::doNotOptimize(TileLayout::visibleTiles(vp, 13));
+                }
+            };
+        });
+    }
+}
+
+void addTileKeyBenchmarks(Bench::Suite& suite) {
+    suite.add("tilekey/hash", []() {
+        auto keys = std::make_shared<std::vector<TileKey>>();
+        uint64_t state = 7;
+        for (int i = 0; i < 4096; ++i) {
+            int z = 10 + static_cast<int>(BenchData::nextRandom(state) % 9);
+            keys->push_back({ z, static_cast<int>(BenchData::nextRandom(state) % (1u << z)),
+                              static_cast<int>(BenchData::nextRandom(state) % (1u << z)) });
+        }
+        return [keys](uint64_t iterations) {
+            TileKeyHash hash;
+            size_t sum = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                sum += hash((*keys)[i & 4095]);
+            }
+            Bench::doNotOptimize(sum);
+        };
+    });
+
+    // The fetcher's tile map: path per key, keys in one block
+    for (int size : LOOKUP_SIZES) {
+        for (bool hit : { true, false }) {
+            suite.add(std::string("tilekey/find-") + (hit ? "hit/" : "miss/") + std::to_string(size), [size, hit]() {
+                int side = sideFor(size);
+                auto map = std::make_shared<std::unordered_map<TileKey, std::filesystem::path, TileKeyHash>>();
+                for (const TileKey& key : BenchData::tileBlock(16, side)) {
+                    (*map)[key] = "resources/tiles/16/" + std::to_string(key.x) + "/" + std::to_string(key.y) + ".png";
+                }
+                // Misses are the neighbouring block, as when panning
+                auto probes = std::make_shared<std::vector<TileKey>>(
+                    shuffled(BenchData::tileBlock(16, side, hit ? 0 : side), 65536));
+                return [map, probes](uint64_t iterations) {
+                    size_t found = 0;
+                    size_t n = probes->size();
+                    for (uint64_t i = 0; i < iterations; ++i) {
+                        found += map->count((*probes)[i % n]);
+                    }
+                    Bench::doNotOptimize(found);
+                };
+            });
+        }
+    }
+}
+
+void addFetcherBenchmarks(Bench::Suite& suite) {
+    for (int size : { 1024, 16384 }) {
+        suite.add("fetcher/isTileCached/" + std::to_string(size), [size]() {
+            std::vector<TileKey> keys = BenchData::tileBlock(17, sideFor(size));
+            auto fetcher = fetcherWith(keys, keys.size());
+            auto probes = std::make_shared<std::vector<TileKey>>(shuffled(keys, 65536));
+            return [fetcher, probes](uint64_t iterations) {
+                size_t found = 0;
+                size_t n = probes->size();
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    const TileKey& key = (*probes)[i % n];
+                    found += fetcher->isTileCached(key.z, key.x, key.y);
+                }
+                Bench::doNotOptimize(found);
+            };
+        });
+        suite.add("fetcher/getTilePath/" + std::to_string(size), [size]() {
+            std::vector<TileKey> keys = BenchData::tileBlock(17, sideFor(size));
+            auto fetcher = fetcherWith(keys, keys.size());
+            auto probes = std::make_shared<std::vector<TileKey>>(shuffled(keys, 65536));
+            return [fetcher, probes](uint64_t iterations) {
+                size_t n = probes->size();
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    const TileKey& key = (*probes)[i % n];
+                    Bench::doNotOptimize(fetcher->getTilePath(key.z, key.x, key.y));
+                }
+            };
+        });
+    }
+
+    // touchTile and evictIfNeeded as a disk hit runs them: the LRU holds
+    // half the tiles cycled through, so every fetch evicts one. Includes
+    // the pool hand-off and the stat of the cached file.
+    for (int size : { 256, 1024 }) {
+        suite.add("fetcher/diskHitEvict/" + std::to_string(size), [size]() {
+            auto keys = std::make_shared<std::vector<TileKey>>(BenchData::tileBlock(18, sideFor(2 * size)));
+            auto fetcher = fetcherWith(*keys, size);
+            auto futures = std::make_shared<std::vector<std::future<bool>>>();
+            auto next = std::make_shared<size_t>(0);
+            return [fetcher, keys, futures, next](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    const TileKey& key = (*keys)[(*next)++ % keys->size()];
+                    futures->push_back(fetcher->fetchTile(key.z, key.x, key.y));
+                    if (futures->size() == 64 || i + 1 == iterations) {
+                        for (auto& f : *futures) {
+                            f.get();
+                        }
+                        futures->clear();
+                    }
+                }
+            };
+        });
+    }
+}
+
+void addThreadPoolBenchmarks(Bench::Suite& suite) {
+    for (size_t threads : { 1, 4, 8 }) {
+        suite.add("threadpool/enqueue/" + std::to_string(threads), [threads]() {
+            auto pool = std::make_shared<ThreadPool>(threads, "bench");
+            auto futures = std::make_shared<std::vector<std::future<void>>>();
+            return [pool, futures](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    futures->push_back(pool->enqueue([] {}));
+                    if (futures->size() == 256 || i + 1 == iterations) {
+                        for (auto& f : *futures) {
+                            f.get();
+                        }
+                        futures->clear();
+                    }
+                }
+            };
+        });
+    }
+}
+
+void addDecodeBenchmarks(Bench::Suite& suite) {
+    for (bool palette : { true, false }) {
+        suite.add(std::string("png/decode/") + (palette ? "palette" : "rgb"), [palette]() {
+            std::vector<uint8_t> indices = BenchData::mapTileIndices(1);
+            auto png = std::make_shared<ByteBuffer>(palette ? BenchData::palettePng(indices)
+                                                            : BenchData::rgbPng(indices));
+            std::shared_ptr<ImageDecoder> decoder = ImageDecoder::create(ImageDecoder::Kind::Native);
+            auto pixels = std::make_shared<ByteBuffer>();
+            return [png, decoder, pixels](uint64_t iterations) {
+                DecodedImage image;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    if (!decoder->decode(png->data(), png->size(), image, *pixels)) {
+                        std::fprintf(stderr, "png/decode: decode failed\n");
+                        std::exit(1);
+                    }
+                }
+                Bench::doNotOptimize(image);
+            };
+        });
+    }
+
+    // The CPU half of a texture upload: expanding the compact decoded form
+    // to 32-bit pixels
+    suite.add("tile/expand/palette", []() {
+        std::shared_ptr<const DecodedTile> tile = BenchData::decodedMapTile(1);
+        auto staging = std::make_shared<ByteBuffer>(BenchData::TILE_SIZE * BenchData::TILE_SIZE * 4);
+        return [tile, staging](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                tile->expandTo(staging->data(), BenchData::TILE_SIZE * 4);
+                Bench::doNotOptimize(staging->data());
+            }
+        };
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Bench::Suite suite;
+    addLayoutBenchmarks(suite);
+    addTileKeyBenchmarks(suite);
+    addFetcherBenchmarks(suite);
+    addThreadPoolBenchmarks(suite);
+    addDecodeBenchmarks(suite);
+#ifdef GIS_BENCH_UI
+    registerUiBenchmarks(suite);
+#endif
+
+    // --json is relative to where the bench was started
+    std::vector<char*> args(argv, argv + argc);
+    std::string jsonPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--json") {
+            jsonPath = std::filesystem::absolute(argv[i + 1]).string();
+            args[i + 1] = &jsonPath[0];
+        }
+    }
+
+    int status = suite.run(argc, args.data());
+    if (!workDir.empty()) {
+        std::filesystem::current_path(originalDir);
+        std::filesystem::remove_all(workDir);
+    }
+    return status;
+}
@@ -0,0 +1,122 @@
+// bench/MicroBenchUi.cpp
+//
+// gis_bench benchmarks that need SDL: texture upload and dropdown text
+// wrapping. Built into gis_bench when the viewer is (GIS_BUILD_UI).
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "../src/Config/ConfigManager.h"
+#include "../src/UI/Components/Dropdown.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <filesystem>
+
+namespace {
+
+// Hidden window with the renderer the viewer would get. Created on first
+// use and kept for the rest of the run.
+SDL_Renderer* benchRenderer() {
+    static SDL_Renderer* renderer = nullptr;
+    if (!renderer) {
+        if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+            std::fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
+            std::exit(1);
+        }
+        SDL_Window* window = SDL_CreateWindow("gis_bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 640, 480,
+                                              SDL_WINDOW_HIDDEN);
+        renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : nullptr;
+        if (!renderer && window) {
+            renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+        }
+        if (!renderer) {
+            std::fprintf(stderr, "Cannot create a renderer: %s\n", SDL_GetError());
+            std::exit(1);
+        }
+        SDL_RendererInfo info;
+        SDL_GetRendererInfo(renderer, &info);
+        std::printf("(UI benchmarks use the %s renderer)\n", info.name);
+    }
+    return renderer;
+}
+
+// Dropdown entries the length of tile source and setting descriptions
+std::vector<std::string> dropdownItems() {
+    static const char* words[] = { "OpenStreetMap", "standard", "tiles", "from", "the", "public", "mirror", "with",
+                                   "hillshading", "and", "contour", "lines", "cached", "for", "offline", "use",
+                                   "high", "resolution", "aerial", "imagery", "(WebP)", "labels", "in", "English" };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    std::vector<std::string> items;
+    uint64_t state = 3;
+    for (int i = 0; i < 32; ++i) {
+        std::string item;
+        int length = 2 + static_cast<int>(BenchData::nextRandom(state) % 14);
+        for (int w = 0; w < length; ++w) {
+            item += (w ? " " : "") + std::string(words[BenchData::nextRandom(state) % wordCount]);
+        }
+        items.push_back(item);
+    }
+    return items;
+}
+
+} // namespace
+
+void registerUiBenchmarks(Bench::Suite& suite) {
+    // What TileRenderer::uploadDecodedTile does per tile: create, expand
+    // into staging, update
+    suite.add("texture/upload/palette", []() {
+        SDL_Renderer* renderer = benchRenderer();
+        std::shared_ptr<const DecodedTile> tile = BenchData::decodedMapTile(1);
+        auto staging = std::make_shared<ByteBuffer>(BenchData::TILE_SIZE * BenchData::TILE_SIZE * 4);
+        return [renderer, tile, staging](uint64_t iterations) {
+            int pitch = tile->width * 4;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                                         tile->width, tile->height);
+                tile->expandTo(staging->data(), pitch);
+                SDL_UpdateTexture(texture, nullptr, staging->data(), pitch);
+                SDL_DestroyTexture(texture);
+            }
+        };
+    });
+
+    // Upload alone, into a texture that already exists
+    suite.add("texture/update", []() {
+        SDL_Renderer* renderer = benchRenderer();
+        std::shared_ptr<const DecodedTile> tile = BenchData::decodedMapTile(1);
+        auto staging = std::make_shared<ByteBuffer>(BenchData::TILE_SIZE * BenchData::TILE_SIZE * 4);
+        tile->expandTo(staging->data(), tile->width * 4);
+        std::shared_ptr<SDL_Texture> texture(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                               SDL_TEXTUREACCESS_STATIC, tile->width, tile->height),
+                                             SDL_DestroyTexture);
+        return [texture, staging](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                SDL_UpdateTexture(texture.get(), nullptr, staging->data(), BenchData::TILE_SIZE * 4);
+            }
+        };
+    });
+
+    // Dropdown::wrapTextByWidth is private; setItems rewraps every item
+    // with it and measures the resulting lines
+    std::string fontPath = std::filesystem::absolute(ConfigManager::loadConfig().fontPath).string();
+    suite.add("dropdown/wrapItems/32", [fontPath]() {
+        SDL_Renderer* renderer = benchRenderer();
+        if (!TTF_WasInit() && TTF_Init() != 0) {
+            std::fprintf(stderr, "TTF_Init: %s\n", TTF_GetError());
+            std::exit(1);
+        }
+        std::shared_ptr<TTF_Font> font(TTF_OpenFont(fontPath.c_str(), 16), TTF_CloseFont);
+        if (!font) {
+            std::fprintf(stderr, "Cannot open font %s: %s\n", fontPath.c_str(), TTF_GetError());
+            std::exit(1);
+        }
+        auto items = std::make_shared<std::vector<std::string>>(dropdownItems());
+        auto dropdown = std::make_shared<Dropdown>(renderer, font.get(), *items, 0, 0, 200, 30, 0,
+                                                   SDL_Color{ 255, 255, 255, 255 }, SDL_Color{ 200, 200, 200, 255 },
+                                                   [](int) {});
+        return [font, items, dropdown](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                dropdown->setItems(*items);
+            }
+        };
+    });
+}
@@ -0,0 +1,131 @@
+// bench/RenderBench.cpp
+//
+// Headless map rendering throughput in images per second.
+//
+// Usage: gis_render_bench [--url template] [--bbox minLon,minLat,maxLon,maxLat]
+//                         [--zoom min-max] [--images N] [--size WxH] [--threads 1,2,4,8]
+//
+// Renders N random views (fixed seed) inside the box at fractional zooms.
+// The first pass fetches and decodes tiles ("cold"); later passes run per
+// thread count against the warm caches, once rendering only and once
+// including PNG encoding. Point --url at a local tile server (or seed the
+// area first) so the network does not dominate the cold pass.
+
+#include "../src/Rendering/StaticMapRenderer.h"
+#include "../src/Encoding/PngWriter.h"
+#include "../tools/ToolSupport.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// Renders every view with the given number of threads; returns images/s
+static double renderAll(StaticMapRenderer& renderer, const std::vector<Viewport>& views, size_t threads,
+                        bool encode, size_t& incomplete) {
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> notComplete(0);
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            StaticMapRenderer::Image image;
+            ByteBuffer png;
+            for (size_t i = next++; i < views.size(); i = next++) {
+                StaticMapRenderer::Stats stats = renderer.render(views[i], image);
+                if (stats.missing > 0 || stats.fallbacks > 0) {
+                    notComplete++;
+                }
+                if (encode) {
+                    PngWriter::encode(image.pixels.data(), image.width, image.height, image.width, false, png);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    incomplete = notComplete;
+    return views.size() / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::string urlTemplate;
+    std::vector<double> box = { 139.55, 35.55, 139.85, 35.80 };
+    double minZoom = 11.0, maxZoom = 14.0;
+    size_t images = 300;
+    int width = 512, height = 512;
+    std::vector<double> threadCounts = { 1, 2, 4, 8 };
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--url") {
+            urlTemplate = value;
+        } else if (arg == "--bbox") {
+            box = ToolSupport::parseNumbers(value, ',');
+        } else if (arg == "--zoom") {
+            size_t dash = value.find('-');
+            minZoom = std::stod(value.substr(0, dash));
+            maxZoom = dash == std::string::npos ? minZoom : std::stod(value.substr(dash + 1));
+        } else if (arg == "--images") {
+            images = std::stoul(value);
+        } else if (arg == "--size") {
+            ToolSupport::parseSize(value, width, height);
+        } else if (arg == "--threads") {
+            threadCounts = ToolSupport::parseNumbers(value, ',');
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (box.size() != 4 || threadCounts.empty()) {
+        std::fprintf(stderr, "Bad --bbox or --threads\n");
+        return 2;
+    }
+
+    AppConfig config = ConfigManager::loadConfig();
+    TileSource source;
+    std::string error;
+    if (!ToolSupport::selectTileSource(config, "", urlTemplate, source, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> lon(box[0], box[2]), lat(box[1], box[3]), zoom(minZoom, maxZoom);
+    std::vector<Viewport> views;
+    for (size_t i = 0; i < images; ++i) {
+        views.push_back({ lat(rng), lon(rng), zoom(rng), width, height });
+    }
+
+    TileFetcher fetcher(8, 1 << 16 /* cacheSize */, source);
+    auto decodedTiles = std::make_shared<DecodedTileCache>(
+        static_cast<size_t>(std::max(config.decodedTileCacheMB, 1)) * 1024 * 1024);
+    StaticMapRenderer renderer(fetcher, decodedTiles);
+
+    size_t maxThreads = 1;
+    for (double t : threadCounts) {
+        maxThreads = std::max(maxThreads, static_cast<size_t>(t));
+    }
+    std::printf("%zu views of %dx%d, z%.1f-%.1f, tiles from %s\n", images, width, height, minZoom, maxZoom,
+                source.mirrors.empty() ? "?" : source.mirrors.front().c_str());
+
+    size_t incomplete = 0;
+    double cold = renderAll(renderer, views, maxThreads, false, incomplete);
+    std::printf("%-28s %8.1f images/s  (%zu incomplete)\n", ("cold, " + std::to_string(maxThreads) + " threads").c_str(),
+                cold, incomplete);
+    std::printf("decoded tile cache: %zu tiles, %.1f MB\n", decodedTiles->size(),
+                decodedTiles->bytesUsed() / (1024.0 * 1024.0));
+
+    for (double t : threadCounts) {
+        size_t threads = std::max<size_t>(1, static_cast<size_t>(t));
+        double render = renderAll(renderer, views, threads, false, incomplete);
+        double withPng = renderAll(renderer, views, threads, true, incomplete);
+        std::printf("warm, %2zu threads             %8.1f images/s  %8.1f with PNG encode\n",
+                    threads, render, withPng);
+    }
+    return 0;
+}
@@ -0,0 +1,539 @@
+// bench/SoakTest.cpp
+//
+// gis_soak: concurrency soak of TileFetcher and ThreadPool. Many client
+// threads hammer one fetcher with a random mix of fetchTile, prefetchTile,
+// isTileCached and getTilePath over a small key space (so tiles are
+// requested concurrently, downloaded, evicted and refetched) against a
+// LoopbackTileServer, then check invariants:
+//
+//   - every fetch future completes (a stall of --stall-seconds aborts)
+//   - getTilePath only returns the cache path of the requested tile
+//   - at rest the LRU holds no more than its capacity
+//   - at rest no tile is left marked in progress: refetching every tile
+//     never answers "already in progress"
+//   - every tile that fetched successfully is a valid PNG on disk
+//   - ThreadPool runs every task exactly once, including tasks queued
+//     when the pool is destroyed
+//   - a promoted background task runs before the background tasks queued
+//     ahead of it
+//   - a hedge that loses its race never makes its mirror primary or moves
+//     the hedge delay
+//   - destroying a fetcher with fetches queued for tiles another process
+//     is downloading completes every one of them as failed
+//
+// Usage: gis_soak [--ops N] [--clients 16] [--fetch-threads 8] [--keys 1024]
+//                 [--cache 256] [--stall-seconds 60] [fault options]
+//
+// Build with -DGIS_SANITIZE=thread to run it under ThreadSanitizer, and
+// with -DGIS_LOCK_PROFILING=ON for per-lock wait and hold times.
+// Exit status: 0 all invariants held, 2 an invariant failed.
+
+#include "LoopbackTileServer.h"
+#include "../src/Decoding/ImageDecoder.h"
+#include "../src/Networking/Tiles/TileFetcher.h"
+#include "../src/Utils/LockProfiler.h"
+#include "../src/Utils/Log.h"
+#include "../src/Utils/Metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__SANITIZE_THREAD__)
+#define GIS_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define GIS_TSAN 1
+#endif
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const int SOAK_ZOOM = 15;
+
+std::atomic<uint64_t> progress{0}; // Watched for stalls
+std::atomic<uint64_t> violations{0};
+
+void fail(const std::string& what) {
+    if (violations++ < 20) {
+        std::fprintf(stderr, "INVARIANT: %s\n", what.c_str());
+    }
+}
+
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+std::filesystem::path cacheDir; // Of the loopback source
+
+std::string expectedPath(const TileKey& key) {
+    return (cacheDir / std::to_string(key.z) / std::to_string(key.x) / (std::to_string(key.y) + ".png")).string();
+}
+
+// Aborts with the lock table if nothing completes for too long, so a
+// deadlock shows up as a failure (and a core dump) instead of a hang
+class Watchdog {
+public:
+    explicit Watchdog(int stallSeconds) : thread([this, stallSeconds] { run(stallSeconds); }) {}
+    ~Watchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool done = false;
+    std::thread thread;
+
+    void run(int stallSeconds) {
+        uint64_t last = progress.load();
+        auto lastChange = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, std::chrono::seconds(1), [this] { return done; })) {
+            uint64_t now = progress.load();
+            if (now != last) {
+                last = now;
+                lastChange = Clock::now();
+            } else if (Clock::now() - lastChange > std::chrono::seconds(stallSeconds)) {
+                std::fprintf(stderr, "INVARIANT: no progress for %d s; likely deadlock\n%s", stallSeconds,
+                             LockProfiler::report().c_str());
+                std::abort();
+            }
+        }
+    }
+};
+
+struct Options {
+    uint64_t ops = 2000000;
+    int clients = 16;
+    size_t fetchThreads = 8;
+    int keys = 1024;
+    size_t cache = 256;
+    int stallSeconds = 60;
+};
+
+struct FetchSoak {
+    std::vector<TileKey> keys;
+    std::unique_ptr<std::atomic<bool>[]> fetched; // Per key: some fetch succeeded
+    std::unique_ptr<std::atomic<bool>[]> requested;
+};
+
+void runClient(TileFetcher& fetcher, FetchSoak& soak, uint64_t ops, uint64_t seed) {
+    uint64_t state = seed;
+    struct Pending {
+        std::future<bool> result;
+        size_t key;
+    };
+    std::deque<Pending> pending;
+    auto settle = [&](Pending& p) {
+        if (p.result.get()) {
+            soak.fetched[p.key] = true;
+        }
+        progress++;
+    };
+
+    for (uint64_t i = 0; i < ops; ++i) {
+        uint64_t r = nextRandom(state);
+        size_t index = static_cast<size_t>((r >> 8) % soak.keys.size());
+        const TileKey& key = soak.keys[index];
+        unsigned roll = static_cast<unsigned>(r % 100);
+        if (roll < 5) {
+            soak.requested[index] = true;
+            pending.push_back({ roll < 4 ? fetcher.fetchTile(key.z, key.x, key.y)
+                                         : fetcher.prefetchTile(key.z, key.x, key.y),
+                                index });
+        } else if (roll < 7) {
+            fetcher.promoteTile(key.z, key.x, key.y);
+        } else if (roll < 52) {
+            fetcher.isTileCached(key.z, key.x, key.y);
+        } else {
+            std::filesystem::path path = fetcher.getTilePath(key.z, key.x, key.y);
+            if (!path.empty() && path.string() != expectedPath(key)) {
+                fail("getTilePath(" + expectedPath(key) + ") returned " + path.string());
+            }
+        }
+        progress++;
+
+        // Bounded outstanding work per client; completed futures first
+        while (!pending.empty() &&
+               (pending.size() > 64 ||
+                pending.front().result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+            settle(pending.front());
+            pending.pop_front();
+        }
+    }
+    for (Pending& p : pending) {
+        settle(p);
+    }
+}
+
+bool validPng(const std::filesystem::path& path, ImageDecoder& decoder) {
+    std::ifstream file(path, std::ios::binary);
+    ByteBuffer data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    DecodedImage image;
+    ByteBuffer pixels;
+    return !data.empty() && decoder.decode(data.data(), data.size(), image, pixels) && image.width == 256 &&
+           image.height == 256;
+}
+
+void soakFetcher(const Options& options, const TileSource& source) {
+    FetchSoak soak;
+    int side = 1;
+    while (side * side < options.keys) {
+        side++;
+    }
+    int origin = (1 << SOAK_ZOOM) / 2 - side / 2;
+    for (int i = 0; i < options.keys; ++i) {
+        soak.keys.push_back({ SOAK_ZOOM, origin + i % side, origin + i / side });
+    }
+    soak.fetched.reset(new std::atomic<bool>[soak.keys.size()]());
+    soak.requested.reset(new std::atomic<bool>[soak.keys.size()]());
+
+    Metrics::Counter& inProgress = Metrics::counter("gis_tile_requests_total", "", "outcome=\"in_progress\"");
+    {
+        TileFetcher fetcher(options.fetchThreads, options.cache, source);
+
+        auto start = Clock::now();
+        std::vector<std::thread> clients;
+        for (int c = 0; c < options.clients; ++c) {
+            clients.emplace_back(runClient, std::ref(fetcher), std::ref(soak), options.ops / options.clients,
+                                 1000 + c);
+        }
+        for (std::thread& client : clients) {
+            client.join();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("fetcher: %llu operations from %d clients in %.1f s (%.0f ops/s); %llu answered in progress\n",
+                    static_cast<unsigned long long>(options.ops), options.clients, seconds, options.ops / seconds,
+                    static_cast<unsigned long long>(inProgress.value()));
+
+        // At rest: the LRU is within capacity
+        size_t cached = 0;
+        for (const TileKey& key : soak.keys) {
+            cached += fetcher.isTileCached(key.z, key.x, key.y);
+        }
+        if (cached > options.cache) {
+            fail("LRU holds " + std::to_string(cached) + " tiles, capacity " + std::to_string(options.cache));
+        }
+
+        // At rest: nothing is left in progress, so one fetch at a time never
+        // hears "already in progress"
+        uint64_t inProgressBefore = inProgress.value();
+        for (size_t i = 0; i < soak.keys.size(); ++i) {
+            if (soak.requested[i]) {
+                const TileKey& key = soak.keys[i];
+                if (fetcher.fetchTile(key.z, key.x, key.y).get()) {
+                    soak.fetched[i] = true;
+                }
+                progress++;
+            }
+        }
+        if (inProgress.value() != inProgressBefore) {
+            fail(std::to_string(inProgress.value() - inProgressBefore) + " tiles still marked in progress at rest");
+        }
+    } // The cache writer finishes its writes here
+
+    // Every successful tile reached the disk intact
+    std::unique_ptr<ImageDecoder> decoder = ImageDecoder::create(ImageDecoder::Kind::Native);
+    size_t fetched = 0;
+    for (size_t i = 0; i < soak.keys.size(); ++i) {
+        if (soak.fetched[i]) {
+            fetched++;
+            if (!validPng(expectedPath(soak.keys[i]), *decoder)) {
+                fail(expectedPath(soak.keys[i]) + " fetched but missing or corrupt on disk");
+            }
+        }
+    }
+    std::printf("fetcher: %zu of %zu tiles fetched and verified on disk\n", fetched, soak.keys.size());
+}
+
+void soakThreadPool(const Options& options) {
+    const int producers = options.clients;
+    const int tasksPerProducer = static_cast<int>(std::min<uint64_t>(options.ops / producers, 100000));
+    std::vector<std::atomic<uint32_t>> runs(static_cast<size_t>(producers) * tasksPerProducer);
+
+    auto start = Clock::now();
+    {
+        ThreadPool pool(options.fetchThreads, "soak");
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                std::deque<std::future<void>> futures;
+                for (int t = 0; t < tasksPerProducer; ++t) {
+                    size_t id = static_cast<size_t>(p) * tasksPerProducer + t;
+                    auto task = [&runs, id] { runs[id]++; };
+                    futures.push_back(t % 8 == 0 ? pool.enqueueLow(task) : pool.enqueue(task));
+                    if (futures.size() > 256) {
+                        futures.front().get();
+                        futures.pop_front();
+                        progress++;
+                    }
+                }
+                for (auto& f : futures) {
+                    f.get();
+                    progress++;
+                }
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+    size_t wrong = 0;
+    for (auto& count : runs) {
+        wrong += count.load() != 1;
+    }
+    if (wrong > 0) {
+        fail(std::to_string(wrong) + " thread pool tasks did not run exactly once");
+    }
+
+    // Destroying a pool runs the normal tasks still queued
+    for (int round = 0; round < 200; ++round) {
+        std::atomic<int> ran{0};
+        {
+            ThreadPool pool(4, "soak shutdown");
+            for (int t = 0; t < 64; ++t) {
+                pool.enqueue([&ran] { ran++; });
+            }
+        }
+        if (ran != 64) {
+            fail("pool destroyed with " + std::to_string(64 - ran) + " queued tasks unrun");
+        }
+        progress++;
+    }
+    std::printf("thread pool: %zu tasks from %d producers in %.1f s, 200 shutdowns\n", runs.size(), producers,
+                std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+// A promoted background task must not wait for the ones queued before it
+void checkPromote() {
+    const int queued = 32;
+    std::mutex orderMutex;
+    std::vector<int> order;
+    {
+        ThreadPool pool(2, "soak promote"); // One background slot
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        std::vector<std::future<void>> futures;
+        futures.push_back(pool.enqueueLow([opened] { opened.wait(); })); // Holds the background slot
+        for (int t = 1; t <= queued; ++t) {
+            futures.push_back(pool.enqueueLowTagged(t, [&orderMutex, &order, t] {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(t);
+            }));
+        }
+        if (!pool.promote(queued)) {
+            fail("promote found no waiting task to promote");
+        }
+        // Runs on the idle worker while every other background task waits
+        if (futures.back().wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+            fail("promoted task did not run while the background slot was busy");
+        }
+        gate.set_value();
+        for (auto& f : futures) {
+            f.get();
+        }
+        if (pool.promote(queued)) {
+            fail("promote moved a task that already ran");
+        }
+    }
+
+    std::vector<int> expected = { queued };
+    for (int t = 1; t < queued; ++t) {
+        expected.push_back(t);
+    }
+    if (order != expected) {
+        std::string got;
+        for (int t : order) {
+            got += (got.empty() ? "" : ",") + std::to_string(t);
+        }
+        fail("promoted task did not run first; order was " + got);
+    } else {
+        std::printf("thread pool: promoted task ran ahead of %d queued background tasks\n", queued - 1);
+    }
+    progress++;
+}
+
+// Fetches of tiles claimed elsewhere park off the pool. A fetcher destroyed
+// while they are still queued must fail them, not park them on a watcher
+// that is gone.
+void checkShutdownWhileClaimed(const TileSource& source) {
+    const int tiles = 64;
+    std::unique_ptr<SharedTileIndex> other = SharedTileIndex::open(cacheDir); // Stands in for another process
+    if (!other) {
+        std::printf("fetcher shutdown: skipped, no shared tile index\n");
+        return;
+    }
+    std::vector<TileKey> keys;
+    for (int i = 0; i < tiles; ++i) {
+        keys.push_back({ SOAK_ZOOM + 1, i, 0 }); // Outside the soak's key space, so never on disk
+    }
+
+    for (int round = 0; round < 20; ++round) {
+        // Claims belong to the process, so each destroyed fetcher drops them
+        for (const TileKey& key : keys) {
+            other->claim(key);
+        }
+        std::vector<std::future<bool>> futures;
+        {
+            TileFetcher fetcher(2, 16, source);
+            for (const TileKey& key : keys) {
+                futures.push_back(fetcher.fetchTile(key.z, key.x, key.y));
+            }
+        }
+        for (size_t i = 0; i < futures.size(); ++i) {
+            if (futures[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                fail("fetch of claimed tile " + expectedPath(keys[i]) + " left pending by a destroyed fetcher");
+            } else if (futures[i].get()) {
+                fail("fetch of claimed tile " + expectedPath(keys[i]) + " downloaded it during shutdown");
+            }
+        }
+        progress++;
+    }
+    std::printf("fetcher shutdown: 20 fetchers destroyed with %d claimed tiles queued\n", tiles);
+}
+
+// A cancelled hedge is censored: it must not seed a cold mirror's latency
+// or reach the p95 behind the hedge delay
+void checkHedgeLoser() {
+    MirrorHealth health(2);
+    for (int i = 0; i < 20; ++i) {
+        health.recordSuccess(0, 100.0);
+    }
+    // Hedge to cold mirror 1, cancelled 1 ms after it started, then its
+    // first real answer takes 300 ms
+    health.recordCancelled(1, 1.0, 100.0);
+    health.recordSuccess(1, 300.0);
+    if (health.orderedMirrors().front() != 0) {
+        fail("a mirror that lost its only hedge 1 ms in became primary over a faster one");
+    }
+
+    // Losses of a measured mirror stay out of the source p95
+    for (int i = 0; i < 300; ++i) {
+        health.recordCancelled(1, 500.0, 100.0);
+    }
+    if (health.hedgeDelay() != std::chrono::milliseconds(100)) {
+        fail("cancelled hedges moved the hedge delay to " + std::to_string(health.hedgeDelay().count()) + " ms");
+    } else if (health.orderedMirrors().front() == 0) {
+        std::printf("mirror health: lost hedges left mirror order and the hedge delay alone\n");
+    }
+    progress++;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+#ifdef GIS_TSAN
+    options.ops = 200000; // ThreadSanitizer runs 5-15x slower
+#endif
+    FaultProfile profile;
+    profile.latencyMedianMs = 2.0;
+    profile.latencySigma = 0.5;
+    profile.rate5xx = 0.02;
+    profile.resetRate = 0.01;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr,
+                         "Usage: %s [--ops N] [--clients N] [--fetch-threads N] [--keys N] [--cache N] "
+                         "[--stall-seconds N] [fault options]\nFault options (default --latency 2:0.5 --5xx 0.02 "
+                         "--resets 0.01):\n%s",
+                         argv[0], FaultProfile::optionsHelp());
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--ops") {
+                options.ops = std::stoull(value);
+            } else if (arg == "--clients") {
+                options.clients = std::max(1, std::stoi(value));
+            } else if (arg == "--fetch-threads") {
+                options.fetchThreads = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--keys") {
+                options.keys = std::max(1, std::stoi(value));
+            } else if (arg == "--cache") {
+                options.cache = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--stall-seconds") {
+                options.stallSeconds = std::max(1, std::stoi(value));
+            } else if (!profile.parseOption(arg, value)) {
+                std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::fprintf(stderr, "Bad value for %s: %s\n", arg.c_str(), value.c_str());
+            return 1;
+        }
+    }
+
+    LoopbackTileServer server(profile);
+    std::string error;
+    if (!server.start(0, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    TileSource source{ "loopback", { server.urlTemplate(0), server.urlTemplate(1) }, { TileFormat::Png } };
+    cacheDir = source.cacheDir();
+
+    // The fetcher caches below the working directory
+    std::filesystem::path originalDir = std::filesystem::current_path();
+    std::filesystem::path workDir = "/tmp/gis_soak-" + std::to_string(getuid());
+    std::error_code ec;
+    std::filesystem::remove_all(workDir, ec);
+    if (!std::filesystem::create_directories(workDir, ec) || chdir(workDir.c_str()) != 0) {
+        std::fprintf(stderr, "Cannot use %s as working directory\n", workDir.c_str());
+        return 1;
+    }
+
+    std::printf("%llu operations, %d clients, %zu fetch threads, %d tiles, LRU of %zu%s\n",
+                static_cast<unsigned long long>(options.ops), options.clients, options.fetchThreads, options.keys,
+                options.cache,
+#ifdef GIS_TSAN
+                ", ThreadSanitizer"
+#else
+                ""
+#endif
+    );
+    {
+        Watchdog watchdog(options.stallSeconds);
+        soakFetcher(options, source);
+        soakThreadPool(options);
+        checkPromote();
+        checkHedgeLoser();
+        checkShutdownWhileClaimed(source);
+    }
+    server.stop();
+    Log::flush();
+    if (chdir(originalDir.c_str()) != 0) {
+        std::perror("chdir");
+    }
+    std::filesystem::remove_all(workDir, ec);
+
+    if (LockProfiler::enabled) {
+        std::printf("\n%s", LockProfiler::report().c_str());
+    } else {
+        std::printf("(configure with -DGIS_LOCK_PROFILING=ON for per-lock wait and hold times)\n");
+    }
+    if (violations > 0) {
+        std::printf("FAILED: %llu invariant violations\n", static_cast<unsigned long long>(violations.load()));
+        return 2;
+    }
+    std::printf("All invariants held\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+// bench/TileStub.cpp
+//
+// Runs a LoopbackTileServer on its own, for pointing the viewer, the seed
+// tool or CustomGIS-serve at a misbehaving upstream by hand:
+//
+//   gis_tile_stub --port 8088 --latency 80:0.6 --5xx 0.02 --resets 0.01
+//   CustomGIS-seed --url 'http://127.0.0.1:8088/m0/{z}/{x}/{y}.png' ...
+//
+// Prints what it served when interrupted.
+
+#include "LoopbackTileServer.h"
+#include <csignal>
+#include <cstdio>
+#include <pthread.h>
+
+int main(int argc, char* argv[]) {
+    int port = 8088;
+    FaultProfile profile;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Usage: %s [--port N] [fault options]\nFault options:\n%s", argv[0],
+                         FaultProfile::optionsHelp());
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--port") {
+                port = std::stoi(value);
+            } else if (!profile.parseOption(arg, value)) {
+                std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::fprintf(stderr, "Bad value for %s: %s\n", arg.c_str(), value.c_str());
+            return 1;
+        }
+    }
+
+    // Blocked before the server threads start so they inherit the mask and
+    // only sigwait below sees the signals
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    LoopbackTileServer server(profile);
+    std::string error;
+    if (!server.start(port, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("Serving %s\n", server.urlTemplate().c_str());
+    std::fflush(stdout);
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+
+    const LoopbackTileServer::Stats& stats = server.stats();
+    std::printf("%llu requests on %llu connections: %llu served (%.1f MB), %llu 429, %llu 5xx, "
+                "%llu timed out, %llu reset, %llu repeated\n",
+                static_cast<unsigned long long>(stats.requests.load()),
+                static_cast<unsigned long long>(stats.connections.load()),
+                static_cast<unsigned long long>(stats.served.load()), stats.bytesSent.load() / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(stats.tooManyRequests.load()),
+                static_cast<unsigned long long>(stats.serverErrors.load()),
+                static_cast<unsigned long long>(stats.timeouts.load()),
+                static_cast<unsigned long long>(stats.resets.load()),
+                static_cast<unsigned long long>(stats.repeated.load()));
+    return 0;
+}
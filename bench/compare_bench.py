@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# bench/compare_bench.py
+#
+# Compares two gis_bench --json runs, benchmark by benchmark:
+#
+#   compare_bench.py before.json after.json [--threshold 3] [--alpha 0.01]
+#                    [--fail-on-regression]
+#
+# A change is reported as faster or slower only if the Mann-Whitney U test
+# on the two sets of samples rejects "no difference" at --alpha and the
+# medians differ by more than --threshold percent; anything else is noise.
+# With --fail-on-regression the exit status is 1 if anything got slower.
+
+import argparse
+import json
+import math
+import sys
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test (normal approximation
+    with tie correction; fine for the 10+ samples gis_bench takes)."""
+    n1, n2 = len(a), len(b)
+    ranked = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(ranked)
+    ties = 0.0
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1.0
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(rank for rank, (_, group) in zip(ranks, ranked) if group == 0)
+    u = r1 - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2.0) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2.0))
+
+
+def format_ns(ns):
+    if ns < 1e3:
+        return "%.2f ns" % ns
+    if ns < 1e6:
+        return "%.2f us" % (ns / 1e3)
+    return "%.2f ms" % (ns / 1e6)
+
+
+def load(path):
+    with open(path) as f:
+        run = json.load(f)
+    return run.get("context", {}), {b["name"]: b for b in run["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two gis_bench JSON runs")
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=3.0, help="smallest change reported, in percent")
+    parser.add_argument("--alpha", type=float, default=0.01, help="significance level")
+    parser.add_argument("--fail-on-regression", action="store_true")
+    args = parser.parse_args()
+
+    before_context, before = load(args.before)
+    after_context, after = load(args.after)
+    for key in ("host", "cpus", "compiler", "assertions"):
+        if before_context.get(key) != after_context.get(key):
+            print("warning: runs differ in %s (%s vs %s)" % (key, before_context.get(key), after_context.get(key)))
+
+    print("%-34s %11s %11s %8s %8s  %s" % ("benchmark", "before", "after", "change", "p", "verdict"))
+    slower = 0
+    for name in before:
+        if name not in after:
+            continue
+        a, b = before[name], after[name]
+        change = 100.0 * (b["median_ns"] - a["median_ns"]) / a["median_ns"] if a["median_ns"] > 0 else 0.0
+        p = mann_whitney_p(a["samples_ns"], b["samples_ns"])
+        verdict = ""
+        if p < args.alpha and abs(change) > args.threshold:
+            verdict = "slower" if change > 0 else "faster"
+            slower += change > 0
+        print("%-34s %11s %11s %+7.1f%% %8.4f  %s"
+              % (name, format_ns(a["median_ns"]), format_ns(b["median_ns"]), change, p, verdict))
+
+    only = sorted(set(before) ^ set(after))
+    if only:
+        print("only in one run: " + ", ".join(only))
+    return 1 if args.fail_on_regression and slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -13,6 +13,15 @@ AppConfig ConfigManager::loadConfig() {
     cfg.fontPath = "../resources/fonts/WaukeganLdo-ax19.ttf";
     cfg.resolutionWidth = 1280;
     cfg.resolutionHeight = 720;
+    cfg.tileSources = { TileSource::openStreetMap() };
+    cfg.decodedTileCacheMB = 128;
+    cfg.imageDecoder = "auto";
+    cfg.prefetchBudgetTiles = 5000;
+    cfg.metricsFile = "";
+    cfg.metricsIntervalSeconds = 15;
+    cfg.logFile = "";
+    cfg.logFileMB = 10;
+    cfg.logFilesKept = 5;
 
     std::ifstream file(CONFIG_FILE_PATH);
     if (!file.is_open()) {
@@ -35,6 +44,52 @@ AppConfig ConfigManager::loadConfig() {
         if (j.contains("resolutionHeight")) {
             cfg.resolutionHeight = j.at("resolutionHeight").get<int>();
         }
+        if (j.contains("decodedTileCacheMB")) {
+            cfg.decodedTileCacheMB = j.at("decodedTileCacheMB").get<int>();
+        }
+        if (j.contains("imageDecoder")) {
+            cfg.imageDecoder = j.at("imageDecoder").get<std::string>();
+        }
+        if (j.contains("prefetchBudgetTiles")) {
+            cfg.prefetchBudgetTiles = j.at("prefetchBudgetTiles").get<int>();
+        }
+        if (j.contains("metricsFile")) {
+            cfg.metricsFile = j.at("metricsFile").get<std::string>();
+        }
+        if (j.contains("metricsIntervalSeconds")) {
+            cfg.metricsIntervalSeconds = j.at("metricsIntervalSeconds").get<int>();
+        }
+        if (j.contains("logFile")) {
+            cfg.logFile = j.at("logFile").get<std::string>();
+        }
+        if (j.contains("logFileMB")) {
+            cfg.logFileMB = j.at("logFileMB").get<int>();
+        }
+        if (j.contains("logFilesKept")) {
+            cfg.logFilesKept = j.at("logFilesKept").get<int>();
+        }
+        if (j.contains("tileSources")) {
+            std::vector<TileSource> sources;
+            for (const auto& js : j.at("tileSources")) {
+                TileSource source;
+                source.name = js.value("name", std::string("Unnamed"));
+                source.mirrors = js.value("mirrors", std::vector<std::string>{});
+                for (const auto& name : js.value("formats", std::vector<std::string>{})) {
+                    TileFormat format = TileFormats::fromName(name);
+                    if (format == TileFormat::Unknown) {
+                        std::cerr << "[ConfigManager] Ignoring unknown tile format: " << name << "\n";
+                        continue;
+                    }
+                    source.formats.push_back(format);
+                }
+                if (!source.mirrors.empty()) {
+                    sources.push_back(source);
+                }
+            }
+            if (!sources.empty()) {
+                cfg.tileSources = sources;
+            }
+        }
     } catch (std::exception& e) {
         std::cerr << "[ConfigManager] JSON parse error: " << e.what() 
                   << " - Using defaults.\n";
@@ -48,6 +103,22 @@ void ConfigManager::saveConfig(const AppConfig& config) {
     j["fontPath"] = config.fontPath;
     j["resolutionWidth"] = config.resolutionWidth;
     j["resolutionHeight"] = config.resolutionHeight;
+    j["decodedTileCacheMB"] = config.decodedTileCacheMB;
+    j["imageDecoder"] = config.imageDecoder;
+    j["prefetchBudgetTiles"] = config.prefetchBudgetTiles;
+    j["metricsFile"] = config.metricsFile;
+    j["metricsIntervalSeconds"] = config.metricsIntervalSeconds;
+    j["logFile"] = config.logFile;
+    j["logFileMB"] = config.logFileMB;
+    j["logFilesKept"] = config.logFilesKept;
+    j["tileSources"] = nlohmann::json::array();
+    for (const auto& source : config.tileSources) {
+        std::vector<std::string> formats;
+        for (TileFormat format : source.acceptedFormats()) {
+            formats.push_back(TileFormats::extension(format));
+        }
+        j["tileSources"].push_back({ {"name", source.name}, {"mirrors", source.mirrors}, {"formats", formats} });
+    }
 
     std::ofstream file(CONFIG_FILE_PATH);
     if (!file.is_open()) {
@@ -3,11 +3,22 @@
 #define CONFIGMANAGER_H
 
 #include <string>
+#include <vector>
+#include "../Networking/Tiles/TileSource.h"
 
 struct AppConfig {
     std::string fontPath;
     int resolutionWidth;
     int resolutionHeight;
+    std::vector<TileSource> tileSources; // First entry is the active source
+    int decodedTileCacheMB;              // RAM budget for compact decoded tiles
+    std::string imageDecoder;            // "auto", "native" or "sdl" (see gis_decode_bench)
+    int prefetchBudgetTiles;             // Predicted tiles fetched per session at most
+    std::string metricsFile;             // Prometheus text file rewritten periodically; empty: off
+    int metricsIntervalSeconds;          // How often metricsFile is rewritten
+    std::string logFile;                 // Log file with timestamps and thread names; empty: console only
+    int logFileMB;                       // Size at which logFile is rotated to logFile.1
+    int logFilesKept;                    // Rotated files kept besides logFile
 };
 
 class ConfigManager {
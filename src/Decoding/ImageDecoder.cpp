@@ -0,0 +1,87 @@
+// src/Decoding/ImageDecoder.cpp
+#include "ImageDecoder.h"
+#include "PngDecoder.h"
+#include "../Utils/Metrics.h"
+#include "../Utils/Utils.h"
+#include <algorithm>
+#include <chrono>
+
+static ImageDecoder::Factory fallbackFactory = nullptr;
+static std::vector<TileFormat> fallbackFormats;
+
+namespace {
+// Times every decode, whichever thread and backend runs it
+class MeteredDecoder : public ImageDecoder {
+public:
+    explicit MeteredDecoder(std::unique_ptr<ImageDecoder> inner)
+        : inner(std::move(inner)),
+          decodeTime(Metrics::histogram("gis_decode_seconds", "Time to decode one tile image")),
+          failures(Metrics::counter("gis_decode_failures_total", "Tile images that failed to decode")),
+          running(Metrics::gauge("gis_decode_running", "Tile images being decoded")) {}
+
+    bool decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) override {
+        running.add(1);
+        auto start = std::chrono::steady_clock::now();
+        bool ok = inner->decode(data, size, image, pixels);
+        decodeTime.observe(std::chrono::steady_clock::now() - start);
+        running.add(-1);
+        if (!ok) {
+            failures.add();
+        }
+        return ok;
+    }
+
+    const char* name() const override { return inner->name(); }
+
+private:
+    std::unique_ptr<ImageDecoder> inner;
+    Metrics::Histogram& decodeTime;
+    Metrics::Counter& failures;
+    Metrics::Gauge& running;
+};
+}
+
+void ImageDecoder::setFallbackFactory(Factory factory, std::vector<TileFormat> formats) {
+    fallbackFactory = factory;
+    fallbackFormats = std::move(formats);
+}
+
+bool ImageDecoder::canDecode(TileFormat format) {
+    return format == TileFormat::Png || (fallbackFactory && std::find(fallbackFormats.begin(),
+                                                                      fallbackFormats.end(), format) !=
+                                                                fallbackFormats.end());
+}
+
+std::unique_ptr<ImageDecoder> ImageDecoder::create(Kind kind) {
+    switch (kind) {
+    case Kind::SdlImage:
+        if (!fallbackFactory) {
+            Utils::logError("Image decoder \"sdl\" requested, but no SDL_image backend is installed");
+            return nullptr;
+        }
+        return std::make_unique<MeteredDecoder>(fallbackFactory());
+    case Kind::Native:
+        // 16-bit, interlaced and non-PNG images fail to decode
+        return std::make_unique<MeteredDecoder>(std::make_unique<PngDecoder>());
+    case Kind::Auto:
+        break;
+    }
+    // Native handles the PNG subsets it has SIMD paths for; the rest goes
+    // through the fallback when one is installed
+    return std::make_unique<MeteredDecoder>(
+        std::make_unique<PngDecoder>(fallbackFactory ? fallbackFactory() : nullptr));
+}
+
+bool ImageDecoder::available(Kind kind) {
+    return kind != Kind::SdlImage || fallbackFactory != nullptr;
+}
+
+ImageDecoder::Kind ImageDecoder::kindFromString(const std::string& name) {
+    if (name == "sdl") {
+        return Kind::SdlImage;
+    }
+    if (name == "native") {
+        return Kind::Native;
+    }
+    return Kind::Auto;
+}
@@ -0,0 +1,68 @@
+// src/Decoding/ImageDecoder.h
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Utils/BufferPool.h"
+#include "../Networking/Tiles/TileFormat.h"
+
+// Layout of pixels a decoder wrote into the caller's buffer. Rows are
+// tightly packed (pitch = width * bytesPerPixel()).
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    bool hasAlpha = false;
+    int paletteSize = 0;                 // Non-zero: pixels are 8-bit palette indices
+    std::array<uint32_t, 256> palette{}; // ARGB8888 entries
+
+    int bytesPerPixel() const { return paletteSize > 0 ? 1 : 4; }
+    size_t pitch() const { return static_cast<size_t>(width) * bytesPerPixel(); }
+};
+
+// Decodes encoded tile images (PNG etc.) into 8-bit indices or ARGB8888.
+// Output goes into a caller-owned buffer so staging memory can be reused
+// across tiles instead of allocating a surface per decode.
+class ImageDecoder {
+public:
+    enum class Kind {
+        Auto,       // Native for the PNGs it handles, the fallback backend for the rest
+        SdlImage,   // The fallback backend alone (SDL_image in the viewer)
+        Native      // Built-in PNG decoder alone (zlib inflate + SIMD unfilter)
+    };
+
+    virtual ~ImageDecoder() = default;
+
+    // Resizes pixels to height * image.pitch() and fills it. Returns false
+    // if the data is corrupt or uses a format the backend cannot handle.
+    virtual bool decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) = 0;
+
+    virtual const char* name() const = 0;
+
+    // Backends are not thread-safe; create one per decoding thread. Returns
+    // null (and logs) if the requested backend is not available, i.e.
+    // SdlImage without a fallback factory.
+    static std::unique_ptr<ImageDecoder> create(Kind kind = Kind::Auto);
+
+    // Whether create(kind) would succeed
+    static bool available(Kind kind);
+
+    // "auto", "sdl" or "native"; unknown names map to Auto
+    static Kind kindFromString(const std::string& name);
+
+    // Backend for images the native decoder cannot handle (16-bit,
+    // interlaced, non-PNG), and the tile formats it decodes. Core code has
+    // no SDL dependency, so front ends register one at startup (see
+    // SdlImageDecoder::install); without it such images fail to decode.
+    using Factory = std::unique_ptr<ImageDecoder> (*)();
+    static void setFallbackFactory(Factory factory, std::vector<TileFormat> formats);
+
+    // Whether create(Kind::Auto) decodes the format: PNG natively, anything
+    // else only through a fallback registered for it
+    static bool canDecode(TileFormat format);
+};
+
+#endif // IMAGEDECODER_H
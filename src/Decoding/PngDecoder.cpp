@@ -0,0 +1,268 @@
+// src/Decoding/PngDecoder.cpp
+#include "PngDecoder.h"
+#include "PngUnfilter.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PNG_DECODER_X86 1
+#endif
+
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+static const int MAX_DIMENSION = 16384;
+
+enum ColorType : uint8_t {
+    COLOR_GRAY = 0,
+    COLOR_RGB = 2,
+    COLOR_PALETTE = 3,
+    COLOR_GRAY_ALPHA = 4,
+    COLOR_RGBA = 6
+};
+
+static inline uint32_t readBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline uint32_t argb(uint8_t a, uint8_t r, uint8_t g, uint8_t b) {
+    return (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+}
+
+static void rgbaToArgbScalar(const uint8_t* src, uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 4) {
+        dst[i] = argb(src[3], src[0], src[1], src[2]);
+    }
+}
+
+#ifdef PNG_DECODER_X86
+// RGBA bytes to little-endian ARGB8888 (B, G, R, A in memory) is a byte shuffle
+__attribute__((target("ssse3")))
+static void rgbaToArgbSsse3(const uint8_t* src, uint32_t* dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(px, shuffle));
+    }
+    rgbaToArgbScalar(src + i * 4, dst + i, count - i);
+}
+#endif
+
+static void rgbaToArgb(const uint8_t* src, uint32_t* dst, size_t count) {
+#ifdef PNG_DECODER_X86
+    static const bool ssse3 = __builtin_cpu_supports("ssse3");
+    if (ssse3) {
+        rgbaToArgbSsse3(src, dst, count);
+        return;
+    }
+#endif
+    rgbaToArgbScalar(src, dst, count);
+}
+
+PngDecoder::PngDecoder(std::unique_ptr<ImageDecoder> fallback)
+    : fallback(std::move(fallback)) {
+    zsReady = inflateInit(&zs) == Z_OK;
+}
+
+PngDecoder::~PngDecoder() {
+    if (zsReady) {
+        inflateEnd(&zs);
+    }
+}
+
+bool PngDecoder::decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) {
+    Result result = decodePng(data, size, image, pixels);
+    if (result == Result::Ok) {
+        return true;
+    }
+    return fallback && fallback->decode(data, size, image, pixels);
+}
+
+PngDecoder::Result PngDecoder::decodePng(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) {
+    if (!zsReady || size < sizeof(PNG_SIGNATURE) || std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) {
+        return Result::Unsupported;
+    }
+
+    int width = 0, height = 0, bitDepth = 0, colorType = -1;
+    int channels = 0;
+    size_t rowBytes = 0;
+    uint8_t palette[256][4] = {};
+    int paletteSize = 0;
+    bool hasTransparency = false;
+    uint16_t transparentKey[3] = { 0, 0, 0 }; // Gray or RGB color key from tRNS
+    bool headerSeen = false;
+    bool done = false;
+
+    inflateReset(&zs);
+
+    // Chunk CRCs are not verified; zlib's adler32 still catches corrupt image data
+    size_t pos = sizeof(PNG_SIGNATURE);
+    while (pos + 12 <= size && !done) {
+        uint32_t length = readBE32(data + pos);
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* body = data + pos + 8;
+        if (length > size - pos - 12) {
+            return Result::Corrupt;
+        }
+        pos += 12 + static_cast<size_t>(length);
+
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            if (length != 13) {
+                return Result::Corrupt;
+            }
+            width = static_cast<int>(readBE32(body));
+            height = static_cast<int>(readBE32(body + 4));
+            bitDepth = body[8];
+            colorType = body[9];
+            int interlace = body[12];
+            if (width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+                return Result::Corrupt;
+            }
+            if (interlace != 0) {
+                return Result::Unsupported;
+            }
+            switch (colorType) {
+            case COLOR_GRAY:       channels = 1; break;
+            case COLOR_RGB:        channels = 3; break;
+            case COLOR_PALETTE:    channels = 1; break;
+            case COLOR_GRAY_ALPHA: channels = 2; break;
+            case COLOR_RGBA:       channels = 4; break;
+            default: return Result::Corrupt;
+            }
+            bool paletteDepth = colorType == COLOR_PALETTE &&
+                                (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8);
+            if (!paletteDepth && bitDepth != 8) {
+                return Result::Unsupported; // 16-bit and low-depth gray
+            }
+            rowBytes = (static_cast<size_t>(width) * channels * bitDepth + 7) / 8;
+            filtered.resize((rowBytes + 1) * height);
+            zs.next_out = filtered.data();
+            zs.avail_out = static_cast<uInt>(filtered.size());
+            headerSeen = true;
+        } else if (!headerSeen) {
+            return Result::Corrupt;
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            if (length % 3 != 0 || length / 3 > 256) {
+                return Result::Corrupt;
+            }
+            paletteSize = static_cast<int>(length / 3);
+            for (int i = 0; i < paletteSize; ++i) {
+                palette[i][0] = body[i * 3];
+                palette[i][1] = body[i * 3 + 1];
+                palette[i][2] = body[i * 3 + 2];
+                palette[i][3] = 255;
+            }
+        } else if (std::memcmp(type, "tRNS", 4) == 0) {
+            if (colorType == COLOR_PALETTE) {
+                for (uint32_t i = 0; i < length && i < 256; ++i) {
+                    palette[i][3] = body[i];
+                }
+                hasTransparency = true;
+            } else if (colorType == COLOR_GRAY && length >= 2) {
+                transparentKey[0] = static_cast<uint16_t>((body[0] << 8) | body[1]);
+                hasTransparency = true;
+            } else if (colorType == COLOR_RGB && length >= 6) {
+                for (int c = 0; c < 3; ++c) {
+                    transparentKey[c] = static_cast<uint16_t>((body[c * 2] << 8) | body[c * 2 + 1]);
+                }
+                hasTransparency = true;
+            }
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            zs.next_in = const_cast<Bytef*>(body);
+            zs.avail_in = length;
+            while (zs.avail_in > 0) {
+                int ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret == Z_STREAM_END) {
+                    break;
+                }
+                if (ret != Z_OK) {
+                    return Result::Corrupt;
+                }
+                if (zs.avail_out == 0) {
+                    break; // Trailing data beyond the image is ignored
+                }
+            }
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            done = true;
+        }
+    }
+
+    if (!headerSeen || zs.avail_out != 0) {
+        return Result::Corrupt; // Truncated image data
+    }
+    if (colorType == COLOR_PALETTE && paletteSize == 0) {
+        return Result::Corrupt;
+    }
+
+    // Unfilter in place; each row's prior is the previous unfiltered row
+    int filterBpp = std::max(1, channels * bitDepth / 8);
+    zeroRow.assign(rowBytes, 0);
+    const uint8_t* prior = zeroRow.data();
+    for (int y = 0; y < height; ++y) {
+        uint8_t* line = filtered.data() + (rowBytes + 1) * y;
+        if (!PngUnfilter::unfilterRow(line[0], line + 1, prior, rowBytes, filterBpp)) {
+            return Result::Corrupt;
+        }
+        prior = line + 1;
+    }
+
+    image = DecodedImage();
+    image.width = width;
+    image.height = height;
+
+    if (colorType == COLOR_PALETTE || colorType == COLOR_GRAY) {
+        // Gray is stored as an identity palette so it stays 1 byte per pixel
+        if (colorType == COLOR_GRAY) {
+            paletteSize = 256;
+            for (int i = 0; i < 256; ++i) {
+                uint8_t alpha = (hasTransparency && transparentKey[0] == i) ? 0 : 255;
+                image.palette[i] = argb(alpha, i, i, i);
+            }
+        } else {
+            for (int i = 0; i < paletteSize; ++i) {
+                image.palette[i] = argb(palette[i][3], palette[i][0], palette[i][1], palette[i][2]);
+            }
+        }
+        image.paletteSize = paletteSize;
+        image.hasAlpha = hasTransparency;
+
+        pixels.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* src = filtered.data() + (rowBytes + 1) * y + 1;
+            uint8_t* dst = pixels.data() + static_cast<size_t>(width) * y;
+            if (bitDepth == 8) {
+                std::memcpy(dst, src, width);
+                continue;
+            }
+            // Unpack 1/2/4-bit indices, most significant bits first
+            int perByte = 8 / bitDepth;
+            uint8_t mask = static_cast<uint8_t>((1 << bitDepth) - 1);
+            for (int x = 0; x < width; ++x) {
+                int shift = 8 - bitDepth * (x % perByte + 1);
+                dst[x] = (src[x / perByte] >> shift) & mask;
+            }
+        }
+        return Result::Ok;
+    }
+
+    image.hasAlpha = colorType == COLOR_RGBA || colorType == COLOR_GRAY_ALPHA || hasTransparency;
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = filtered.data() + (rowBytes + 1) * y + 1;
+        uint32_t* dst = reinterpret_cast<uint32_t*>(pixels.data()) + static_cast<size_t>(width) * y;
+        if (colorType == COLOR_RGBA) {
+            rgbaToArgb(src, dst, width);
+        } else if (colorType == COLOR_RGB) {
+            for (int x = 0; x < width; ++x, src += 3) {
+                bool keyed = hasTransparency && src[0] == transparentKey[0] &&
+                             src[1] == transparentKey[1] && src[2] == transparentKey[2];
+                dst[x] = argb(keyed ? 0 : 255, src[0], src[1], src[2]);
+            }
+        } else {
+            for (int x = 0; x < width; ++x, src += 2) {
+                dst[x] = argb(src[1], src[0], src[0], src[0]);
+            }
+        }
+    }
+    return Result::Ok;
+}
@@ -0,0 +1,32 @@
+// src/Decoding/PngDecoder.h
+#ifndef PNGDECODER_H
+#define PNGDECODER_H
+
+#include <memory>
+#include <zlib.h>
+#include "ImageDecoder.h"
+
+// Built-in PNG decoder for the formats tile servers actually serve:
+// 8-bit RGB/RGBA/gray and 1-8 bit palette, non-interlaced. Inflates with
+// a reused zlib stream and unfilters with SIMD kernels. Anything else is
+// handed to the fallback decoder.
+class PngDecoder : public ImageDecoder {
+public:
+    explicit PngDecoder(std::unique_ptr<ImageDecoder> fallback = nullptr);
+    ~PngDecoder() override;
+
+    bool decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) override;
+    const char* name() const override { return "native"; }
+
+private:
+    std::unique_ptr<ImageDecoder> fallback;
+    z_stream zs{};
+    bool zsReady = false;
+    ByteBuffer filtered;  // Inflated scanlines, each prefixed by its filter byte
+    ByteBuffer zeroRow;   // Prior row for the first scanline
+
+    enum class Result { Ok, Unsupported, Corrupt };
+    Result decodePng(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels);
+};
+
+#endif // PNGDECODER_H
@@ -0,0 +1,202 @@
+// src/Decoding/PngUnfilter.cpp
+#include "PngUnfilter.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PNG_UNFILTER_X86 1
+#endif
+
+namespace PngUnfilter {
+
+enum FilterType : uint8_t {
+    FILTER_NONE = 0,
+    FILTER_SUB = 1,
+    FILTER_UP = 2,
+    FILTER_AVG = 3,
+    FILTER_PAETH = 4
+};
+
+static inline uint8_t paethPredictor(int a, int b, int c) {
+    int pa = std::abs(b - c);
+    int pb = std::abs(a - c);
+    int pc = std::abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<uint8_t>(a);
+    }
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+static void unfilterScalar(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+    switch (filter) {
+    case FILTER_SUB:
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + row[i - bpp]);
+        }
+        break;
+    case FILTER_UP:
+        for (size_t i = 0; i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+        }
+        break;
+    case FILTER_AVG:
+        for (size_t i = 0; i < bpp && i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + (prior[i] >> 1));
+        }
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+        }
+        break;
+    case FILTER_PAETH:
+        for (size_t i = 0; i < bpp && i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+        }
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(row[i] + paethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+#ifdef PNG_UNFILTER_X86
+// Sub, Avg and Paeth depend on the pixel to the left, so the SIMD kernels
+// work one whole pixel (3 or 4 bytes) per step instead of one byte.
+static inline __m128i loadPixel(const uint8_t* p, size_t bpp) {
+    uint32_t v = 0;
+    std::memcpy(&v, p, bpp);
+    return _mm_cvtsi32_si128(static_cast<int>(v));
+}
+
+static inline void storePixel(uint8_t* p, __m128i v, size_t bpp) {
+    uint32_t out = static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+    std::memcpy(p, &out, bpp);
+}
+
+static void unfilterSubSse(uint8_t* row, size_t rowBytes, size_t bpp) {
+    __m128i a = _mm_setzero_si128();
+    for (size_t i = 0; i < rowBytes; i += bpp) {
+        a = _mm_add_epi8(loadPixel(row + i, bpp), a);
+        storePixel(row + i, a, bpp);
+    }
+}
+
+static void unfilterAvgSse(uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+    const __m128i ones = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    for (size_t i = 0; i < rowBytes; i += bpp) {
+        __m128i b = loadPixel(prior + i, bpp);
+        // avg_epu8 rounds up; subtract the carry bit to get floor((a + b) / 2)
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+        a = _mm_add_epi8(loadPixel(row + i, bpp), avg);
+        storePixel(row + i, a, bpp);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void unfilterPaethSse41(uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero; // 16-bit lanes
+    __m128i c = zero;
+    for (size_t i = 0; i < rowBytes; i += bpp) {
+        __m128i b = _mm_unpacklo_epi8(loadPixel(prior + i, bpp), zero);
+        __m128i pa = _mm_sub_epi16(b, c);   // p - a
+        __m128i pb = _mm_sub_epi16(a, c);   // p - b
+        __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+        pa = _mm_abs_epi16(pa);
+        pb = _mm_abs_epi16(pb);
+        __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+        __m128i nearest = _mm_blendv_epi8(c, b, _mm_cmpeq_epi16(smallest, pb));
+        nearest = _mm_blendv_epi8(nearest, a, _mm_cmpeq_epi16(smallest, pa));
+
+        __m128i out = _mm_add_epi8(loadPixel(row + i, bpp), _mm_packus_epi16(nearest, zero));
+        storePixel(row + i, out, bpp);
+        a = _mm_unpacklo_epi8(out, zero);
+        c = b;
+    }
+}
+
+static size_t unfilterUpSse2(uint8_t* row, const uint8_t* prior, size_t rowBytes) {
+    size_t i = 0;
+    for (; i + 16 <= rowBytes; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_add_epi8(x, b));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t unfilterUpAvx2(uint8_t* row, const uint8_t* prior, size_t rowBytes) {
+    size_t i = 0;
+    for (; i + 32 <= rowBytes; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prior + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), _mm256_add_epi8(x, b));
+    }
+    return i + unfilterUpSse2(row + i, prior + i, rowBytes - i);
+}
+
+static bool hasSse41() {
+    static const bool supported = __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+
+static bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+bool unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t rowBytes, int bpp) {
+    if (filter > FILTER_PAETH) {
+        return false;
+    }
+    if (filter == FILTER_NONE) {
+        return true;
+    }
+    size_t pixelBytes = static_cast<size_t>(bpp);
+
+#ifdef PNG_UNFILTER_X86
+    if (filter == FILTER_UP) {
+        size_t done = hasAvx2() ? unfilterUpAvx2(row, prior, rowBytes) : unfilterUpSse2(row, prior, rowBytes);
+        unfilterScalar(FILTER_UP, row + done, prior + done, rowBytes - done, pixelBytes);
+        return true;
+    }
+    // Palette and grayscale rows (bpp 1-2) have no useful pixel parallelism
+    if ((bpp == 3 || bpp == 4) && rowBytes % pixelBytes == 0) {
+        if (filter == FILTER_SUB) {
+            unfilterSubSse(row, rowBytes, pixelBytes);
+            return true;
+        }
+        if (filter == FILTER_AVG) {
+            unfilterAvgSse(row, prior, rowBytes, pixelBytes);
+            return true;
+        }
+        if (hasSse41()) {
+            unfilterPaethSse41(row, prior, rowBytes, pixelBytes);
+            return true;
+        }
+    }
+#endif
+
+    unfilterScalar(filter, row, prior, rowBytes, pixelBytes);
+    return true;
+}
+
+const char* simdLevel() {
+#ifdef PNG_UNFILTER_X86
+    if (hasAvx2()) {
+        return "avx2";
+    }
+    if (hasSse41()) {
+        return "sse4.1";
+    }
+#endif
+    return "scalar";
+}
+
+} // namespace PngUnfilter
@@ -0,0 +1,21 @@
+// src/Decoding/PngUnfilter.h
+#ifndef PNGUNFILTER_H
+#define PNGUNFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PngUnfilter {
+
+// Reverses a PNG scanline filter in place. prior is the previous
+// unfiltered row (all zeros for the first row); bpp is the filter's byte
+// distance (bytes per complete pixel, at least 1). Returns false for an
+// unknown filter type.
+bool unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t rowBytes, int bpp);
+
+// "avx2", "sse4.1" or "scalar": the best kernel set this CPU runs
+const char* simdLevel();
+
+} // namespace PngUnfilter
+
+#endif // PNGUNFILTER_H
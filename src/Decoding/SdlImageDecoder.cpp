@@ -0,0 +1,71 @@
+// src/Decoding/SdlImageDecoder.cpp
+#include "SdlImageDecoder.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstring>
+
+// Copies surface rows into a tightly packed buffer
+static void copyRows(SDL_Surface* surface, size_t rowBytes, ByteBuffer& pixels) {
+    pixels.resize(rowBytes * surface->h);
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; ++y) {
+        std::memcpy(pixels.data() + rowBytes * y,
+                    static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch,
+                    rowBytes);
+    }
+    SDL_UnlockSurface(surface);
+}
+
+bool SdlImageDecoder::decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) {
+    SDL_RWops* rw = SDL_RWFromConstMem(data, static_cast<int>(size));
+    SDL_Surface* surface = rw ? IMG_Load_RW(rw, 1 /* close rw */) : nullptr;
+    if (!surface) {
+        return false;
+    }
+
+    image = DecodedImage();
+    image.width = surface->w;
+    image.height = surface->h;
+    image.hasAlpha = surface->format->Amask != 0;
+
+    if (surface->format->BytesPerPixel == 1 && surface->format->palette) {
+        const SDL_Palette* sdlPalette = surface->format->palette;
+        image.paletteSize = std::max(1, std::min(sdlPalette->ncolors, 256));
+        for (int i = 0; i < image.paletteSize && i < sdlPalette->ncolors; ++i) {
+            const SDL_Color& c = sdlPalette->colors[i];
+            image.palette[i] = (Uint32(c.a) << 24) | (Uint32(c.r) << 16) | (Uint32(c.g) << 8) | Uint32(c.b);
+            image.hasAlpha = image.hasAlpha || c.a != 255;
+        }
+        copyRows(surface, image.pitch(), pixels);
+        SDL_FreeSurface(surface);
+        return true;
+    }
+
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surface);
+    if (!argb) {
+        return false;
+    }
+    copyRows(argb, image.pitch(), pixels);
+    SDL_FreeSurface(argb);
+    return true;
+}
+
+void SdlImageDecoder::install() {
+    // Only formats whose SDL_image loaders were initialized
+    int initialized = IMG_Init(0);
+    std::vector<TileFormat> formats;
+    if (initialized & IMG_INIT_PNG) {
+        formats.push_back(TileFormat::Png);
+    }
+    if (initialized & IMG_INIT_JPG) {
+        formats.push_back(TileFormat::Jpeg);
+    }
+    if (initialized & IMG_INIT_WEBP) {
+        formats.push_back(TileFormat::WebP);
+    }
+    ImageDecoder::setFallbackFactory([]() -> std::unique_ptr<ImageDecoder> {
+        return std::make_unique<SdlImageDecoder>();
+    }, formats);
+}
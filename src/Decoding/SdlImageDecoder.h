@@ -0,0 +1,19 @@
+// src/Decoding/SdlImageDecoder.h
+#ifndef SDLIMAGEDECODER_H
+#define SDLIMAGEDECODER_H
+
+#include "ImageDecoder.h"
+
+// Reference backend: decodes any format SDL_image was initialized with,
+// then copies the surface into the caller's buffer.
+class SdlImageDecoder : public ImageDecoder {
+public:
+    bool decode(const uint8_t* data, size_t size, DecodedImage& image, ByteBuffer& pixels) override;
+    const char* name() const override { return "sdl_image"; }
+
+    // Makes SDL_image the backend ImageDecoder::create falls back to.
+    // Call once after IMG_Init, before decoding threads start.
+    static void install();
+};
+
+#endif // SDLIMAGEDECODER_H
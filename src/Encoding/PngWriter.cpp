@@ -0,0 +1,141 @@
+// src/Encoding/PngWriter.cpp
+#include "PngWriter.h"
+#include <cstring>
+
+// IDAT chunks are emitted once this much compressed data is pending
+static const size_t IDAT_CHUNK_BYTES = 64 * 1024;
+
+static void putBigEndian(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+PngWriter::PngWriter(Sink sink, int width, int height, bool withAlpha, int level)
+    : sink(std::move(sink)), width(width), height(height), withAlpha(withAlpha) {
+    size_t rowBytes = static_cast<size_t>(width) * (withAlpha ? 4 : 3);
+    row.resize(rowBytes + 1);
+    prior.assign(rowBytes, 0);
+    current.resize(rowBytes);
+
+    if (deflateInit(&zs, level) != Z_OK) {
+        failed = true;
+        return;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint8_t header[13];
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8;                      // Bit depth
+    header[9] = withAlpha ? 6 : 2;      // Color type: RGBA or RGB
+    header[10] = 0;                     // Deflate
+    header[11] = 0;                     // Adaptive filtering
+    header[12] = 0;                     // Not interlaced
+    failed = !this->sink(signature, sizeof(signature)) || !writeChunk("IHDR", header, sizeof(header));
+}
+
+PngWriter::~PngWriter() {
+    deflateEnd(&zs);
+}
+
+bool PngWriter::writeChunk(const char type[4], const uint8_t* data, size_t size) {
+    uint8_t head[8];
+    putBigEndian(head, static_cast<uint32_t>(size));
+    std::memcpy(head + 4, type, 4);
+    uLong crc = crc32(0, head + 4, 4);
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size)); // crc32 of a null buffer resets to 0
+    }
+    uint8_t tail[4];
+    putBigEndian(tail, static_cast<uint32_t>(crc));
+    return sink(head, sizeof(head)) && (size == 0 || sink(data, size)) && sink(tail, sizeof(tail));
+}
+
+bool PngWriter::deflateInto(int flush) {
+    uint8_t out[16384];
+    do {
+        zs.next_out = out;
+        zs.avail_out = sizeof(out);
+        int ret = deflate(&zs, flush);
+        if (ret == Z_STREAM_ERROR) {
+            return false;
+        }
+        idat.insert(idat.end(), out, out + (sizeof(out) - zs.avail_out));
+        if (idat.size() >= IDAT_CHUNK_BYTES) {
+            if (!writeChunk("IDAT", idat.data(), idat.size())) {
+                return false;
+            }
+            idat.clear();
+        }
+    } while (zs.avail_out == 0);
+    return true;
+}
+
+bool PngWriter::writeRows(const uint32_t* argb, int rows, size_t pitch) {
+    const int channels = withAlpha ? 4 : 3;
+    for (int r = 0; r < rows && !failed; ++r, argb += pitch) {
+        if (rowsWritten >= height) {
+            failed = true;
+            break;
+        }
+        uint8_t* samples = current.data();
+        for (int x = 0; x < width; ++x) {
+            uint32_t p = argb[x];
+            samples[0] = static_cast<uint8_t>(p >> 16);
+            samples[1] = static_cast<uint8_t>(p >> 8);
+            samples[2] = static_cast<uint8_t>(p);
+            if (withAlpha) {
+                samples[3] = static_cast<uint8_t>(p >> 24);
+            }
+            samples += channels;
+        }
+
+        // Up filter: cheap, and map images repeat a lot vertically
+        row[0] = 2;
+        for (size_t i = 0; i < current.size(); ++i) {
+            row[i + 1] = static_cast<uint8_t>(current[i] - prior[i]);
+        }
+        current.swap(prior);
+
+        zs.next_in = row.data();
+        zs.avail_in = static_cast<uInt>(row.size());
+        failed = !deflateInto(Z_NO_FLUSH);
+        rowsWritten++;
+    }
+    return !failed;
+}
+
+bool PngWriter::finish() {
+    if (failed || rowsWritten != height) {
+        return false;
+    }
+    zs.next_in = nullptr;
+    zs.avail_in = 0;
+    int ret;
+    do {
+        uint8_t out[16384];
+        zs.next_out = out;
+        zs.avail_out = sizeof(out);
+        ret = deflate(&zs, Z_FINISH);
+        if (ret == Z_STREAM_ERROR) {
+            return false;
+        }
+        idat.insert(idat.end(), out, out + (sizeof(out) - zs.avail_out));
+    } while (ret != Z_STREAM_END);
+
+    failed = (!idat.empty() && !writeChunk("IDAT", idat.data(), idat.size())) || !writeChunk("IEND", nullptr, 0);
+    idat.clear();
+    return !failed;
+}
+
+bool PngWriter::encode(const uint32_t* argb, int width, int height, size_t pitch, bool withAlpha,
+                       ByteBuffer& out, int level) {
+    out.clear();
+    PngWriter writer([&out](const uint8_t* data, size_t size) {
+        out.insert(out.end(), data, data + size);
+        return true;
+    }, width, height, withAlpha, level);
+    return writer.writeRows(argb, height, pitch) && writer.finish();
+}
@@ -0,0 +1,52 @@
+// src/Encoding/PngWriter.h
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <cstdint>
+#include <functional>
+#include <zlib.h>
+#include "../Utils/BufferPool.h"
+
+// Streaming PNG encoder for rendered maps: 8-bit RGB or RGBA, rows taken
+// from ARGB8888 pixels. Compressed data is handed to the sink in IDAT
+// chunks as it is produced, so images of any height can be written with
+// one row band in memory.
+class PngWriter {
+public:
+    // The sink receives the file bytes in order; returning false aborts
+    using Sink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    PngWriter(Sink sink, int width, int height, bool withAlpha, int level = 6);
+    ~PngWriter();
+
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    // Appends rows top to bottom; pitch is in pixels
+    bool writeRows(const uint32_t* argb, int rows, size_t pitch);
+
+    // Ends the stream once all rows are written
+    bool finish();
+
+    // Encodes a whole image into memory
+    static bool encode(const uint32_t* argb, int width, int height, size_t pitch, bool withAlpha,
+                       ByteBuffer& out, int level = 6);
+
+private:
+    Sink sink;
+    int width;
+    int height;
+    bool withAlpha;
+    int rowsWritten = 0;
+    bool failed = false;
+    z_stream zs{};
+    ByteBuffer row;       // Filter byte + filtered samples
+    ByteBuffer prior;     // Unfiltered samples of the previous row
+    ByteBuffer current;   // Unfiltered samples of this row
+    ByteBuffer idat;      // Compressed bytes not yet emitted
+
+    bool writeChunk(const char type[4], const uint8_t* data, size_t size);
+    bool deflateInto(int flush);
+};
+
+#endif // PNGWRITER_H
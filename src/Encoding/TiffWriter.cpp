@@ -0,0 +1,169 @@
+// src/Encoding/TiffWriter.cpp
+#include "TiffWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+// Field types and tags used in the directory
+enum : uint16_t { TYPE_SHORT = 3, TYPE_LONG = 4, TYPE_LONG8 = 16 };
+enum : uint16_t {
+    TAG_IMAGE_WIDTH = 256,
+    TAG_IMAGE_LENGTH = 257,
+    TAG_BITS_PER_SAMPLE = 258,
+    TAG_COMPRESSION = 259,
+    TAG_PHOTOMETRIC = 262,
+    TAG_STRIP_OFFSETS = 273,
+    TAG_SAMPLES_PER_PIXEL = 277,
+    TAG_ROWS_PER_STRIP = 278,
+    TAG_STRIP_BYTE_COUNTS = 279,
+    TAG_PLANAR_CONFIG = 284,
+    TAG_PREDICTOR = 317,
+    TAG_EXTRA_SAMPLES = 338
+};
+static const uint16_t COMPRESSION_DEFLATE = 8;
+static const uint16_t PHOTOMETRIC_RGB = 2;
+static const uint16_t PREDICTOR_HORIZONTAL = 2;
+static const uint16_t EXTRA_SAMPLE_UNASSOCIATED_ALPHA = 2;
+
+// Byte offset of the first-directory pointer in the BigTIFF header
+static const uint64_t FIRST_IFD_POINTER = 8;
+
+TiffWriter::TiffWriter(const std::string& path, int width, int height, bool withAlpha,
+                       int rowsPerStrip, int level)
+    : file(path, std::ios::binary | std::ios::trunc), width(width), height(height), withAlpha(withAlpha),
+      rowsPerStrip(std::max(1, rowsPerStrip)), level(level) {
+    // Little endian, version 43 (BigTIFF), 8-byte offsets; directory offset patched in finish()
+    uint8_t header[16] = { 'I', 'I', 43, 0, 8, 0, 0, 0 };
+    failed = !file || !write(header, sizeof(header));
+}
+
+bool TiffWriter::write(const void* data, size_t size) {
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    fileOffset += size;
+    return static_cast<bool>(file);
+}
+
+bool TiffWriter::flushStrip() {
+    if (strip.empty()) {
+        return true;
+    }
+    uLongf size = compressBound(static_cast<uLong>(strip.size()));
+    compressed.resize(size);
+    if (compress2(compressed.data(), &size, strip.data(), static_cast<uLong>(strip.size()), level) != Z_OK) {
+        return false;
+    }
+    stripOffsets.push_back(fileOffset);
+    stripByteCounts.push_back(size);
+    strip.clear();
+    return write(compressed.data(), size);
+}
+
+bool TiffWriter::writeRows(const uint32_t* argb, int rows, size_t pitch) {
+    const int channels = withAlpha ? 4 : 3;
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    for (int r = 0; r < rows && !failed; ++r, argb += pitch) {
+        if (rowsWritten >= height) {
+            failed = true;
+            break;
+        }
+        size_t start = strip.size();
+        strip.resize(start + rowBytes);
+        uint8_t* samples = strip.data() + start;
+
+        // Horizontal predictor: each sample minus the same channel one pixel left
+        uint32_t previous = 0;
+        for (int x = 0; x < width; ++x) {
+            uint32_t p = argb[x];
+            samples[0] = static_cast<uint8_t>((p >> 16) - (previous >> 16));
+            samples[1] = static_cast<uint8_t>((p >> 8) - (previous >> 8));
+            samples[2] = static_cast<uint8_t>(p - previous);
+            if (withAlpha) {
+                samples[3] = static_cast<uint8_t>((p >> 24) - (previous >> 24));
+            }
+            previous = p;
+            samples += channels;
+        }
+        rowsWritten++;
+
+        if (rowsWritten % rowsPerStrip == 0) {
+            failed = !flushStrip();
+        }
+    }
+    return !failed;
+}
+
+bool TiffWriter::finish() {
+    if (failed || rowsWritten != height || !flushStrip()) {
+        failed = true;
+        return false;
+    }
+
+    const uint16_t channels = withAlpha ? 4 : 3;
+    ByteBuffer directory;
+    auto put = [&directory](uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            directory.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    };
+
+    // Arrays that do not fit in an entry's 8 value bytes follow the directory
+    uint64_t directoryOffset = fileOffset + (fileOffset & 1); // Word aligned
+    const int entryCount = withAlpha ? 12 : 11;
+    uint64_t arraysOffset = directoryOffset + 8 + entryCount * 20 + 8;
+    ByteBuffer arrays;
+
+    auto entry = [&](uint16_t tag, uint16_t type, uint64_t count, const std::vector<uint64_t>& values) {
+        int size = type == TYPE_SHORT ? 2 : type == TYPE_LONG ? 4 : 8;
+        put(tag, 2);
+        put(type, 2);
+        put(count, 8);
+        if (count * size <= 8) {
+            for (uint64_t v : values) {
+                put(v, size);
+            }
+            put(0, static_cast<int>(8 - count * size));
+            return;
+        }
+        put(arraysOffset + arrays.size(), 8);
+        for (uint64_t v : values) {
+            for (int i = 0; i < size; ++i) {
+                arrays.push_back(static_cast<uint8_t>(v >> (8 * i)));
+            }
+        }
+    };
+
+    put(entryCount, 8);
+    entry(TAG_IMAGE_WIDTH, TYPE_LONG, 1, { uint64_t(width) });
+    entry(TAG_IMAGE_LENGTH, TYPE_LONG, 1, { uint64_t(height) });
+    entry(TAG_BITS_PER_SAMPLE, TYPE_SHORT, channels, std::vector<uint64_t>(channels, 8));
+    entry(TAG_COMPRESSION, TYPE_SHORT, 1, { COMPRESSION_DEFLATE });
+    entry(TAG_PHOTOMETRIC, TYPE_SHORT, 1, { PHOTOMETRIC_RGB });
+    entry(TAG_STRIP_OFFSETS, TYPE_LONG8, stripOffsets.size(), stripOffsets);
+    entry(TAG_SAMPLES_PER_PIXEL, TYPE_SHORT, 1, { channels });
+    entry(TAG_ROWS_PER_STRIP, TYPE_LONG, 1, { uint64_t(rowsPerStrip) });
+    entry(TAG_STRIP_BYTE_COUNTS, TYPE_LONG8, stripByteCounts.size(), stripByteCounts);
+    entry(TAG_PLANAR_CONFIG, TYPE_SHORT, 1, { 1 });
+    entry(TAG_PREDICTOR, TYPE_SHORT, 1, { PREDICTOR_HORIZONTAL });
+    if (withAlpha) {
+        entry(TAG_EXTRA_SAMPLES, TYPE_SHORT, 1, { EXTRA_SAMPLE_UNASSOCIATED_ALPHA });
+    }
+    put(0, 8); // No further directories
+
+    uint8_t pad = 0;
+    if (directoryOffset != fileOffset && !write(&pad, 1)) {
+        return false;
+    }
+    if (!write(directory.data(), directory.size()) || !write(arrays.data(), arrays.size())) {
+        return false;
+    }
+
+    uint8_t pointer[8];
+    for (int i = 0; i < 8; ++i) {
+        pointer[i] = static_cast<uint8_t>(directoryOffset >> (8 * i));
+    }
+    file.seekp(static_cast<std::streamoff>(FIRST_IFD_POINTER));
+    file.write(reinterpret_cast<const char*>(pointer), sizeof(pointer));
+    file.close();
+    failed = !file;
+    return !failed;
+}
@@ -0,0 +1,49 @@
+// src/Encoding/TiffWriter.h
+#ifndef TIFFWRITER_H
+#define TIFFWRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../Utils/BufferPool.h"
+
+// Streaming BigTIFF encoder for rendered maps: 8-bit RGB or RGBA, rows
+// taken from ARGB8888 pixels. Rows are grouped into deflate-compressed
+// strips (horizontal predictor) written as soon as they are complete; the
+// directory goes at the end of the file. BigTIFF's 64-bit offsets allow
+// files past 4 GB.
+class TiffWriter {
+public:
+    TiffWriter(const std::string& path, int width, int height, bool withAlpha,
+               int rowsPerStrip = 16, int level = 6);
+
+    TiffWriter(const TiffWriter&) = delete;
+    TiffWriter& operator=(const TiffWriter&) = delete;
+
+    // Appends rows top to bottom; pitch is in pixels
+    bool writeRows(const uint32_t* argb, int rows, size_t pitch);
+
+    // Writes the directory once all rows are written
+    bool finish();
+
+private:
+    std::ofstream file;
+    int width;
+    int height;
+    bool withAlpha;
+    int rowsPerStrip;
+    int level;
+    int rowsWritten = 0;
+    bool failed = false;
+    uint64_t fileOffset = 0;
+    ByteBuffer strip;         // Predicted samples of the strip being filled
+    ByteBuffer compressed;
+    std::vector<uint64_t> stripOffsets;
+    std::vector<uint64_t> stripByteCounts;
+
+    bool write(const void* data, size_t size);
+    bool flushStrip();
+};
+
+#endif // TIFFWRITER_H
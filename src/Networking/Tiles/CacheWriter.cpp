@@ -0,0 +1,108 @@
+// src/Networking/Tiles/CacheWriter.cpp
+#include "CacheWriter.h"
+#include "../../Utils/Log.h"
+#include "../../Utils/Trace.h"
+#include "../../Utils/Utils.h"
+
+CacheWriter::CacheWriter(const std::filesystem::path& blobRoot, size_t maxBatch,
+                         std::chrono::milliseconds maxDelay)
+    : maxBatch(maxBatch), maxDelay(maxDelay), ioEngine(IoEngine::create()), blobStore(blobRoot)
+{
+    Utils::logInfo(std::string("CacheWriter using ") + ioEngine->name() + " I/O engine");
+    worker = std::thread(&CacheWriter::run, this);
+}
+
+CacheWriter::~CacheWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    workAvailable.notify_all();
+    worker.join();
+}
+
+void CacheWriter::enqueue(const std::filesystem::path& path, std::shared_ptr<const ByteBuffer> data,
+                          const ContentHash& hash, StoredCallback onStored) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({path, std::move(data), hash});
+        callbacks.push_back(std::move(onStored));
+        pendingPaths[path.string()]++;
+    }
+    workAvailable.notify_one();
+}
+
+bool CacheWriter::isPending(const std::filesystem::path& path) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pendingPaths.find(path.string()) != pendingPaths.end();
+}
+
+void CacheWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    batchDone.wait(lock, [this] { return queue.empty() && writesInFlight == 0; });
+}
+
+void CacheWriter::run() {
+    Log::setThreadName("cache writer");
+    Trace::setThreadName("cache writer");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        workAvailable.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) {
+            return; // stop requested and nothing left to write
+        }
+
+        // Give the batch a short window to fill up before writing it
+        if (!stop && queue.size() < maxBatch) {
+            workAvailable.wait_for(lock, maxDelay, [this] { return stop || queue.size() >= maxBatch; });
+        }
+
+        std::vector<WriteRequest> batch;
+        std::vector<StoredCallback> batchCallbacks;
+        batch.swap(queue);
+        batchCallbacks.swap(callbacks);
+        writesInFlight = batch.size();
+        lock.unlock();
+
+        std::vector<bool> results = writeBatch(batch);
+        for (size_t i = 0; i < batchCallbacks.size(); ++i) {
+            if (batchCallbacks[i]) {
+                batchCallbacks[i](results[i]);
+            }
+        }
+
+        // The batch's files are in place now; a path stays pending while a
+        // later write of it is still queued
+        lock.lock();
+        for (const auto& request : batch) {
+            auto it = pendingPaths.find(request.tilePath.string());
+            if (it != pendingPaths.end() && --it->second == 0) {
+                pendingPaths.erase(it);
+            }
+        }
+        writesInFlight = 0;
+        batchDone.notify_all();
+    }
+}
+
+std::vector<bool> CacheWriter::writeBatch(std::vector<WriteRequest>& batch) {
+    Trace::Scope span("write batch", "disk");
+    span.setValue(static_cast<int64_t>(batch.size()));
+
+    std::unordered_set<std::string> createdDirs;
+    for (const WriteRequest& request : batch) {
+        std::filesystem::path dir = request.tilePath.parent_path();
+        if (createdDirs.insert(dir.string()).second) {
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+        }
+    }
+
+    std::vector<bool> results = blobStore.storeBatch(batch, *ioEngine);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i]) {
+            Utils::logError("Failed to store tile in cache: " + batch[i].tilePath.string());
+        }
+    }
+    return results;
+}
@@ -0,0 +1,68 @@
+// src/Networking/Tiles/CacheWriter.h
+#ifndef CACHEWRITER_H
+#define CACHEWRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../../Utils/BufferPool.h"
+#include "../../Storage/IoEngine.h"
+#include "../../Storage/BlobStore.h"
+
+// Persists downloaded tiles to the disk cache on a background thread.
+// Writes are grouped into batches and handed to the BlobStore in one go:
+// identical tiles share one blob, new blobs are written through the
+// IoEngine via a .tmp sibling and renamed into place, so readers never see
+// partially written tiles.
+class CacheWriter {
+public:
+    CacheWriter(const std::filesystem::path& blobRoot = "resources/tiles/blobs",
+                size_t maxBatch = 32,
+                std::chrono::milliseconds maxDelay = std::chrono::milliseconds(50));
+    ~CacheWriter(); // Flushes outstanding writes
+
+    // Called on the writer thread once the tile is on disk (or failed)
+    using StoredCallback = std::function<void(bool stored)>;
+
+    // Queues data to be written to path; the buffer is shared, not copied
+    void enqueue(const std::filesystem::path& path, std::shared_ptr<const ByteBuffer> data,
+                 const ContentHash& hash, StoredCallback onStored = nullptr);
+
+    // True while path is queued or being written
+    bool isPending(const std::filesystem::path& path) const;
+
+    // Blocks until everything queued so far is on disk
+    void flush();
+
+private:
+    using WriteRequest = BlobStore::StoreOp;
+
+    size_t maxBatch;
+    std::chrono::milliseconds maxDelay;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable batchDone;
+    std::vector<WriteRequest> queue;
+    std::vector<StoredCallback> callbacks; // Parallel to queue
+    // Queued or in-flight writes per path; a path can be queued again while
+    // an earlier write of it is still in flight
+    std::unordered_map<std::string, size_t> pendingPaths;
+    size_t writesInFlight = 0;
+    bool stop = false;
+
+    std::unique_ptr<IoEngine> ioEngine;
+    BlobStore blobStore;
+    std::thread worker;
+
+    void run();
+    std::vector<bool> writeBatch(std::vector<WriteRequest>& batch);
+};
+
+#endif // CACHEWRITER_H
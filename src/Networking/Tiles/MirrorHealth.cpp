@@ -0,0 +1,140 @@
+// src/Networking/Tiles/MirrorHealth.cpp
+#include "MirrorHealth.h"
+#include "../../Utils/Utils.h"
+#include <algorithm>
+
+static const double EWMA_ALPHA = 0.2;
+static const auto DEFAULT_HEDGE_DELAY = std::chrono::milliseconds(1000);
+static const auto MIN_HEDGE_DELAY = std::chrono::milliseconds(50);
+static const auto BASE_DEMOTION = std::chrono::seconds(10);
+static const auto MAX_DEMOTION = std::chrono::seconds(300);
+
+MirrorHealth::MirrorHealth(size_t numMirrors)
+    : mirrors(numMirrors)
+{
+    latencies.reserve(LATENCY_WINDOW);
+}
+
+void MirrorHealth::recordSuccess(size_t mirror, double latencyMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mirror >= mirrors.size()) {
+        return;
+    }
+    mirrors[mirror].consecutiveFailures = 0;
+    recordLatencyLocked(mirror, latencyMs, false);
+}
+
+void MirrorHealth::recordCancelled(size_t mirror, double elapsedMs, double winnerLatencyMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // An unmeasured (or just demoted) mirror stays unmeasured: a hedge
+    // cancelled moments after it started says nothing about its speed
+    if (mirror >= mirrors.size() || mirrors[mirror].ewmaLatencyMs == 0.0) {
+        return;
+    }
+    // Never let losing a race make a mirror look faster than the winner
+    recordLatencyLocked(mirror, std::max(elapsedMs, winnerLatencyMs), true);
+}
+
+void MirrorHealth::recordFailure(size_t mirror) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mirror >= mirrors.size()) {
+        return;
+    }
+
+    MirrorState& state = mirrors[mirror];
+    state.consecutiveFailures++;
+    if (state.consecutiveFailures >= FAILURES_BEFORE_DEMOTION) {
+        Utils::logInfo("Demoting failing mirror " + std::to_string(mirror));
+        demoteLocked(state);
+        state.consecutiveFailures = 0;
+    }
+}
+
+std::vector<size_t> MirrorHealth::orderedMirrors() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<size_t> order(mirrors.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    Clock::time_point now = Clock::now();
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        bool demotedA = mirrors[a].demotedUntil > now;
+        bool demotedB = mirrors[b].demotedUntil > now;
+        if (demotedA != demotedB) {
+            return !demotedA;
+        }
+        // Unmeasured mirrors are tried first, in their configured order
+        bool measuredA = mirrors[a].ewmaLatencyMs > 0.0;
+        bool measuredB = mirrors[b].ewmaLatencyMs > 0.0;
+        if (measuredA != measuredB) {
+            return !measuredA;
+        }
+        if (!measuredA) {
+            return a < b;
+        }
+        return mirrors[a].ewmaLatencyMs < mirrors[b].ewmaLatencyMs;
+    });
+    return order;
+}
+
+std::chrono::milliseconds MirrorHealth::hedgeDelay() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latencies.size() < MIN_SAMPLES) {
+        return DEFAULT_HEDGE_DELAY;
+    }
+    auto delay = std::chrono::milliseconds(static_cast<long long>(p95Locked()));
+    return std::max(delay, MIN_HEDGE_DELAY);
+}
+
+void MirrorHealth::recordLatencyLocked(size_t mirror, double latencyMs, bool censored) {
+    // A censored sample is only a lower bound; the p95 that sets the hedge
+    // delay is built from completed requests alone
+    if (!censored) {
+        if (latencies.size() < LATENCY_WINDOW) {
+            latencies.push_back(latencyMs);
+        } else {
+            latencies[nextLatency] = latencyMs;
+        }
+        nextLatency = (nextLatency + 1) % LATENCY_WINDOW;
+    }
+
+    MirrorState& state = mirrors[mirror];
+    state.ewmaLatencyMs = (state.ewmaLatencyMs == 0.0)
+        ? latencyMs
+        : EWMA_ALPHA * latencyMs + (1.0 - EWMA_ALPHA) * state.ewmaLatencyMs;
+
+    // A mirror that is consistently much slower than the source as a whole is demoted
+    if (mirrors.size() > 1 && latencies.size() >= MIN_SAMPLES &&
+        state.ewmaLatencyMs > SLOW_FACTOR * p95Locked()) {
+        Utils::logInfo("Demoting slow mirror " + std::to_string(mirror));
+        demoteLocked(state);
+    } else if (state.demotedUntil <= Clock::now()) {
+        state.demotions = 0;
+    }
+}
+
+double MirrorHealth::p95Locked() const {
+    if (latencies.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sorted(latencies);
+    size_t idx = (sorted.size() * 95) / 100;
+    if (idx >= sorted.size()) {
+        idx = sorted.size() - 1;
+    }
+    std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+    return sorted[idx];
+}
+
+void MirrorHealth::demoteLocked(MirrorState& state) {
+    // Exponential backoff so a persistently bad mirror stays out longer
+    auto duration = BASE_DEMOTION * (1 << std::min(state.demotions, 5));
+    if (duration > MAX_DEMOTION) {
+        duration = MAX_DEMOTION;
+    }
+    state.demotedUntil = Clock::now() + duration;
+    state.demotions++;
+    state.ewmaLatencyMs = 0.0;
+}
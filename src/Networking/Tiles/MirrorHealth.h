@@ -0,0 +1,57 @@
+// src/Networking/Tiles/MirrorHealth.h
+#ifndef MIRRORHEALTH_H
+#define MIRRORHEALTH_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Tracks latency and failures for each mirror of a tile source.
+// Used to pick the primary mirror, to decide when a request should be
+// hedged (rolling p95 of the source) and to demote slow or failing mirrors.
+class MirrorHealth {
+public:
+    explicit MirrorHealth(size_t numMirrors);
+
+    void recordSuccess(size_t mirror, double latencyMs);
+    void recordFailure(size_t mirror);
+    // A request cancelled after another mirror answered first in
+    // winnerLatencyMs. Its latency is unknown, only that it lost: it counts
+    // as no faster than the winner or its own elapsed time, only for a
+    // mirror already measured, and never in the source p95.
+    void recordCancelled(size_t mirror, double elapsedMs, double winnerLatencyMs);
+
+    // Mirrors ordered best first: unmeasured mirrors in configured order,
+    // then by latency; demoted mirrors go last
+    std::vector<size_t> orderedMirrors() const;
+
+    // Delay after which a duplicate request is sent to another mirror
+    std::chrono::milliseconds hedgeDelay() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct MirrorState {
+        double ewmaLatencyMs = 0.0;
+        int consecutiveFailures = 0;
+        int demotions = 0;
+        Clock::time_point demotedUntil{};
+    };
+
+    static constexpr size_t LATENCY_WINDOW = 256;    // samples kept for p95
+    static constexpr size_t MIN_SAMPLES = 20;        // before p95 is trusted
+    static constexpr int FAILURES_BEFORE_DEMOTION = 3;
+    static constexpr double SLOW_FACTOR = 3.0;       // EWMA vs source p95
+
+    mutable std::mutex mutex;
+    std::vector<MirrorState> mirrors;
+    std::vector<double> latencies; // Ring buffer of recent successful latencies
+    size_t nextLatency = 0;
+
+    // censored: a lower bound from a cancelled request, kept out of latencies
+    void recordLatencyLocked(size_t mirror, double latencyMs, bool censored);
+    double p95Locked() const;
+    void demoteLocked(MirrorState& state);
+};
+
+#endif // MIRRORHEALTH_H
@@ -0,0 +1,372 @@
+// src/Networking/Tiles/SharedTileIndex.cpp
+#include "SharedTileIndex.h"
+#include "../../Utils/ContentHash.h"
+#include "../../Utils/Utils.h"
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static const uint32_t MAGIC = 0x43474953; // "CGIS"
+static const uint32_t VERSION = 2;
+
+// 2M slots (16 MB of address space; pages are only backed once touched)
+static const uint32_t SLOT_COUNT = 1u << 21;
+static const uint32_t FLIGHT_COUNT = 1024;
+
+// Slot layout: valid bit, 2 format bits, 5 zoom bits, 24 bits each of x and y
+static const uint64_t SLOT_VALID = 1ull << 63;
+static const int FORMAT_SHIFT = 56;
+static const uint64_t FORMAT_MASK = 3ull << FORMAT_SHIFT;
+static const int MAX_INDEXED_ZOOM = 24;
+
+// How long to wait for a creating process to finish initializing
+static const auto INIT_TIMEOUT = std::chrono::seconds(1);
+
+struct SharedTileIndex::Segment {
+    std::atomic<uint32_t> magic; // Stored last by the creating process
+    uint32_t version;
+    uint64_t dirDevice;          // Tiles directory the index describes
+    uint64_t dirInode;
+    std::atomic<uint32_t> tiles;
+    pthread_mutex_t flightMutex; // Robust and process-shared; guards users, removed and flights
+    uint32_t users;              // Processes attached
+    bool removed;                // Unlinked by the last user; joiners must create a new one
+    struct Flight {
+        uint64_t key;            // Packed tile key, 0 if free
+        int32_t pid;
+    } flights[FLIGHT_COUNT];
+    std::atomic<uint64_t> slots[SLOT_COUNT];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared slots must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared counters must be lock-free");
+
+static bool packKey(const TileKey& key, uint64_t& packed) {
+    if (key.z < 0 || key.z > MAX_INDEXED_ZOOM || key.x < 0 || key.y < 0 ||
+        key.x >= (1 << key.z) || key.y >= (1 << key.z)) {
+        return false;
+    }
+    packed = SLOT_VALID | (static_cast<uint64_t>(key.z) << 48) | (static_cast<uint64_t>(key.x) << 24) |
+             static_cast<uint64_t>(key.y);
+    return true;
+}
+
+static uint32_t slotFor(uint64_t packed) {
+    packed ^= packed >> 33;
+    packed *= 0xff51afd7ed558ccdULL;
+    packed ^= packed >> 33;
+    return static_cast<uint32_t>(packed) & (SLOT_COUNT - 1);
+}
+
+static bool processAlive(int32_t pid) {
+    return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// Locks a robust mutex, recovering it if its holder died
+static void lockRobust(pthread_mutex_t* mutex) {
+    if (pthread_mutex_lock(mutex) == EOWNERDEAD) {
+        pthread_mutex_consistent(mutex);
+    }
+}
+
+static std::string segmentNameFor(const std::filesystem::path& dir) {
+    std::string path = dir.string();
+    ContentHash hash = ContentHash::of(reinterpret_cast<const uint8_t*>(path.data()), path.size());
+    return "/customgis-tiles-" + hash.toHex().substr(0, 16);
+}
+
+std::unique_ptr<SharedTileIndex> SharedTileIndex::open(const std::filesystem::path& cacheDir) {
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    std::filesystem::path dir = std::filesystem::canonical(cacheDir, ec);
+    struct stat dirInfo;
+    if (ec || ::stat(dir.c_str(), &dirInfo) != 0) {
+        Utils::logError("Shared tile index disabled: cannot resolve " + cacheDir.string());
+        return nullptr;
+    }
+
+    std::string name = segmentNameFor(dir);
+    const size_t size = sizeof(Segment);
+
+    // Later attempts replace a segment left over from a deleted tiles
+    // directory or an older version, or one its last user just removed
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        bool created = true;
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            created = false;
+            fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0600);
+        }
+        if (fd < 0) {
+            Utils::logError("Shared tile index disabled: shm_open failed: " + std::string(std::strerror(errno)));
+            return nullptr;
+        }
+        if (created && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            Utils::logError("Shared tile index disabled: cannot size segment");
+            return nullptr;
+        }
+
+        // A joining process may see the segment before the creator sized it
+        auto deadline = std::chrono::steady_clock::now() + INIT_TIMEOUT;
+        struct stat info;
+        while (!created && ::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < size &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        void* memory = created || (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == size)
+                           ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                           : MAP_FAILED;
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            if (!created && attempt + 1 < 3) {
+                ::shm_unlink(name.c_str()); // Wrong size: another version's segment
+                continue;
+            }
+            Utils::logError("Shared tile index disabled: cannot map segment " + name);
+            return nullptr;
+        }
+        Segment* segment = static_cast<Segment*>(memory);
+
+        if (created) {
+            if (!initializeSegment(segment, dirInfo.st_dev, dirInfo.st_ino)) {
+                ::munmap(memory, size);
+                ::shm_unlink(name.c_str());
+                Utils::logError("Shared tile index disabled: cannot create process-shared locks");
+                return nullptr;
+            }
+            Utils::logInfo("Created shared tile index " + name + " for " + dir.string());
+            return std::unique_ptr<SharedTileIndex>(new SharedTileIndex(segment, size, name));
+        }
+
+        while (segment->magic.load(std::memory_order_acquire) != MAGIC &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        bool current = segment->magic.load(std::memory_order_acquire) == MAGIC && segment->version == VERSION &&
+                       segment->dirDevice == static_cast<uint64_t>(dirInfo.st_dev) &&
+                       segment->dirInode == static_cast<uint64_t>(dirInfo.st_ino);
+        if (current) {
+            lockRobust(&segment->flightMutex);
+            bool removed = segment->removed;
+            if (!removed) {
+                segment->users++;
+            }
+            pthread_mutex_unlock(&segment->flightMutex);
+            if (removed) {
+                ::munmap(memory, size); // Its last user left between our shm_open and now
+                continue;
+            }
+            Utils::logInfo("Joined shared tile index " + name + " (" + std::to_string(segment->tiles.load()) +
+                           " tiles)");
+            return std::unique_ptr<SharedTileIndex>(new SharedTileIndex(segment, size, name));
+        }
+
+        // Stale: processes still using it keep their mapping, new ones start
+        // fresh. Marked removed so its last user does not unlink the new one.
+        if (segment->magic.load(std::memory_order_acquire) == MAGIC && segment->version == VERSION) {
+            lockRobust(&segment->flightMutex);
+            segment->removed = true;
+            pthread_mutex_unlock(&segment->flightMutex);
+        }
+        ::munmap(memory, size);
+        ::shm_unlink(name.c_str());
+    }
+    Utils::logError("Shared tile index disabled: could not replace stale segment " + name);
+    return nullptr;
+}
+
+bool SharedTileIndex::initializeSegment(Segment* segment, uint64_t dirDevice, uint64_t dirInode) {
+    // The segment arrives zero-filled, which is an empty table
+    segment->version = VERSION;
+    segment->dirDevice = dirDevice;
+    segment->dirInode = dirInode;
+    segment->users = 1;
+
+    pthread_mutexattr_t mutexAttr;
+    pthread_mutexattr_init(&mutexAttr);
+    pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+    int mutexResult = pthread_mutex_init(&segment->flightMutex, &mutexAttr);
+    pthread_mutexattr_destroy(&mutexAttr);
+
+    if (mutexResult != 0) {
+        return false;
+    }
+    segment->magic.store(MAGIC, std::memory_order_release);
+    return true;
+}
+
+SharedTileIndex::SharedTileIndex(Segment* segment, size_t mappedBytes, std::string name)
+    : segment(segment), mappedBytes(mappedBytes), segmentName(std::move(name)) {}
+
+SharedTileIndex::~SharedTileIndex() {
+    // Claims still held by this process are dropped so nobody waits on them
+    int32_t self = static_cast<int32_t>(::getpid());
+    lockRobust(&segment->flightMutex);
+    for (Segment::Flight& flight : segment->flights) {
+        if (flight.key != 0 && flight.pid == self) {
+            flight.key = 0;
+        }
+    }
+    // The last user removes the segment; the next one rebuilds the index
+    // from the tiles directory as it probes misses
+    bool last = --segment->users == 0 && !segment->removed;
+    if (last) {
+        segment->removed = true;
+        ::shm_unlink(segmentName.c_str());
+    }
+    pthread_mutex_unlock(&segment->flightMutex);
+
+    ::munmap(segment, mappedBytes);
+    if (last) {
+        Utils::logInfo("Removed shared tile index " + segmentName);
+    }
+}
+
+bool SharedTileIndex::find(const TileKey& key, TileFormat& format) const {
+    uint64_t packed;
+    if (!packKey(key, packed)) {
+        return false;
+    }
+    uint32_t slot = slotFor(packed);
+    for (uint32_t probe = 0; probe < SLOT_COUNT; ++probe, slot = (slot + 1) & (SLOT_COUNT - 1)) {
+        uint64_t value = segment->slots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            return false;
+        }
+        if ((value & ~FORMAT_MASK) == packed) {
+            format = static_cast<TileFormat>((value & FORMAT_MASK) >> FORMAT_SHIFT);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SharedTileIndex::insert(const TileKey& key, TileFormat format) {
+    uint64_t packed;
+    if (!packKey(key, packed) || format == TileFormat::Unknown ||
+        segment->tiles.load(std::memory_order_relaxed) >= SLOT_COUNT / 4 * 3) {
+        return;
+    }
+    uint64_t entry = packed | (static_cast<uint64_t>(format) << FORMAT_SHIFT);
+    uint32_t slot = slotFor(packed);
+    for (uint32_t probe = 0; probe < SLOT_COUNT; ++probe, slot = (slot + 1) & (SLOT_COUNT - 1)) {
+        uint64_t value = segment->slots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            if (segment->slots[slot].compare_exchange_strong(value, entry, std::memory_order_acq_rel)) {
+                segment->tiles.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // Lost the race for this slot; value now holds the winner
+        }
+        if ((value & ~FORMAT_MASK) == packed) {
+            if (value != entry) {
+                segment->slots[slot].compare_exchange_strong(value, entry, std::memory_order_acq_rel);
+            }
+            return;
+        }
+    }
+}
+
+bool SharedTileIndex::claim(const TileKey& key) {
+    uint64_t packed;
+    if (!packKey(key, packed)) {
+        return true; // Not tracked; the caller just downloads
+    }
+    int32_t self = static_cast<int32_t>(::getpid());
+    lockRobust(&segment->flightMutex);
+    Segment::Flight* freeFlight = nullptr;
+    for (Segment::Flight& flight : segment->flights) {
+        if (flight.key != 0 && !processAlive(flight.pid)) {
+            flight.key = 0; // Left behind by a process that died
+        }
+        if (flight.key == packed) {
+            pthread_mutex_unlock(&segment->flightMutex);
+            return false;
+        }
+        if (flight.key == 0 && !freeFlight) {
+            freeFlight = &flight;
+        }
+    }
+    if (freeFlight) {
+        freeFlight->key = packed;
+        freeFlight->pid = self;
+    }
+    pthread_mutex_unlock(&segment->flightMutex);
+    return true; // With the table full the download goes ahead unclaimed
+}
+
+void SharedTileIndex::release(const TileKey& key) {
+    uint64_t packed;
+    if (!packKey(key, packed)) {
+        return;
+    }
+    int32_t self = static_cast<int32_t>(::getpid());
+    lockRobust(&segment->flightMutex);
+    for (Segment::Flight& flight : segment->flights) {
+        if (flight.key == packed && flight.pid == self) {
+            flight.key = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&segment->flightMutex);
+}
+
+bool SharedTileIndex::isClaimed(const TileKey& key) {
+    uint64_t packed;
+    if (!packKey(key, packed)) {
+        return false;
+    }
+    bool held = false;
+    lockRobust(&segment->flightMutex);
+    for (Segment::Flight& flight : segment->flights) {
+        if (flight.key == packed) {
+            if (processAlive(flight.pid)) {
+                held = true;
+            } else {
+                flight.key = 0; // Left behind by a process that died
+            }
+        }
+    }
+    pthread_mutex_unlock(&segment->flightMutex);
+    return held;
+}
+
+size_t SharedTileIndex::size() const {
+    return segment->tiles.load(std::memory_order_relaxed);
+}
+
+#else // !__linux__
+
+struct SharedTileIndex::Segment {};
+
+std::unique_ptr<SharedTileIndex> SharedTileIndex::open(const std::filesystem::path&) {
+    return nullptr;
+}
+
+SharedTileIndex::SharedTileIndex(Segment* segment, size_t mappedBytes, std::string name)
+    : segment(segment), mappedBytes(mappedBytes), segmentName(std::move(name)) {}
+
+SharedTileIndex::~SharedTileIndex() = default;
+bool SharedTileIndex::find(const TileKey&, TileFormat&) const { return false; }
+void SharedTileIndex::insert(const TileKey&, TileFormat) {}
+bool SharedTileIndex::claim(const TileKey&) { return true; }
+void SharedTileIndex::release(const TileKey&) {}
+bool SharedTileIndex::isClaimed(const TileKey&) { return false; }
+size_t SharedTileIndex::size() const { return 0; }
+
+#endif // __linux__
@@ -0,0 +1,72 @@
+// src/Networking/Tiles/SharedTileIndex.h
+#ifndef SHAREDTILEINDEX_H
+#define SHAREDTILEINDEX_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "TileKey.h"
+#include "TileFormat.h"
+
+// Index of the disk cache shared by every process using the same tiles
+// directory (one viewer per screen, the tile server, seeding), in a POSIX
+// shared memory segment named after the directory. The segment lives as
+// long as some process has it open; the last one to close it removes it.
+//
+// - Tiles on disk: a lock-free open-addressing table of atomic 64-bit
+//   slots recording tiles once they are fully written, with their format,
+//   so a lookup costs one stat however many formats the source accepts.
+// - Downloads in flight: a small table guarded by a robust process-shared
+//   mutex. A process claims a tile before downloading it; others see the
+//   claim and wait for its copy instead of downloading the same tile.
+//   Claims of processes that died are dropped.
+//
+// The filesystem stays authoritative: callers confirm hits (tiles can be
+// deleted behind the index), probe it on misses and add what they find.
+// Linux only; open() returns nullptr elsewhere.
+class SharedTileIndex {
+public:
+    // Opens, or creates, the index for cacheDir; nullptr if unavailable
+    static std::unique_ptr<SharedTileIndex> open(const std::filesystem::path& cacheDir);
+    ~SharedTileIndex();
+
+    SharedTileIndex(const SharedTileIndex&) = delete;
+    SharedTileIndex& operator=(const SharedTileIndex&) = delete;
+
+    // Format of a tile known to be on disk; false if not indexed
+    bool find(const TileKey& key, TileFormat& format) const;
+
+    // Records a tile that is on disk (ignored once the table is 3/4 full)
+    void insert(const TileKey& key, TileFormat format);
+
+    // Claims the download of key for this process. False if a live process
+    // (possibly this one) already holds it.
+    bool claim(const TileKey& key);
+
+    // Drops this process's claim on key
+    void release(const TileKey& key);
+
+    // True while a live process holds a claim on key. Never blocks on the
+    // download; callers poll it.
+    bool isClaimed(const TileKey& key);
+
+    // Tiles currently indexed
+    size_t size() const;
+
+    const std::string& name() const { return segmentName; }
+
+private:
+    struct Segment;
+
+    SharedTileIndex(Segment* segment, size_t mappedBytes, std::string name);
+
+    // Sets up a freshly created (zero-filled) segment and publishes it
+    static bool initializeSegment(Segment* segment, uint64_t dirDevice, uint64_t dirInode);
+
+    Segment* segment;
+    size_t mappedBytes;
+    std::string segmentName;
+};
+
+#endif // SHAREDTILEINDEX_H
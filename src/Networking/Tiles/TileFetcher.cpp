@@ -1,9 +1,15 @@
 // src/Networking/TileFetcher.cpp
 #include "TileFetcher.h"
-#include "../../Utils/Utils.h"
+#include "../../Decoding/ImageDecoder.h"
+#include "../../Utils/Log.h"
+#include "../../Utils/Metrics.h"
+#include "../../Utils/Trace.h"
 #include <curl/curl.h>
-#include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
 
 // ------------------------------------------
 // Rate limiting fetching as per OSM policy
@@ -14,153 +20,456 @@ static const int WAIT_BETWEEN_FETCHES_MS = 100;
 static const long TIMEOUT_SECONDS = 30L;         // total transfer timeout
 static const long CONNECT_TIMEOUT_SECONDS = 10L; // time allowed to connect
 
-// Callback for libcurl to write fetched data into a buffer
+// How often parked fetches check whether another process's download is done
+static const auto CLAIM_POLL_INTERVAL = std::chrono::milliseconds(50);
+
+// Number of freshly downloaded tile bodies kept in memory for decoding
+static const size_t MAX_RECENT_TILES = 128;
+
+namespace {
+// One in-flight request against a single mirror
+struct MirrorTransfer {
+    CURL* handle = nullptr;
+    size_t mirror = 0;
+    PooledBuffer body;
+    std::chrono::steady_clock::time_point started;
+};
+
+Metrics::Counter& tileRequests(const char* outcome) {
+    return Metrics::counter("gis_tile_requests_total", "Tile fetch tasks by outcome",
+                            std::string("outcome=\"") + outcome + "\"");
+}
+
+Metrics::Counter& cacheLookups(const char* tier, const char* result) {
+    return Metrics::counter("gis_cache_lookups_total", "Tile cache lookups by tier and result",
+                            std::string("tier=\"") + tier + "\",result=\"" + result + "\"");
+}
+
+struct FetchMetrics {
+    Metrics::Counter& fromDisk = tileRequests("disk");
+    Metrics::Counter& downloaded = tileRequests("downloaded");
+    Metrics::Counter& shared = tileRequests("shared");          // Another process downloaded it
+    Metrics::Counter& inProgress = tileRequests("in_progress"); // Already being fetched here
+    Metrics::Counter& failed = tileRequests("failed");
+    Metrics::Counter& diskHits = cacheLookups("disk", "hit");
+    Metrics::Counter& diskMisses = cacheLookups("disk", "miss");
+    Metrics::Counter& memoryHits = cacheLookups("memory", "hit");
+    Metrics::Counter& memoryMisses = cacheLookups("memory", "miss");
+    Metrics::Counter& bytesDownloaded =
+        Metrics::counter("gis_download_bytes_total", "Tile bytes downloaded from upstream");
+    Metrics::Counter& upstreamErrors =
+        Metrics::counter("gis_upstream_errors_total", "Upstream transfers that failed or did not return a tile");
+    Metrics::Histogram& upstreamLatency =
+        Metrics::histogram("gis_upstream_latency_seconds", "Request to complete tile body, per successful transfer");
+    Metrics::Gauge& queueDepth = Metrics::gauge("gis_fetch_queue_depth", "Tile fetch tasks waiting for a worker");
+    Metrics::Gauge& running = Metrics::gauge("gis_fetch_running", "Tile fetch tasks running on a worker");
+};
+
+FetchMetrics& metrics() {
+    static FetchMetrics instance;
+    return instance;
+}
+}
+
+// Callback for libcurl to write fetched data into a pooled buffer
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t totalSize = size * nmemb;
-    std::string* mem = static_cast<std::string*>(userp);
-    mem->append(static_cast<char*>(contents), totalSize);
+    MirrorTransfer* transfer = static_cast<MirrorTransfer*>(userp);
+    ByteBuffer& mem = *transfer->body;
+
+    // Size the buffer once from Content-Length when the first chunk arrives
+    if (mem.empty()) {
+        curl_off_t contentLength = -1;
+        if (curl_easy_getinfo(transfer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) == CURLE_OK &&
+            contentLength > 0) {
+            mem.reserve(static_cast<size_t>(contentLength));
+        }
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(contents);
+    mem.insert(mem.end(), bytes, bytes + totalSize);
     return totalSize;
 }
 
-TileFetcher::TileFetcher(size_t numThreads, size_t maxCacheSize)
-    : maxCacheSize(maxCacheSize), threadPool(numThreads)
+// Phases of a finished transfer from libcurl's own timings, as spans
+static void traceTransfer(const MirrorTransfer& transfer, int z, int x, int y, long responseCode) {
+    curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, firstByte = 0, total = 0;
+    curl_easy_getinfo(transfer.handle, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(transfer.handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(transfer.handle, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(transfer.handle, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(transfer.handle, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+    curl_easy_getinfo(transfer.handle, CURLINFO_TOTAL_TIME_T, &total);
+
+    // Offsets are in microseconds from the start of the transfer
+    uint64_t started = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        transfer.started.time_since_epoch()).count());
+    auto at = [started](curl_off_t us) { return started + static_cast<uint64_t>(us) * 1000; };
+
+    Trace::record("http", "net", started, at(total), z, x, y, responseCode);
+    Trace::record("dns", "net", started, at(dns), z, x, y);
+    Trace::record("connect", "net", at(dns), at(connect), z, x, y);
+    if (tls > 0) {
+        Trace::record("tls", "net", at(connect), at(tls), z, x, y);
+    }
+    if (firstByte > 0) {
+        Trace::record("ttfb", "net", at(pretransfer), at(firstByte), z, x, y);
+        Trace::record("transfer", "net", at(firstByte), at(total), z, x, y);
+    }
+}
+
+// Only negotiates formats this process can decode; headless builds have no
+// JPEG or WebP decoder. A source serving nothing decodable is left as is.
+static TileSource withDecodableFormats(TileSource source) {
+    std::vector<TileFormat> accepted = source.acceptedFormats();
+    std::vector<TileFormat> decodable;
+    for (TileFormat format : accepted) {
+        if (ImageDecoder::canDecode(format)) {
+            decodable.push_back(format);
+        } else {
+            LOG_INFO("Not requesting ", TileFormats::mimeType(format), " tiles from ", source.name,
+                     ": no decoder for them");
+        }
+    }
+    if (decodable.empty()) {
+        LOG_ERROR("No decoder for any format tile source ", source.name, " serves");
+        return source;
+    }
+    source.formats = decodable;
+    return source;
+}
+
+TileFetcher::TileFetcher(size_t numThreads, size_t maxCacheSize, const TileSource& source)
+    : maxCacheSize(maxCacheSize), source(withDecodableFormats(source)), cacheDir(source.cacheDir()),
+      acceptedFormats(this->source.acceptedFormats()),
+      acceptHeader(TileFormats::acceptHeader(acceptedFormats)), negotiatedFormat(acceptedFormats.front()),
+      mirrorHealth(source.mirrors.size()), sharedIndex(SharedTileIndex::open(cacheDir)),
+      readEngine(IoEngine::create()), threadPool(numThreads, "tile fetch")
 {
-    Utils::logInfo("TileFetcher created with " + std::to_string(numThreads) 
-                   + " threads, maxCacheSize=" + std::to_string(maxCacheSize));
+    LOG_INFO("TileFetcher created", Log::kv("threads", numThreads), Log::kv("maxCacheSize", maxCacheSize),
+             Log::kv("source", source.name), Log::kv("mirrors", source.mirrors.size()), " (", acceptHeader, ")");
     curl_global_init(CURL_GLOBAL_DEFAULT);
+    if (sharedIndex) {
+        claimWatcher = std::thread(&TileFetcher::watchClaims, this);
+    }
 }
 
 TileFetcher::~TileFetcher() {
-    Utils::logInfo("TileFetcher destroyed. Cleaning up cached tiles.");
+    LOG_INFO("TileFetcher destroyed. Cleaning up cached tiles.");
+    // The watcher stops first, as it requeues onto the pool; from then on
+    // a fetch that would park fails instead
+    {
+        std::lock_guard<std::mutex> lock(claimWaitMutex);
+        stopWatching = true;
+    }
+    claimWaitChanged.notify_all();
+    if (claimWatcher.joinable()) {
+        claimWatcher.join();
+    }
+
+    // Queued fetches run while every member they use is still alive
+    threadPool.shutdown();
+
+    std::vector<std::shared_ptr<FetchRequest>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(claimWaitMutex);
+        abandoned.swap(claimWaits);
+    }
+    for (const std::shared_ptr<FetchRequest>& request : abandoned) {
+        request->result.set_value(false);
+    }
     curl_global_cleanup();
 }
 
-std::string TileFetcher::getTileURL(int z, int x, int y) {
-    std::stringstream ss;
-    ss << "https://tile.openstreetmap.org/" << z << "/" << x << "/" << y << ".png";
-    return ss.str();
+bool TileFetcher::downloadTile(int z, int x, int y, PooledBuffer& buffer, TileFormat& format) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<size_t> order = mirrorHealth.orderedMirrors();
+    if (order.empty()) {
+        LOG_ERROR("No mirrors configured for tile source ", source.name);
+        return false;
+    }
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        LOG_ERROR("Failed to initialize cURL multi handle", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+        return false;
+    }
+
+    // Format negotiation: every mirror gets the same Accept header
+    struct curl_slist* headers = curl_slist_append(nullptr, acceptHeader.c_str());
+
+    // std::list keeps element addresses stable for CURLOPT_WRITEDATA
+    std::list<MirrorTransfer> transfers;
+    size_t nextMirror = 0;
+
+    // Starts a request on the next best mirror that has not been tried yet
+    auto startTransfer = [&]() -> bool {
+        if (nextMirror >= order.size()) {
+            return false;
+        }
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            LOG_ERROR("Failed to initialize cURL", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+            return false;
+        }
+
+        transfers.emplace_back();
+        MirrorTransfer& transfer = transfers.back();
+        transfer.handle = curl;
+        transfer.mirror = order[nextMirror++];
+        transfer.body = bufferPool.acquire();
+        transfer.started = Clock::now();
+
+        std::string url = source.formatURL(transfer.mirror, z, x, y);
+        LOG_INFO("Fetching tile from URL: ", url);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "CustomGIS/1.0");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+        // Timeouts
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, TIMEOUT_SECONDS);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_SECONDS);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        curl_multi_add_handle(multi, curl);
+        return true;
+    };
+
+    auto finishTransfer = [&](std::list<MirrorTransfer>::iterator it) {
+        curl_multi_remove_handle(multi, it->handle);
+        curl_easy_cleanup(it->handle);
+        return transfers.erase(it);
+    };
+
+    bool success = false;
+    bool hedged = false;
+    double winnerLatencyMs = 0.0;
+    Clock::time_point hedgeAt = Clock::now() + mirrorHealth.hedgeDelay();
+    startTransfer();
+
+    while (!transfers.empty() && !success) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg = nullptr;
+        int queued = 0;
+        while (!success && (msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            auto it = std::find_if(transfers.begin(), transfers.end(),
+                                   [&](const MirrorTransfer& t) { return t.handle == msg->easy_handle; });
+            if (it == transfers.end()) {
+                continue;
+            }
+
+            CURLcode res = msg->data.result;
+            long response_code = 0;
+            curl_easy_getinfo(it->handle, CURLINFO_RESPONSE_CODE, &response_code);
+            if (Trace::enabled()) {
+                traceTransfer(*it, z, x, y, response_code);
+            }
+
+            // Trust the bytes over the header; servers often mislabel tiles
+            TileFormat served = TileFormat::Unknown;
+            if (res == CURLE_OK && response_code == 200) {
+                served = TileFormats::sniff(it->body->data(), it->body->size());
+                char* contentType = nullptr;
+                if (served == TileFormat::Unknown &&
+                    curl_easy_getinfo(it->handle, CURLINFO_CONTENT_TYPE, &contentType) == CURLE_OK && contentType) {
+                    served = TileFormats::fromContentType(contentType);
+                }
+            }
+
+            if (res == CURLE_OK && response_code == 200 && served != TileFormat::Unknown) {
+                double latencyMs = std::chrono::duration<double, std::milli>(
+                    Clock::now() - it->started).count();
+                mirrorHealth.recordSuccess(it->mirror, latencyMs);
+                winnerLatencyMs = latencyMs;
+                metrics().upstreamLatency.observe(Clock::now() - it->started);
+                metrics().bytesDownloaded.add(it->body->size());
+                buffer = std::move(it->body);
+                format = served;
+                success = true;
+            } else {
+                if (res == CURLE_OK && response_code == 200) {
+                    LOG_ERROR("Unrecognized image format", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y),
+                              Log::kv("mirror", it->mirror));
+                } else if (res != CURLE_OK) {
+                    LOG_ERROR("cURL perform failed", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y),
+                              Log::kv("error", curl_easy_strerror(res)));
+                } else {
+                    LOG_ERROR("Received non-200 response", Log::kv("status", response_code), Log::kv("z", z),
+                              Log::kv("x", x), Log::kv("y", y));
+                }
+                mirrorHealth.recordFailure(it->mirror);
+                metrics().upstreamErrors.add();
+                finishTransfer(it);
+
+                // Fail over immediately when nothing else is in flight
+                if (transfers.empty() && startTransfer()) {
+                    hedgeAt = Clock::now() + mirrorHealth.hedgeDelay();
+                }
+            }
+        }
+
+        if (success || transfers.empty()) {
+            break;
+        }
+
+        // Hedge: duplicate a slow request onto the next mirror
+        Clock::time_point now = Clock::now();
+        if (!hedged && transfers.size() == 1 && now >= hedgeAt) {
+            hedged = true;
+            if (startTransfer()) {
+                LOG_INFO("Hedging slow request", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+            }
+        }
+
+        int pollMs = 100;
+        if (!hedged && hedgeAt > now) {
+            auto untilHedge = std::chrono::duration_cast<std::chrono::milliseconds>(hedgeAt - now).count();
+            pollMs = static_cast<int>(std::min<long long>(pollMs, untilHedge + 1));
+        }
+        curl_multi_poll(multi, nullptr, 0, pollMs, nullptr);
+    }
+
+    // Cancel whichever requests lost the race; they were slower than the winner
+    for (auto it = transfers.begin(); it != transfers.end();) {
+        mirrorHealth.recordCancelled(it->mirror, std::chrono::duration<double, std::milli>(
+            Clock::now() - it->started).count(), winnerLatencyMs);
+        it = finishTransfer(it);
+    }
+    curl_multi_cleanup(multi);
+    curl_slist_free_all(headers);
+
+    return success;
 }
 
-bool TileFetcher::fetchTileTask(int z, int x, int y) {
-    TileKey key = {z, x, y};
+void TileFetcher::fetchTileTask(std::shared_ptr<FetchRequest> request, uint64_t queuedNs) {
+    const TileKey key = request->key;
+    const int z = key.z, x = key.x, y = key.y;
+    const bool decodeCached = request->decodeCached;
+    Trace::Scope span("fetch tile", "fetch", z, x, y);
+    metrics().queueDepth.add(-1);
+    metrics().running.add(1);
+    if (queuedNs != 0) {
+        Trace::record("queued", "fetch", queuedNs, Trace::nowNs(), z, x, y);
+    }
 
-    Utils::logInfo("Starting fetchTileTask for z=" + std::to_string(z) +
-                  ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+    LOG_DEBUG("Starting fetchTileTask", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
 
     // Step 1: Acquire lock to check and insert into inProgressTiles
     {
-        std::unique_lock<std::shared_mutex> lock(cacheMutex);
+        std::unique_lock<ProfiledSharedMutex> lock(cacheMutex);
         if (inProgressTiles.find(key) != inProgressTiles.end()) {
-            Utils::logInfo("Tile already in progress: z=" + std::to_string(z) +
-                          ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
-            return false;
+            LOG_DEBUG("Tile already in progress", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+            metrics().inProgress.add();
+            metrics().running.add(-1);
+            request->result.set_value(false);
+            return;
         }
         inProgressTiles.insert(key);
-        Utils::logInfo("Inserted tile into inProgressTiles: z=" + std::to_string(z) +
-                      ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+        LOG_DEBUG("Inserted tile into inProgressTiles", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
     } // Release lock
 
     bool success = false;
+    bool claimed = false;     // This process holds the shared in-flight claim
+    bool handedOff = false;   // The cache writer releases the claim once stored
+    bool parked = false;      // Waiting for another process's download off the pool
+    Metrics::Counter* outcome = &metrics().failed;
 
     try {
-        // Step 2: Check disk cache
-        std::filesystem::path cacheDir =
-            "resources/tiles/" + std::to_string(z) + "/" + std::to_string(x);
-        std::filesystem::create_directories(cacheDir);
-        std::filesystem::path cachePath = cacheDir / (std::to_string(y) + ".png");
+        // Step 2: Check disk cache (any accepted format)
+        std::filesystem::path cachePath = findCachedTile(z, x, y);
+        (cachePath.empty() ? metrics().diskMisses : metrics().diskHits).add();
+        outcome = request->claimWaited ? &metrics().shared : &metrics().fromDisk;
+
+        // Step 2b: If another process sharing the cache is downloading the
+        // tile, wait for its copy instead of downloading it again. The wait
+        // happens off the pool; the fetch is queued again once it is over.
+        // After one wait a tile that is still missing is downloaded here.
+        if (cachePath.empty() && sharedIndex) {
+            claimed = sharedIndex->claim(key);
+            if (!claimed && !request->claimWaited) {
+                LOG_INFO("Waiting for another process to fetch", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+                parked = true;
+                goto cleanup;
+            }
+        }
 
-        if (std::filesystem::exists(cachePath)) {
-            Utils::logInfo("Tile found on disk: " + cachePath.string());
+        if (!cachePath.empty()) {
+            LOG_DEBUG("Tile found on disk: ", cachePath.native());
 
             // Update cache with the found tile
             {
-                std::unique_lock<std::shared_mutex> lock(cacheMutex);
+                std::unique_lock<ProfiledSharedMutex> lock(cacheMutex);
                 tileCache[key] = cachePath;
                 touchTile(key, lock);
                 evictIfNeeded();
-                Utils::logInfo("Updated cache with tile from disk: z=" + std::to_string(z) +
-                              ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+                LOG_DEBUG("Updated cache with tile from disk", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
             }
 
-            success = true;
-            goto cleanup;
-        }
+            if (decodeCached) {
+                warmCachedTile(key, cachePath);
+            }
 
-        // Step 3: Fetch from server using cURL
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-            Utils::logError("Failed to initialize cURL for tile z=" + std::to_string(z) +
-                            ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+            success = true;
             goto cleanup;
         }
 
-        std::string url = getTileURL(z, x, y);
-        Utils::logInfo("Fetching tile from URL: " + url);
-        std::string buffer;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "CustomGIS/1.0");
-
-        // Timeouts
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, TIMEOUT_SECONDS);
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_SECONDS);
-        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            Utils::logError("cURL perform failed for tile z=" + std::to_string(z) +
-                            ", x=" + std::to_string(x) + ", y=" + std::to_string(y) +
-                            " => " + curl_easy_strerror(res));
-            curl_easy_cleanup(curl);
+        // Step 3: Fetch from server using cURL (hedged across mirrors)
+        PooledBuffer buffer;
+        TileFormat format = TileFormat::Unknown;
+        if (!downloadTile(z, x, y, buffer, format)) {
             goto cleanup;
         }
+        outcome = &metrics().downloaded;
 
-        long response_code;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-        curl_easy_cleanup(curl);
-
-        if (response_code != 200) {
-            Utils::logError("Received non-200 response code (" + std::to_string(response_code) +
-                            ") for tile z=" + std::to_string(z) +
-                            ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
-            goto cleanup;
+        // The cache entry is tagged with the format the source actually served
+        cachePath = cachePathFor(z, x, y, format);
+        if (negotiatedFormat.exchange(format) != format) {
+            LOG_INFO("Tile source ", source.name, " serves ", TileFormats::mimeType(format));
         }
 
-        // Step 4: Save to disk using a .tmp approach to avoid partial writes
-        std::filesystem::path tmpPath = cachePath.string() + ".tmp";
+        // Step 4: Hand the same buffer to the async cache writer and keep it
+        // in memory so the renderer can decode it without a disk round trip
         {
-            std::ofstream outFile(tmpPath, std::ios::binary);
-            if (!outFile) {
-                Utils::logError("Failed to open tmp file for writing: " + tmpPath.string());
-                goto cleanup;
-            }
-            outFile.write(buffer.data(), buffer.size());
-            if (!outFile) {
-                Utils::logError("Failed to write data to tmp file: " + tmpPath.string());
-                outFile.close();
-                std::filesystem::remove(tmpPath);
-                goto cleanup;
-            }
-            outFile.close();
+            std::shared_ptr<const ByteBuffer> data = std::move(buffer);
+            ContentHash hash = ContentHash::of(data->data(), data->size());
 
-            std::error_code ec;
-            std::filesystem::rename(tmpPath, cachePath, ec);
-            if (ec) {
-                Utils::logError("Failed to rename tmp file to final cache path: " + ec.message());
-                std::filesystem::remove(tmpPath);
-                goto cleanup;
+            // Decode on this worker before the renderer asks for the tile
+            if (decodeHook) {
+                Trace::Scope decodeSpan("decode", "decode", z, x, y);
+                decodeHook(hash, *data, format);
             }
-        }
 
-        // Step 5: Update cache with the newly fetched tile
-        {
-            std::unique_lock<std::shared_mutex> lock(cacheMutex);
+            std::unique_lock<ProfiledSharedMutex> lock(cacheMutex);
+            data = rememberRecentTile(key, data, hash);
+            uint64_t enqueuedNs = Trace::enabled() ? Trace::nowNs() : 0;
+            cacheWriter.enqueue(cachePath, data, hash, [this, key, format, claimed, enqueuedNs](bool stored) {
+                if (enqueuedNs != 0) {
+                    Trace::record("cache write", "disk", enqueuedNs, Trace::nowNs(), key.z, key.x, key.y);
+                }
+                if (sharedIndex) {
+                    if (stored) {
+                        sharedIndex->insert(key, format);
+                    }
+                    if (claimed) {
+                        sharedIndex->release(key);
+                    }
+                }
+            });
+            handedOff = true;
+
+            // Step 5: Update cache with the newly fetched tile
             tileCache[key] = cachePath;
             touchTile(key, lock);
             evictIfNeeded();
-            Utils::logInfo("Fetched and cached tile: z=" + std::to_string(z) +
-                          ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+            LOG_INFO("Fetched and cached tile", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
         }
 
         if (WAIT_BETWEEN_FETCHES_MS > 0) {
@@ -169,39 +478,165 @@ bool TileFetcher::fetchTileTask(int z, int x, int y) {
 
         success = true;
     } catch (const std::exception& e) {
-        Utils::logError("Exception while fetching tile z=" + std::to_string(key.z) +
-                        ", x=" + std::to_string(key.x) + ", y=" + std::to_string(key.y) +
-                        " => " + e.what());
+        LOG_ERROR("Exception while fetching tile", Log::kv("z", key.z), Log::kv("x", key.x), Log::kv("y", key.y),
+                  Log::kv("error", e.what()));
     } catch (...) {
-        Utils::logError("Unknown exception while fetching tile z=" + std::to_string(key.z) +
-                        ", x=" + std::to_string(key.x) + ", y=" + std::to_string(key.y));
+        LOG_ERROR("Unknown exception while fetching tile", Log::kv("z", key.z), Log::kv("x", key.x),
+                  Log::kv("y", key.y));
     }
 
 cleanup:
+    if (!parked) {
+        (success ? *outcome : metrics().failed).add();
+    }
+
     // Step 6: Remove from inProgressTiles regardless of success or failure
     {
-        std::unique_lock<std::shared_mutex> lock(cacheMutex);
+        std::unique_lock<ProfiledSharedMutex> lock(cacheMutex);
         inProgressTiles.erase(key);
-        Utils::logInfo("Removed tile from inProgressTiles: z=" + std::to_string(z) +
-                      ", x=" + std::to_string(x) + ", y=" + std::to_string(y));
+        LOG_DEBUG("Removed tile from inProgressTiles", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+    }
+    if (claimed && !handedOff) {
+        sharedIndex->release(key);
     }
 
-    return success;
+    metrics().running.add(-1);
+    if (parked) {
+        parkForClaim(std::move(request)); // After leaving inProgressTiles, so the requeued fetch can run
+        return;
+    }
+    request->result.set_value(success);
+}
+
+void TileFetcher::parkForClaim(std::shared_ptr<FetchRequest> request) {
+    request->claimWaited = true;
+    request->claimDeadline = std::chrono::steady_clock::now() +
+                             std::chrono::seconds(TIMEOUT_SECONDS + CONNECT_TIMEOUT_SECONDS);
+    {
+        std::lock_guard<std::mutex> lock(claimWaitMutex);
+        if (!stopWatching) {
+            claimWaits.push_back(std::move(request));
+            claimWaitChanged.notify_one();
+            return;
+        }
+    }
+    request->result.set_value(false); // Shutting down
+}
+
+void TileFetcher::watchClaims() {
+    std::unique_lock<std::mutex> lock(claimWaitMutex);
+    while (!stopWatching) {
+        if (claimWaits.empty()) {
+            claimWaitChanged.wait(lock);
+            continue;
+        }
+        claimWaitChanged.wait_for(lock, CLAIM_POLL_INTERVAL);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = claimWaits.begin(); it != claimWaits.end() && !stopWatching;) {
+            if (now < (*it)->claimDeadline && sharedIndex->isClaimed((*it)->key)) {
+                ++it;
+                continue;
+            }
+            enqueueFetch(std::move(*it));
+            it = claimWaits.erase(it);
+        }
+    }
+}
+
+// Plain blocking read, for threads other than the render thread (the
+// batched read engine belongs to it)
+static std::shared_ptr<ByteBuffer> readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    return std::make_shared<ByteBuffer>(std::istreambuf_iterator<char>(file),
+                                        std::istreambuf_iterator<char>());
+}
+
+// Identifies a tile's prefetch in the pool; z + 1 keeps it non-zero
+static ThreadPool::Tag prefetchTag(int z, int x, int y) {
+    return (static_cast<uint64_t>(z + 1) << 48) | (static_cast<uint64_t>(x) << 24) | static_cast<uint64_t>(y);
+}
+
+std::future<bool> TileFetcher::submit(const TileKey& key, bool decodeCached, bool low) {
+    auto request = std::make_shared<FetchRequest>();
+    request->key = key;
+    request->decodeCached = decodeCached;
+    request->low = low;
+    std::future<bool> result = request->result.get_future();
+    enqueueFetch(std::move(request));
+    return result;
+}
+
+void TileFetcher::enqueueFetch(std::shared_ptr<FetchRequest> request) {
+    metrics().queueDepth.add(1);
+    uint64_t queuedNs = Trace::enabled() ? Trace::nowNs() : 0;
+    const TileKey& key = request->key;
+    if (request->low) {
+        threadPool.enqueueLowTagged(prefetchTag(key.z, key.x, key.y), &TileFetcher::fetchTileTask, this, request,
+                                    queuedNs);
+    } else {
+        threadPool.enqueue(&TileFetcher::fetchTileTask, this, request, queuedNs);
+    }
 }
 
 std::future<bool> TileFetcher::fetchTile(int z, int x, int y) {
-    return threadPool.enqueue(&TileFetcher::fetchTileTask, this, z, x, y);
+    return submit({z, x, y}, false, false);
+}
+
+std::future<bool> TileFetcher::prefetchTile(int z, int x, int y) {
+    return submit({z, x, y}, false, true);
+}
+
+bool TileFetcher::promoteTile(int z, int x, int y) {
+    return threadPool.promote(prefetchTag(z, x, y));
+}
+
+std::future<bool> TileFetcher::warmTile(int z, int x, int y) {
+    return submit({z, x, y}, true, false);
+}
+
+void TileFetcher::warmCachedTile(const TileKey& key, const std::filesystem::path& path) {
+    {
+        std::shared_lock<ProfiledSharedMutex> lock(cacheMutex);
+        if (recentTiles.find(key) != recentTiles.end()) {
+            return; // Already in memory (and decoded when it arrived)
+        }
+    }
+
+    std::shared_ptr<ByteBuffer> data;
+    {
+        Trace::Scope span("disk read", "disk", key.z, key.x, key.y);
+        data = readFile(path);
+    }
+    if (!data) {
+        LOG_ERROR("Failed to read cached tile: ", path.native());
+        return;
+    }
+    ContentHash hash = ContentHash::of(data->data(), data->size());
+    if (decodeHook) {
+        Trace::Scope span("decode", "decode", key.z, key.x, key.y);
+        decodeHook(hash, *data, TileFormats::sniff(data->data(), data->size()));
+    }
+
+    std::unique_lock<ProfiledSharedMutex> lock(cacheMutex);
+    rememberRecentTile(key, std::move(data), hash);
 }
 
 bool TileFetcher::isTileCached(int z, int x, int y) {
     TileKey key = {z, x, y};
-    std::shared_lock<std::shared_mutex> lock(cacheMutex);
+    std::shared_lock<ProfiledSharedMutex> lock(cacheMutex);
     return (tileCache.find(key) != tileCache.end());
 }
 
+bool TileFetcher::isTileOnDisk(int z, int x, int y) {
+    return !findCachedTile(z, x, y).empty();
+}
+
 std::filesystem::path TileFetcher::getTilePath(int z, int x, int y) {
     TileKey key = {z, x, y};
-    std::shared_lock<std::shared_mutex> lock(cacheMutex);
+    std::shared_lock<ProfiledSharedMutex> lock(cacheMutex);
     auto it = tileCache.find(key);
     if (it != tileCache.end()) {
         return it->second;
@@ -209,7 +644,144 @@ std::filesystem::path TileFetcher::getTilePath(int z, int x, int y) {
     return ""; // Return empty path if not cached
 }
 
-void TileFetcher::touchTile(const TileKey& key, std::unique_lock<std::shared_mutex>& lock) {
+void TileFetcher::setDecodeHook(DecodeHook hook) {
+    decodeHook = std::move(hook);
+}
+
+std::filesystem::path TileFetcher::cachePathFor(int z, int x, int y, TileFormat format) const {
+    return cacheDir / std::to_string(z) / std::to_string(x) /
+           (std::to_string(y) + "." + TileFormats::extension(format));
+}
+
+std::filesystem::path TileFetcher::findCachedTile(int z, int x, int y) {
+    // Tiles any process sharing the cache has stored: one stat in the right
+    // format. Checked, since tiles may have been deleted behind the index.
+    TileFormat indexed;
+    if (sharedIndex && sharedIndex->find({z, x, y}, indexed) &&
+        std::find(acceptedFormats.begin(), acceptedFormats.end(), indexed) != acceptedFormats.end()) {
+        std::filesystem::path path = cachePathFor(z, x, y, indexed);
+        if (std::filesystem::exists(path)) {
+            return path;
+        }
+    }
+
+    TileFormat preferred = negotiatedFormat.load();
+    std::filesystem::path path = cachePathFor(z, x, y, preferred);
+    if (cacheWriter.isPending(path)) {
+        return path;
+    }
+    if (std::filesystem::exists(path)) {
+        if (sharedIndex) {
+            sharedIndex->insert({z, x, y}, preferred);
+        }
+        return path;
+    }
+    for (TileFormat format : acceptedFormats) {
+        if (format == preferred) {
+            continue;
+        }
+        path = cachePathFor(z, x, y, format);
+        if (cacheWriter.isPending(path)) {
+            return path;
+        }
+        if (std::filesystem::exists(path)) {
+            if (sharedIndex) {
+                sharedIndex->insert({z, x, y}, format);
+            }
+            return path;
+        }
+    }
+    return "";
+}
+
+std::shared_ptr<const ByteBuffer> TileFetcher::getTileData(int z, int x, int y) {
+    TileKey key = {z, x, y};
+    std::shared_lock<ProfiledSharedMutex> lock(cacheMutex);
+    auto it = recentTiles.find(key);
+    if (it != recentTiles.end()) {
+        metrics().memoryHits.add();
+        return it->second.data;
+    }
+    metrics().memoryMisses.add();
+    return nullptr;
+}
+
+std::shared_ptr<const ByteBuffer> TileFetcher::readTile(int z, int x, int y) {
+    if (std::shared_ptr<const ByteBuffer> recent = getTileData(z, x, y)) {
+        return recent;
+    }
+    std::filesystem::path path = getTilePath(z, x, y);
+    if (path.empty()) {
+        path = findCachedTile(z, x, y);
+    }
+    if (path.empty()) {
+        return nullptr;
+    }
+    Trace::Scope span("disk read", "disk", z, x, y);
+    return readFile(path);
+}
+
+std::vector<std::shared_ptr<const ByteBuffer>> TileFetcher::readTiles(const std::vector<TileKey>& keys) {
+    std::vector<std::shared_ptr<const ByteBuffer>> results(keys.size());
+    std::vector<std::filesystem::path> paths;
+    std::vector<size_t> pathIndices;
+
+    {
+        std::shared_lock<ProfiledSharedMutex> lock(cacheMutex);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto recent = recentTiles.find(keys[i]);
+            if (recent != recentTiles.end()) {
+                metrics().memoryHits.add();
+                results[i] = recent->second.data;
+                continue;
+            }
+            metrics().memoryMisses.add();
+            auto cached = tileCache.find(keys[i]);
+            if (cached != tileCache.end()) {
+                paths.push_back(cached->second);
+                pathIndices.push_back(i);
+            }
+        }
+    }
+
+    if (!paths.empty()) {
+        Trace::Scope span("read batch", "disk");
+        span.setValue(static_cast<int64_t>(paths.size()));
+        std::vector<IoEngine::ReadResult> reads = readEngine->readBatch(paths);
+        for (size_t j = 0; j < reads.size(); ++j) {
+            if (reads[j].ok) {
+                results[pathIndices[j]] = std::make_shared<const ByteBuffer>(std::move(reads[j].data));
+            } else {
+                LOG_ERROR("Failed to read cached tile: ", paths[j].native());
+            }
+        }
+    }
+    return results;
+}
+
+std::shared_ptr<const ByteBuffer> TileFetcher::rememberRecentTile(const TileKey& key,
+                                                              std::shared_ptr<const ByteBuffer> data,
+                                                              const ContentHash& hash) {
+    // Share the body of an identical recent tile instead of keeping a copy
+    for (const auto& [otherKey, recent] : recentTiles) {
+        if (recent.hash == hash) {
+            data = recent.data;
+            break;
+        }
+    }
+
+    if (recentTiles.find(key) == recentTiles.end()) {
+        recentOrder.push_back(key);
+    }
+    recentTiles[key] = { data, hash };
+    while (recentTiles.size() > MAX_RECENT_TILES) {
+        recentTiles.erase(recentOrder.front());
+        recentOrder.pop_front();
+    }
+    return data;
+}
+
+void TileFetcher::touchTile(const TileKey& key, std::unique_lock<ProfiledSharedMutex>& lock) {
     // Move key to front (LRU)
     auto it = cacheIterators.find(key);
     if (it != cacheIterators.end()) {
@@ -225,8 +797,8 @@ void TileFetcher::evictIfNeeded() {
         lruList.pop_back();
         auto it = tileCache.find(lruKey);
         if (it != tileCache.end()) {
-            Utils::logInfo("Evicting tile from cache: z=" + std::to_string(lruKey.z) +
-                          ", x=" + std::to_string(lruKey.x) + ", y=" + std::to_string(lruKey.y));
+            LOG_DEBUG("Evicting tile from cache", Log::kv("z", lruKey.z), Log::kv("x", lruKey.x),
+                      Log::kv("y", lruKey.y));
             tileCache.erase(it);
         }
         cacheIterators.erase(lruKey);
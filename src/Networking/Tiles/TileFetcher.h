@@ -9,23 +9,79 @@
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../../Utils/LockProfiler.h"
 #include "../../Utils/ThreadPool.h"
 #include "TileKey.h" // Shared TileKey definitions
+#include "TileSource.h"
+#include "TileFormat.h"
+#include "MirrorHealth.h"
+#include "CacheWriter.h"
+#include "SharedTileIndex.h"
+#include "../../Utils/BufferPool.h"
 
 class TileFetcher {
 public:
-    TileFetcher(size_t numThreads = 4, size_t maxCacheSize = 200);
+    TileFetcher(size_t numThreads = 4, size_t maxCacheSize = 200,
+                const TileSource& source = TileSource::openStreetMap());
     ~TileFetcher();
 
     // Fetches a tile asynchronously; returns a future indicating success or failure
     std::future<bool> fetchTile(int z, int x, int y);
 
+    // Same as fetchTile but at background priority (see ThreadPool::enqueueLow),
+    // for tiles that are only predicted to be needed
+    std::future<bool> prefetchTile(int z, int x, int y);
+
+    // Moves a prefetch of the tile that has not started yet ahead of all
+    // other prefetches, at normal priority. False if none is waiting.
+    bool promoteTile(int z, int x, int y);
+
+    // Like fetchTile, but a tile already on disk is also read and decoded on
+    // the worker (through the decode hook) and kept in memory, so the render
+    // thread only has to upload it. Used when a tile is certain to be needed soon.
+    std::future<bool> warmTile(int z, int x, int y);
+
     // Public methods to check cache
     bool isTileCached(int z, int x, int y);
     
+    // True if the disk cache holds the tile in any accepted format, whether
+    // or not this fetcher has seen it yet
+    bool isTileOnDisk(int z, int x, int y);
+
+    // Cached file in any accepted format (negotiated one first), or empty
+    std::filesystem::path findCachedTile(int z, int x, int y);
+
     // Retrieves the file path of the cached tile
     std::filesystem::path getTilePath(int z, int x, int y);
 
+    // Directory this fetcher's source is cached in (TileSource::cacheDir)
+    const std::filesystem::path& getCacheDir() const { return cacheDir; }
+
+    // Returns the in-memory bytes of a freshly downloaded tile, or nullptr.
+    // Lets callers decode new tiles without reading them back from disk.
+    std::shared_ptr<const ByteBuffer> getTileData(int z, int x, int y);
+
+    // Bytes of one cached tile from memory or disk, or nullptr. Safe from any
+    // thread, unlike readTiles, whose read engine belongs to the render thread.
+    std::shared_ptr<const ByteBuffer> readTile(int z, int x, int y);
+
+    // Returns the bytes of each cached tile, reading the ones that are not
+    // in memory as a single batch. Entries are nullptr for uncached tiles.
+    std::vector<std::shared_ptr<const ByteBuffer>> readTiles(const std::vector<TileKey>& keys);
+
+    // Called on the fetching worker thread with every downloaded tile body,
+    // so expensive formats (JPEG, WebP) are decoded off the render thread.
+    // Set before the first fetch.
+    using DecodeHook = std::function<void(const ContentHash&, const ByteBuffer&, TileFormat)>;
+    void setDecodeHook(DecodeHook hook);
+
 private:
     size_t maxCacheSize;
 
@@ -34,19 +90,87 @@ private:
     std::unordered_map<TileKey, std::filesystem::path, TileKeyHash> tileCache;
     std::unordered_map<TileKey, std::list<TileKey>::iterator, TileKeyHash> cacheIterators;
     std::unordered_set<TileKey, TileKeyHash> inProgressTiles;
+
+    // Recently downloaded tile bodies, shared with the cache writer.
+    // Identical bodies are stored once.
+    struct RecentTile {
+        std::shared_ptr<const ByteBuffer> data;
+        ContentHash hash;
+    };
+    std::list<TileKey> recentOrder;
+    std::unordered_map<TileKey, RecentTile, TileKeyHash> recentTiles;
     
-    mutable std::shared_mutex cacheMutex; // For concurrent reads
+    mutable ProfiledSharedMutex cacheMutex{ "TileFetcher::cacheMutex" }; // For concurrent reads
+
+    TileSource source;
+    std::filesystem::path cacheDir; // source.cacheDir(); tiles are z/x/y.ext below it
+    std::vector<TileFormat> acceptedFormats;
+    std::string acceptHeader;
+    std::atomic<TileFormat> negotiatedFormat; // Last format the source actually served
+    MirrorHealth mirrorHealth;
+    BufferPool bufferPool;
+
+    // Cache index and download claims shared with other processes using
+    // cacheDir; nullptr if shared memory is unavailable. Declared
+    // before the cache writer, whose callbacks use it until it is destroyed.
+    std::unique_ptr<SharedTileIndex> sharedIndex;
+    CacheWriter cacheWriter;
+    std::unique_ptr<IoEngine> readEngine;
+
+    DecodeHook decodeHook;
+
+    // A fetch whose caller is waiting on the result
+    struct FetchRequest {
+        TileKey key;
+        bool decodeCached = false; // Also decode a tile found on disk
+        bool low = false;          // Prefetch priority
+        bool claimWaited = false;  // Already waited once for another process's download
+        std::chrono::steady_clock::time_point claimDeadline;
+        std::promise<bool> result;
+    };
+
+    // Fetches of tiles another process is downloading, parked off the pool
+    // until its claim goes away or the deadline passes (see watchClaims).
+    // Declared before the pool, whose tasks park fetches here.
+    std::mutex claimWaitMutex;
+    std::condition_variable claimWaitChanged;
+    std::vector<std::shared_ptr<FetchRequest>> claimWaits;
+    bool stopWatching = false;
+    std::thread claimWatcher;
 
     ThreadPool threadPool;
 
-    // Helper function to construct tile URL
-    std::string getTileURL(int z, int x, int y);
+    // Downloads a tile, hedging slow requests onto alternate mirrors.
+    // format is taken from the response (signature first, then Content-Type).
+    bool downloadTile(int z, int x, int y, PooledBuffer& buffer, TileFormat& format);
+
+    // Cache file for a tile in a given format: <cacheDir>/z/x/y.<ext>
+    std::filesystem::path cachePathFor(int z, int x, int y, TileFormat format) const;
+
+    // Keeps a fresh tile body in memory (caller holds cacheMutex)
+    std::shared_ptr<const ByteBuffer> rememberRecentTile(const TileKey& key,
+                                                         std::shared_ptr<const ByteBuffer> data,
+                                                         const ContentHash& hash);
+
+    // Queues a fetch on the pool at its priority
+    std::future<bool> submit(const TileKey& key, bool decodeCached, bool low);
+    void enqueueFetch(std::shared_ptr<FetchRequest> request);
+
+    // Fetch tile task; completes request->result unless it parks the
+    // request to wait for another process's download
+    void fetchTileTask(std::shared_ptr<FetchRequest> request, uint64_t queuedNs);
+
+    // Hands a fetch to the claim watcher
+    void parkForClaim(std::shared_ptr<FetchRequest> request);
+
+    // Claim watcher thread: requeues parked fetches once their claims go away
+    void watchClaims();
 
-    // Fetch tile task
-    bool fetchTileTask(int z, int x, int y);
+    // Reads a cached tile, runs the decode hook on it and keeps it in memory
+    void warmCachedTile(const TileKey& key, const std::filesystem::path& path);
 
     // Helper method to move a key to the front of the LRU list
-    void touchTile(const TileKey& key, std::unique_lock<std::shared_mutex>& lock);
+    void touchTile(const TileKey& key, std::unique_lock<ProfiledSharedMutex>& lock);
 
     // Evict least recently used tile
     void evictIfNeeded();
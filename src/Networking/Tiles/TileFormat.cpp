@@ -0,0 +1,99 @@
+// src/Networking/Tiles/TileFormat.cpp
+#include "TileFormat.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace TileFormats {
+
+const char* extension(TileFormat format) {
+    switch (format) {
+    case TileFormat::Png:  return "png";
+    case TileFormat::Jpeg: return "jpg";
+    case TileFormat::WebP: return "webp";
+    default:               return "bin";
+    }
+}
+
+const char* mimeType(TileFormat format) {
+    switch (format) {
+    case TileFormat::Png:  return "image/png";
+    case TileFormat::Jpeg: return "image/jpeg";
+    case TileFormat::WebP: return "image/webp";
+    default:               return "application/octet-stream";
+    }
+}
+
+TileFormat fromName(const std::string& name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "png") {
+        return TileFormat::Png;
+    }
+    if (lower == "jpeg" || lower == "jpg") {
+        return TileFormat::Jpeg;
+    }
+    if (lower == "webp") {
+        return TileFormat::WebP;
+    }
+    return TileFormat::Unknown;
+}
+
+TileFormat fromContentType(const std::string& contentType) {
+    std::string type = contentType.substr(0, contentType.find(';'));
+    type.erase(std::remove_if(type.begin(), type.end(),
+                              [](unsigned char c) { return std::isspace(c); }), type.end());
+    std::transform(type.begin(), type.end(), type.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (type == "image/png") {
+        return TileFormat::Png;
+    }
+    if (type == "image/jpeg" || type == "image/jpg") {
+        return TileFormat::Jpeg;
+    }
+    if (type == "image/webp") {
+        return TileFormat::WebP;
+    }
+    return TileFormat::Unknown;
+}
+
+TileFormat sniff(const uint8_t* data, size_t size) {
+    static const uint8_t PNG_MAGIC[4] = { 0x89, 'P', 'N', 'G' };
+    if (size >= 4 && std::memcmp(data, PNG_MAGIC, 4) == 0) {
+        return TileFormat::Png;
+    }
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
+        return TileFormat::Jpeg;
+    }
+    if (size >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WEBP", 4) == 0) {
+        return TileFormat::WebP;
+    }
+    return TileFormat::Unknown;
+}
+
+std::string acceptHeader(const std::vector<TileFormat>& preferred) {
+    std::string header = "Accept: ";
+    int rank = 0;
+    for (TileFormat format : preferred) {
+        if (format == TileFormat::Unknown) {
+            continue;
+        }
+        if (rank > 0) {
+            // q drops by 0.1 per rank so servers honour our order
+            char q[16];
+            std::snprintf(q, sizeof(q), ";q=%.1f", std::max(0.1, 1.0 - 0.1 * rank));
+            header += std::string(", ") + mimeType(format) + q;
+        } else {
+            header += mimeType(format);
+        }
+        rank++;
+    }
+    if (rank == 0) {
+        header += "image/*";
+    }
+    return header;
+}
+
+} // namespace TileFormats
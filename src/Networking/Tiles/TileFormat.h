@@ -0,0 +1,40 @@
+// src/Networking/Tiles/TileFormat.h
+#ifndef TILEFORMAT_H
+#define TILEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Encoded image formats a tile source may serve. Cached tiles keep their
+// native format and are tagged by file extension.
+enum class TileFormat {
+    Png,
+    Jpeg,
+    WebP,
+    Unknown
+};
+
+namespace TileFormats {
+
+// Cache file extension without the dot ("png", "jpg", "webp")
+const char* extension(TileFormat format);
+
+const char* mimeType(TileFormat format);
+
+// Parses a config name such as "png", "jpeg"/"jpg" or "webp"
+TileFormat fromName(const std::string& name);
+
+// Maps a Content-Type header value (parameters are ignored)
+TileFormat fromContentType(const std::string& contentType);
+
+// Identifies the format from the file signature
+TileFormat sniff(const uint8_t* data, size_t size);
+
+// Accept header listing formats in order of preference
+std::string acceptHeader(const std::vector<TileFormat>& preferred);
+
+} // namespace TileFormats
+
+#endif // TILEFORMAT_H
@@ -0,0 +1,621 @@
+// src/Networking/Tiles/TileServer.cpp
+#include "TileServer.h"
+#include "../../Utils/Log.h"
+#include "../../Utils/Metrics.h"
+#include "../../Utils/Trace.h"
+#include "../../Utils/Utils.h"
+#include <chrono>
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// epoll user data of the two non-connection descriptors
+static const uint64_t LISTEN_ID = 0;
+static const uint64_t WAKE_ID = UINT64_MAX;
+
+// Requests are a line and a few headers; anything bigger is not a tile client
+static const size_t MAX_REQUEST_BYTES = 16 * 1024;
+
+// Deepest level a tile path may name
+static const int MAX_TILE_ZOOM = 30;
+
+// Forget remembered file hashes past this many files
+static const size_t MAX_FILE_TAGS = 1 << 20;
+
+static int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Case-insensitive value of one header in a raw header block, or ""
+static std::string headerValue(const std::string& headers, const char* name) {
+    size_t nameLength = std::strlen(name);
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string::npos) {
+        pos += 2;
+        if (headers.size() - pos > nameLength && headers[pos + nameLength] == ':' &&
+            strncasecmp(headers.c_str() + pos, name, nameLength) == 0) {
+            size_t start = headers.find_first_not_of(' ', pos + nameLength + 1);
+            size_t end = headers.find("\r\n", pos);
+            if (start == std::string::npos || (end != std::string::npos && start >= end)) {
+                return "";
+            }
+            return headers.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        }
+    }
+    return "";
+}
+
+static bool containsToken(const std::string& value, const char* token) {
+    std::string lower = value;
+    for (char& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return lower.find(token) != std::string::npos;
+}
+
+// Parses "/z/x/y" with an optional extension and query; false if malformed
+static bool parseTilePath(const std::string& target, TileKey& key) {
+    std::string path = target.substr(0, target.find('?'));
+    int values[3];
+    size_t pos = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (pos >= path.size() || path[pos] != '/') {
+            return false;
+        }
+        char* end = nullptr;
+        long value = std::strtol(path.c_str() + pos + 1, &end, 10);
+        size_t next = static_cast<size_t>(end - path.c_str());
+        if (next == pos + 1 || value < 0 || value > INT32_MAX) {
+            return false;
+        }
+        values[i] = static_cast<int>(value);
+        pos = next;
+    }
+    if (pos != path.size() && (path[pos] != '.' || path.find('/', pos) != std::string::npos)) {
+        return false;
+    }
+    key = { values[0], values[1], values[2] };
+    return key.z <= MAX_TILE_ZOOM && key.x < (1 << key.z) && key.y < (1 << key.z);
+}
+
+static bool etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+    return !ifNoneMatch.empty() && (ifNoneMatch == "*" || ifNoneMatch.find(etag) != std::string::npos);
+}
+
+TileServer::TileServer(TileFetcher& fetcher, const TileServerOptions& options)
+    : fetcher(fetcher), options(options),
+      upstreamPool(std::make_unique<ThreadPool>(std::max<size_t>(1, options.upstreamWaiters), "upstream wait")) {}
+
+TileServer::~TileServer() {
+    // Fetches in flight still signal wakeFd
+    upstreamPool.reset();
+    for (auto& [id, conn] : connections) {
+        for (Response& response : conn.output) {
+            if (response.fileFd >= 0) {
+                ::close(response.fileFd);
+            }
+        }
+        ::close(conn.fd);
+    }
+    for (int fd : { listenFd, epollFd, wakeFd }) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+bool TileServer::start(std::string& error) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+        error = "Invalid listen address " + options.host;
+        return false;
+    }
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int enable = 1;
+    if (listenFd < 0 ||
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0 ||
+        ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        error = "Cannot listen on " + options.host + ":" + std::to_string(options.port) + ": " +
+                std::strerror(errno);
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event listenEvent{};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.u64 = LISTEN_ID;
+    epoll_event wakeEvent{};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.u64 = WAKE_ID;
+    if (epollFd < 0 || wakeFd < 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) != 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEvent) != 0) {
+        error = std::string("Cannot set up epoll: ") + std::strerror(errno);
+        return false;
+    }
+    Utils::logInfo("Tile server listening on " + options.host + ":" + std::to_string(options.port));
+    return true;
+}
+
+void TileServer::stop() {
+    stopping = true;
+    uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void TileServer::run() {
+    Log::setThreadName("tile server");
+    Trace::setThreadName("tile server");
+    epoll_event events[128];
+    int64_t lastSweep = nowSeconds();
+    while (!stopping) {
+        int count = epoll_wait(epollFd, events, 128, 1000);
+        if (count < 0 && errno != EINTR) {
+            Utils::logError(std::string("epoll_wait failed: ") + std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptConnections();
+                continue;
+            }
+            if (id == WAKE_ID) {
+                uint64_t value;
+                ssize_t ignored = ::read(wakeFd, &value, sizeof(value));
+                (void)ignored;
+                deliverCompletions();
+                continue;
+            }
+
+            auto it = connections.find(id);
+            if (it == connections.end()) {
+                continue; // Closed earlier in this batch
+            }
+            Connection& conn = it->second;
+            bool alive = !(events[i].events & EPOLLERR);
+            if (alive && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))) {
+                alive = onReadable(conn);
+            }
+            if (alive && (events[i].events & EPOLLOUT)) {
+                alive = flushOutput(conn);
+            }
+            if (!alive) {
+                closeConnection(id);
+            }
+        }
+
+        if (nowSeconds() != lastSweep) {
+            lastSweep = nowSeconds();
+            closeIdleConnections();
+        }
+    }
+}
+
+void TileServer::acceptConnections() {
+    for (;;) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Utils::logError(std::string("accept failed: ") + std::strerror(errno));
+            }
+            return;
+        }
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        uint64_t id = nextConnectionId++;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        Connection& conn = connections[id];
+        conn.id = id;
+        conn.fd = fd;
+        conn.lastActive = nowSeconds();
+        counters.connections++;
+    }
+}
+
+bool TileServer::onReadable(Connection& conn) {
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.input.append(buffer, static_cast<size_t>(n));
+            conn.lastActive = nowSeconds();
+            if (conn.input.size() > MAX_REQUEST_BYTES) {
+                return false;
+            }
+            continue;
+        }
+        if (n == 0) {
+            conn.peerClosed = true; // Requests already buffered still get their answers
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return false;
+    }
+    return processRequests(conn);
+}
+
+bool TileServer::processRequests(Connection& conn) {
+    // Pipelined requests are answered in order, one at a time
+    while (!conn.waiting && !conn.closeAfterWrite) {
+        size_t end = conn.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            break;
+        }
+        std::string request = conn.input.substr(0, end + 2);
+        conn.input.erase(0, end + 4);
+        counters.requests++;
+
+        size_t lineEnd = request.find("\r\n");
+        std::string line = request.substr(0, lineEnd);
+        size_t firstSpace = line.find(' ');
+        size_t secondSpace = line.find(' ', firstSpace + 1);
+        if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+            serveError(conn, 400, "Bad Request", false);
+            break;
+        }
+        std::string method = line.substr(0, firstSpace);
+        std::string target = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+        std::string version = line.substr(secondSpace + 1);
+        std::string headers = request.substr(lineEnd);
+
+        std::string connection = headerValue(headers, "Connection");
+        bool keepAlive = version == "HTTP/1.1" ? !containsToken(connection, "close")
+                                               : containsToken(connection, "keep-alive");
+        std::string contentLength = headerValue(headers, "Content-Length");
+        if (!contentLength.empty() && contentLength != "0") {
+            serveError(conn, 400, "Bad Request", false); // Tile requests carry no body
+            break;
+        }
+
+        if (!handleRequest(conn, method, target, headerValue(headers, "If-None-Match"), keepAlive)) {
+            conn.waiting = true;
+        }
+    }
+    return flushOutput(conn);
+}
+
+bool TileServer::handleRequest(Connection& conn, const std::string& method, const std::string& target,
+                               const std::string& ifNoneMatch, bool keepAlive) {
+    bool head = method == "HEAD";
+    if (method != "GET" && !head) {
+        serveError(conn, 405, "Method Not Allowed", false);
+        return true;
+    }
+    if (target == "/metrics" || target.compare(0, 9, "/metrics?") == 0) {
+        serveMetrics(conn, head, keepAlive);
+        return true;
+    }
+    TileKey key;
+    if (!parseTilePath(target, key)) {
+        serveError(conn, 404, "Not Found", keepAlive);
+        return true;
+    }
+
+    std::filesystem::path path = fetcher.findCachedTile(key.z, key.x, key.y);
+    if (!path.empty() && serveFile(conn, path.string(), head, ifNoneMatch, keepAlive)) {
+        counters.hits++;
+        return true;
+    }
+    // Downloaded but not yet written by the cache writer
+    if (std::shared_ptr<const ByteBuffer> data = fetcher.getTileData(key.z, key.x, key.y)) {
+        counters.hits++;
+        serveBytes(conn, std::move(data), head, ifNoneMatch, keepAlive);
+        return true;
+    }
+    if (!options.upstream) {
+        serveError(conn, 404, "Not Found", keepAlive);
+        return true;
+    }
+
+    // One upstream fetch per tile, however many clients are waiting for it
+    std::vector<Waiter>& waiting = waiters[key];
+    waiting.push_back({ conn.id, head, keepAlive, ifNoneMatch });
+    if (waiting.size() > 1) {
+        counters.coalesced++;
+        return false;
+    }
+    counters.upstreamFetches++;
+    upstreamPool->enqueue([this, key]() {
+        bool ok = fetcher.fetchTile(key.z, key.x, key.y).get();
+        std::shared_ptr<const ByteBuffer> data = ok ? fetcher.readTile(key.z, key.x, key.y) : nullptr;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            completions.push_back({ key, std::move(data) });
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    });
+    return false;
+}
+
+void TileServer::deliverCompletions() {
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        done.swap(completions);
+    }
+    for (Completion& completion : done) {
+        auto it = waiters.find(completion.key);
+        if (it == waiters.end()) {
+            continue;
+        }
+        std::vector<Waiter> waiting = std::move(it->second);
+        waiters.erase(it);
+
+        for (const Waiter& waiter : waiting) {
+            auto conn = connections.find(waiter.connectionId);
+            if (conn == connections.end()) {
+                continue; // Client went away
+            }
+            if (completion.data) {
+                serveBytes(conn->second, completion.data, waiter.head, waiter.ifNoneMatch, waiter.keepAlive);
+            } else {
+                serveError(conn->second, 502, "Bad Gateway", waiter.keepAlive);
+            }
+            conn->second.waiting = false;
+            if (!processRequests(conn->second)) {
+                closeConnection(waiter.connectionId);
+            }
+        }
+    }
+}
+
+std::string TileServer::headers(int status, const char* reason, const char* contentType, size_t length,
+                                const std::string& etag, bool keepAlive) const {
+    std::string head = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\nServer: CustomGIS\r\n";
+    if (contentType) {
+        head += std::string("Content-Type: ") + contentType + "\r\n";
+    }
+    if (status != 304) {
+        head += "Content-Length: " + std::to_string(length) + "\r\n";
+    }
+    if (!etag.empty()) {
+        head += "ETag: " + etag + "\r\nCache-Control: public, max-age=" +
+                std::to_string(options.maxAgeSeconds) + "\r\n";
+    }
+    head += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    return head;
+}
+
+bool TileServer::serveFile(Connection& conn, const std::string& path, bool head, const std::string& ifNoneMatch,
+                           bool keepAlive) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    // Tiles are hard links into the blob store, so identical tiles share an
+    // inode and are hashed once
+    uint64_t fileKey = (static_cast<uint64_t>(info.st_dev) << 40) ^ static_cast<uint64_t>(info.st_ino);
+    int64_t mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    auto tag = fileTags.find(fileKey);
+    if (tag == fileTags.end() || tag->second.mtime != mtime || tag->second.size != info.st_size) {
+        ByteBuffer data(static_cast<size_t>(info.st_size));
+        if (::pread(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+            ::close(fd);
+            return false;
+        }
+        if (fileTags.size() >= MAX_FILE_TAGS) {
+            fileTags.clear();
+        }
+        tag = fileTags.insert_or_assign(fileKey, FileTag{ mtime, info.st_size, ContentHash::of(data.data(), data.size()) }).first;
+    }
+    std::string etag = "\"" + tag->second.hash.toHex() + "\"";
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    const char* contentType = TileFormats::mimeType(TileFormats::fromName(extension.empty() ? "" : extension.substr(1)));
+
+    Response response;
+    if (etagMatches(ifNoneMatch, etag)) {
+        counters.notModified++;
+        response.head = headers(304, "Not Modified", nullptr, 0, etag, keepAlive);
+        ::close(fd);
+    } else {
+        response.head = headers(200, "OK", contentType, static_cast<size_t>(info.st_size), etag, keepAlive);
+        if (head) {
+            ::close(fd);
+        } else {
+            response.fileFd = fd;
+            response.fileRemaining = static_cast<size_t>(info.st_size);
+        }
+    }
+    conn.output.push_back(std::move(response));
+    conn.closeAfterWrite = !keepAlive;
+    return true;
+}
+
+void TileServer::serveBytes(Connection& conn, std::shared_ptr<const ByteBuffer> data, bool head,
+                            const std::string& ifNoneMatch, bool keepAlive) {
+    std::string etag = "\"" + ContentHash::of(data->data(), data->size()).toHex() + "\"";
+    const char* contentType = TileFormats::mimeType(TileFormats::sniff(data->data(), data->size()));
+
+    Response response;
+    if (etagMatches(ifNoneMatch, etag)) {
+        counters.notModified++;
+        response.head = headers(304, "Not Modified", nullptr, 0, etag, keepAlive);
+    } else {
+        response.head = headers(200, "OK", contentType, data->size(), etag, keepAlive);
+        if (!head) {
+            response.body = std::move(data);
+        }
+    }
+    conn.output.push_back(std::move(response));
+    conn.closeAfterWrite = !keepAlive;
+}
+
+void TileServer::serveMetrics(Connection& conn, bool head, bool keepAlive) {
+    // The process registry (fetcher, caches, decoding) plus this server's counters
+    std::string text = Metrics::prometheusText();
+    auto counter = [&text](const char* name, const char* help, uint64_t value) {
+        text += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " counter\n" + name + " " +
+                std::to_string(value) + "\n";
+    };
+    counter("gis_server_requests_total", "HTTP requests answered or parked", counters.requests);
+    counter("gis_server_cache_hits_total", "Requests served from the cache", counters.hits);
+    counter("gis_server_not_modified_total", "Requests answered with 304", counters.notModified);
+    counter("gis_server_upstream_fetches_total", "Misses fetched from the tile source", counters.upstreamFetches);
+    counter("gis_server_coalesced_total", "Misses that joined a fetch in flight", counters.coalesced);
+    counter("gis_server_failures_total", "Requests answered with an error", counters.failures);
+    counter("gis_server_connections_total", "Connections accepted", counters.connections);
+
+    Response response;
+    response.head = headers(200, "OK", "text/plain; version=0.0.4", text.size(), "", keepAlive);
+    if (!head) {
+        response.body = std::make_shared<const ByteBuffer>(text.begin(), text.end());
+    }
+    conn.output.push_back(std::move(response));
+    conn.closeAfterWrite = !keepAlive;
+}
+
+void TileServer::serveError(Connection& conn, int status, const char* reason, bool keepAlive) {
+    counters.failures++;
+    Response response;
+    response.head = headers(status, reason, nullptr, 0, "", keepAlive);
+    conn.output.push_back(std::move(response));
+    conn.closeAfterWrite = !keepAlive;
+}
+
+bool TileServer::flushOutput(Connection& conn) {
+    while (!conn.output.empty()) {
+        Response& response = conn.output.front();
+        bool hasBody = response.fileRemaining > 0 || (response.body && response.bodyOffset < response.body->size());
+
+        while (response.headOffset < response.head.size()) {
+            ssize_t n = ::send(conn.fd, response.head.data() + response.headOffset,
+                               response.head.size() - response.headOffset,
+                               MSG_NOSIGNAL | (hasBody ? MSG_MORE : 0));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK; // Resumed on EPOLLOUT
+            }
+            response.headOffset += static_cast<size_t>(n);
+            conn.lastActive = nowSeconds();
+        }
+
+        // Zero copy from the page cache
+        while (response.fileRemaining > 0) {
+            off_t offset = static_cast<off_t>(response.fileOffset);
+            ssize_t n = ::sendfile(conn.fd, response.fileFd, &offset, response.fileRemaining);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (n == 0) {
+                return false; // File shrank underneath us
+            }
+            response.fileOffset = offset;
+            response.fileRemaining -= static_cast<size_t>(n);
+            conn.lastActive = nowSeconds();
+        }
+
+        while (response.body && response.bodyOffset < response.body->size()) {
+            ssize_t n = ::send(conn.fd, response.body->data() + response.bodyOffset,
+                               response.body->size() - response.bodyOffset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            response.bodyOffset += static_cast<size_t>(n);
+            conn.lastActive = nowSeconds();
+        }
+
+        if (response.fileFd >= 0) {
+            ::close(response.fileFd);
+        }
+        conn.output.pop_front();
+    }
+    // A half-closed peer is done once nothing it sent is left unanswered
+    return !conn.closeAfterWrite && !(conn.peerClosed && !conn.waiting);
+}
+
+void TileServer::closeConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) {
+        return;
+    }
+    for (Response& response : it->second.output) {
+        if (response.fileFd >= 0) {
+            ::close(response.fileFd);
+        }
+    }
+    ::close(it->second.fd); // Also removes it from the epoll set
+    connections.erase(it);
+}
+
+void TileServer::closeIdleConnections() {
+    int64_t now = nowSeconds();
+    std::vector<uint64_t> idle;
+    for (const auto& [id, conn] : connections) {
+        if (!conn.waiting && conn.output.empty() && now - conn.lastActive >= options.idleTimeoutSeconds) {
+            idle.push_back(id);
+        }
+    }
+    for (uint64_t id : idle) {
+        closeConnection(id);
+    }
+}
+
+#else // !__linux__
+
+TileServer::TileServer(TileFetcher& fetcher, const TileServerOptions& options)
+    : fetcher(fetcher), options(options) {}
+
+TileServer::~TileServer() = default;
+
+bool TileServer::start(std::string& error) {
+    error = "The tile server needs Linux (epoll, sendfile)";
+    return false;
+}
+
+void TileServer::run() {}
+
+void TileServer::stop() {
+    stopping = true;
+}
+
+#endif // __linux__
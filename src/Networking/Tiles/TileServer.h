@@ -0,0 +1,144 @@
+// src/Networking/Tiles/TileServer.h
+#ifndef TILESERVER_H
+#define TILESERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TileFetcher.h"
+#include "../../Utils/ContentHash.h"
+#include "../../Utils/ThreadPool.h"
+
+struct TileServerOptions {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    bool upstream = true;          // Fetch missing tiles from the fetcher's source
+    size_t upstreamWaiters = 16;   // Misses being fetched at once
+    int idleTimeoutSeconds = 60;   // Keep-alive connections idle this long are closed
+    int maxAgeSeconds = 86400;     // Cache-Control max-age sent with tiles
+};
+
+// Serves the tile cache over HTTP as /z/x/y.<ext> so several viewers on a
+// network share one cache: clients point a tile source at
+// http://host:port/{z}/{x}/{y}.png.
+//
+// One thread runs an epoll loop over non-blocking keep-alive connections.
+// Cached tiles are sent straight from the file with sendfile(); ETags are
+// the tile's content hash, so clients revalidate with If-None-Match and
+// get 304. A missing tile is fetched once through the TileFetcher no
+// matter how many clients ask for it; every request waiting on it is
+// answered when it arrives. GET /metrics returns the process metrics in
+// the Prometheus text format. Linux only.
+class TileServer {
+public:
+    TileServer(TileFetcher& fetcher, const TileServerOptions& options);
+    ~TileServer();
+
+    TileServer(const TileServer&) = delete;
+    TileServer& operator=(const TileServer&) = delete;
+
+    // Binds the listening socket; false (with error set) on failure
+    bool start(std::string& error);
+
+    // Serves until stop() is called from another thread or a signal handler
+    void run();
+    void stop();
+
+    struct Stats {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> hits{0};          // Served from the cache
+        std::atomic<uint64_t> notModified{0};   // 304 answers
+        std::atomic<uint64_t> upstreamFetches{0};
+        std::atomic<uint64_t> coalesced{0};     // Misses that joined a fetch in flight
+        std::atomic<uint64_t> failures{0};      // 404/502 answers
+        std::atomic<uint64_t> connections{0};
+    };
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Response {
+        std::string head;
+        int fileFd = -1;                           // Body sent with sendfile
+        int64_t fileOffset = 0;
+        size_t fileRemaining = 0;
+        std::shared_ptr<const ByteBuffer> body;    // Or sent from memory
+        size_t bodyOffset = 0;
+        size_t headOffset = 0;
+    };
+
+    struct Connection {
+        uint64_t id = 0;
+        int fd = -1;
+        std::string input;
+        std::deque<Response> output;
+        bool waiting = false;   // A request is blocked on an upstream fetch
+        bool closeAfterWrite = false;
+        bool peerClosed = false; // Read side shut; close once what was read is answered
+        int64_t lastActive = 0;
+    };
+
+    // A request parked until its tile arrives
+    struct Waiter {
+        uint64_t connectionId;
+        bool head;
+        bool keepAlive;
+        std::string ifNoneMatch;
+    };
+
+    struct Completion {
+        TileKey key;
+        std::shared_ptr<const ByteBuffer> data;
+    };
+
+    // Content hash of a cached file, remembered by inode and mtime
+    struct FileTag {
+        int64_t mtime;
+        int64_t size;
+        ContentHash hash;
+    };
+
+    TileFetcher& fetcher;
+    TileServerOptions options;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> stopping{false};
+    Stats counters;
+
+    uint64_t nextConnectionId = 1;
+    std::unordered_map<uint64_t, Connection> connections;
+    std::unordered_map<TileKey, std::vector<Waiter>, TileKeyHash> waiters;
+    std::unordered_map<uint64_t, FileTag> fileTags; // Keyed by device and inode
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+    std::unique_ptr<ThreadPool> upstreamPool; // Drained before the descriptors close
+
+    // The per-connection steps return false once the connection must close
+    void acceptConnections();
+    bool onReadable(Connection& conn);
+    bool processRequests(Connection& conn);
+    bool flushOutput(Connection& conn);
+    void closeConnection(uint64_t id);
+    void closeIdleConnections();
+    void deliverCompletions();
+
+    // Answers one GET/HEAD request; false if it has to wait for upstream
+    bool handleRequest(Connection& conn, const std::string& method, const std::string& target,
+                       const std::string& ifNoneMatch, bool keepAlive);
+    bool serveFile(Connection& conn, const std::string& path, bool head, const std::string& ifNoneMatch,
+                   bool keepAlive);
+    void serveBytes(Connection& conn, std::shared_ptr<const ByteBuffer> data, bool head,
+                    const std::string& ifNoneMatch, bool keepAlive);
+    void serveError(Connection& conn, int status, const char* reason, bool keepAlive);
+    void serveMetrics(Connection& conn, bool head, bool keepAlive);
+    std::string headers(int status, const char* reason, const char* contentType, size_t length,
+                        const std::string& etag, bool keepAlive) const;
+};
+
+#endif // TILESERVER_H
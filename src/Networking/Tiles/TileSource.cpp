@@ -0,0 +1,69 @@
+// src/Networking/Tiles/TileSource.cpp
+#include "TileSource.h"
+#include "../../Utils/ContentHash.h"
+#include <cctype>
+
+static void replaceAll(std::string& str, const std::string& from, const std::string& to) {
+    size_t pos = 0;
+    while ((pos = str.find(from, pos)) != std::string::npos) {
+        str.replace(pos, from.length(), to);
+        pos += to.length();
+    }
+}
+
+std::string TileSource::formatURL(size_t mirrorIndex, int z, int x, int y) const {
+    if (mirrorIndex >= mirrors.size()) {
+        return "";
+    }
+    std::string url = mirrors[mirrorIndex];
+    replaceAll(url, "{z}", std::to_string(z));
+    replaceAll(url, "{x}", std::to_string(x));
+    replaceAll(url, "{y}", std::to_string(y));
+    replaceAll(url, "{ext}", TileFormats::extension(acceptedFormats().front()));
+    return url;
+}
+
+std::vector<TileFormat> TileSource::acceptedFormats() const {
+    std::vector<TileFormat> accepted;
+    for (TileFormat format : formats) {
+        if (format != TileFormat::Unknown) {
+            accepted.push_back(format);
+        }
+    }
+    if (accepted.empty()) {
+        accepted.push_back(TileFormat::Png);
+    }
+    return accepted;
+}
+
+std::filesystem::path TileSource::cacheDir() const {
+    const std::filesystem::path root = "resources/tiles";
+    if (mirrors == openStreetMap().mirrors) {
+        return root;
+    }
+
+    // Readable prefix from the name; the hash tells apart sources that
+    // share a name but not their servers
+    std::string slug;
+    for (char c : name) {
+        if (slug.size() >= 32) {
+            break;
+        }
+        unsigned char u = static_cast<unsigned char>(c);
+        slug += std::isalnum(u) ? static_cast<char>(std::tolower(u)) : '-';
+    }
+    std::string urls;
+    for (const std::string& mirror : mirrors) {
+        urls += mirror + '\n';
+    }
+    ContentHash hash = ContentHash::of(reinterpret_cast<const uint8_t*>(urls.data()), urls.size());
+    return root / "sources" / ((slug.empty() ? "source" : slug) + "-" + hash.toHex().substr(0, 12));
+}
+
+TileSource TileSource::openStreetMap() {
+    TileSource source;
+    source.name = "OpenStreetMap";
+    source.mirrors = { "https://tile.openstreetmap.org/{z}/{x}/{y}.png" };
+    source.formats = { TileFormat::Png };
+    return source;
+}
@@ -0,0 +1,34 @@
+// src/Networking/Tiles/TileSource.h
+#ifndef TILESOURCE_H
+#define TILESOURCE_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "TileFormat.h"
+
+// Describes an upstream XYZ tile source and the mirrors that serve it.
+// Mirror URLs are templates containing {z}, {x} and {y} placeholders, and
+// optionally {ext} for the extension of the preferred format.
+struct TileSource {
+    std::string name;
+    std::vector<std::string> mirrors;
+    std::vector<TileFormat> formats; // Accepted formats, most preferred first
+
+    // Builds the URL of tile z/x/y on the given mirror
+    std::string formatURL(size_t mirrorIndex, int z, int x, int y) const;
+
+    // Preferred formats, or PNG when none are configured
+    std::vector<TileFormat> acceptedFormats() const;
+
+    // Directory this source's tiles are cached in, relative to the working
+    // directory. The built-in OpenStreetMap source keeps resources/tiles;
+    // any other source gets resources/tiles/sources/<name>-<hash of its
+    // URLs>, so sources never serve each other's tiles.
+    std::filesystem::path cacheDir() const;
+
+    // Default source used when nothing is configured
+    static TileSource openStreetMap();
+};
+
+#endif // TILESOURCE_H
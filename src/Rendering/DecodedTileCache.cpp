@@ -0,0 +1,269 @@
+// src/Rendering/DecodedTileCache.cpp
+#include "DecodedTileCache.h"
+#include "../Utils/Metrics.h"
+#include "../Utils/PaletteExpand.h"
+#include <algorithm>
+#include <cstring>
+
+void DecodedTile::expandTo(uint8_t* dst, int pitch) const {
+    switch (format) {
+    case Format::Indexed8:
+        for (int y = 0; y < height; ++y) {
+            PaletteExpand::expandIndexed(pixels.data() + static_cast<size_t>(y) * width, width,
+                                         palette.data(),
+                                         reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * pitch));
+        }
+        break;
+    case Format::Runs:
+        PaletteExpand::expandRuns(pixels.data(), pixels.size() / 3, palette.data(), dst, width, height, pitch);
+        break;
+    case Format::Argb8888:
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(dst + static_cast<size_t>(y) * pitch,
+                        pixels.data() + static_cast<size_t>(y) * width * 4,
+                        static_cast<size_t>(width) * 4);
+        }
+        break;
+    }
+}
+
+std::shared_ptr<DecodedTile> DecodedTile::fromIndexed(const uint8_t* indices, int width, int height,
+                                                      int pitch, const uint32_t* palette,
+                                                      int paletteSize) {
+    auto tile = std::make_shared<DecodedTile>();
+    tile->width = width;
+    tile->height = height;
+    for (int i = 0; i < paletteSize && i < 256; ++i) {
+        tile->palette[i] = palette[i];
+        if ((palette[i] >> 24) != 0xFF) {
+            tile->hasAlpha = true;
+        }
+    }
+
+    // Try runs first; give up as soon as they stop paying off
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> runs;
+    runs.reserve(pixelCount / 8);
+    uint8_t current = indices[0];
+    size_t length = 0;
+    bool useRuns = true;
+    for (int y = 0; y < height && useRuns; ++y) {
+        const uint8_t* row = indices + static_cast<size_t>(y) * pitch;
+        for (int x = 0; x < width; ++x) {
+            if (row[x] == current && length < 0xFFFF) {
+                ++length;
+                continue;
+            }
+            runs.push_back(static_cast<uint8_t>(length & 0xFF));
+            runs.push_back(static_cast<uint8_t>(length >> 8));
+            runs.push_back(current);
+            current = row[x];
+            length = 1;
+            if (runs.size() >= pixelCount / 2) {
+                useRuns = false;
+                break;
+            }
+        }
+    }
+
+    if (useRuns) {
+        runs.push_back(static_cast<uint8_t>(length & 0xFF));
+        runs.push_back(static_cast<uint8_t>(length >> 8));
+        runs.push_back(current);
+        runs.shrink_to_fit();
+        tile->format = Format::Runs;
+        tile->pixels = std::move(runs);
+    } else {
+        tile->format = Format::Indexed8;
+        tile->pixels.resize(pixelCount);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(tile->pixels.data() + static_cast<size_t>(y) * width,
+                        indices + static_cast<size_t>(y) * pitch, width);
+        }
+    }
+    return tile;
+}
+
+// Returns true and the ARGB color when every pixel of the image is identical
+static bool detectUniformColor(const DecodedImage& image, const ByteBuffer& pixels, uint32_t& color) {
+    size_t count = static_cast<size_t>(image.width) * image.height;
+    if (count == 0) {
+        return false;
+    }
+
+    if (image.paletteSize > 0) {
+        uint8_t first = pixels[0];
+        if (std::any_of(pixels.begin() + 1, pixels.begin() + count, [first](uint8_t v) { return v != first; })) {
+            return false;
+        }
+        color = image.palette[first];
+        return true;
+    }
+
+    const uint32_t* argb = reinterpret_cast<const uint32_t*>(pixels.data());
+    for (size_t i = 1; i < count; ++i) {
+        if (argb[i] != argb[0]) {
+            return false;
+        }
+    }
+    color = argb[0];
+    return true;
+}
+
+std::shared_ptr<DecodedTile> DecodedTile::fromImage(const DecodedImage& image, const ByteBuffer& pixels) {
+    uint32_t color = 0;
+    if (detectUniformColor(image, pixels, color)) {
+        auto tile = std::make_shared<DecodedTile>();
+        tile->width = image.width;
+        tile->height = image.height;
+        tile->uniform = true;
+        tile->uniformColor = color;
+        tile->hasAlpha = (color >> 24) != 0xFF;
+        return tile;
+    }
+
+    if (image.paletteSize > 0) {
+        return fromIndexed(pixels.data(), image.width, image.height, image.width,
+                           image.palette.data(), image.paletteSize);
+    }
+
+    // Truecolor tiles (e.g. photos) are kept expanded
+    auto tile = std::make_shared<DecodedTile>();
+    tile->format = Format::Argb8888;
+    tile->width = image.width;
+    tile->height = image.height;
+    tile->hasAlpha = image.hasAlpha;
+    tile->pixels.assign(pixels.begin(), pixels.begin() + image.pitch() * image.height);
+    return tile;
+}
+
+std::shared_ptr<DecodedTile> DecodedTile::overzoom(const DecodedTile& ancestor, int levels, int subX, int subY) {
+    if (ancestor.uniform) {
+        return std::make_shared<DecodedTile>(ancestor);
+    }
+
+    int width = ancestor.width;
+    int height = ancestor.height;
+    int originX = (subX * width) >> levels;
+    int originY = (subY * height) >> levels;
+
+    // Source column of every output column, shared by all rows
+    std::vector<int> columns(width);
+    for (int x = 0; x < width; ++x) {
+        columns[x] = std::min(originX + (x >> levels), width - 1);
+    }
+
+    if (ancestor.format == Format::Argb8888) {
+        auto tile = std::make_shared<DecodedTile>();
+        tile->format = Format::Argb8888;
+        tile->width = width;
+        tile->height = height;
+        tile->hasAlpha = ancestor.hasAlpha;
+        tile->pixels.resize(static_cast<size_t>(width) * height * 4);
+        const uint32_t* src = reinterpret_cast<const uint32_t*>(ancestor.pixels.data());
+        uint32_t* dst = reinterpret_cast<uint32_t*>(tile->pixels.data());
+        for (int y = 0; y < height; ++y) {
+            const uint32_t* srcRow = src + static_cast<size_t>(std::min(originY + (y >> levels), height - 1)) * width;
+            for (int x = 0; x < width; ++x) {
+                dst[static_cast<size_t>(y) * width + x] = srcRow[columns[x]];
+            }
+        }
+        return tile;
+    }
+
+    // Palette tiles stay palette tiles: work on the index plane
+    std::vector<uint8_t> indices;
+    if (ancestor.format == Format::Indexed8) {
+        indices = ancestor.pixels;
+    } else {
+        indices.reserve(static_cast<size_t>(width) * height);
+        for (size_t r = 0; r + 2 < ancestor.pixels.size(); r += 3) {
+            size_t length = ancestor.pixels[r] | (static_cast<size_t>(ancestor.pixels[r + 1]) << 8);
+            indices.insert(indices.end(), length, ancestor.pixels[r + 2]);
+        }
+        indices.resize(static_cast<size_t>(width) * height);
+    }
+
+    std::vector<uint8_t> scaled(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* srcRow = indices.data() + static_cast<size_t>(std::min(originY + (y >> levels), height - 1)) * width;
+        uint8_t* dstRow = scaled.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            dstRow[x] = srcRow[columns[x]];
+        }
+    }
+    auto tile = fromIndexed(scaled.data(), width, height, width, ancestor.palette.data(), 256);
+    tile->hasAlpha = ancestor.hasAlpha; // Unused palette slots are zero, not transparent pixels
+    return tile;
+}
+
+namespace {
+struct CacheMetrics {
+    Metrics::Counter& hits = Metrics::counter("gis_cache_lookups_total", "Tile cache lookups by tier and result",
+                                              "tier=\"decoded\",result=\"hit\"");
+    Metrics::Counter& misses = Metrics::counter("gis_cache_lookups_total", "Tile cache lookups by tier and result",
+                                                "tier=\"decoded\",result=\"miss\"");
+    Metrics::Gauge& bytes = Metrics::gauge("gis_decoded_cache_bytes", "RAM held by decoded tiles");
+};
+
+CacheMetrics& metrics() {
+    static CacheMetrics instance;
+    return instance;
+}
+}
+
+DecodedTileCache::DecodedTileCache(size_t budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+}
+
+DecodedTileCache::~DecodedTileCache() {
+    metrics().bytes.add(-static_cast<int64_t>(usedBytes));
+}
+
+std::shared_ptr<const DecodedTile> DecodedTileCache::get(const ContentHash& hash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(hash);
+    if (it == entries.end()) {
+        metrics().misses.add();
+        return nullptr;
+    }
+    metrics().hits.add();
+    lruList.splice(lruList.begin(), lruList, it->second.lruIt);
+    return it->second.tile;
+}
+
+void DecodedTileCache::put(const ContentHash& hash, std::shared_ptr<const DecodedTile> tile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t before = usedBytes;
+    auto it = entries.find(hash);
+    if (it != entries.end()) {
+        usedBytes -= it->second.tile->byteSize();
+        lruList.erase(it->second.lruIt);
+        entries.erase(it);
+    }
+    usedBytes += tile->byteSize();
+    lruList.push_front(hash);
+    entries[hash] = { std::move(tile), lruList.begin() };
+    evictIfNeeded();
+    metrics().bytes.add(static_cast<int64_t>(usedBytes) - static_cast<int64_t>(before));
+}
+
+size_t DecodedTileCache::bytesUsed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+size_t DecodedTileCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void DecodedTileCache::evictIfNeeded() {
+    while (usedBytes > budgetBytes && lruList.size() > 1) {
+        auto it = entries.find(lruList.back());
+        usedBytes -= it->second.tile->byteSize();
+        entries.erase(it);
+        lruList.pop_back();
+    }
+}
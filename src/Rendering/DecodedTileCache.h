@@ -0,0 +1,84 @@
+// src/Rendering/DecodedTileCache.h
+#ifndef DECODEDTILECACHE_H
+#define DECODEDTILECACHE_H
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../Utils/ContentHash.h"
+#include "../Decoding/ImageDecoder.h"
+
+// A decoded tile kept in its most compact form. Palette tiles stay as
+// 8-bit indices (or runs of indices) plus a palette and are only expanded
+// to 32-bit pixels when uploaded to a texture.
+struct DecodedTile {
+    enum class Format {
+        Indexed8,   // pixels = width*height palette indices
+        Runs,       // pixels = 3-byte runs (length lo, length hi, index)
+        Argb8888    // pixels = width*height*4 bytes, already expanded
+    };
+
+    Format format = Format::Argb8888;
+    int width = 0;
+    int height = 0;
+    bool hasAlpha = false;
+    bool uniform = false;                // Single color; pixels is empty
+    uint32_t uniformColor = 0;           // ARGB8888
+    std::array<uint32_t, 256> palette{}; // ARGB8888 entries
+    std::vector<uint8_t> pixels;
+
+    // The palette is an inline member, so sizeof(*this) already counts it
+    size_t byteSize() const {
+        return sizeof(*this) + pixels.size();
+    }
+
+    // Expands into 32-bit ARGB rows of the given pitch
+    void expandTo(uint8_t* dst, int pitch) const;
+
+    // Builds a compact tile from 8-bit indices, choosing runs when smaller
+    static std::shared_ptr<DecodedTile> fromIndexed(const uint8_t* indices, int width, int height,
+                                                    int pitch, const uint32_t* palette,
+                                                    int paletteSize);
+
+    // Builds the cached form of a decoder's output
+    static std::shared_ptr<DecodedTile> fromImage(const DecodedImage& image, const ByteBuffer& pixels);
+
+    // Upscales one (1 << levels)-th sub-square of an ancestor tile to full
+    // size (nearest neighbour), for zoom levels the source does not serve.
+    // subX/subY select the sub-square, each in [0, 1 << levels).
+    static std::shared_ptr<DecodedTile> overzoom(const DecodedTile& ancestor, int levels, int subX, int subY);
+};
+
+// Byte-budgeted LRU of decoded tiles keyed by content hash, so identical
+// tiles are decoded and stored once.
+class DecodedTileCache {
+public:
+    explicit DecodedTileCache(size_t budgetBytes);
+    ~DecodedTileCache();
+
+    std::shared_ptr<const DecodedTile> get(const ContentHash& hash);
+    void put(const ContentHash& hash, std::shared_ptr<const DecodedTile> tile);
+
+    size_t bytesUsed() const;
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const DecodedTile> tile;
+        std::list<ContentHash>::iterator lruIt;
+    };
+
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+    mutable std::mutex mutex;
+    std::list<ContentHash> lruList; // Front is most recently used
+    std::unordered_map<ContentHash, Entry, ContentHashHasher> entries;
+
+    void evictIfNeeded();
+};
+
+#endif // DECODEDTILECACHE_H
@@ -0,0 +1,92 @@
+// src/Rendering/FlightPath.cpp
+#include "FlightPath.h"
+#include "Projection.h"
+#include <algorithm>
+#include <cmath>
+
+// Trade-off between zooming and panning; 1.42 is the value the paper
+// found most comfortable in user tests
+static const double RHO = 1.42;
+
+// Path length flown per second by suggestedDurationMs()
+static const double FLIGHT_SPEED = 1.2;
+static const double MIN_FLIGHT_MS = 300.0;
+static const double MAX_FLIGHT_MS = 6000.0;
+
+FlightPath::FlightPath(const Viewport& from, double toLat, double toLon, double toZoom)
+    : from(from), toZoom(toZoom) {
+    startX = Projection::lonToWorldX(from.centerLon, 0.0);
+    startY = Projection::latToWorldY(from.centerLat, 0.0);
+    deltaX = Projection::lonToWorldX(toLon, 0.0) - startX;
+    deltaY = Projection::latToWorldY(toLat, 0.0) - startY;
+
+    // Cross the antimeridian when that is the shorter way
+    double world = Projection::worldSize(0.0);
+    if (deltaX > world / 2.0) {
+        deltaX -= world;
+    } else if (deltaX < -world / 2.0) {
+        deltaX += world;
+    }
+
+    double span = std::max(from.windowWidth, from.windowHeight);
+    w0 = span / std::pow(2.0, from.zoom);
+    w1 = span / std::pow(2.0, toZoom);
+    u1 = std::hypot(deltaX, deltaY);
+
+    double rho2 = RHO * RHO;
+    auto r = [&](int i) {
+        double w = i == 0 ? w0 : w1;
+        double sign = i == 0 ? 1.0 : -1.0;
+        double b = (w1 * w1 - w0 * w0 + sign * rho2 * rho2 * u1 * u1) / (2.0 * w * rho2 * u1);
+        return std::log(std::sqrt(b * b + 1.0) - b);
+    };
+
+    zoomOnly = u1 < 1e-9;
+    if (!zoomOnly) {
+        r0 = r(0);
+        length = (r(1) - r0) / RHO;
+        zoomOnly = !std::isfinite(length);
+    }
+    if (zoomOnly) {
+        r0 = 0.0;
+        length = std::abs(std::log(w1 / w0)) / RHO;
+    }
+}
+
+Viewport FlightPath::at(double t) const {
+    Viewport vp = from;
+    double fraction;
+    double w;
+    if (t >= 1.0) {
+        fraction = 1.0; // Land exactly on the target
+        w = w1;
+    } else if (zoomOnly) {
+        fraction = t;
+        w = w0 * std::pow(w1 / w0, t);
+    } else {
+        double s = t * length;
+        w = w0 * std::cosh(r0) / std::cosh(r0 + RHO * s);
+        double u = w0 * (std::cosh(r0) * std::tanh(r0 + RHO * s) - std::sinh(r0)) / (RHO * RHO);
+        fraction = u / u1;
+    }
+
+    double span = std::max(from.windowWidth, from.windowHeight);
+    vp.zoom = t >= 1.0 ? toZoom : std::max(std::log2(span / w), double(Viewport::MIN_ZOOM));
+
+    double world = Projection::worldSize(0.0);
+    double x = std::fmod(startX + deltaX * fraction, world);
+    if (x < 0.0) {
+        x += world;
+    }
+    vp.centerLon = Projection::worldXToLon(x, 0.0);
+    vp.centerLat = std::clamp(Projection::worldYToLat(startY + deltaY * fraction, 0.0),
+                              -Projection::MAX_LATITUDE, Projection::MAX_LATITUDE);
+    return vp;
+}
+
+double FlightPath::suggestedDurationMs() const {
+    if (length <= 0.0) {
+        return 0.0;
+    }
+    return std::clamp(1000.0 * length / FLIGHT_SPEED, MIN_FLIGHT_MS, MAX_FLIGHT_MS);
+}
@@ -0,0 +1,33 @@
+// src/Rendering/FlightPath.h
+#ifndef FLIGHTPATH_H
+#define FLIGHTPATH_H
+
+#include "Viewport.h"
+
+// Zoom-out / pan / zoom-in path between two views, following van Wijk and
+// Nuij's "smooth and efficient zooming and panning". Positions are
+// interpolated in Web Mercator world space, so the pan is a straight line
+// on screen, and longitude goes the short way round the antimeridian.
+class FlightPath {
+public:
+    FlightPath(const Viewport& from, double toLat, double toLon, double toZoom);
+
+    // View at progress t in [0, 1]; t maps linearly to path length
+    Viewport at(double t) const;
+
+    // Duration that flies the path at a comfortable constant speed, ms
+    double suggestedDurationMs() const;
+
+private:
+    Viewport from;
+    double startX, startY;   // View center in zoom 0 world pixels
+    double deltaX, deltaY;   // Offset to the target center, zoom 0 pixels
+    double toZoom;
+    double w0, w1;           // Visible span at either end, zoom 0 pixels
+    double u1;               // Pan distance, zoom 0 pixels
+    double r0;
+    double length;           // Path length S in the paper's units
+    bool zoomOnly;           // Same center: pure exponential zoom
+};
+
+#endif // FLIGHTPATH_H
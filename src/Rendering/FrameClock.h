@@ -0,0 +1,45 @@
+// src/Rendering/FrameClock.h
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Samples the time once per frame so everything animated within a frame
+// agrees on "now", independent of how long the frame takes to draw.
+// With a fixed step, every tick advances by exactly that much instead, so
+// a replayed session animates the same way however fast it runs.
+class FrameClock {
+public:
+    // Call once at the start of every frame
+    void tick() {
+        double t = fixedStepMs > 0.0 ? current + fixedStepMs
+                                     : std::chrono::duration<double, std::milli>(Clock::now() - origin).count();
+        delta = frames > 0 ? t - current : 0.0;
+        current = t;
+        frames++;
+    }
+
+    double now() const { return current; }     // ms since the clock was created
+    double deltaMs() const { return delta; }   // ms since the previous tick
+    uint64_t frameCount() const { return frames; }
+
+    // 0 returns to the wall clock (continuing from the current time)
+    void setFixedStep(double ms) {
+        if (ms <= 0.0 && fixedStepMs > 0.0) {
+            origin = Clock::now() - std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(current));
+        }
+        fixedStepMs = ms;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point origin = Clock::now();
+    double current = 0.0;
+    double delta = 0.0;
+    uint64_t frames = 0;
+    double fixedStepMs = 0.0;
+};
+
+#endif // FRAMECLOCK_H
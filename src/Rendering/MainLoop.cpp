@@ -4,67 +4,308 @@
 #include "TileRenderer.h"
 #include "../UI/UIManager.h"
 #include "../UI/Windows/MapWindow.h"
+#include "../Utils/Log.h"
+#include "../Utils/Metrics.h"
+#include "../Utils/Trace.h"
 #include "../Utils/Utils.h"
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <vector>
 
-void runMainLoop(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow) {
+// How long a replay waits after its last event for the view to load
+static const auto REPLAY_SETTLE_TIMEOUT = std::chrono::seconds(30);
+
+// F9 starts tracing the tile pipeline; pressing it again writes the spans
+// to trace-<time>.json in the working directory (open in ui.perfetto.dev)
+static void toggleTracing() {
+    if (!Trace::enabled()) {
+        Trace::start();
+        Utils::logInfo("Tracing started; press F9 again to save the trace");
+        return;
+    }
+    Trace::stop();
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(name, sizeof(name), "trace-%Y%m%d-%H%M%S.json", std::localtime(&now));
+    Trace::writeJson(name);
+}
+
+// Input that can change what is drawn
+static bool isInputEvent(const SDL_Event& event) {
+    switch (event.type) {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEWHEEL:
+    case SDL_KEYDOWN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// F10 starts recording input; pressing it again saves the events to
+// input-<time>.json for replay (CustomGIS --replay)
+static void toggleRecording(InputRecorder& recorder, SDL_Window* window, MapWindow& mapWindow) {
+    if (!recorder.isRecording()) {
+        int width = 0, height = 0;
+        SDL_GetWindowSize(window, &width, &height);
+        recorder.start(mapWindow.getTileRenderer().viewport, width, height);
+        return;
+    }
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(name, sizeof(name), "input-%Y%m%d-%H%M%S.json", std::localtime(&now));
+    recorder.stop(name);
+}
+
+// Updates the map and the UI and draws a frame if anything changed.
+// Returns false when nothing needed drawing.
+static bool updateAndDraw(SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow,
+                          double& cpuMs, double& presentMs) {
+    // Update map & UI
+    auto frameStart = std::chrono::steady_clock::now();
+    mapWindow.update();
+    uiManager.update();
+
+    // Combine flags
+    bool mapNeeds = mapWindow.needsRedraw();
+    bool uiNeeds  = uiManager.needsRedraw();
+    if (!mapNeeds && !uiNeeds) {
+        return false;
+    }
+
+    // **Fix B Implementation Start**
+
+    if (uiNeeds) {
+        // Notify TileRenderer to redraw the map
+        mapWindow.getTileRenderer().setNeedsRedraw(true);
+    }
+
+    // **Fix B Implementation End**
+
+    // Clear entire screen
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderClear(renderer);
+
+    // Render map first
+    mapWindow.render(renderer);
+
+    // Render UI on top
+    uiManager.render();
+
+    auto presentStart = std::chrono::steady_clock::now();
+    SDL_RenderPresent(renderer);
+    auto presentEnd = std::chrono::steady_clock::now();
+    cpuMs = std::chrono::duration<double, std::milli>(presentStart - frameStart).count();
+    presentMs = std::chrono::duration<double, std::milli>(presentEnd - presentStart).count();
+
+    // Reset the flags
+    mapWindow.getTileRenderer().resetRedrawFlag();
+    // Optionally you could do a UI manager "resetAllRedrawFlags()" if needed
+    return true;
+}
+
+// Frames are paced against a running deadline rather than a per-frame
+// delay, so animations advance at an even 60 Hz instead of drifting.
+// Delays until the next deadline; resyncs after a long stall.
+static const double FRAME_DELAY_MS = 1000.0 / 60;
+
+static void waitForNextFrame(double& nextFrame) {
+    nextFrame += FRAME_DELAY_MS;
+    double now = SDL_GetTicks();
+    if (nextFrame > now) {
+        SDL_Delay(static_cast<Uint32>(nextFrame - now));
+    } else if (now - nextFrame > FRAME_DELAY_MS) {
+        nextFrame = now;
+    }
+}
+
+void runMainLoop(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow,
+                 PerfHud& perfHud) {
     bool running = true;
     SDL_Event event;
 
-    const int FPS = 60;
-    const int frameDelay = 1000 / FPS;
+    double nextFrame = SDL_GetTicks();
+    Log::setThreadName("render");
+    Trace::setThreadName("render");
+    Metrics::Histogram& frameTime = Metrics::histogram("gis_frame_seconds", "Time to draw and present a frame");
+    Metrics::Histogram& inputLatency = Metrics::histogram(
+        "gis_input_latency_seconds", "From an input event to the first frame presented after it");
+    InputRecorder* recorder = uiManager.getInputRecorder();
 
     while (running) {
-        Uint32 frameStart = SDL_GetTicks();
+        Uint32 firstInputTicks = 0; // Oldest input event handled this iteration
 
         // Poll events
         while (SDL_PollEvent(&event)) {
+            if (firstInputTicks == 0 && isInputEvent(event)) {
+                firstInputTicks = std::max<Uint32>(event.common.timestamp, 1);
+            }
             if (event.type == SDL_QUIT) {
                 running = false;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9 && !event.key.repeat) {
+                toggleTracing();
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F10 && !event.key.repeat &&
+                       recorder) {
+                toggleRecording(*recorder, window, mapWindow);
             }
             uiManager.handleEvent(event);
         }
 
-        // Update map & UI
-        mapWindow.update();
-        uiManager.update();
+        double cpuMs = 0.0, presentMs = 0.0;
+        if (updateAndDraw(renderer, uiManager, mapWindow, cpuMs, presentMs)) {
+            frameTime.observeMicros(static_cast<uint64_t>((cpuMs + presentMs) * 1000.0));
+            perfHud.recordFrame(cpuMs, presentMs);
+            if (firstInputTicks != 0) {
+                Uint32 latencyMs = SDL_GetTicks() - firstInputTicks;
+                inputLatency.observe(std::chrono::milliseconds(latencyMs));
+                perfHud.recordInputLatency(latencyMs);
+            }
+        }
+        if (recorder) {
+            recorder->nextFrame();
+        }
 
-        // Combine flags
-        bool mapNeeds = mapWindow.needsRedraw();
-        bool uiNeeds  = uiManager.needsRedraw();
-        bool needsRedraw = mapNeeds || uiNeeds;
+        waitForNextFrame(nextFrame);
+    }
 
-        if (needsRedraw) {
-            // **Fix B Implementation Start**
+    if (recorder && recorder->isRecording()) {
+        toggleRecording(*recorder, window, mapWindow);
+    }
+}
 
-            if (uiNeeds) {
-                // Notify TileRenderer to redraw the map
-                mapWindow.getTileRenderer().setNeedsRedraw(true);
-            }
+static Metrics::Counter& tileRequests(const char* outcome) {
+    return Metrics::counter("gis_tile_requests_total", "", std::string("outcome=\"") + outcome + "\"");
+}
+
+static uint64_t tileRequestCount() {
+    uint64_t total = 0;
+    for (const char* outcome : { "disk", "downloaded", "shared", "in_progress", "failed" }) {
+        total += tileRequests(outcome).value();
+    }
+    return total;
+}
+
+static double percentile(std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+void runReplay(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow,
+               PerfHud& perfHud, const InputTrace& trace, ReplayReport& report) {
+    SDL_Event event;
+    Log::setThreadName("render");
+    Trace::setThreadName("render");
+    TileRenderer& tileRenderer = mapWindow.getTileRenderer();
 
-            // **Fix B Implementation End**
+    // Recreate the recorded window and view
+    SDL_RestoreWindow(window);
+    SDL_SetWindowSize(window, trace.windowWidth, trace.windowHeight);
+    SDL_Event resize{};
+    resize.type = SDL_WINDOWEVENT;
+    resize.window.event = SDL_WINDOWEVENT_RESIZED;
+    resize.window.data1 = trace.windowWidth;
+    resize.window.data2 = trace.windowHeight;
+    uiManager.handleEvent(resize);
+    tileRenderer.setViewport(trace.start);
+    tileRenderer.setFixedFrameStep(FRAME_DELAY_MS);
 
-            // Clear entire screen
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-            SDL_RenderClear(renderer);
+    Metrics::Counter& downloaded = tileRequests("downloaded");
+    Metrics::Counter& downloadBytes = Metrics::counter("gis_download_bytes_total", "");
+    uint64_t requestsBefore = tileRequestCount();
+    uint64_t downloadedBefore = downloaded.value();
+    uint64_t bytesBefore = downloadBytes.value();
 
-            // Render map first
-            mapWindow.render(renderer);
+    std::vector<double> frameMs;
+    frameMs.reserve(trace.frames + 600);
+    auto start = std::chrono::steady_clock::now();
+    auto lastInput = start;
+    double nextFrame = SDL_GetTicks();
+    size_t next = 0;
 
-            // Render UI on top
-            uiManager.render();
+    for (uint64_t frame = 0;; ++frame) {
+        // Live input is ignored so it cannot disturb the replay
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                report.aborted = true;
+            }
+        }
+        if (report.aborted) {
+            break;
+        }
 
-            SDL_RenderPresent(renderer);
+        // Deliver the events recorded on this frame
+        for (; next < trace.entries.size() && trace.entries[next].frame <= frame; ++next) {
+            const InputTrace::Entry& entry = trace.entries[next];
+            event = entry.event;
+            event.common.timestamp = SDL_GetTicks();
+            if (event.type == SDL_MOUSEWHEEL) {
+                SDL_WarpMouseInWindow(window, entry.mouseX, entry.mouseY); // Wheel handlers read the cursor
+            } else if (event.type == SDL_WINDOWEVENT) {
+                SDL_SetWindowSize(window, event.window.data1, event.window.data2);
+            }
+            uiManager.handleEvent(event);
+            lastInput = std::chrono::steady_clock::now();
+        }
 
-            // Reset the flags
-            mapWindow.getTileRenderer().resetRedrawFlag();
-            // Optionally you could do a UI manager "resetAllRedrawFlags()" if needed
+        double cpuMs = 0.0, presentMs = 0.0;
+        if (updateAndDraw(renderer, uiManager, mapWindow, cpuMs, presentMs)) {
+            frameMs.push_back(cpuMs + presentMs);
+            perfHud.recordFrame(cpuMs, presentMs);
         }
+        report.frames = frame + 1;
 
-        // Delay for fixed FPS
-        Uint32 frameTime = SDL_GetTicks() - frameStart;
-        if (frameDelay > frameTime) {
-            SDL_Delay(frameDelay - frameTime);
+        // After the recording ends, run until the view has fully loaded
+        auto now = std::chrono::steady_clock::now();
+        if (next == trace.entries.size() && frame >= trace.frames) {
+            if (tileRenderer.isViewComplete()) {
+                report.loadedAfterMs = std::chrono::duration<double, std::milli>(now - lastInput).count();
+                break;
+            }
+            if (now - lastInput > REPLAY_SETTLE_TIMEOUT) {
+                break;
+            }
         }
+        waitForNextFrame(nextFrame);
     }
+    tileRenderer.setFixedFrameStep(0.0);
+
+    report.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report.framesDrawn = frameMs.size();
+    std::sort(frameMs.begin(), frameMs.end());
+    report.frameP50Ms = percentile(frameMs, 0.50);
+    report.frameP90Ms = percentile(frameMs, 0.90);
+    report.frameP99Ms = percentile(frameMs, 0.99);
+    report.frameMaxMs = frameMs.empty() ? 0.0 : frameMs.back();
+    report.tilesRequested = tileRequestCount() - requestsBefore;
+    report.tilesFetched = downloaded.value() - downloadedBefore;
+    report.bytesDownloaded = downloadBytes.value() - bytesBefore;
+}
+
+std::string ReplayReport::toJson() const {
+    char text[1024];
+    std::snprintf(text, sizeof(text),
+                  "{\n"
+                  "  \"frames\": %llu,\n"
+                  "  \"framesDrawn\": %llu,\n"
+                  "  \"frameMs\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n"
+                  "  \"tilesRequested\": %llu,\n"
+                  "  \"tilesFetched\": %llu,\n"
+                  "  \"bytesDownloaded\": %llu,\n"
+                  "  \"durationMs\": %.1f,\n"
+                  "  \"loadedAfterMs\": %s,\n"
+                  "  \"aborted\": %s\n"
+                  "}\n",
+                  static_cast<unsigned long long>(frames), static_cast<unsigned long long>(framesDrawn),
+                  frameP50Ms, frameP90Ms, frameP99Ms, frameMaxMs, static_cast<unsigned long long>(tilesRequested),
+                  static_cast<unsigned long long>(tilesFetched), static_cast<unsigned long long>(bytesDownloaded),
+                  durationMs, loadedAfterMs < 0.0 ? "null" : std::to_string(loadedAfterMs).c_str(),
+                  aborted ? "true" : "false");
+    return text;
 }
@@ -2,9 +2,40 @@
 #define MAINLOOP_H
 
 #include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include "../UI/InputRecorder.h"
 #include "../UI/UIManager.h"
 #include "../UI/Windows/MapWindow.h"
+#include "../UI/Windows/PerfHud.h"
 
-void runMainLoop(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow);
+void runMainLoop(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow,
+                 PerfHud& perfHud);
+
+// What a replay measured, for comparing builds
+struct ReplayReport {
+    uint64_t frames = 0;          // Main loop iterations
+    uint64_t framesDrawn = 0;
+    double frameP50Ms = 0.0;      // Update, draw and present of the drawn frames
+    double frameP90Ms = 0.0;
+    double frameP99Ms = 0.0;
+    double frameMaxMs = 0.0;
+    uint64_t tilesRequested = 0;  // Tile fetch tasks
+    uint64_t tilesFetched = 0;    // Tiles downloaded from upstream
+    uint64_t bytesDownloaded = 0;
+    double durationMs = 0.0;
+    double loadedAfterMs = -1.0;  // From the last event to a fully loaded view; < 0 if it never loaded
+    bool aborted = false;         // The window was closed
+
+    std::string toJson() const;
+};
+
+// Plays a recorded input trace back from its starting view, delivering
+// every event on the frame it was recorded on. Animations advance a fixed
+// step per frame, so the same trace always drives the same sequence of
+// views. Once the events run out it keeps drawing until every visible tile
+// has loaded (or 30 s pass).
+void runReplay(SDL_Window* window, SDL_Renderer* renderer, UIManager& uiManager, MapWindow& mapWindow,
+               PerfHud& perfHud, const InputTrace& trace, ReplayReport& report);
 
 #endif // MAINLOOP_H
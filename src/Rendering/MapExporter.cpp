@@ -0,0 +1,188 @@
+// src/Rendering/MapExporter.cpp
+#include "MapExporter.h"
+#include "Projection.h"
+#include "../Encoding/PngWriter.h"
+#include "../Encoding/TiffWriter.h"
+#include "../Utils/ThreadPool.h"
+#include "../Utils/Trace.h"
+#include "../Utils/Utils.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+// Larger exports are almost certainly a mistyped zoom
+static const double MAX_EXPORT_SIDE = 1 << 20;
+
+// Top-left pixel of the export in world pixels at the export zoom. Whole
+// pixels, so tile edges land on the same pixels in every block.
+static void exportOrigin(const ExportOptions& options, double& left, double& top) {
+    left = std::floor(Projection::lonToWorldX(options.minLon, options.zoom));
+    top = std::floor(Projection::latToWorldY(std::min(options.maxLat, Projection::MAX_LATITUDE), options.zoom));
+}
+
+// View of the export pixels [x, x + width) x [y, y + height)
+static Viewport regionView(const ExportOptions& options, double left, double top,
+                           int x, int y, int width, int height) {
+    Viewport vp;
+    vp.centerLon = Projection::worldXToLon(left + x + width / 2.0, options.zoom);
+    vp.centerLat = Projection::worldYToLat(top + y + height / 2.0, options.zoom);
+    vp.zoom = options.zoom;
+    vp.windowWidth = width;
+    vp.windowHeight = height;
+    return vp;
+}
+
+MapExporter::MapExporter(StaticMapRenderer& renderer) : renderer(renderer) {}
+
+bool MapExporter::imageSize(const ExportOptions& options, int& width, int& height) {
+    double left, top;
+    exportOrigin(options, left, top);
+    double right = std::ceil(Projection::lonToWorldX(options.maxLon, options.zoom));
+    if (options.maxLon < options.minLon) {
+        right += Projection::worldSize(options.zoom); // Box crosses the antimeridian
+    }
+    double bottom = std::ceil(Projection::latToWorldY(std::max(options.minLat, -Projection::MAX_LATITUDE),
+                                                      options.zoom));
+    if (right - left < 1.0 || bottom - top < 1.0 ||
+        right - left > MAX_EXPORT_SIDE || bottom - top > MAX_EXPORT_SIDE) {
+        return false;
+    }
+    width = static_cast<int>(right - left);
+    height = static_cast<int>(bottom - top);
+    return true;
+}
+
+bool MapExporter::run(const ExportOptions& options, const std::string& path, const std::atomic<bool>& cancel,
+                      const std::function<void(const ExportProgress&)>& onProgress, std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+    ExportProgress progress;
+    if (options.zoom < Viewport::MIN_ZOOM || options.zoom > Viewport::MAX_OVERZOOM) {
+        error = "Zoom must be between " + std::to_string(Viewport::MIN_ZOOM) + " and " +
+                std::to_string(Viewport::MAX_OVERZOOM);
+        return false;
+    }
+    if (!imageSize(options, progress.width, progress.height)) {
+        error = "Bounding box is empty or too large at this zoom";
+        return false;
+    }
+    const int width = progress.width;
+    const int height = progress.height;
+    const int stripHeight = std::max(1, std::min(options.stripHeight, height));
+    const int blockWidth = std::max(256, options.blockWidth);
+    double left, top;
+    exportOrigin(options, left, top);
+
+    // Encoder for the chosen format, fed one strip at a time
+    std::ofstream pngFile;
+    std::unique_ptr<PngWriter> png;
+    std::unique_ptr<TiffWriter> tiff;
+    if (options.format == ExportFormat::Png) {
+        pngFile.open(path, std::ios::binary | std::ios::trunc);
+        png = std::make_unique<PngWriter>([&pngFile](const uint8_t* data, size_t size) {
+            pngFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return static_cast<bool>(pngFile);
+        }, width, height, false);
+    } else {
+        tiff = std::make_unique<TiffWriter>(path, width, height, false);
+    }
+    auto writeRows = [&](const std::vector<uint32_t>& strip, int rows) {
+        Trace::Scope span("encode strip", "encode");
+        span.setValue(rows);
+        return png ? png->writeRows(strip.data(), rows, width) : tiff->writeRows(strip.data(), rows, width);
+    };
+
+    size_t threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(threads, "export render");
+    std::atomic<int> fallbacks(0);
+    std::atomic<int> missing(0);
+
+    // Two strips: one being rendered while the other is encoded
+    std::vector<uint32_t> strips[2];
+    std::future<bool> encoding;
+    bool ok = true;
+
+    int stripIndex = 0;
+    for (int y = 0; y < height && ok && !cancel; y += stripHeight, ++stripIndex) {
+        int rows = std::min(stripHeight, height - y);
+        std::vector<uint32_t>& strip = strips[stripIndex & 1];
+        strip.resize(static_cast<size_t>(width) * rows);
+
+        // Get the next strip's downloads going while this one renders
+        if (y + rows < height) {
+            renderer.prefetch(regionView(options, left, top, 0, y + rows, width,
+                                         std::min(stripHeight, height - y - rows)));
+        }
+
+        std::vector<std::future<void>> blocks;
+        for (int x = 0; x < width; x += blockWidth) {
+            int columns = std::min(blockWidth, width - x);
+            blocks.push_back(pool.enqueue([&, x, y, rows, columns]() {
+                if (cancel) {
+                    return;
+                }
+                thread_local StaticMapRenderer::Image block;
+                StaticMapRenderer::Stats stats = renderer.render(
+                    regionView(options, left, top, x, y, columns, rows), block, options.tileTimeoutMs);
+                fallbacks += stats.fallbacks;
+                missing += stats.missing;
+                for (int r = 0; r < rows; ++r) {
+                    std::copy_n(block.pixels.data() + static_cast<size_t>(r) * columns, columns,
+                                strip.data() + static_cast<size_t>(r) * width + x);
+                }
+            }));
+        }
+        for (std::future<void>& block : blocks) {
+            block.get();
+        }
+        if (cancel) {
+            break;
+        }
+
+        // Hand the strip to the encoder once the previous one is written
+        if (encoding.valid() && !encoding.get()) {
+            ok = false;
+            break;
+        }
+        encoding = std::async(std::launch::async, writeRows, std::cref(strip), rows);
+
+        progress.rowsDone = y + rows;
+        progress.tilesFallback = fallbacks;
+        progress.tilesMissing = missing;
+        progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        onProgress(progress);
+    }
+    if (encoding.valid() && !encoding.get()) {
+        ok = false;
+    }
+
+    if (cancel) {
+        error = "Cancelled";
+        ok = false;
+    } else {
+        ok = ok && (png ? png->finish() : tiff->finish());
+        if (pngFile.is_open()) {
+            pngFile.close();
+            ok = ok && static_cast<bool>(pngFile);
+        }
+        if (!ok) {
+            error = "Failed to write " + path;
+        }
+    }
+
+    if (!ok) {
+        png.reset();
+        tiff.reset();
+        pngFile.close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+
+    progress.rowsDone = height;
+    progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    onProgress(progress);
+    Utils::logInfo("Exported " + std::to_string(width) + "x" + std::to_string(height) + " map to " + path);
+    return true;
+}
@@ -0,0 +1,59 @@
+// src/Rendering/MapExporter.h
+#ifndef MAPEXPORTER_H
+#define MAPEXPORTER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include "StaticMapRenderer.h"
+
+enum class ExportFormat {
+    Png,
+    BigTiff
+};
+
+struct ExportOptions {
+    double minLon = 0.0;
+    double minLat = 0.0;
+    double maxLon = 0.0;
+    double maxLat = 0.0;
+    double zoom = 0.0;
+    ExportFormat format = ExportFormat::Png;
+    int stripHeight = 256;     // Rows composited at once
+    int blockWidth = 1024;     // Strips are split into blocks rendered in parallel
+    size_t threads = 0;        // Rendering threads; 0 = one per core
+    int tileTimeoutMs = 30000; // Per block; late tiles fall back to ancestors
+};
+
+struct ExportProgress {
+    int width = 0;
+    int height = 0;
+    int rowsDone = 0;          // Rows handed to the encoder
+    int tilesFallback = 0;     // Drawn from a lower zoom (counted per block)
+    int tilesMissing = 0;      // Left blank (counted per block)
+    double elapsedSeconds = 0.0;
+};
+
+// Writes a map of a bounding box at a zoom level to a PNG or BigTIFF file
+// of any size in bounded memory. The image is produced in horizontal
+// strips: the blocks of a strip are rendered on all cores while the
+// previous strip is being encoded and the next strip's tiles download, so
+// only two strips, the decoded tile cache and the fetcher's buffers are in
+// memory at any time.
+class MapExporter {
+public:
+    explicit MapExporter(StaticMapRenderer& renderer);
+
+    // Pixel size of the export; false if the box is empty or too large
+    static bool imageSize(const ExportOptions& options, int& width, int& height);
+
+    // Runs until the file is written or cancel is set (the partial file is
+    // then removed). Progress is reported after every strip.
+    bool run(const ExportOptions& options, const std::string& path, const std::atomic<bool>& cancel,
+             const std::function<void(const ExportProgress&)>& onProgress, std::string& error);
+
+private:
+    StaticMapRenderer& renderer;
+};
+
+#endif // MAPEXPORTER_H
@@ -0,0 +1,39 @@
+// src/Rendering/Projection.h
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <cmath>
+
+// Web Mercator conversions between lon/lat and world pixel coordinates at
+// a (possibly fractional) zoom level, where the world is 256 * 2^zoom
+// pixels wide.
+namespace Projection {
+
+constexpr double TILE_SIZE = 256.0;
+constexpr double MAX_LATITUDE = 85.0511;
+
+inline double worldSize(double zoom) {
+    return TILE_SIZE * std::pow(2.0, zoom);
+}
+
+inline double lonToWorldX(double lon, double zoom) {
+    return (lon + 180.0) / 360.0 * worldSize(zoom);
+}
+
+inline double latToWorldY(double lat, double zoom) {
+    double latRad = lat * M_PI / 180.0;
+    return (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0 * worldSize(zoom);
+}
+
+inline double worldXToLon(double x, double zoom) {
+    return x / worldSize(zoom) * 360.0 - 180.0;
+}
+
+inline double worldYToLat(double y, double zoom) {
+    double n = M_PI - 2.0 * M_PI * y / worldSize(zoom);
+    return 180.0 / M_PI * std::atan(std::sinh(n));
+}
+
+} // namespace Projection
+
+#endif // PROJECTION_H
@@ -0,0 +1,261 @@
+// src/Rendering/StaticMapRenderer.cpp
+#include "StaticMapRenderer.h"
+#include "Projection.h"
+#include "../Decoding/ImageDecoder.h"
+#include "../Utils/Trace.h"
+#include "../Utils/Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unordered_set>
+
+// Same limits and background as the window renderer
+static const int MAX_FALLBACK_LEVELS = 8;
+static const uint32_t BACKGROUND = 0xFFFFFFFF;
+
+// Forget remembered tile hashes past this many tiles
+static const size_t MAX_REMEMBERED_HASHES = 1 << 20;
+
+// Finished downloads are dropped from the shared table past this size
+static const size_t MAX_TRACKED_DOWNLOADS = 256;
+
+StaticMapRenderer::StaticMapRenderer(TileFetcher& fetcher, std::shared_ptr<DecodedTileCache> decodedTiles)
+    : fetcher(fetcher), decodedTiles(std::move(decodedTiles)) {}
+
+std::shared_ptr<const DecodedTile> StaticMapRenderer::loadTile(const TileKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tileHashes.find(key);
+        if (it != tileHashes.end()) {
+            if (std::shared_ptr<const DecodedTile> tile = decodedTiles->get(it->second)) {
+                return tile;
+            }
+        }
+    }
+
+    std::shared_ptr<const ByteBuffer> data = fetcher.readTile(key.z, key.x, key.y);
+    if (!data) {
+        return nullptr;
+    }
+    ContentHash hash = ContentHash::of(data->data(), data->size());
+    std::shared_ptr<const DecodedTile> tile = decodedTiles->get(hash);
+    if (!tile) {
+        // Decoders are not thread-safe; each rendering thread keeps its own
+        thread_local std::unique_ptr<ImageDecoder> decoder;
+        thread_local ByteBuffer pixels;
+        if (!decoder) {
+            decoder = ImageDecoder::create();
+        }
+        Trace::Scope span("decode", "decode", key.z, key.x, key.y);
+        DecodedImage image;
+        if (!decoder->decode(data->data(), data->size(), image, pixels)) {
+            Utils::logError("Failed to decode image for tile z=" + std::to_string(key.z) +
+                            ", x=" + std::to_string(key.x) + ", y=" + std::to_string(key.y) +
+                            " (" + decoder->name() + ")");
+            return nullptr;
+        }
+        std::shared_ptr<DecodedTile> decoded = DecodedTile::fromImage(image, pixels);
+        decodedTiles->put(hash, decoded);
+        tile = decoded;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tileHashes.size() >= MAX_REMEMBERED_HASHES) {
+        tileHashes.clear();
+    }
+    tileHashes[key] = hash;
+    return tile;
+}
+
+std::shared_future<bool> StaticMapRenderer::download(const TileKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = downloads.find(key);
+    if (it != downloads.end() &&
+        it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return it->second; // Another render is already waiting for it
+    }
+
+    if (downloads.size() >= MAX_TRACKED_DOWNLOADS) {
+        for (auto d = downloads.begin(); d != downloads.end();) {
+            if (d->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                d = downloads.erase(d);
+            } else {
+                ++d;
+            }
+        }
+    }
+    std::shared_future<bool> result = fetcher.fetchTile(key.z, key.x, key.y).share();
+    downloads[key] = result;
+    return result;
+}
+
+// Draws the (1 << levels)-th sub-square of tile that covers key into rect,
+// nearest neighbour like the window renderer's texture scaling
+static void drawTile(StaticMapRenderer::Image& image, const DecodedTile& tile, const TileKey& key,
+                     int levels, const TileRect& rect) {
+    int x0 = std::max(0, static_cast<int>(rect.x));
+    int y0 = std::max(0, static_cast<int>(rect.y));
+    int x1 = std::min(image.width, static_cast<int>(rect.x + rect.w));
+    int y1 = std::min(image.height, static_cast<int>(rect.y + rect.h));
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    auto blend = [](uint32_t src, uint32_t dst) {
+        uint32_t a = src >> 24;
+        if (a == 255) {
+            return src;
+        }
+        auto channel = [&](int shift) {
+            uint32_t s = (src >> shift) & 0xFF;
+            uint32_t d = (dst >> shift) & 0xFF;
+            return ((s * a + d * (255 - a) + 127) / 255) << shift;
+        };
+        return 0xFF000000u | channel(16) | channel(8) | channel(0);
+    };
+
+    if (tile.uniform) {
+        for (int y = y0; y < y1; ++y) {
+            uint32_t* dst = image.pixels.data() + static_cast<size_t>(y) * image.width;
+            for (int x = x0; x < x1; ++x) {
+                dst[x] = blend(tile.uniformColor, dst[x]);
+            }
+        }
+        return;
+    }
+
+    thread_local std::vector<uint8_t> expanded;
+    expanded.resize(static_cast<size_t>(tile.width) * tile.height * 4);
+    tile.expandTo(expanded.data(), tile.width * 4);
+    const uint32_t* src = reinterpret_cast<const uint32_t*>(expanded.data());
+
+    int span = 1 << levels;
+    float srcW = float(tile.width) / span;
+    float srcH = float(tile.height) / span;
+    float srcX = (key.x & (span - 1)) * srcW;
+    float srcY = (key.y & (span - 1)) * srcH;
+
+    thread_local std::vector<int> columns;
+    columns.resize(x1 - x0);
+    for (int x = x0; x < x1; ++x) {
+        int sx = static_cast<int>(srcX + (x - rect.x + 0.5f) * srcW / rect.w);
+        columns[x - x0] = std::clamp(sx, 0, tile.width - 1);
+    }
+
+    for (int y = y0; y < y1; ++y) {
+        int sy = std::clamp(static_cast<int>(srcY + (y - rect.y + 0.5f) * srcH / rect.h), 0, tile.height - 1);
+        const uint32_t* srcRow = src + static_cast<size_t>(sy) * tile.width;
+        uint32_t* dst = image.pixels.data() + static_cast<size_t>(y) * image.width;
+        if (tile.hasAlpha) {
+            for (int x = x0; x < x1; ++x) {
+                dst[x] = blend(srcRow[columns[x - x0]], dst[x]);
+            }
+        } else {
+            for (int x = x0; x < x1; ++x) {
+                dst[x] = srcRow[columns[x - x0]];
+            }
+        }
+    }
+}
+
+StaticMapRenderer::Stats StaticMapRenderer::render(const Viewport& vp, Image& out, int timeoutMs) {
+    Trace::Scope span("static render", "render");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    Stats stats;
+
+    out.width = vp.windowWidth;
+    out.height = vp.windowHeight;
+    out.pixels.assign(static_cast<size_t>(out.width) * out.height, BACKGROUND);
+
+    int level = std::clamp(static_cast<int>(std::lround(vp.zoom)), Viewport::MIN_ZOOM, Viewport::MAX_OVERZOOM);
+    std::vector<std::pair<TileKey, TileRect>> placements = TileLayout::visibleTiles(vp, level);
+    stats.tiles = static_cast<int>(placements.size());
+
+    // Past MAX_ZOOM tiles are cut from their deepest served ancestor
+    auto sourceLevels = [](const TileKey& key) { return std::max(0, key.z - Viewport::MAX_ZOOM); };
+
+    // Load what is cached, and download the rest in parallel
+    std::unordered_map<TileKey, std::shared_ptr<const DecodedTile>, TileKeyHash> tiles;
+    std::vector<std::pair<TileKey, std::shared_future<bool>>> pending;
+    for (const auto& [key, rect] : placements) {
+        TileKey source = TileLayout::ancestor(key, sourceLevels(key));
+        if (tiles.count(source)) {
+            continue;
+        }
+        tiles[source] = loadTile(source);
+        if (!tiles[source]) {
+            pending.emplace_back(source, download(source));
+        }
+    }
+    for (auto& [key, result] : pending) {
+        if (result.wait_until(deadline) == std::future_status::ready) {
+            tiles[key] = loadTile(key);
+            stats.fetched += tiles[key] ? 1 : 0;
+        }
+    }
+
+    for (const auto& [key, rect] : placements) {
+        int levels = sourceLevels(key);
+        std::shared_ptr<const DecodedTile> tile = tiles[TileLayout::ancestor(key, levels)];
+
+        // Missing: draw a cached ancestor scaled up instead
+        for (int extra = 1; !tile && extra <= MAX_FALLBACK_LEVELS && levels + extra <= key.z; ++extra) {
+            TileKey ancestorKey = TileLayout::ancestor(key, levels + extra);
+            auto it = tiles.find(ancestorKey);
+            tile = it != tiles.end() ? it->second : (tiles[ancestorKey] = loadTile(ancestorKey));
+            if (tile) {
+                levels += extra;
+                stats.fallbacks++;
+            }
+        }
+        if (!tile) {
+            stats.missing++;
+            continue;
+        }
+        drawTile(out, *tile, key, levels, rect);
+    }
+    return stats;
+}
+
+void StaticMapRenderer::prefetch(const Viewport& vp) {
+    int level = std::clamp(static_cast<int>(std::lround(vp.zoom)), Viewport::MIN_ZOOM, Viewport::MAX_OVERZOOM);
+    std::unordered_set<TileKey, TileKeyHash> seen;
+    for (const auto& [key, rect] : TileLayout::visibleTiles(vp, level)) {
+        TileKey source = TileLayout::ancestor(key, std::max(0, key.z - Viewport::MAX_ZOOM));
+        if (!seen.insert(source).second) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tileHashes.count(source)) {
+                continue;
+            }
+        }
+        if (!fetcher.isTileOnDisk(source.z, source.x, source.y)) {
+            download(source);
+        }
+    }
+}
+
+Viewport StaticMapRenderer::fitBounds(double minLon, double minLat, double maxLon, double maxLat,
+                                      int width, int height) {
+    double world = Projection::worldSize(0.0);
+    double left = Projection::lonToWorldX(minLon, 0.0);
+    double spanX = Projection::lonToWorldX(maxLon, 0.0) - left;
+    if (spanX <= 0.0) {
+        spanX += world; // Box crosses the antimeridian
+    }
+    double top = Projection::latToWorldY(std::min(maxLat, Projection::MAX_LATITUDE), 0.0);
+    double spanY = Projection::latToWorldY(std::max(minLat, -Projection::MAX_LATITUDE), 0.0) - top;
+
+    double zoom = std::min(std::log2(width / spanX), std::log2(height / std::max(spanY, 1e-9)));
+
+    Viewport vp;
+    vp.zoom = std::clamp(zoom, double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
+    double centerX = std::fmod(left + spanX / 2.0, world);
+    vp.centerLon = Projection::worldXToLon(centerX, 0.0);
+    vp.centerLat = Projection::worldYToLat(top + spanY / 2.0, 0.0);
+    vp.windowWidth = width;
+    vp.windowHeight = height;
+    return vp;
+}
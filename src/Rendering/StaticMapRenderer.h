@@ -0,0 +1,64 @@
+// src/Rendering/StaticMapRenderer.h
+#ifndef STATICMAPRENDERER_H
+#define STATICMAPRENDERER_H
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../Networking/Tiles/TileFetcher.h"
+#include "DecodedTileCache.h"
+#include "TileLayout.h"
+#include "Viewport.h"
+
+// Renders map images without a window. Tiles are placed by TileLayout like
+// on screen, fetched through a TileFetcher, kept in a DecodedTileCache and
+// composited on the CPU. render() is thread-safe: concurrent renders share
+// the fetcher, the decoded tiles and any download in flight.
+class StaticMapRenderer {
+public:
+    StaticMapRenderer(TileFetcher& fetcher, std::shared_ptr<DecodedTileCache> decodedTiles);
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> pixels; // ARGB8888, width * height
+    };
+
+    struct Stats {
+        int tiles = 0;       // Tiles the view needs
+        int fetched = 0;     // Of those, downloaded for this render
+        int fallbacks = 0;   // Drawn from an ancestor instead
+        int missing = 0;     // Left blank
+    };
+
+    // Renders vp (windowWidth x windowHeight pixels). Tiles not available
+    // within timeoutMs are drawn from a cached ancestor, or left blank.
+    Stats render(const Viewport& vp, Image& out, int timeoutMs = 10000);
+
+    // Starts downloading the tiles vp needs that are neither cached nor on
+    // disk, without waiting; a later render() joins those downloads
+    void prefetch(const Viewport& vp);
+
+    // Largest fractional zoom at which the box fits into width x height
+    static Viewport fitBounds(double minLon, double minLat, double maxLon, double maxLat, int width, int height);
+
+private:
+    TileFetcher& fetcher;
+    std::shared_ptr<DecodedTileCache> decodedTiles;
+
+    // Content hash of each tile seen, so repeat renders skip the disk read
+    std::mutex mutex;
+    std::unordered_map<TileKey, ContentHash, TileKeyHash> tileHashes;
+    std::unordered_map<TileKey, std::shared_future<bool>, TileKeyHash> downloads;
+
+    // Decoded tile from memory or disk (no network), or nullptr
+    std::shared_ptr<const DecodedTile> loadTile(const TileKey& key);
+
+    // Starts (or joins) the download of a tile
+    std::shared_future<bool> download(const TileKey& key);
+};
+
+#endif // STATICMAPRENDERER_H
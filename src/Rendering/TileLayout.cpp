@@ -0,0 +1,77 @@
+// src/Rendering/TileLayout.cpp
+#include "TileLayout.h"
+#include "Projection.h"
+#include <algorithm>
+#include <cmath>
+
+namespace TileLayout {
+
+std::vector<std::pair<TileKey, TileRect>> visibleTiles(const Viewport& vp, int z) {
+    std::vector<std::pair<TileKey, TileRect>> tiles;
+
+    // Tiles of level z drawn at the viewport's fractional zoom
+    double tileSize = Projection::TILE_SIZE * std::pow(2.0, vp.zoom - z);
+    int windowWidth = vp.windowWidth;
+    int windowHeight = vp.windowHeight;
+
+    double n = std::pow(2.0, z);
+    double x = Projection::lonToWorldX(vp.centerLon, z) / Projection::TILE_SIZE;
+    double y = Projection::latToWorldY(vp.centerLat, z) / Projection::TILE_SIZE;
+
+    double tileStartX = x - (windowWidth / 2.0) / tileSize;
+    double tileStartY = y - (windowHeight / 2.0) / tileSize;
+
+    int startTileX = static_cast<int>(std::floor(tileStartX));
+    int startTileY = static_cast<int>(std::floor(tileStartY));
+
+    double offsetX = (tileStartX - startTileX) * tileSize;
+    double offsetY = (tileStartY - startTileY) * tileSize;
+
+    int tilesX = static_cast<int>(std::ceil(double(windowWidth) / tileSize)) + 2;
+    int tilesY = static_cast<int>(std::ceil(double(windowHeight) / tileSize)) + 2;
+
+    for (int dx = 0; dx < tilesX; dx++) {
+        for (int dy = 0; dy < tilesY; dy++) {
+            int rawTileX = startTileX + dx;
+            int rawTileY = startTileY + dy;
+
+            // Normalize tileX by wrapping around
+            int tileX = rawTileX % static_cast<int>(n);
+            if (tileX < 0) {
+                tileX += static_cast<int>(n);
+            }
+
+            // Clamp tileY between 0 and (n - 1)
+            int tileY = rawTileY;
+            if (tileY < 0) {
+                tileY = 0;
+            } else if (tileY >= static_cast<int>(n)) {
+                tileY = static_cast<int>(n) - 1;
+            }
+
+            TileKey key = { z, tileX, tileY };
+
+            // Snap edges to whole pixels so neighbouring tiles never leave seams
+            double left = std::round(dx * tileSize - offsetX);
+            double top = std::round(dy * tileSize - offsetY);
+            double right = std::round((dx + 1) * tileSize - offsetX);
+            double bottom = std::round((dy + 1) * tileSize - offsetY);
+
+            TileRect dstRect = {
+                static_cast<float>(left),
+                static_cast<float>(top),
+                static_cast<float>(right - left),
+                static_cast<float>(bottom - top)
+            };
+            tiles.emplace_back(key, dstRect);
+        }
+    }
+    return tiles;
+}
+
+TileKey ancestor(const TileKey& key, int levels) {
+    levels = std::min(levels, key.z);
+    return { key.z - levels, key.x >> levels, key.y >> levels };
+}
+
+} // namespace TileLayout
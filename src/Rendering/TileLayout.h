@@ -0,0 +1,31 @@
+// src/Rendering/TileLayout.h
+#ifndef TILELAYOUT_H
+#define TILELAYOUT_H
+
+#include <utility>
+#include <vector>
+#include "../Networking/Tiles/TileKey.h"
+#include "Viewport.h"
+
+// Destination of a tile in view pixels (same layout as SDL_FRect)
+struct TileRect {
+    float x;
+    float y;
+    float w;
+    float h;
+};
+
+// Where tiles go on screen; shared by the window and headless renderers so
+// both draw a view identically.
+namespace TileLayout {
+
+// Tiles of level z covering the view (plus a one-tile margin), drawn at the
+// viewport's fractional zoom. Edges are snapped to whole pixels.
+std::vector<std::pair<TileKey, TileRect>> visibleTiles(const Viewport& vp, int z);
+
+// Ancestor covering key, levels up (stops at level 0)
+TileKey ancestor(const TileKey& key, int levels);
+
+} // namespace TileLayout
+
+#endif // TILELAYOUT_H
@@ -0,0 +1,159 @@
+// src/Rendering/TilePrefetcher.cpp
+#include "TilePrefetcher.h"
+#include "Projection.h"
+#include <algorithm>
+#include <cmath>
+
+// How far ahead a drag is extrapolated, and the limits on that guess
+static const double LOOKAHEAD_MS = 600.0;
+static const double MAX_LOOKAHEAD_SCREENS = 1.5;
+static const double MIN_SPEED_PX_PER_MS = 0.05;   // Slower drags are treated as idle
+static const double PAN_IDLE_MS = 150.0;          // Velocity decays to zero after this
+static const double VELOCITY_SMOOTHING = 0.5;     // EWMA weight of the newest sample
+static const int NEXT_ZOOM_RADIUS = 1;            // 3x3 tiles around the cursor
+
+namespace {
+struct TileRange {
+    int minX, maxX, minY, maxY;
+};
+
+// Tiles of level z covering a screen-sized window around a world point
+TileRange coveringTiles(double centerWorldX, double centerWorldY, int width, int height, int z) {
+    int n = 1 << z;
+    TileRange range;
+    range.minX = static_cast<int>(std::floor((centerWorldX - width / 2.0) / Projection::TILE_SIZE));
+    range.maxX = static_cast<int>(std::floor((centerWorldX + width / 2.0) / Projection::TILE_SIZE));
+    range.minY = std::max(0, static_cast<int>(std::floor((centerWorldY - height / 2.0) / Projection::TILE_SIZE)));
+    range.maxY = std::min(n - 1, static_cast<int>(std::floor((centerWorldY + height / 2.0) / Projection::TILE_SIZE)));
+    return range;
+}
+
+int wrapX(int x, int z) {
+    int n = 1 << z;
+    x %= n;
+    return x < 0 ? x + n : x;
+}
+}
+
+TilePrefetcher::TilePrefetcher(size_t sessionBudget)
+    : budget(sessionBudget) {}
+
+void TilePrefetcher::recordPan(double dx, double dy) {
+    pendingDx += dx;
+    pendingDy += dy;
+}
+
+void TilePrefetcher::recordCursor(double x, double y) {
+    cursorX = x;
+    cursorY = y;
+}
+
+void TilePrefetcher::recordZoomDirection(int direction) {
+    if (direction != 0) {
+        zoomDirection = direction > 0 ? 1 : -1;
+    }
+}
+
+void TilePrefetcher::charge(size_t tiles) {
+    budget -= std::min(budget, tiles);
+}
+
+std::vector<TileKey> TilePrefetcher::plan(const Viewport& vp, int tileZoom, double nowMs) {
+    // Turn the drag accumulated since the last frame into a velocity sample
+    if (lastPlanMs >= 0.0 && nowMs > lastPlanMs) {
+        double dt = nowMs - lastPlanMs;
+        if (pendingDx != 0.0 || pendingDy != 0.0) {
+            velocityX += VELOCITY_SMOOTHING * (pendingDx / dt - velocityX);
+            velocityY += VELOCITY_SMOOTHING * (pendingDy / dt - velocityY);
+            lastPanMs = nowMs;
+        } else if (lastPanMs < 0.0 || nowMs - lastPanMs > PAN_IDLE_MS) {
+            velocityX = 0.0;
+            velocityY = 0.0;
+        }
+    }
+    pendingDx = 0.0;
+    pendingDy = 0.0;
+    lastPlanMs = nowMs;
+
+    std::vector<TileKey> out;
+    if (budget == 0) {
+        return out;
+    }
+
+    if (std::hypot(velocityX, velocityY) >= MIN_SPEED_PX_PER_MS) {
+        planAhead(vp, tileZoom, out);
+    } else if (cursorX >= 0.0 && cursorY >= 0.0) {
+        planNextZoom(vp, tileZoom, out);
+    }
+    return out;
+}
+
+void TilePrefetcher::planAhead(const Viewport& vp, int tileZoom, std::vector<TileKey>& out) const {
+    double scale = std::pow(2.0, tileZoom - vp.zoom); // Screen px to level-tileZoom world px
+
+    // Dragging right moves the map right, so the view travels left
+    double maxShiftX = MAX_LOOKAHEAD_SCREENS * vp.windowWidth;
+    double maxShiftY = MAX_LOOKAHEAD_SCREENS * vp.windowHeight;
+    double shiftX = std::clamp(-velocityX * LOOKAHEAD_MS, -maxShiftX, maxShiftX);
+    double shiftY = std::clamp(-velocityY * LOOKAHEAD_MS, -maxShiftY, maxShiftY);
+
+    double centerX = Projection::lonToWorldX(vp.centerLon, tileZoom);
+    double centerY = Projection::latToWorldY(vp.centerLat, tileZoom);
+    int width = static_cast<int>(vp.windowWidth * scale);
+    int height = static_cast<int>(vp.windowHeight * scale);
+
+    TileRange now = coveringTiles(centerX, centerY, width, height, tileZoom);
+    double aheadX = centerX + shiftX * scale;
+    double aheadY = centerY + shiftY * scale;
+    TileRange ahead = coveringTiles(aheadX, aheadY, width, height, tileZoom);
+
+    // Tiles in the predicted view that are not in the current one form the
+    // leading ring; nearer ones (along the path) come first
+    std::vector<std::pair<double, TileKey>> ranked;
+    for (int ty = ahead.minY; ty <= ahead.maxY; ++ty) {
+        for (int tx = ahead.minX; tx <= ahead.maxX; ++tx) {
+            if (tx >= now.minX && tx <= now.maxX && ty >= now.minY && ty <= now.maxY) {
+                continue;
+            }
+            double tileCenterX = (tx + 0.5) * Projection::TILE_SIZE;
+            double tileCenterY = (ty + 0.5) * Projection::TILE_SIZE;
+            double distance = std::hypot(tileCenterX - centerX, tileCenterY - centerY);
+            ranked.emplace_back(distance, TileKey{ tileZoom, wrapX(tx, tileZoom), ty });
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& entry : ranked) {
+        out.push_back(entry.second);
+    }
+}
+
+void TilePrefetcher::planNextZoom(const Viewport& vp, int tileZoom, std::vector<TileKey>& out) const {
+    int z = tileZoom + zoomDirection;
+    if (z < Viewport::MIN_ZOOM || z > Viewport::MAX_ZOOM) {
+        return; // Nothing to fetch past what the source serves
+    }
+
+    // Cursor position in level-z world pixels
+    double scale = std::pow(2.0, z - vp.zoom);
+    double cursorWorldX = Projection::lonToWorldX(vp.centerLon, z) + (cursorX - vp.windowWidth / 2.0) * scale;
+    double cursorWorldY = Projection::latToWorldY(vp.centerLat, z) + (cursorY - vp.windowHeight / 2.0) * scale;
+    int cx = static_cast<int>(std::floor(cursorWorldX / Projection::TILE_SIZE));
+    int cy = static_cast<int>(std::floor(cursorWorldY / Projection::TILE_SIZE));
+
+    std::vector<std::pair<int, TileKey>> ranked;
+    for (int dy = -NEXT_ZOOM_RADIUS; dy <= NEXT_ZOOM_RADIUS; ++dy) {
+        for (int dx = -NEXT_ZOOM_RADIUS; dx <= NEXT_ZOOM_RADIUS; ++dx) {
+            int ty = cy + dy;
+            if (ty < 0 || ty >= (1 << z)) {
+                continue;
+            }
+            ranked.emplace_back(dx * dx + dy * dy, TileKey{ z, wrapX(cx + dx, z), ty });
+        }
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& entry : ranked) {
+        out.push_back(entry.second);
+    }
+}
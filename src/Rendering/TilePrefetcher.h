@@ -0,0 +1,52 @@
+// src/Rendering/TilePrefetcher.h
+#ifndef TILEPREFETCHER_H
+#define TILEPREFETCHER_H
+
+#include <cstddef>
+#include <vector>
+#include "../Networking/Tiles/TileKey.h"
+#include "Viewport.h"
+
+// Predicts which tiles will be needed next. While dragging, it projects
+// the pan velocity ahead and lists the tiles entering view in the
+// direction of motion. When idle, it lists the next zoom level around the
+// cursor. A per-session tile budget caps the bandwidth spent on guesses.
+class TilePrefetcher {
+public:
+    explicit TilePrefetcher(size_t sessionBudget);
+
+    // Drag distance in screen pixels since the last call
+    void recordPan(double dx, double dy);
+
+    // Cursor position relative to the map area's top-left corner
+    void recordCursor(double x, double y);
+
+    // +1 after zooming in, -1 after zooming out
+    void recordZoomDirection(int direction);
+
+    // Tiles worth prefetching for this frame, most useful first. Tiles of
+    // level tileZoom currently in view are never included.
+    std::vector<TileKey> plan(const Viewport& vp, int tileZoom, double nowMs);
+
+    void charge(size_t tiles);
+    size_t remainingBudget() const { return budget; }
+
+private:
+    size_t budget;
+
+    double pendingDx = 0.0;     // Pan since the last plan()
+    double pendingDy = 0.0;
+    double velocityX = 0.0;     // Screen px per ms, smoothed
+    double velocityY = 0.0;
+    double lastPlanMs = -1.0;
+    double lastPanMs = -1.0;
+
+    double cursorX = -1.0;
+    double cursorY = -1.0;
+    int zoomDirection = 1;
+
+    void planAhead(const Viewport& vp, int tileZoom, std::vector<TileKey>& out) const;
+    void planNextZoom(const Viewport& vp, int tileZoom, std::vector<TileKey>& out) const;
+};
+
+#endif // TILEPREFETCHER_H
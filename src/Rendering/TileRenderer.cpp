@@ -1,31 +1,126 @@
 // src/Rendering/TileRenderer.cpp
 
 #include "TileRenderer.h"
+#include "../Utils/Metrics.h"
+#include "../Utils/Trace.h"
 #include "../Utils/Utils.h"
+#include "../Config/ConfigManager.h"
+#include "Projection.h"
+#include "TileLayout.h"
 #include <cmath>
 #include <future>
 #include <mutex>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+// Upper bound on tile textures kept in VRAM; evicted tiles are re-uploaded
+// from the decoded tile cache without touching disk or the decoder
+static const size_t MAX_TILE_TEXTURES = 512;
+
+namespace {
+struct TextureMetrics {
+    Metrics::Counter& hits = Metrics::counter("gis_cache_lookups_total", "Tile cache lookups by tier and result",
+                                              "tier=\"texture\",result=\"hit\"");
+    Metrics::Counter& misses = Metrics::counter("gis_cache_lookups_total", "Tile cache lookups by tier and result",
+                                                "tier=\"texture\",result=\"miss\"");
+    Metrics::Gauge& bytes = Metrics::gauge("gis_texture_bytes", "Video memory held by tile textures");
+};
+
+TextureMetrics& metrics() {
+    static TextureMetrics instance;
+    return instance;
+}
+
+int64_t textureBytes(SDL_Texture* texture) {
+    int w = 0, h = 0;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+    return static_cast<int64_t>(w) * h * 4;
+}
+}
+
+// How far up the pyramid a missing tile looks for a placeholder, and how
+// far down when composing one from already loaded children
+static const int MAX_FALLBACK_LEVELS = 8;
+static const int MAX_DESCENDANT_LEVELS = 2;
+
+// Zoom animation length, and how far past x.5 the zoom must go before
+// tiles switch to the next level
+static const double ZOOM_ANIMATION_MS = 250.0;
+static const double ZOOM_HYSTERESIS = 0.15;
+static const double ZOOM_SETTLE_STEP = 0.05; // Well inside the hysteresis band
+
+// Background fetches allowed in flight at once
+static const size_t MAX_PREFETCH_IN_FLIGHT = 16;
+
+// flyTo: tiles are planned at this frame interval, and this many may be
+// fetching or decoding ahead of the animation at once
+static const double FLIGHT_PLAN_STEP_MS = 1000.0 / 60.0;
+static const size_t MAX_FLIGHT_IN_FLIGHT = 24;
+
+// Config is only needed while constructing the renderer; read it once
+static const AppConfig& rendererConfig() {
+    static const AppConfig config = ConfigManager::loadConfig();
+    return config;
+}
+
+// Active tile source is the first one listed in the config
+static TileSource activeTileSource() {
+    const AppConfig& config = rendererConfig();
+    return config.tileSources.empty() ? TileSource::openStreetMap() : config.tileSources.front();
+}
 
 TileRenderer::TileRenderer(SDL_Renderer* renderer)
-    : renderer(renderer), tileFetcher(8 /* threads */, 1024 /* cacheSize */), needsRedrawFlag(true) 
+    : renderer(renderer), tileFetcher(8 /* threads */, 1024 /* cacheSize */, activeTileSource()),
+      decodedTiles(std::make_shared<DecodedTileCache>(
+          static_cast<size_t>(std::max(rendererConfig().decodedTileCacheMB, 1)) * 1024 * 1024)),
+      needsRedrawFlag(true),
+      prefetcher(static_cast<size_t>(std::max(rendererConfig().prefetchBudgetTiles, 0)))
 {
     viewport.centerLat = 35.6895; // Example: Tokyo coordinates
     viewport.centerLon = 139.6917;
     viewport.zoom = 6;
     viewport.windowWidth = 1920;
     viewport.windowHeight = 1080;
+    tileZoom = selectTileZoom(viewport.zoom, tileZoom);
+
+    ImageDecoder::Kind decoderKind = ImageDecoder::kindFromString(rendererConfig().imageDecoder);
+    if (!ImageDecoder::available(decoderKind)) {
+        Utils::logError("Configured image decoder \"" + rendererConfig().imageDecoder +
+                        "\" is not available; using auto");
+        decoderKind = ImageDecoder::Kind::Auto;
+    }
+    imageDecoder = ImageDecoder::create(decoderKind);
+
+    // Fresh downloads are decoded on the fetch workers, each with its own
+    // decoder; the cache is shared so it outlives the renderer if needed
+    std::shared_ptr<DecodedTileCache> cache = decodedTiles;
+    tileFetcher.setDecodeHook([cache, decoderKind](const ContentHash& hash, const ByteBuffer& data, TileFormat) {
+        thread_local std::unique_ptr<ImageDecoder> decoder;
+        thread_local ByteBuffer pixels;
+        if (cache->get(hash)) {
+            return;
+        }
+        if (!decoder) {
+            decoder = ImageDecoder::create(decoderKind);
+        }
+        DecodedImage image;
+        if (decoder->decode(data.data(), data.size(), image, pixels)) {
+            cache->put(hash, DecodedTile::fromImage(image, pixels));
+        }
+    });
 
     precomputeTilePositions();
 }
 
 TileRenderer::~TileRenderer() {
-    // Cleanup cached textures
-    for (auto& pair : tileTextures) {
-        if (pair.second) {
-            SDL_DestroyTexture(pair.second);
+    // Cleanup cached textures (owned per content hash, shared between tiles)
+    for (auto& pair : sharedTextures) {
+        if (pair.second.texture) {
+            metrics().bytes.add(-textureBytes(pair.second.texture));
+            SDL_DestroyTexture(pair.second.texture);
         }
     }
     Utils::logInfo("TileRenderer destroyed");
@@ -33,9 +128,14 @@ TileRenderer::~TileRenderer() {
 
 void TileRenderer::setViewport(const Viewport& vp) {
     std::lock_guard<std::mutex> lock(renderMutex);
-    
-    // Clamp the zoom level within MIN_ZOOM and MAX_ZOOM
-    int clampedZoom = std::clamp(vp.zoom, Viewport::MIN_ZOOM, Viewport::MAX_ZOOM);
+    zoomAnimation.reset(); // An explicit viewport wins over any animation
+    flight.reset();
+    applyViewport(vp);
+}
+
+void TileRenderer::applyViewport(const Viewport& vp) {
+    // Clamp the zoom level; past MAX_ZOOM tiles are synthesized (overzoom)
+    double clampedZoom = std::clamp(vp.zoom, double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
     if (clampedZoom != vp.zoom) {
         Utils::logInfo("Zoom level clamped from " + std::to_string(vp.zoom) + " to " + std::to_string(clampedZoom));
     }
@@ -45,10 +145,205 @@ void TileRenderer::setViewport(const Viewport& vp) {
     updatedVp.zoom = clampedZoom;
 
     viewport = updatedVp;
+    tileZoom = selectTileZoom(viewport.zoom, tileZoom);
     needsRedrawFlag = true;
     precomputeTilePositions(); // Automatically called within setViewport
 }
 
+int TileRenderer::selectTileZoom(double zoom, int current) {
+    int nearest = static_cast<int>(std::lround(zoom));
+    nearest = std::clamp(nearest, Viewport::MIN_ZOOM, Viewport::MAX_OVERZOOM);
+    if (std::abs(zoom - current) <= 0.5 + ZOOM_HYSTERESIS &&
+        current >= Viewport::MIN_ZOOM && current <= Viewport::MAX_OVERZOOM) {
+        return current;
+    }
+    return nearest;
+}
+
+int TileRenderer::settleTileZoom(double from, double to, int level) {
+    int steps = static_cast<int>(std::ceil(std::abs(to - from) / ZOOM_SETTLE_STEP));
+    for (int i = 1; i <= steps; ++i) {
+        level = selectTileZoom(from + (to - from) * i / steps, level);
+    }
+    return selectTileZoom(to, level);
+}
+
+void TileRenderer::zoomAt(double delta, int windowX, int windowY) {
+    std::lock_guard<std::mutex> lock(renderMutex);
+
+    double base = zoomAnimation ? zoomAnimation->toZoom : viewport.zoom;
+    double target = std::clamp(base + delta, double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
+    if (target == viewport.zoom && !zoomAnimation) {
+        return;
+    }
+
+    flight.reset();
+
+    ZoomAnimation anim;
+    anim.fromZoom = viewport.zoom;
+    anim.toZoom = target;
+    anim.anchorDx = windowX - lastMapArea.x - viewport.windowWidth / 2.0;
+    anim.anchorDy = windowY - lastMapArea.y - viewport.windowHeight / 2.0;
+    anim.anchorLon = Projection::worldXToLon(
+        Projection::lonToWorldX(viewport.centerLon, viewport.zoom) + anim.anchorDx, viewport.zoom);
+    anim.anchorLat = Projection::worldYToLat(
+        Projection::latToWorldY(viewport.centerLat, viewport.zoom) + anim.anchorDy, viewport.zoom);
+    anim.startMs = frameClock.now();
+    zoomAnimation = anim;
+    prefetcher.recordZoomDirection(delta > 0 ? 1 : -1);
+
+    // Start fetching the level the animation ends on right away; with the
+    // hysteresis that can still be the current one
+    Viewport targetVp = viewport;
+    targetVp.zoom = target;
+    targetVp.centerLon = Projection::worldXToLon(
+        Projection::lonToWorldX(anim.anchorLon, target) - anim.anchorDx, target);
+    targetVp.centerLat = Projection::worldYToLat(
+        Projection::latToWorldY(anim.anchorLat, target) - anim.anchorDy, target);
+    prefetchViewport(targetVp, settleTileZoom(viewport.zoom, target, tileZoom));
+
+    needsRedrawFlag = true;
+}
+
+double TileRenderer::targetZoom() const {
+    if (flight) {
+        return flight->path.at(1.0).zoom;
+    }
+    return zoomAnimation ? zoomAnimation->toZoom : viewport.zoom;
+}
+
+void TileRenderer::flyTo(double lat, double lon, double zoom, double durationMs) {
+    std::lock_guard<std::mutex> lock(renderMutex);
+    zoomAnimation.reset();
+
+    lat = std::clamp(lat, -Projection::MAX_LATITUDE, Projection::MAX_LATITUDE);
+    zoom = std::clamp(zoom, double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
+    FlightPath path(viewport, lat, lon, zoom);
+    if (durationMs <= 0.0) {
+        durationMs = path.suggestedDurationMs();
+    }
+    if (durationMs <= 0.0) {
+        flight.reset();
+        applyViewport(path.at(1.0)); // Already there
+        return;
+    }
+
+    flight = Flight{ path, frameClock.now(), durationMs, {} };
+    planFlightTiles(*flight);
+    Utils::logInfo("Flying to " + std::to_string(lat) + ", " + std::to_string(lon) +
+                   " z" + std::to_string(zoom) + " over " + std::to_string(static_cast<int>(durationMs)) +
+                   " ms; " + std::to_string(flight->plannedTiles.size()) + " tiles planned");
+
+    // Start on the first frames' tiles now rather than on the next update
+    issueFlightTiles();
+    needsRedrawFlag = true;
+}
+
+bool TileRenderer::isFlying() const {
+    return flight.has_value();
+}
+
+bool TileRenderer::isViewComplete() const {
+    return !flight && !zoomAnimation && !needsRedrawFlag && placeholdersDrawn == 0;
+}
+
+void TileRenderer::setFixedFrameStep(double ms) {
+    frameClock.setFixedStep(ms);
+}
+
+// Ease in and out so the flight neither jerks into motion nor stops dead
+static double easeInOut(double t) {
+    return t < 0.5 ? 4.0 * t * t * t : 1.0 - std::pow(-2.0 * t + 2.0, 3.0) / 2.0;
+}
+
+void TileRenderer::planFlightTiles(Flight& f) const {
+    // Walk the flight frame by frame and list each tile the first time a
+    // frame shows it; overzoomed tiles need their MAX_ZOOM source instead.
+    // The level is carried from frame to frame with render()'s hysteresis,
+    // so the plan holds the tiles that will actually be drawn.
+    std::unordered_set<TileKey, TileKeyHash> seen;
+    int level = tileZoom;
+    double lastZoom = viewport.zoom;
+    for (double ms = 0.0;; ms = std::min(ms + FLIGHT_PLAN_STEP_MS, f.durationMs)) {
+        Viewport vp = f.path.at(easeInOut(ms / f.durationMs));
+        level = settleTileZoom(lastZoom, vp.zoom, level);
+        lastZoom = vp.zoom;
+        for (const auto& [key, rect] : layoutTiles(vp, level)) {
+            TileKey fetchKey = key.z > Viewport::MAX_ZOOM ? getAncestorTile(key, key.z - Viewport::MAX_ZOOM) : key;
+            if (seen.insert(fetchKey).second) {
+                f.plannedTiles.emplace_back(ms, fetchKey);
+            }
+        }
+        if (ms >= f.durationMs) {
+            break;
+        }
+    }
+}
+
+void TileRenderer::issueFlightTiles() {
+    double elapsed = frameClock.now() - flight->startMs;
+    while (!flight->plannedTiles.empty() && prefetchFutures.size() < MAX_FLIGHT_IN_FLIGHT) {
+        auto [neededAtMs, key] = flight->plannedTiles.front();
+        flight->plannedTiles.pop_front();
+
+        // Frames already shown are past saving; render() requests anything
+        // still on screen itself
+        if (neededAtMs + FLIGHT_PLAN_STEP_MS < elapsed && neededAtMs < flight->durationMs) {
+            continue;
+        }
+        if (isTileLoaded(key) || tileFutures.find(key) != tileFutures.end() ||
+            prefetchFutures.find(key) != prefetchFutures.end()) {
+            continue;
+        }
+        // Cached tiles are decoded on a worker too, so the frame only uploads
+        prefetchFutures[key] = tileFetcher.warmTile(key.z, key.x, key.y);
+    }
+}
+
+void TileRenderer::advanceAnimation() {
+    frameClock.tick();
+    if (flight) {
+        double t = std::clamp((frameClock.now() - flight->startMs) / flight->durationMs, 0.0, 1.0);
+        Viewport vp = flight->path.at(easeInOut(t));
+        vp.windowWidth = viewport.windowWidth;
+        vp.windowHeight = viewport.windowHeight;
+        if (t >= 1.0) {
+            flight.reset();
+        }
+        applyViewport(vp);
+        return;
+    }
+    if (!zoomAnimation) {
+        return;
+    }
+
+    const ZoomAnimation& anim = *zoomAnimation;
+    double t = std::clamp((frameClock.now() - anim.startMs) / ZOOM_ANIMATION_MS, 0.0, 1.0);
+    double eased = 1.0 - std::pow(1.0 - t, 3.0); // Ease out: fast start, soft landing
+
+    Viewport vp = viewport;
+    vp.zoom = anim.fromZoom + (anim.toZoom - anim.fromZoom) * eased;
+    vp.centerLon = Projection::worldXToLon(
+        Projection::lonToWorldX(anim.anchorLon, vp.zoom) - anim.anchorDx, vp.zoom);
+    vp.centerLat = std::clamp(Projection::worldYToLat(
+        Projection::latToWorldY(anim.anchorLat, vp.zoom) - anim.anchorDy, vp.zoom),
+        -Projection::MAX_LATITUDE, Projection::MAX_LATITUDE);
+
+    if (t >= 1.0) {
+        zoomAnimation.reset();
+    }
+    applyViewport(vp);
+}
+
+void TileRenderer::prefetchViewport(const Viewport& vp, int level) {
+    for (const auto& [key, rect] : layoutTiles(vp, level)) {
+        TileKey fetchKey = key.z > Viewport::MAX_ZOOM ? getAncestorTile(key, key.z - Viewport::MAX_ZOOM) : key;
+        if (!isTileLoaded(fetchKey)) {
+            requestTile(fetchKey);
+        }
+    }
+}
+
 bool TileRenderer::needsRedraw() const {
     return needsRedrawFlag;
 }
@@ -59,54 +354,172 @@ void TileRenderer::resetRedrawFlag() {
 
 void TileRenderer::updateTiles() {
     std::lock_guard<std::mutex> lock(renderMutex);
+    advanceAnimation();
     processTileFutures();
+    runPrefetch();
 }
 
-TileKey TileRenderer::getParentTile(const TileKey& key) const {
-    if (key.z == 0) {
-        return key; // No parent exists for zoom level 0
+void TileRenderer::notePan(int dx, int dy) {
+    std::lock_guard<std::mutex> lock(renderMutex);
+    prefetcher.recordPan(dx, dy);
+}
+
+void TileRenderer::noteCursor(int windowX, int windowY) {
+    std::lock_guard<std::mutex> lock(renderMutex);
+    prefetcher.recordCursor(windowX - lastMapArea.x, windowY - lastMapArea.y);
+}
+
+void TileRenderer::requestTile(const TileKey& key) {
+    if (tileFutures.find(key) != tileFutures.end()) {
+        return;
     }
-    TileKey parent = { key.z - 1, key.x / 2, key.y / 2 };
-    return parent;
+
+    // A background fetch for this tile is already queued or running; take
+    // it over rather than starting a duplicate that would be rejected as in
+    // progress, and if it has not started, move it ahead of the prefetches
+    auto prefetchIt = prefetchFutures.find(key);
+    if (prefetchIt != prefetchFutures.end()) {
+        tileFetcher.promoteTile(key.z, key.x, key.y);
+        tileFutures[key] = std::move(prefetchIt->second);
+        prefetchFutures.erase(prefetchIt);
+        return;
+    }
+    tileFutures[key] = tileFetcher.fetchTile(key.z, key.x, key.y);
 }
 
-void TileRenderer::renderParentTile(const TileKey& childKey, const SDL_Rect& dstRect) {
-    TileKey parentKey = getParentTile(childKey);
-    auto parentIt = tileTextures.find(parentKey);
+void TileRenderer::runPrefetch() {
+    // Finished prefetches need no follow-up: the bytes are in the fetcher's
+    // cache and the workers already decoded them into decodedTiles
+    for (auto it = prefetchFutures.begin(); it != prefetchFutures.end();) {
+        if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            it->second.get();
+            it = prefetchFutures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // A flight knows exactly what it will need; prediction would only compete
+    if (flight) {
+        issueFlightTiles();
+        return;
+    }
 
-    if (parentIt == tileTextures.end()) {
-        // Parent tile not loaded; optionally, you can queue its loading
-        if (tileFetcher.isTileCached(parentKey.z, parentKey.x, parentKey.y) &&
-            tileFutures.find(parentKey) == tileFutures.end()) {
-            tileFutures[parentKey] = tileFetcher.fetchTile(parentKey.z, parentKey.x, parentKey.y);
+    bool hadBudget = prefetcher.remainingBudget() > 0;
+    for (TileKey key : prefetcher.plan(viewport, tileZoom, frameClock.now())) {
+        if (prefetchFutures.size() >= MAX_PREFETCH_IN_FLIGHT || prefetcher.remainingBudget() == 0) {
+            break;
+        }
+        if (key.z > Viewport::MAX_ZOOM) {
+            key = getAncestorTile(key, key.z - Viewport::MAX_ZOOM);
+        }
+        if (isTileLoaded(key) || tileFetcher.isTileCached(key.z, key.x, key.y) ||
+            tileFutures.find(key) != tileFutures.end() || prefetchFutures.find(key) != prefetchFutures.end()) {
+            continue;
         }
-        return; // Cannot render parent tile
+        prefetchFutures[key] = tileFetcher.prefetchTile(key.z, key.x, key.y);
+        prefetcher.charge(1);
     }
 
-    SDL_Texture* parentTexture = parentIt->second;
-    if (!parentTexture) {
-        return; // Parent texture invalid
+    if (hadBudget && prefetcher.remainingBudget() == 0) {
+        Utils::logInfo("Prefetch budget for this session used up; prefetching stopped");
     }
+}
 
-    // Determine which quadrant the child tile is in the parent tile
-    int quadrantX = childKey.x % 2;
-    int quadrantY = childKey.y % 2;
+TileKey TileRenderer::getAncestorTile(const TileKey& key, int levels) const {
+    return TileLayout::ancestor(key, levels);
+}
 
-    SDL_Rect srcRect;
-    srcRect.x = quadrantX * 128; // Each quadrant is 128x128 in a 256x256 parent tile
-    srcRect.y = quadrantY * 128;
-    srcRect.w = 128;
-    srcRect.h = 128;
+bool TileRenderer::renderAncestorTile(const TileKey& key, const SDL_FRect& dstRect) {
+    for (int levels = 1; levels <= MAX_FALLBACK_LEVELS && levels <= key.z; ++levels) {
+        TileKey ancestorKey = getAncestorTile(key, levels);
+
+        // A single-color ancestor fills the area with its color
+        auto uniformIt = uniformTiles.find(ancestorKey);
+        if (uniformIt != uniformTiles.end()) {
+            const SDL_Color& c = uniformIt->second;
+            SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+            SDL_RenderFillRectF(renderer, &dstRect);
+            return true;
+        }
 
-    // Destination rectangle is the size of the child tile
-    SDL_Rect scaledDstRect = dstRect;
-    scaledDstRect.w = 256;
-    scaledDstRect.h = 256;
+        auto ancestorIt = tileTextures.find(ancestorKey);
+        if (ancestorIt == tileTextures.end() || !ancestorIt->second) {
+            continue;
+        }
 
-    // Render the quadrant scaled up to fill the child tile's area
-    // Use nearest-neighbor scaling to preserve pixel art (optional)
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-    SDL_RenderCopy(renderer, parentTexture, &srcRect, &scaledDstRect);
+        // Crop the part of the ancestor covering this tile, whatever the
+        // ancestor's pixel size; below one source pixel take a single pixel
+        int texW = 0;
+        int texH = 0;
+        SDL_QueryTexture(ancestorIt->second, nullptr, nullptr, &texW, &texH);
+        int span = 1 << levels;
+        int subX = key.x & (span - 1);
+        int subY = key.y & (span - 1);
+
+        SDL_Rect srcRect;
+        srcRect.x = subX * texW / span;
+        srcRect.y = subY * texH / span;
+        srcRect.w = std::max(1, (subX + 1) * texW / span - srcRect.x);
+        srcRect.h = std::max(1, (subY + 1) * texH / span - srcRect.y);
+
+        touchTexture(ancestorKey);
+        SDL_RenderCopyF(renderer, ancestorIt->second, &srcRect, &dstRect);
+        return true;
+    }
+    return false;
+}
+
+bool TileRenderer::renderDescendantTiles(const TileKey& key, const SDL_FRect& dstRect, int depth) {
+    if (depth <= 0 || key.z + 1 > Viewport::MAX_OVERZOOM) {
+        return false;
+    }
+
+    bool covered = true;
+    float halfW = dstRect.w / 2.0f;
+    float halfH = dstRect.h / 2.0f;
+    for (int i = 0; i < 4; ++i) {
+        int right = i & 1;
+        int bottom = i >> 1;
+        TileKey childKey = { key.z + 1, key.x * 2 + right, key.y * 2 + bottom };
+        SDL_FRect childRect = {
+            dstRect.x + (right ? halfW : 0.0f),
+            dstRect.y + (bottom ? halfH : 0.0f),
+            halfW,
+            halfH
+        };
+
+        auto uniformIt = uniformTiles.find(childKey);
+        if (uniformIt != uniformTiles.end()) {
+            const SDL_Color& c = uniformIt->second;
+            SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+            SDL_RenderFillRectF(renderer, &childRect);
+            continue;
+        }
+        auto childIt = tileTextures.find(childKey);
+        if (childIt != tileTextures.end() && childIt->second) {
+            touchTexture(childKey);
+            SDL_RenderCopyF(renderer, childIt->second, nullptr, &childRect);
+            continue;
+        }
+        if (!renderDescendantTiles(childKey, childRect, depth - 1)) {
+            covered = false;
+        }
+    }
+    return covered;
+}
+
+void TileRenderer::renderFallbackTile(const TileKey& key, const SDL_FRect& dstRect) {
+    // Keep the parent coming so the next frame has a closer placeholder
+    TileKey parentKey = getAncestorTile(key, 1);
+    if (parentKey.z != key.z && !isTileLoaded(parentKey) &&
+        tileFetcher.isTileCached(parentKey.z, parentKey.x, parentKey.y)) {
+        requestTile(parentKey);
+    }
+
+    // Blurry ancestor first, then sharper children (zooming out) on top
+    renderAncestorTile(key, dstRect);
+    renderDescendantTiles(key, dstRect, MAX_DESCENDANT_LEVELS);
 }
 
 void TileRenderer::render(const SDL_Rect& mapArea) {
@@ -118,6 +531,8 @@ void TileRenderer::render(const SDL_Rect& mapArea) {
     }
 
     needsRedrawFlag = false;
+    lastMapArea = mapArea;
+    Trace::Scope frameSpan("frame", "render");
 
     //SDL_Log("Rendering map area: {x:%d, y:%d, w:%d, h:%d}", 
     //        mapArea.x, mapArea.y, mapArea.w, mapArea.h);
@@ -129,28 +544,57 @@ void TileRenderer::render(const SDL_Rect& mapArea) {
 
     // Prepare to collect tiles to render
     int renderedTiles = 0;
-    std::vector<std::pair<SDL_Texture*, SDL_Rect>> tilesToRender;
-    std::vector<std::pair<TileKey, SDL_Rect>> parentTilesToRender;
+    std::vector<std::pair<SDL_Texture*, SDL_FRect>> tilesToRender;
+    std::vector<std::pair<SDL_Color, SDL_FRect>> uniformTilesToRender;
+    std::vector<std::pair<TileKey, SDL_FRect>> fallbackTilesToRender;
+
+    // Load every cached tile that has no texture yet with one batched read.
+    // Overzoomed tiles need their deepest served ancestor instead.
+    std::vector<TileKey> cachedToLoad;
+    std::vector<TileKey> overzoomed;
+    for (auto& [key, dstRect] : precomputedTiles) {
+        if (isTileLoaded(key)) {
+            continue;
+        }
+        TileKey sourceKey = key;
+        if (key.z > Viewport::MAX_ZOOM) {
+            overzoomed.push_back(key);
+            sourceKey = getAncestorTile(key, key.z - Viewport::MAX_ZOOM);
+            if (isTileLoaded(sourceKey)) {
+                continue;
+            }
+            if (!tileFetcher.isTileCached(sourceKey.z, sourceKey.x, sourceKey.y)) {
+                requestTile(sourceKey);
+            }
+        }
+        if (tileFetcher.isTileCached(sourceKey.z, sourceKey.x, sourceKey.y)) {
+            cachedToLoad.push_back(sourceKey);
+        }
+    }
+    loadTextures(cachedToLoad);
+    for (const TileKey& key : overzoomed) {
+        synthesizeOverzoomTile(key);
+    }
 
     for (auto& [key, dstRect] : precomputedTiles) {
         SDL_Texture* tex = nullptr;
 
+        auto uniformIt = uniformTiles.find(key);
+        if (uniformIt != uniformTiles.end()) {
+            uniformTilesToRender.emplace_back(uniformIt->second, dstRect);
+            renderedTiles++;
+            continue;
+        }
+
         auto it = tileTextures.find(key);
         if (it != tileTextures.end()) {
             tex = it->second;
+            touchTexture(key);
         } else {
-            // Check if tile is cached and load texture
-            if (tileFetcher.isTileCached(key.z, key.x, key.y)) {
-                loadTexture(key);
-                it = tileTextures.find(key);
-                if (it != tileTextures.end()) {
-                    tex = it->second;
-                }
-            }
-
-            // If texture still not available, enqueue fetch
-            if (!tex && tileFutures.find(key) == tileFutures.end()) {
-                tileFutures[key] = tileFetcher.fetchTile(key.z, key.x, key.y);
+            // If texture still not available, enqueue fetch (the source has
+            // nothing past MAX_ZOOM)
+            if (key.z <= Viewport::MAX_ZOOM) {
+                requestTile(key);
             }
         }
 
@@ -158,8 +602,8 @@ void TileRenderer::render(const SDL_Rect& mapArea) {
             tilesToRender.emplace_back(tex, dstRect);
             renderedTiles++;
         } else {
-            // Attempt to render parent tile as placeholder
-            parentTilesToRender.emplace_back(key, dstRect);
+            // Draw a placeholder from loaded ancestors or descendants
+            fallbackTilesToRender.emplace_back(key, dstRect);
         }
     }
 
@@ -167,87 +611,51 @@ void TileRenderer::render(const SDL_Rect& mapArea) {
 
     // Render available tiles
     for (auto& tile : tilesToRender) {
-        SDL_Rect& dst = tile.second;
-        SDL_RenderCopy(renderer, tile.first, nullptr, &dst);
+        SDL_FRect& dst = tile.second;
+        SDL_RenderCopyF(renderer, tile.first, nullptr, &dst);
     }
 
-    // Render parent tiles as placeholders
-    for (auto& [key, dstRect] : parentTilesToRender) {
-        renderParentTile(key, dstRect);
+    // Single-color tiles need no texture at all
+    for (auto& [color, dst] : uniformTilesToRender) {
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRectF(renderer, &dst);
     }
 
+    // Render placeholders for tiles that are still missing
+    for (auto& [key, dstRect] : fallbackTilesToRender) {
+        renderFallbackTile(key, dstRect);
+    }
+    placeholdersDrawn = fallbackTilesToRender.size();
+
     SDL_RenderSetViewport(renderer, nullptr); // Reset to full window
+
+    evictTexturesIfNeeded();
+    frameCounter++;
 }
 
 void TileRenderer::precomputeTilePositions() {
-    precomputedTiles.clear();
-
-    int z = viewport.zoom;
-    double centerLat = viewport.centerLat;
-    double centerLon = viewport.centerLon;
-    int windowWidth = viewport.windowWidth;
-    int windowHeight = viewport.windowHeight;
-
-    double n = pow(2.0, z);
-    double x = (centerLon + 180.0) / 360.0 * n;
-    double y = (1.0 - log(tan(centerLat * M_PI / 180.0) + 1.0 / cos(centerLat * M_PI / 180.0)) / M_PI) / 2.0 * n;
-
-    double tileStartX = x - (windowWidth / 2.0) / 256.0;
-    double tileStartY = y - (windowHeight / 2.0) / 256.0;
-
-    double offsetX = (tileStartX - floor(tileStartX)) * 256.0;
-    double offsetY = (tileStartY - floor(tileStartY)) * 256.0;
-
-    int startTileX = static_cast<int>(tileStartX);
-    int startTileY = static_cast<int>(tileStartY);
-
-    int tilesX = static_cast<int>(ceil(double(windowWidth) / 256.0)) + 2;
-    int tilesY = static_cast<int>(ceil(double(windowHeight) / 256.0)) + 2;
-
-    for (int dx = 0; dx < tilesX; dx++) {
-        for (int dy = 0; dy < tilesY; dy++) {
-            int rawTileX = startTileX + dx;
-            int rawTileY = startTileY + dy;
-
-            // Normalize tileX by wrapping around
-            int tileX = rawTileX % static_cast<int>(n);
-            if (tileX < 0) {
-                tileX += static_cast<int>(n);
-            }
-
-            // Clamp tileY between 0 and (n - 1)
-            int tileY = rawTileY;
-            if (tileY < 0) {
-                tileY = 0;
-            } else if (tileY >= static_cast<int>(n)) {
-                tileY = static_cast<int>(n) - 1;
-            }
-
-            TileKey key = { z, tileX, tileY };
-
-            double screenX = dx * 256.0 - offsetX;
-            double screenY = dy * 256.0 - offsetY;
+    precomputedTiles = layoutTiles(viewport, tileZoom);
+}
 
-            SDL_Rect dstRect = {
-                static_cast<int>(floor(screenX)),
-                static_cast<int>(floor(screenY)),
-                256, 256
-            };
-            precomputedTiles.emplace_back(key, dstRect);
-        }
+std::vector<std::pair<TileKey, SDL_FRect>> TileRenderer::layoutTiles(const Viewport& vp, int z) const {
+    std::vector<std::pair<TileKey, SDL_FRect>> tiles;
+    for (const auto& [key, rect] : TileLayout::visibleTiles(vp, z)) {
+        tiles.emplace_back(key, SDL_FRect{ rect.x, rect.y, rect.w, rect.h });
     }
+    return tiles;
 }
 
 void TileRenderer::processTileFutures() {
     int processedTiles = 0;
     int failedTiles = 0;
+    std::vector<TileKey> fetchedTiles;
 
     for (auto it = tileFutures.begin(); it != tileFutures.end();) {
         std::future<bool>& fut = it->second;
         if (fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
             bool success = fut.get();
             if (success) {
-                loadTexture(it->first);
+                fetchedTiles.push_back(it->first);
                 processedTiles++;
             } else {
                 failedTiles++;
@@ -261,6 +669,8 @@ void TileRenderer::processTileFutures() {
         }
     }
 
+    loadTextures(fetchedTiles);
+
     if (processedTiles > 0 || failedTiles > 0) {
         //SDL_Log("Processed tiles: %d, Failed tiles: %d", processedTiles, failedTiles);
     }
@@ -271,35 +681,232 @@ void TileRenderer::processTileFutures() {
 }
 
 void TileRenderer::loadTexture(const TileKey& key) {
-    if (tileTextures.find(key) != tileTextures.end()) {
-        return; // Texture already loaded
+    loadTextures({ key });
+}
+
+void TileRenderer::loadTextures(const std::vector<TileKey>& keys) {
+    std::vector<TileKey> missing;
+    for (const TileKey& key : keys) {
+        if (!isTileLoaded(key) &&
+            std::find(missing.begin(), missing.end(), key) == missing.end()) {
+            missing.push_back(key);
+        }
+    }
+    if (missing.empty()) {
+        return; // Textures already loaded
     }
 
-    std::filesystem::path tilePath = tileFetcher.getTilePath(key.z, key.x, key.y);
-    if (tilePath.empty()) {
-        //Utils::logError("Attempted to load texture for non-cached tile z=" +
-        //                std::to_string(key.z) + ", x=" + std::to_string(key.x) +
-        //                ", y=" + std::to_string(key.y));
-        return;
+    // Fresh tiles come straight from their download buffers; the rest are
+    // read from the disk cache as one batch
+    std::vector<std::shared_ptr<const ByteBuffer>> data = tileFetcher.readTiles(missing);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (data[i]) {
+            createTexture(missing[i], *data[i]);
+        }
     }
+}
 
-    SDL_Surface* surface = IMG_Load(tilePath.string().c_str());
-    if (!surface) {
-        Utils::logError("Failed to load image from " + tilePath.string() + " => " + IMG_GetError());
+void TileRenderer::createTexture(const TileKey& key, const ByteBuffer& data) {
+    ContentHash hash = ContentHash::of(data.data(), data.size());
+    if (reuseTexture(key, hash)) {
         return;
     }
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
+    std::shared_ptr<const DecodedTile> decoded = decodeTile(key, data, hash);
+    if (decoded) {
+        attachDecodedTile(key, hash, *decoded);
+    }
+}
+
+std::shared_ptr<const DecodedTile> TileRenderer::decodeTile(const TileKey& key, const ByteBuffer& data,
+                                                            const ContentHash& hash) {
+    // Decode only if the compact form is not already hot in RAM
+    std::shared_ptr<const DecodedTile> decoded = decodedTiles->get(hash);
+    if (decoded) {
+        return decoded;
+    }
 
+    Trace::Scope span("decode", "decode", key.z, key.x, key.y);
+    DecodedImage image;
+    if (!imageDecoder->decode(data.data(), data.size(), image, decodeScratch)) {
+        Utils::logError("Failed to decode image for tile z=" + std::to_string(key.z) +
+                        ", x=" + std::to_string(key.x) + ", y=" + std::to_string(key.y) +
+                        " (" + imageDecoder->name() + ")");
+        return nullptr;
+    }
+
+    std::shared_ptr<DecodedTile> tile = DecodedTile::fromImage(image, decodeScratch);
+    decodedTiles->put(hash, tile);
+    return tile;
+}
+
+bool TileRenderer::reuseTexture(const TileKey& key, const ContentHash& hash) {
+    // Identical content was already decoded: reuse its color or texture
+    auto uniformIt = uniformColors.find(hash);
+    if (uniformIt != uniformColors.end()) {
+        uniformTiles[key] = uniformIt->second;
+        metrics().hits.add();
+        return true;
+    }
+    auto sharedIt = sharedTextures.find(hash);
+    if (sharedIt != sharedTextures.end()) {
+        sharedIt->second.lastUsedFrame = frameCounter;
+        tileTextures[key] = sharedIt->second.texture;
+        tileHashes[key] = hash;
+        metrics().hits.add();
+        return true;
+    }
+    metrics().misses.add();
+    return false;
+}
+
+void TileRenderer::attachDecodedTile(const TileKey& key, const ContentHash& hash, const DecodedTile& tile) {
+    if (tile.uniform) {
+        SDL_Color color;
+        color.a = static_cast<Uint8>(tile.uniformColor >> 24);
+        color.r = static_cast<Uint8>(tile.uniformColor >> 16);
+        color.g = static_cast<Uint8>(tile.uniformColor >> 8);
+        color.b = static_cast<Uint8>(tile.uniformColor);
+        uniformColors[hash] = color;
+        uniformTiles[key] = color;
+        return;
+    }
+
+    SDL_Texture* texture = nullptr;
+    {
+        Trace::Scope span("upload", "render", key.z, key.x, key.y);
+        texture = uploadDecodedTile(tile);
+    }
     if (!texture) {
-        Utils::logError("Failed to create texture from surface for tile z=" +
+        Utils::logError("Failed to create texture for tile z=" +
                         std::to_string(key.z) + ", x=" + std::to_string(key.x) +
                         ", y=" + std::to_string(key.y) + " => " + SDL_GetError());
         return;
     }
 
+    sharedTextures[hash] = { texture, frameCounter };
     tileTextures[key] = texture;
+    tileHashes[key] = hash;
+}
+
+bool TileRenderer::isTileLoaded(const TileKey& key) const {
+    return tileTextures.find(key) != tileTextures.end() || uniformTiles.find(key) != uniformTiles.end();
+}
+
+bool TileRenderer::synthesizeOverzoomTile(const TileKey& key) {
+    int levels = key.z - Viewport::MAX_ZOOM;
+    TileKey sourceKey = getAncestorTile(key, levels);
+
+    auto uniformIt = uniformTiles.find(sourceKey);
+    if (uniformIt != uniformTiles.end()) {
+        uniformTiles[key] = uniformIt->second;
+        return true;
+    }
+    auto sourceHashIt = tileHashes.find(sourceKey);
+    if (sourceHashIt == tileHashes.end()) {
+        return false; // Source tile not loaded yet
+    }
+    ContentHash sourceHash = sourceHashIt->second;
+
+    // Derived tiles get a stable hash of their own so they go through the
+    // same decoded-tile and texture caches as downloaded ones
+    int span = 1 << levels;
+    int subX = key.x & (span - 1);
+    int subY = key.y & (span - 1);
+    uint64_t words[4] = { sourceHash.hi, sourceHash.lo, static_cast<uint64_t>(levels),
+                          (static_cast<uint64_t>(subX) << 32) | static_cast<uint32_t>(subY) };
+    ContentHash hash = ContentHash::of(reinterpret_cast<const uint8_t*>(words), sizeof(words));
+    if (reuseTexture(key, hash)) {
+        return true;
+    }
+
+    std::shared_ptr<const DecodedTile> derived = decodedTiles->get(hash);
+    if (!derived) {
+        std::shared_ptr<const DecodedTile> source = decodedTiles->get(sourceHash);
+        if (!source) {
+            // Source texture is live but its decoded form was evicted
+            std::shared_ptr<const ByteBuffer> data = tileFetcher.readTiles({ sourceKey })[0];
+            source = data ? decodeTile(sourceKey, *data, sourceHash) : nullptr;
+            if (!source) {
+                return false;
+            }
+        }
+        std::shared_ptr<DecodedTile> tile = DecodedTile::overzoom(*source, levels, subX, subY);
+        decodedTiles->put(hash, tile);
+        derived = tile;
+    }
+
+    attachDecodedTile(key, hash, *derived);
+    return true;
+}
+
+SDL_Texture* TileRenderer::uploadDecodedTile(const DecodedTile& tile) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC, tile.width, tile.height);
+    if (!texture) {
+        return nullptr;
+    }
+
+    // Palette expansion happens here, into a reused staging buffer
+    int pitch = tile.width * 4;
+    uploadStaging.resize(static_cast<size_t>(pitch) * tile.height);
+    tile.expandTo(uploadStaging.data(), pitch);
+    SDL_UpdateTexture(texture, nullptr, uploadStaging.data(), pitch);
+    metrics().bytes.add(static_cast<int64_t>(pitch) * tile.height);
+
+    if (tile.hasAlpha) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    return texture;
+}
+
+void TileRenderer::touchTexture(const TileKey& key) {
+    auto hashIt = tileHashes.find(key);
+    if (hashIt == tileHashes.end()) {
+        return;
+    }
+    auto sharedIt = sharedTextures.find(hashIt->second);
+    if (sharedIt != sharedTextures.end()) {
+        sharedIt->second.lastUsedFrame = frameCounter;
+    }
+}
+
+void TileRenderer::evictTexturesIfNeeded() {
+    if (sharedTextures.size() <= MAX_TILE_TEXTURES) {
+        return;
+    }
+
+    // Oldest textures first; anything drawn this frame stays
+    std::vector<std::pair<uint64_t, ContentHash>> candidates;
+    for (const auto& [hash, shared] : sharedTextures) {
+        if (shared.lastUsedFrame < frameCounter) {
+            candidates.emplace_back(shared.lastUsedFrame, hash);
+        }
+    }
+    size_t excess = sharedTextures.size() - MAX_TILE_TEXTURES;
+    if (candidates.size() > excess) {
+        std::nth_element(candidates.begin(), candidates.begin() + excess, candidates.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        candidates.resize(excess);
+    }
+
+    std::unordered_set<ContentHash, ContentHashHasher> evicted;
+    for (const auto& candidate : candidates) {
+        auto it = sharedTextures.find(candidate.second);
+        metrics().bytes.add(-textureBytes(it->second.texture));
+        SDL_DestroyTexture(it->second.texture);
+        sharedTextures.erase(it);
+        evicted.insert(candidate.second);
+    }
+
+    for (auto it = tileHashes.begin(); it != tileHashes.end();) {
+        if (evicted.count(it->second)) {
+            tileTextures.erase(it->first);
+            it = tileHashes.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 SDL_Texture* TileRenderer::createPlaceholderTexture() {
     SDL_Surface* placeholder = SDL_CreateRGBSurface(
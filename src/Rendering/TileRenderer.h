@@ -6,12 +6,20 @@
 #include <mutex>
 #include <unordered_map>
 #include <future>
+#include <optional>
+#include <deque>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <filesystem>
 #include "../Networking/Tiles/TileKey.h"
 #include "../Networking/Tiles/TileFetcher.h"
+#include "../Utils/ContentHash.h"
+#include "DecodedTileCache.h"
+#include "../Decoding/ImageDecoder.h"
 #include "Viewport.h"
+#include "FrameClock.h"
+#include "TilePrefetcher.h"
+#include "FlightPath.h"
 
 class TileRenderer {
 public:
@@ -21,6 +29,33 @@ public:
     void setViewport(const Viewport& vp);
     void render(const SDL_Rect& mapArea);
 
+    // Animates the zoom by delta levels, keeping the map point under the
+    // given window position fixed. Repeated calls extend the animation.
+    void zoomAt(double delta, int windowX, int windowY);
+
+    // Zoom level the current animation ends at (current zoom if idle)
+    double targetZoom() const;
+
+    // Flies to a view along a zoom-out / pan / zoom-in path. The tiles every
+    // frame of the flight will show are fetched and decoded in the order
+    // they are needed. durationMs <= 0 picks a duration from the distance.
+    // Any other viewport change cancels the flight.
+    void flyTo(double lat, double lon, double zoom, double durationMs = 0.0);
+    bool isFlying() const;
+
+    // True once the last frame drew every tile of a settled view: no
+    // animation running and no placeholder drawn
+    bool isViewComplete() const;
+
+    // Advances animations by a fixed step per frame instead of the wall
+    // clock (input replay); 0 restores the wall clock
+    void setFixedFrameStep(double ms);
+
+    // Input hints for the prefetcher: drag distance in pixels, and the
+    // cursor position in window coordinates
+    void notePan(int dx, int dy);
+    void noteCursor(int windowX, int windowY);
+
     bool needsRedraw() const;
     void setNeedsRedraw(bool flag = true);
     void resetRedrawFlag();
@@ -36,18 +71,102 @@ private:
     TileFetcher tileFetcher;
     std::mutex renderMutex;
     std::unordered_map<TileKey, SDL_Texture*, TileKeyHash> tileTextures;
+
+    // Tiles with identical content share one texture; this map owns them.
+    // A texture is freed only by LRU eviction, which also unlinks every
+    // tile using it, so no per-tile reference count is needed.
+    struct SharedTexture {
+        SDL_Texture* texture;
+        uint64_t lastUsedFrame;
+    };
+    std::unordered_map<ContentHash, SharedTexture, ContentHashHasher> sharedTextures;
+    std::unordered_map<TileKey, ContentHash, TileKeyHash> tileHashes;
+    uint64_t frameCounter = 0;
+    size_t placeholdersDrawn = 0; // In the last frame
+
+    // Compact (palette-indexed) decoded tiles, re-uploaded after texture eviction.
+    // Shared with the fetch workers, which decode downloads into it.
+    std::shared_ptr<DecodedTileCache> decodedTiles;
+    std::vector<uint8_t> uploadStaging;
+
+    // Decodes on the render thread into a reused scratch buffer
+    std::unique_ptr<ImageDecoder> imageDecoder;
+    ByteBuffer decodeScratch;
+
+    // Single-color tiles are drawn as filled rects and never get a texture
+    std::unordered_map<TileKey, SDL_Color, TileKeyHash> uniformTiles;
+    std::unordered_map<ContentHash, SDL_Color, ContentHashHasher> uniformColors;
     std::unordered_map<TileKey, std::future<bool>, TileKeyHash> tileFutures;
     bool needsRedrawFlag;
-    std::vector<std::pair<TileKey, SDL_Rect>> precomputedTiles;
+    std::vector<std::pair<TileKey, SDL_FRect>> precomputedTiles;
+
+    // Integer level tiles are drawn from; changes with hysteresis so a
+    // zoom hovering around x.5 does not flip between levels. Out of range
+    // until the constructor picks the level nearest the starting zoom.
+    int tileZoom = -1;
+    SDL_Rect lastMapArea = { 0, 0, 0, 0 };
+
+    struct ZoomAnimation {
+        double fromZoom;
+        double toZoom;
+        double anchorLon;   // Map point kept under the cursor
+        double anchorLat;
+        double anchorDx;    // Cursor offset from the view center, px
+        double anchorDy;
+        double startMs;
+    };
+    std::optional<ZoomAnimation> zoomAnimation;
+
+    struct Flight {
+        FlightPath path;
+        double startMs;
+        double durationMs;
+        std::deque<std::pair<double, TileKey>> plannedTiles; // (ms into flight, tile), in order of need
+    };
+    std::optional<Flight> flight;
+    FrameClock frameClock;
+
+    // Predicted tiles, fetched at background priority
+    TilePrefetcher prefetcher;
+    std::unordered_map<TileKey, std::future<bool>, TileKeyHash> prefetchFutures;
 
     void processTileFutures();
     void precomputeTilePositions();
+    void applyViewport(const Viewport& vp); // Caller holds renderMutex
+    void advanceAnimation();
+    // Level to draw at zoom when level current was drawn last
+    static int selectTileZoom(double zoom, int current);
+    // Level drawn after the zoom moves steadily from one value to another,
+    // applying selectTileZoom's rule along the way as frames would
+    static int settleTileZoom(double from, double to, int level);
+    std::vector<std::pair<TileKey, SDL_FRect>> layoutTiles(const Viewport& vp, int z) const;
+    void prefetchViewport(const Viewport& vp, int level);
+    void requestTile(const TileKey& key); // Fetch now, promoting a running prefetch
+    void runPrefetch();
+    void planFlightTiles(Flight& f) const;
+    void issueFlightTiles();
     void loadTexture(const TileKey& key);
+    void loadTextures(const std::vector<TileKey>& keys); // One batched cache read
+    void createTexture(const TileKey& key, const ByteBuffer& data);
+    std::shared_ptr<const DecodedTile> decodeTile(const TileKey& key, const ByteBuffer& data,
+                                                  const ContentHash& hash);
+    bool reuseTexture(const TileKey& key, const ContentHash& hash);
+    void attachDecodedTile(const TileKey& key, const ContentHash& hash, const DecodedTile& tile);
+    bool isTileLoaded(const TileKey& key) const;
+    SDL_Texture* uploadDecodedTile(const DecodedTile& tile);
+    void touchTexture(const TileKey& key);
+    void evictTexturesIfNeeded();
     SDL_Texture* createPlaceholderTexture();
 
-    // New helper functions
-    TileKey getParentTile(const TileKey& key) const;
-    void renderParentTile(const TileKey& childKey, const SDL_Rect& dstRect);
+    // Placeholders for missing tiles: a cropped ancestor, overdrawn by
+    // whatever descendants are already loaded
+    TileKey getAncestorTile(const TileKey& key, int levels) const;
+    bool renderAncestorTile(const TileKey& key, const SDL_FRect& dstRect);
+    bool renderDescendantTiles(const TileKey& key, const SDL_FRect& dstRect, int depth);
+    void renderFallbackTile(const TileKey& key, const SDL_FRect& dstRect);
+
+    // Tiles past Viewport::MAX_ZOOM are cut from the deepest served ancestor
+    bool synthesizeOverzoomTile(const TileKey& key);
 };
 
 #endif // TILERENDERER_H
@@ -5,13 +5,14 @@
 struct Viewport {
     double centerLat;
     double centerLon;
-    int zoom;
+    double zoom;     // Fractional; tiles come from the nearest integer level
     int windowWidth;
     int windowHeight;
 
     // Define zoom limits
     static constexpr int MIN_ZOOM = 2;
-    static constexpr int MAX_ZOOM = 19;
+    static constexpr int MAX_ZOOM = 19;     // Deepest level the tile source serves
+    static constexpr int MAX_OVERZOOM = 22; // Deeper levels are upscaled from MAX_ZOOM
 };
 
 #endif // VIEWPORT_H
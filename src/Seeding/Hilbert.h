@@ -0,0 +1,34 @@
+// src/Seeding/Hilbert.h
+#ifndef HILBERT_H
+#define HILBERT_H
+
+#include <cstdint>
+#include <utility>
+
+namespace Hilbert {
+
+// Position of cell (x, y) along the Hilbert curve filling a 2^order grid.
+// Cells close on the curve are close on the map, so tiles fetched in this
+// order land in neighbouring cache directories and upstream server caches.
+inline uint64_t index(int order, uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = order > 0 ? (1u << (order - 1)) : 0; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the sub-curve is in standard orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+} // namespace Hilbert
+
+#endif // HILBERT_H
@@ -0,0 +1,248 @@
+// src/Seeding/SeedArea.cpp
+#include "SeedArea.h"
+#include "Hilbert.h"
+#include "../Rendering/Projection.h"
+#include "../Utils/ContentHash.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Polygon edge in tile units of one zoom level
+struct Edge {
+    double ax, ay, bx, by;
+    double minY() const { return std::min(ay, by); }
+    double maxY() const { return std::max(ay, by); }
+};
+
+SeedArea::Ring parseRing(const nlohmann::json& coords) {
+    SeedArea::Ring ring;
+    for (const auto& point : coords) {
+        if (!point.is_array() || point.size() < 2) {
+            throw std::runtime_error("GeoJSON position must be [lon, lat]");
+        }
+        ring.emplace_back(point[0].get<double>(), point[1].get<double>());
+    }
+    return ring;
+}
+
+} // namespace
+
+SeedArea SeedArea::fromBoundingBox(double minLon, double minLat, double maxLon, double maxLat) {
+    if (minLat >= maxLat) {
+        throw std::runtime_error("Bounding box needs minLat < maxLat");
+    }
+    if (minLon > maxLon) {
+        // Split at the antimeridian into two boxes
+        SeedArea area = fromBoundingBox(minLon, minLat, 180.0, maxLat);
+        area.polygons.push_back(fromBoundingBox(-180.0, minLat, maxLon, maxLat).polygons.front());
+        return area;
+    }
+    return fromPolygon({ { minLon, minLat }, { maxLon, minLat }, { maxLon, maxLat }, { minLon, maxLat } });
+}
+
+SeedArea SeedArea::fromPolygon(const Ring& ring) {
+    if (ring.size() < 3) {
+        throw std::runtime_error("Polygon needs at least 3 points");
+    }
+    SeedArea area;
+    area.polygons.push_back({ { ring } });
+    return area;
+}
+
+SeedArea SeedArea::fromGeoJson(const std::string& text) {
+    SeedArea area;
+    std::function<void(const nlohmann::json&)> addGeometry = [&](const nlohmann::json& node) {
+        std::string type = node.value("type", "");
+        if (type == "FeatureCollection") {
+            for (const auto& feature : node.at("features")) {
+                addGeometry(feature);
+            }
+        } else if (type == "Feature") {
+            if (!node.at("geometry").is_null()) {
+                addGeometry(node.at("geometry"));
+            }
+        } else if (type == "GeometryCollection") {
+            for (const auto& geometry : node.at("geometries")) {
+                addGeometry(geometry);
+            }
+        } else if (type == "Polygon" || type == "MultiPolygon") {
+            const nlohmann::json& coords = node.at("coordinates");
+            std::vector<nlohmann::json> polygons;
+            if (type == "Polygon") {
+                polygons.push_back(coords);
+            } else {
+                polygons.assign(coords.begin(), coords.end());
+            }
+            for (const auto& rings : polygons) {
+                Polygon polygon;
+                for (const auto& ring : rings) {
+                    polygon.rings.push_back(parseRing(ring));
+                }
+                if (!polygon.rings.empty() && polygon.rings.front().size() >= 3) {
+                    area.polygons.push_back(std::move(polygon));
+                }
+            }
+        }
+    };
+
+    try {
+        addGeometry(nlohmann::json::parse(text));
+    } catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error(std::string("Invalid GeoJSON: ") + e.what());
+    }
+    if (area.polygons.empty()) {
+        throw std::runtime_error("GeoJSON contains no polygons");
+    }
+    return area;
+}
+
+void SeedArea::forEachRun(int z, const std::function<void(int, int, int)>& visit) const {
+    const int n = 1 << z;
+    auto toTileX = [&](double lon) {
+        return Projection::lonToWorldX(lon, z) / Projection::TILE_SIZE;
+    };
+    auto toTileY = [&](double lat) {
+        lat = std::clamp(lat, -Projection::MAX_LATITUDE, Projection::MAX_LATITUDE);
+        return Projection::latToWorldY(lat, z) / Projection::TILE_SIZE;
+    };
+    auto clampTile = [&](double v) {
+        return std::clamp(static_cast<int>(std::floor(v)), 0, n - 1);
+    };
+
+    std::vector<std::vector<Edge>> polygonEdges;
+    double minY = n, maxY = 0.0;
+    for (const Polygon& polygon : polygons) {
+        std::vector<Edge> edges;
+        for (const Ring& ring : polygon.rings) {
+            for (size_t i = 0; i < ring.size(); ++i) {
+                const auto& a = ring[i];
+                const auto& b = ring[(i + 1) % ring.size()]; // Closing edge may be implicit
+                if (a == b) {
+                    continue;
+                }
+                edges.push_back({ toTileX(a.first), toTileY(a.second), toTileX(b.first), toTileY(b.second) });
+                minY = std::min(minY, edges.back().minY());
+                maxY = std::max(maxY, edges.back().maxY());
+            }
+        }
+        std::sort(edges.begin(), edges.end(), [](const Edge& l, const Edge& r) { return l.minY() < r.minY(); });
+        polygonEdges.push_back(std::move(edges));
+    }
+    if (minY > maxY) {
+        return;
+    }
+
+    // Covered spans per row, collected over all polygons and merged at the end
+    const int firstRow = clampTile(minY);
+    std::vector<std::vector<std::pair<int, int>>> rows(clampTile(maxY) - firstRow + 1);
+
+    for (const std::vector<Edge>& edges : polygonEdges) {
+        if (edges.empty()) {
+            continue;
+        }
+        double polygonMaxY = 0.0;
+        for (const Edge& e : edges) {
+            polygonMaxY = std::max(polygonMaxY, e.maxY());
+        }
+
+        // Sweep the rows, keeping the edges that reach into the current one
+        std::vector<const Edge*> active;
+        size_t nextEdge = 0;
+        for (int y = clampTile(edges.front().minY()); y <= clampTile(polygonMaxY); ++y) {
+            while (nextEdge < edges.size() && edges[nextEdge].minY() <= y + 1) {
+                active.push_back(&edges[nextEdge++]);
+            }
+            active.erase(std::remove_if(active.begin(), active.end(),
+                                        [y](const Edge* e) { return e->maxY() < y; }),
+                         active.end());
+
+            std::vector<double> crossings;
+            double mid = y + 0.5;
+            for (const Edge* e : active) {
+                // Tiles the boundary passes through
+                double top = std::max(e->minY(), double(y));
+                double bottom = std::min(e->maxY(), double(y + 1));
+                if (top <= bottom) {
+                    double x0 = e->ax, x1 = e->bx;
+                    if (e->ay != e->by) {
+                        x0 = e->ax + (top - e->ay) * (e->bx - e->ax) / (e->by - e->ay);
+                        x1 = e->ax + (bottom - e->ay) * (e->bx - e->ax) / (e->by - e->ay);
+                    }
+                    rows[y - firstRow].emplace_back(clampTile(std::min(x0, x1)), clampTile(std::max(x0, x1)));
+                }
+
+                // Interior, found by even-odd crossings of the row's center line
+                if ((e->ay > mid) != (e->by > mid)) {
+                    crossings.push_back(e->ax + (mid - e->ay) * (e->bx - e->ax) / (e->by - e->ay));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+            for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                int first = static_cast<int>(std::ceil(crossings[i] - 0.5));
+                int last = static_cast<int>(std::floor(crossings[i + 1] - 0.5));
+                if (first <= last && last >= 0 && first < n) {
+                    rows[y - firstRow].emplace_back(std::max(first, 0), std::min(last, n - 1));
+                }
+            }
+        }
+    }
+
+    for (int y = firstRow; y < firstRow + static_cast<int>(rows.size()); ++y) {
+        auto& spans = rows[y - firstRow];
+        if (spans.empty()) {
+            continue;
+        }
+        std::sort(spans.begin(), spans.end());
+        int start = spans.front().first;
+        int end = spans.front().second;
+        for (const auto& [first, last] : spans) {
+            if (first > end + 1) {
+                visit(y, start, end);
+                start = first;
+            }
+            end = std::max(end, last);
+        }
+        visit(y, start, end);
+    }
+}
+
+size_t SeedArea::countTiles(int z) const {
+    size_t count = 0;
+    forEachRun(z, [&](int, int x0, int x1) { count += x1 - x0 + 1; });
+    return count;
+}
+
+std::vector<TileKey> SeedArea::tilesAt(int z) const {
+    std::vector<std::pair<uint64_t, TileKey>> ordered;
+    forEachRun(z, [&](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; ++x) {
+            ordered.push_back({ Hilbert::index(z, x, y), { z, x, y } });
+        }
+    });
+    std::sort(ordered.begin(), ordered.end(),
+              [](const auto& l, const auto& r) { return l.first < r.first; });
+
+    std::vector<TileKey> tiles;
+    tiles.reserve(ordered.size());
+    for (const auto& entry : ordered) {
+        tiles.push_back(entry.second);
+    }
+    return tiles;
+}
+
+std::string SeedArea::signature() const {
+    std::string text;
+    for (const Polygon& polygon : polygons) {
+        for (const Ring& ring : polygon.rings) {
+            for (const auto& [lon, lat] : ring) {
+                text += std::to_string(lon) + "," + std::to_string(lat) + ";";
+            }
+            text += "|";
+        }
+        text += "#";
+    }
+    return ContentHash::of(reinterpret_cast<const uint8_t*>(text.data()), text.size()).toHex();
+}
@@ -0,0 +1,46 @@
+// src/Seeding/SeedArea.h
+#ifndef SEEDAREA_H
+#define SEEDAREA_H
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../Networking/Tiles/TileKey.h"
+
+// Region to prepare tiles for: a union of polygons (with holes) in lon/lat.
+// Parse errors are reported as std::runtime_error.
+class SeedArea {
+public:
+    using Ring = std::vector<std::pair<double, double>>; // (lon, lat) pairs
+
+    // A bounding box with minLon > maxLon crosses the antimeridian
+    static SeedArea fromBoundingBox(double minLon, double minLat, double maxLon, double maxLat);
+    static SeedArea fromPolygon(const Ring& ring);
+
+    // Accepts a Polygon or MultiPolygon geometry, a Feature or a FeatureCollection;
+    // other geometry types are ignored
+    static SeedArea fromGeoJson(const std::string& text);
+
+    // Number of tiles of level z touching the area
+    size_t countTiles(int z) const;
+
+    // Tiles of level z touching the area, in Hilbert curve order
+    std::vector<TileKey> tilesAt(int z) const;
+
+    // Stable text identifying the area, used to match resume state
+    std::string signature() const;
+
+    bool empty() const { return polygons.empty(); }
+
+private:
+    struct Polygon {
+        std::vector<Ring> rings; // Outer boundary first, then holes
+    };
+    std::vector<Polygon> polygons;
+
+    // Calls visit(y, x0, x1) for each run of covered tiles in row y
+    void forEachRun(int z, const std::function<void(int, int, int)>& visit) const;
+};
+
+#endif // SEEDAREA_H
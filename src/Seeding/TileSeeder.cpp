@@ -0,0 +1,239 @@
+// src/Seeding/TileSeeder.cpp
+#include "TileSeeder.h"
+#include "../Utils/Utils.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static const std::chrono::milliseconds PROGRESS_INTERVAL(1000);
+static const std::chrono::milliseconds CHECKPOINT_INTERVAL(2000);
+
+// Marks in-flight retries, which have no position in the level's order
+static const size_t NO_INDEX = static_cast<size_t>(-1);
+
+TileSeeder::TileSeeder(TileFetcher& fetcher, const SeedArea& area, const SeedOptions& options)
+    : fetcher(fetcher), area(area), options(options), resumeZoom(options.minZoom), resumeIndex(0) {}
+
+std::string TileSeeder::jobSignature() const {
+    return area.signature() + ":" + std::to_string(options.minZoom) + "-" + std::to_string(options.maxZoom);
+}
+
+bool TileSeeder::loadState() {
+    if (options.statePath.empty() || !std::filesystem::exists(options.statePath)) {
+        return false;
+    }
+    try {
+        std::ifstream file(options.statePath);
+        nlohmann::json j;
+        file >> j;
+        if (j.at("job").get<std::string>() != jobSignature()) {
+            Utils::logError("Seed state " + options.statePath.string() +
+                            " belongs to a different area or zoom range; starting over");
+            return false;
+        }
+        resumeZoom = j.at("zoom").get<int>();
+        resumeIndex = j.at("index").get<size_t>();
+        for (const auto& key : j.at("failed")) {
+            failedTiles.push_back({ key.at(0).get<int>(), key.at(1).get<int>(), key.at(2).get<int>() });
+        }
+        return true;
+    } catch (const std::exception& e) {
+        Utils::logError("Ignoring unreadable seed state " + options.statePath.string() + ": " + e.what());
+        return false;
+    }
+}
+
+void TileSeeder::saveState(int zoom, size_t index, const std::vector<TileKey>& failed) const {
+    if (options.statePath.empty()) {
+        return;
+    }
+    nlohmann::json j;
+    j["job"] = jobSignature();
+    j["zoom"] = zoom;
+    j["index"] = index;
+    j["failed"] = nlohmann::json::array();
+    for (const TileKey& key : failed) {
+        j["failed"].push_back({ key.z, key.x, key.y });
+    }
+
+    // Write then rename so an interruption never leaves a torn checkpoint
+    std::filesystem::path tmpPath = options.statePath.string() + ".tmp";
+    {
+        std::ofstream file(tmpPath);
+        file << j.dump(2);
+        if (!file) {
+            Utils::logError("Failed to write seed state " + tmpPath.string());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, options.statePath, ec);
+    if (ec) {
+        Utils::logError("Failed to write seed state " + options.statePath.string() + ": " + ec.message());
+    }
+}
+
+bool TileSeeder::run(const std::atomic<bool>& cancel, const std::function<void(const SeedProgress&)>& onProgress) {
+    Clock::time_point start = Clock::now();
+    SeedProgress progress;
+
+    bool resumed = loadState();
+    for (int z = options.minZoom; z <= options.maxZoom; ++z) {
+        size_t count = area.countTiles(z);
+        progress.total += count;
+        if (z < resumeZoom) {
+            progress.done += count;
+        }
+    }
+    progress.done += resumeIndex;
+    progress.done -= std::min(progress.done, failedTiles.size()); // Counted again when retried
+    if (resumed) {
+        Utils::logInfo("Resuming seed at z" + std::to_string(resumeZoom) + " tile " + std::to_string(resumeIndex) +
+                       " with " + std::to_string(failedTiles.size()) + " failed tiles to retry");
+    }
+
+    struct Pending {
+        TileKey key;
+        size_t index;
+        std::future<bool> result;
+    };
+    std::deque<Pending> inFlight;
+    std::vector<TileKey> failed;
+    int zoom = resumeZoom;
+    size_t nextIndex = resumeIndex;
+    double nextSlot = 0.0; // Rate limit: earliest start of the next download, s since start
+    Clock::time_point lastReport = start;
+    Clock::time_point lastCheckpoint = start;
+
+    auto elapsed = [&] { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    auto report = [&] {
+        progress.zoom = std::min(zoom, options.maxZoom);
+        progress.elapsedSeconds = elapsed();
+        onProgress(progress);
+        lastReport = Clock::now();
+    };
+
+    // Everything before the oldest unfinished tile of the level is done
+    auto checkpoint = [&] {
+        size_t index = nextIndex;
+        for (const Pending& pending : inFlight) {
+            if (pending.index != NO_INDEX) {
+                index = std::min(index, pending.index);
+            }
+        }
+        std::vector<TileKey> unfinished = failed;
+        for (const Pending& pending : inFlight) {
+            if (pending.index == NO_INDEX) {
+                unfinished.push_back(pending.key); // A retry still running
+            }
+        }
+        saveState(zoom, index, unfinished);
+        lastCheckpoint = Clock::now();
+    };
+
+    // Completes finished requests in order; with block, waits for the oldest
+    auto reap = [&](bool block) {
+        while (!inFlight.empty()) {
+            Pending& front = inFlight.front();
+            if (front.result.wait_for(std::chrono::milliseconds(block ? 100 : 0)) != std::future_status::ready) {
+                if (!block) {
+                    return;
+                }
+                if (Clock::now() - lastReport >= PROGRESS_INTERVAL) {
+                    report();
+                }
+                continue;
+            }
+            if (front.result.get()) {
+                progress.downloaded++;
+            } else {
+                progress.failed++;
+                failed.push_back(front.key);
+                Utils::logError("Failed to seed tile z=" + std::to_string(front.key.z) +
+                                ", x=" + std::to_string(front.key.x) + ", y=" + std::to_string(front.key.y));
+            }
+            progress.done++;
+            inFlight.pop_front();
+            block = false;
+        }
+    };
+
+    auto submit = [&](const TileKey& key, size_t index) {
+        if (fetcher.isTileOnDisk(key.z, key.x, key.y)) {
+            progress.skipped++;
+            progress.done++;
+            return;
+        }
+        while (inFlight.size() >= options.maxInFlight) {
+            reap(true);
+        }
+        if (options.maxTilesPerSecond > 0.0) {
+            double now = elapsed();
+            if (nextSlot > now) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(nextSlot - now));
+            }
+            nextSlot = std::max(nextSlot, now) + 1.0 / options.maxTilesPerSecond;
+        }
+        inFlight.push_back({ key, index, fetcher.fetchTile(key.z, key.x, key.y) });
+    };
+
+    auto housekeeping = [&] {
+        reap(false);
+        if (Clock::now() - lastReport >= PROGRESS_INTERVAL) {
+            report();
+        }
+        if (Clock::now() - lastCheckpoint >= CHECKPOINT_INTERVAL) {
+            checkpoint();
+        }
+    };
+
+    // Tiles that failed last time go first
+    std::vector<TileKey> retries;
+    retries.swap(failedTiles);
+    for (const TileKey& key : retries) {
+        if (cancel) {
+            break;
+        }
+        submit(key, NO_INDEX);
+        housekeeping();
+    }
+
+    while (zoom <= options.maxZoom && !cancel) {
+        std::vector<TileKey> tiles = area.tilesAt(zoom);
+        Utils::logInfo("Seeding z" + std::to_string(zoom) + ": " + std::to_string(tiles.size()) + " tiles");
+        for (; nextIndex < tiles.size() && !cancel; ++nextIndex) {
+            submit(tiles[nextIndex], nextIndex);
+            housekeeping();
+        }
+        if (cancel) {
+            break;
+        }
+
+        // Finish the level so the checkpoint never spans two levels
+        while (!inFlight.empty()) {
+            reap(true);
+        }
+        ++zoom;
+        nextIndex = 0;
+        checkpoint();
+    }
+
+    while (!inFlight.empty()) {
+        reap(true);
+    }
+    if (cancel) {
+        checkpoint();
+    } else if (failed.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(options.statePath, ec);
+    } else {
+        saveState(options.maxZoom + 1, 0, failed);
+    }
+    report();
+    return !cancel && failed.empty();
+}
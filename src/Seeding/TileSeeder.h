@@ -0,0 +1,58 @@
+// src/Seeding/TileSeeder.h
+#ifndef TILESEEDER_H
+#define TILESEEDER_H
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include "SeedArea.h"
+#include "../Networking/Tiles/TileFetcher.h"
+
+struct SeedOptions {
+    int minZoom = 0;
+    int maxZoom = 0;
+    size_t maxInFlight = 8;           // Requests queued on the fetcher at once
+    double maxTilesPerSecond = 0.0;   // Download rate limit; 0 = unlimited
+    std::filesystem::path statePath;  // Resume checkpoint; empty disables resume
+};
+
+struct SeedProgress {
+    int zoom = 0;
+    size_t total = 0;       // Tiles in the whole job
+    size_t done = 0;        // Downloaded + skipped + failed
+    size_t downloaded = 0;
+    size_t skipped = 0;     // Already on disk
+    size_t failed = 0;
+    double elapsedSeconds = 0.0;
+};
+
+// Fills the disk cache for an area and zoom range through a TileFetcher.
+// Tiles are visited level by level in Hilbert order. The position is
+// checkpointed to statePath so an interrupted run continues where it left
+// off, and tiles that failed are retried first on the next run.
+class TileSeeder {
+public:
+    TileSeeder(TileFetcher& fetcher, const SeedArea& area, const SeedOptions& options);
+
+    // Runs until done or cancel is set; progress is reported about once a
+    // second and once at the end. Returns true if every tile is on disk.
+    bool run(const std::atomic<bool>& cancel, const std::function<void(const SeedProgress&)>& onProgress);
+
+private:
+    TileFetcher& fetcher;
+    const SeedArea& area;
+    SeedOptions options;
+
+    // Resume checkpoint
+    int resumeZoom;
+    size_t resumeIndex;
+    std::vector<TileKey> failedTiles;
+
+    bool loadState();
+    void saveState(int zoom, size_t index, const std::vector<TileKey>& failed) const;
+    std::string jobSignature() const;
+};
+
+#endif // TILESEEDER_H
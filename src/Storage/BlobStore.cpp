@@ -0,0 +1,193 @@
+// src/Storage/BlobStore.cpp
+#include "BlobStore.h"
+#include "../Utils/Utils.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool parseHex64(const std::string& hex, uint64_t& out) {
+    if (hex.size() != 16) {
+        return false;
+    }
+    out = 0;
+    for (char c : hex) {
+        out <<= 4;
+        if (c >= '0' && c <= '9') out |= static_cast<uint64_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') out |= static_cast<uint64_t>(c - 'a' + 10);
+        else return false;
+    }
+    return true;
+}
+
+BlobStore::BlobStore(const std::filesystem::path& root)
+    : root(root)
+{
+    loadIndex();
+}
+
+std::filesystem::path BlobStore::blobPath(const ContentHash& hash) const {
+    std::string hex = hash.toHex();
+    return root / hex.substr(0, 2) / hex;
+}
+
+void BlobStore::loadIndex() {
+    std::error_code ec;
+    if (!std::filesystem::exists(root, ec)) {
+        return;
+    }
+
+    for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        std::string name = it->path().filename().string();
+        ContentHash hash;
+        if (name.size() != 32 || !parseHex64(name.substr(0, 16), hash.hi) ||
+            !parseHex64(name.substr(16), hash.lo)) {
+            continue;
+        }
+        struct stat st;
+        if (stat(it->path().c_str(), &st) != 0) {
+            continue;
+        }
+        indexBlob(hash, it->path(), st.st_ino);
+    }
+    Utils::logInfo("BlobStore indexed " + std::to_string(blobs.size()) + " unique tiles");
+}
+
+void BlobStore::indexBlob(const ContentHash& hash, const std::filesystem::path& path, ino_t inode) {
+    BlobEntry& entry = blobs[hash];
+    if (entry.inode != 0) {
+        blobsByInode.erase(entry.inode);
+    }
+    entry.path = path;
+    entry.inode = inode;
+    blobsByInode[inode] = hash;
+}
+
+std::unordered_map<ContentHash, BlobStore::BlobEntry, ContentHashHasher>::iterator
+BlobStore::adoptExisting(const ContentHash& hash) {
+    std::filesystem::path path = blobPath(hash);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return blobs.end();
+    }
+    indexBlob(hash, path, st.st_ino);
+    return blobs.find(hash);
+}
+
+void BlobStore::releaseLocked(ino_t inode) {
+    auto byInode = blobsByInode.find(inode);
+    if (byInode == blobsByInode.end()) {
+        return; // A private copy, not a blob
+    }
+    auto it = blobs.find(byInode->second);
+    if (it == blobs.end()) {
+        blobsByInode.erase(byInode);
+        return;
+    }
+
+    // The link count is authoritative across processes; only the blob's
+    // own entry left means no tile uses it
+    struct stat st;
+    if (stat(it->second.path.c_str(), &st) == 0 && (st.st_ino != inode || st.st_nlink > 1)) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::remove(it->second.path, ec);
+    blobsByInode.erase(byInode);
+    blobs.erase(it);
+}
+
+bool BlobStore::linkIntoPlace(const std::filesystem::path& blob, const std::filesystem::path& tilePath) {
+    // link() refuses to overwrite, so link to a tmp name and rename over
+    std::string tmpPath = tilePath.string() + ".lnk";
+    ::unlink(tmpPath.c_str());
+    if (::link(blob.c_str(), tmpPath.c_str()) != 0) {
+        return false;
+    }
+    if (::rename(tmpPath.c_str(), tilePath.c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<bool> BlobStore::storeBatch(const std::vector<StoreOp>& ops, IoEngine& engine) {
+    std::vector<bool> results(ops.size(), false);
+
+    // Work out which blobs are new; duplicates inside the batch are written once
+    std::vector<IoEngine::WriteOp> newBlobs;
+    std::vector<ContentHash> newBlobHashes;
+    std::vector<std::filesystem::path> targets(ops.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<ContentHash, size_t, ContentHashHasher> queued;
+        for (size_t i = 0; i < ops.size(); ++i) {
+            auto it = blobs.find(ops[i].hash);
+            if (it == blobs.end()) {
+                it = adoptExisting(ops[i].hash);
+            }
+            if (it != blobs.end()) {
+                targets[i] = it->second.path;
+            } else if (queued.count(ops[i].hash)) {
+                targets[i] = newBlobs[queued[ops[i].hash]].path;
+            } else {
+                targets[i] = blobPath(ops[i].hash);
+                queued[ops[i].hash] = newBlobs.size();
+                newBlobs.push_back({ targets[i], ops[i].data });
+                newBlobHashes.push_back(ops[i].hash);
+            }
+        }
+    }
+
+    std::vector<bool> blobWritten;
+    if (!newBlobs.empty()) {
+        for (const auto& blob : newBlobs) {
+            std::error_code ec;
+            std::filesystem::create_directories(blob.path.parent_path(), ec);
+        }
+        blobWritten = engine.writeBatch(newBlobs);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < newBlobs.size(); ++i) {
+            struct stat st;
+            if (blobWritten[i] && stat(newBlobs[i].path.c_str(), &st) == 0) {
+                indexBlob(newBlobHashes[i], newBlobs[i].path, st.st_ino);
+            }
+        }
+    }
+
+    // Link every tile path to its blob; fall back to a private copy if the
+    // filesystem does not support hard links
+    std::vector<IoEngine::WriteOp> copies;
+    std::vector<size_t> copyIndices;
+    std::vector<ino_t> replaced(ops.size(), 0); // Blob inode each tile path linked to before
+    for (size_t i = 0; i < ops.size(); ++i) {
+        struct stat previous;
+        if (::lstat(ops[i].tilePath.c_str(), &previous) == 0 && previous.st_nlink > 1) {
+            replaced[i] = previous.st_ino;
+        }
+        if (linkIntoPlace(targets[i], ops[i].tilePath)) {
+            results[i] = true;
+        } else {
+            copies.push_back({ ops[i].tilePath, ops[i].data });
+            copyIndices.push_back(i);
+        }
+    }
+    if (!copies.empty()) {
+        std::vector<bool> copied = engine.writeBatch(copies);
+        for (size_t j = 0; j < copies.size(); ++j) {
+            results[copyIndices[j]] = copied[j];
+        }
+    }
+
+    // Overwritten tiles gave up their reference to the old blob
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (results[i] && replaced[i] != 0) {
+            releaseLocked(replaced[i]);
+        }
+    }
+    return results;
+}
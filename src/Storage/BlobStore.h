@@ -0,0 +1,59 @@
+// src/Storage/BlobStore.h
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <filesystem>
+#include <sys/types.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "IoEngine.h"
+#include "../Utils/ContentHash.h"
+
+// Content-addressed storage for cached tiles. Each distinct tile body is
+// stored once under blobs/<2 hex>/<hash>; the z/x/y tile paths are hard
+// links to that blob, so existing path-based readers keep working while
+// identical tiles (open ocean, empty land) share one copy on disk. The
+// blob's hard link count is its reference count: when a tile path is
+// overwritten with different content, the old blob is deleted once no
+// tile (in any process sharing the directory) links to it any more.
+class BlobStore {
+public:
+    struct StoreOp {
+        std::filesystem::path tilePath;
+        std::shared_ptr<const ByteBuffer> data;
+        ContentHash hash;
+    };
+
+    explicit BlobStore(const std::filesystem::path& root);
+
+    // Writes the blobs that do not exist yet as one engine batch, then links
+    // every tile path to its blob, releasing the blob a path linked to
+    // before. Returns per-op success.
+    std::vector<bool> storeBatch(const std::vector<StoreOp>& ops, IoEngine& engine);
+
+private:
+    struct BlobEntry {
+        std::filesystem::path path;
+        ino_t inode = 0;
+    };
+
+    std::filesystem::path root;
+    mutable std::mutex mutex;
+    std::unordered_map<ContentHash, BlobEntry, ContentHashHasher> blobs;
+    std::unordered_map<ino_t, ContentHash> blobsByInode; // Finds the blob an overwritten tile linked to
+
+    std::filesystem::path blobPath(const ContentHash& hash) const;
+    void loadIndex();
+    void indexBlob(const ContentHash& hash, const std::filesystem::path& path, ino_t inode); // Caller holds mutex
+
+    // Deletes the blob with this inode if no tile links to it (caller holds mutex)
+    void releaseLocked(ino_t inode);
+
+    // Indexes a blob another process sharing the directory wrote since
+    // loadIndex(), so it is linked rather than rewritten (caller holds mutex)
+    std::unordered_map<ContentHash, BlobEntry, ContentHashHasher>::iterator adoptExisting(const ContentHash& hash);
+    static bool linkIntoPlace(const std::filesystem::path& blob, const std::filesystem::path& tilePath);
+};
+
+#endif // BLOBSTORE_H
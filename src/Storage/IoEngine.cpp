@@ -0,0 +1,81 @@
+// src/Storage/IoEngine.cpp
+#include "IoEngine.h"
+#include "ThreadPoolIoEngine.h"
+#include "UringIoEngine.h"
+#include "../Utils/Utils.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+std::unique_ptr<IoEngine> IoEngine::create(Kind kind) {
+    if (kind != Kind::ThreadPool) {
+        std::unique_ptr<IoEngine> uring = UringIoEngine::tryCreate();
+        if (uring) {
+            return uring;
+        }
+        if (kind == Kind::IoUring) {
+            Utils::logError("io_uring engine unavailable, falling back to thread pool I/O");
+        }
+    }
+    return std::make_unique<ThreadPoolIoEngine>();
+}
+
+bool IoEngine::writeFileAtomically(const std::filesystem::path& path, const ByteBuffer& data) {
+    std::string tmpPath = path.string() + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        Utils::logError("Failed to open tmp file for writing: " + tmpPath);
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    ::close(fd);
+
+    if (written != data.size()) {
+        Utils::logError("Failed to write data to tmp file: " + tmpPath);
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    if (::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        Utils::logError("Failed to rename tmp file to final cache path: " + path.string());
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool IoEngine::readWholeFile(const std::filesystem::path& path, ByteBuffer& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    out.clear();
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size > 0) {
+        out.reserve(static_cast<size_t>(size));
+    }
+    ::lseek(fd, 0, SEEK_SET);
+
+    uint8_t chunk[64 * 1024];
+    bool ok = true;
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        out.insert(out.end(), chunk, chunk + n);
+    }
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,53 @@
+// src/Storage/IoEngine.h
+#ifndef IOENGINE_H
+#define IOENGINE_H
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Utils/BufferPool.h"
+
+// Batched file I/O for the tile cache. Implementations submit a whole
+// batch of reads or writes at once instead of one blocking syscall
+// sequence per tile.
+class IoEngine {
+public:
+    enum class Kind {
+        Auto,       // io_uring when the kernel supports it, else ThreadPool
+        IoUring,
+        ThreadPool
+    };
+
+    struct WriteOp {
+        std::filesystem::path path;
+        std::shared_ptr<const ByteBuffer> data;
+    };
+
+    struct ReadResult {
+        bool ok = false;
+        ByteBuffer data;
+    };
+
+    virtual ~IoEngine() = default;
+
+    // Writes every file via a .tmp sibling that is renamed into place.
+    // Parent directories must already exist. Returns per-op success.
+    virtual std::vector<bool> writeBatch(const std::vector<WriteOp>& ops) = 0;
+
+    // Reads whole files; results are in the same order as paths
+    virtual std::vector<ReadResult> readBatch(const std::vector<std::filesystem::path>& paths) = 0;
+
+    virtual const char* name() const = 0;
+
+    // Creates the requested engine, falling back to the thread pool engine
+    // when io_uring is unavailable
+    static std::unique_ptr<IoEngine> create(Kind kind = Kind::Auto);
+
+protected:
+    // Blocking single-file helpers shared by the engines
+    static bool writeFileAtomically(const std::filesystem::path& path, const ByteBuffer& data);
+    static bool readWholeFile(const std::filesystem::path& path, ByteBuffer& out);
+};
+
+#endif // IOENGINE_H
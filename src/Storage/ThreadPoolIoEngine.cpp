@@ -0,0 +1,39 @@
+// src/Storage/ThreadPoolIoEngine.cpp
+#include "ThreadPoolIoEngine.h"
+
+ThreadPoolIoEngine::ThreadPoolIoEngine(size_t numThreads)
+    : threadPool(numThreads, "disk io")
+{
+}
+
+std::vector<bool> ThreadPoolIoEngine::writeBatch(const std::vector<WriteOp>& ops) {
+    std::vector<std::future<bool>> futures;
+    futures.reserve(ops.size());
+    for (const WriteOp& op : ops) {
+        futures.push_back(threadPool.enqueue([&op]() {
+            return writeFileAtomically(op.path, *op.data);
+        }));
+    }
+
+    std::vector<bool> results;
+    results.reserve(ops.size());
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+std::vector<IoEngine::ReadResult> ThreadPoolIoEngine::readBatch(const std::vector<std::filesystem::path>& paths) {
+    std::vector<ReadResult> results(paths.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        futures.push_back(threadPool.enqueue([&paths, &results, i]() {
+            results[i].ok = readWholeFile(paths[i], results[i].data);
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    return results;
+}
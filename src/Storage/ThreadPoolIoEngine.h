@@ -0,0 +1,22 @@
+// src/Storage/ThreadPoolIoEngine.h
+#ifndef THREADPOOLIOENGINE_H
+#define THREADPOOLIOENGINE_H
+
+#include "IoEngine.h"
+#include "../Utils/ThreadPool.h"
+
+// Portable engine: each file of a batch is handled with blocking syscalls
+// on a worker thread, so queue depth equals the number of workers.
+class ThreadPoolIoEngine : public IoEngine {
+public:
+    explicit ThreadPoolIoEngine(size_t numThreads = 8);
+
+    std::vector<bool> writeBatch(const std::vector<WriteOp>& ops) override;
+    std::vector<ReadResult> readBatch(const std::vector<std::filesystem::path>& paths) override;
+    const char* name() const override { return "threadpool"; }
+
+private:
+    ThreadPool threadPool;
+};
+
+#endif // THREADPOOLIOENGINE_H
@@ -0,0 +1,344 @@
+// src/Storage/UringIoEngine.cpp
+#include "UringIoEngine.h"
+#include "../Utils/Utils.h"
+#include <functional>
+
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+// Operation tags kept in the low bits of user_data; the op index goes above
+enum : uint64_t { TAG_OPEN = 0, TAG_DATA = 1, TAG_RENAME = 2, TAG_CLOSE = 3 };
+
+static uint64_t makeUserData(size_t index, uint64_t tag) {
+    return (static_cast<uint64_t>(index) << 2) | tag;
+}
+
+static int sysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nrArgs) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+std::unique_ptr<UringIoEngine> UringIoEngine::tryCreate() {
+    std::unique_ptr<UringIoEngine> engine(new UringIoEngine());
+    if (!engine->init()) {
+        return nullptr;
+    }
+    return engine;
+}
+
+bool UringIoEngine::init() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = sysSetup(RING_ENTRIES, &params);
+    if (ringFd < 0) {
+        Utils::logInfo("io_uring_setup failed: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    // Direct-descriptor OPENAT arrived together with MKDIRAT in 5.15, so the
+    // probe for MKDIRAT doubles as a feature check for it
+    const int requiredOps[] = { IORING_OP_OPENAT, IORING_OP_CLOSE, IORING_OP_READ_FIXED,
+                                IORING_OP_WRITE, IORING_OP_RENAMEAT, IORING_OP_MKDIRAT };
+    size_t probeSize = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+    std::vector<uint8_t> probeBytes(probeSize, 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBytes.data());
+    if (sysRegister(ringFd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) {
+        Utils::logInfo("io_uring probe failed; kernel too old for the io_uring engine");
+        return false;
+    }
+    for (int op : requiredOps) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            Utils::logInfo("io_uring op " + std::to_string(op) + " unsupported; using thread pool I/O");
+            return false;
+        }
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            return false;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMem = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd, IORING_OFF_SQES);
+    if (sqeMem == MAP_FAILED) {
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(sqeMem);
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Sparse table of direct descriptors used by the OPENAT chains
+    std::vector<int> slots(FILE_SLOTS, -1);
+    if (sysRegister(ringFd, IORING_REGISTER_FILES, slots.data(), FILE_SLOTS) < 0) {
+        Utils::logInfo("io_uring file registration failed: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    // Fixed read buffers: pinned once instead of on every read
+    readArena.resize(READ_BUFFERS * READ_BUFFER_SIZE);
+    std::vector<iovec> iovecs(READ_BUFFERS);
+    for (unsigned i = 0; i < READ_BUFFERS; ++i) {
+        iovecs[i].iov_base = readArena.data() + i * READ_BUFFER_SIZE;
+        iovecs[i].iov_len = READ_BUFFER_SIZE;
+    }
+    if (sysRegister(ringFd, IORING_REGISTER_BUFFERS, iovecs.data(), READ_BUFFERS) < 0) {
+        Utils::logInfo("io_uring buffer registration failed: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    Utils::logInfo("io_uring I/O engine initialized");
+    return true;
+}
+
+UringIoEngine::~UringIoEngine() {
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing) {
+        munmap(sqRing, sqRingSize);
+    }
+    if (ringFd >= 0) {
+        close(ringFd); // Also releases registered files and buffers
+    }
+}
+
+io_uring_sqe* UringIoEngine::nextSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail + pendingSubmit;
+    if (tail - head >= RING_ENTRIES) {
+        return nullptr;
+    }
+    unsigned index = tail & *sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    pendingSubmit++;
+    return sqe;
+}
+
+bool UringIoEngine::submitAndReap(unsigned count, const std::function<void(const io_uring_cqe&)>& onCqe) {
+    __atomic_store_n(sqTail, *sqTail + pendingSubmit, __ATOMIC_RELEASE);
+    unsigned toSubmit = pendingSubmit;
+    pendingSubmit = 0;
+
+    unsigned reaped = 0;
+    while (reaped < count) {
+        int ret = sysEnter(ringFd, toSubmit, count - reaped, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Utils::logError("io_uring_enter failed: " + std::string(std::strerror(errno)));
+            return false;
+        }
+        toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            onCqe(cqes[head & *cqMask]);
+            head++;
+            reaped++;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+std::vector<bool> UringIoEngine::writeBatch(const std::vector<WriteOp>& ops) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<bool> results(ops.size(), false);
+    std::vector<std::string> tmpPaths(ops.size());
+    std::vector<std::string> finalPaths(ops.size());
+
+    const size_t chunkSize = std::min<size_t>(FILE_SLOTS, RING_ENTRIES / 4);
+    for (size_t begin = 0; begin < ops.size(); begin += chunkSize) {
+        size_t end = std::min(ops.size(), begin + chunkSize);
+
+        for (size_t i = begin; i < end; ++i) {
+            unsigned slot = static_cast<unsigned>(i - begin);
+            tmpPaths[i] = ops[i].path.string() + ".tmp";
+            finalPaths[i] = ops[i].path.string();
+
+            io_uring_sqe* open = nextSqe();
+            open->opcode = IORING_OP_OPENAT;
+            open->fd = AT_FDCWD;
+            open->addr = reinterpret_cast<uint64_t>(tmpPaths[i].c_str());
+            open->open_flags = O_WRONLY | O_CREAT | O_TRUNC; // O_CLOEXEC is rejected for direct descriptors
+            open->len = 0644;
+            open->file_index = slot + 1;
+            open->flags = IOSQE_IO_LINK;
+            open->user_data = makeUserData(i, TAG_OPEN);
+
+            io_uring_sqe* write = nextSqe();
+            write->opcode = IORING_OP_WRITE;
+            write->fd = static_cast<int>(slot);
+            write->addr = reinterpret_cast<uint64_t>(ops[i].data->data());
+            write->len = static_cast<unsigned>(ops[i].data->size());
+            write->off = 0;
+            write->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK; // short write cancels the rename
+            write->user_data = makeUserData(i, TAG_DATA);
+
+            io_uring_sqe* rename = nextSqe();
+            rename->opcode = IORING_OP_RENAMEAT;
+            rename->fd = AT_FDCWD;
+            rename->addr = reinterpret_cast<uint64_t>(tmpPaths[i].c_str());
+            rename->len = static_cast<unsigned>(AT_FDCWD);
+            rename->addr2 = reinterpret_cast<uint64_t>(finalPaths[i].c_str());
+            rename->flags = IOSQE_IO_HARDLINK;
+            rename->user_data = makeUserData(i, TAG_RENAME);
+
+            io_uring_sqe* close = nextSqe();
+            close->opcode = IORING_OP_CLOSE;
+            close->file_index = slot + 1;
+            close->user_data = makeUserData(i, TAG_CLOSE);
+        }
+
+        bool ok = submitAndReap(static_cast<unsigned>((end - begin) * 4), [&](const io_uring_cqe& cqe) {
+            size_t index = static_cast<size_t>(cqe.user_data >> 2);
+            if ((cqe.user_data & 3) == TAG_RENAME && cqe.res == 0) {
+                results[index] = true;
+            }
+        });
+        if (!ok) {
+            break;
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            if (!results[i]) {
+                Utils::logError("Failed to write cache file: " + finalPaths[i]);
+                unlink(tmpPaths[i].c_str());
+            }
+        }
+    }
+    return results;
+}
+
+std::vector<IoEngine::ReadResult> UringIoEngine::readBatch(const std::vector<std::filesystem::path>& paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ReadResult> results(paths.size());
+    std::vector<std::string> pathStrings(paths.size());
+    std::vector<int> readBytes(paths.size(), -1);
+
+    const size_t chunkSize = std::min<size_t>({ FILE_SLOTS, READ_BUFFERS, RING_ENTRIES / 3 });
+    for (size_t begin = 0; begin < paths.size(); begin += chunkSize) {
+        size_t end = std::min(paths.size(), begin + chunkSize);
+
+        for (size_t i = begin; i < end; ++i) {
+            unsigned slot = static_cast<unsigned>(i - begin);
+            pathStrings[i] = paths[i].string();
+
+            io_uring_sqe* open = nextSqe();
+            open->opcode = IORING_OP_OPENAT;
+            open->fd = AT_FDCWD;
+            open->addr = reinterpret_cast<uint64_t>(pathStrings[i].c_str());
+            open->open_flags = O_RDONLY;
+            open->file_index = slot + 1;
+            open->flags = IOSQE_IO_LINK;
+            open->user_data = makeUserData(i, TAG_OPEN);
+
+            // Hard link: a short read (the normal case) must not cancel the close
+            io_uring_sqe* read = nextSqe();
+            read->opcode = IORING_OP_READ_FIXED;
+            read->fd = static_cast<int>(slot);
+            read->addr = reinterpret_cast<uint64_t>(readArena.data() + slot * READ_BUFFER_SIZE);
+            read->len = static_cast<unsigned>(READ_BUFFER_SIZE);
+            read->off = 0;
+            read->buf_index = static_cast<uint16_t>(slot);
+            read->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            read->user_data = makeUserData(i, TAG_DATA);
+
+            io_uring_sqe* close = nextSqe();
+            close->opcode = IORING_OP_CLOSE;
+            close->file_index = slot + 1;
+            close->user_data = makeUserData(i, TAG_CLOSE);
+        }
+
+        bool ok = submitAndReap(static_cast<unsigned>((end - begin) * 3), [&](const io_uring_cqe& cqe) {
+            if ((cqe.user_data & 3) == TAG_DATA) {
+                readBytes[static_cast<size_t>(cqe.user_data >> 2)] = cqe.res;
+            }
+        });
+        if (!ok) {
+            break;
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            int n = readBytes[i];
+            if (n >= 0 && static_cast<size_t>(n) < READ_BUFFER_SIZE) {
+                const uint8_t* src = readArena.data() + (i - begin) * READ_BUFFER_SIZE;
+                results[i].data.assign(src, src + n);
+                results[i].ok = true;
+            } else if (n >= 0) {
+                // Larger than a registered buffer; rare enough to read synchronously
+                results[i].ok = readWholeFile(paths[i], results[i].data);
+            }
+        }
+    }
+    return results;
+}
+
+#else // !__linux__
+
+std::unique_ptr<UringIoEngine> UringIoEngine::tryCreate() {
+    return nullptr;
+}
+
+UringIoEngine::~UringIoEngine() {}
+
+std::vector<bool> UringIoEngine::writeBatch(const std::vector<WriteOp>& ops) {
+    return std::vector<bool>(ops.size(), false);
+}
+
+std::vector<IoEngine::ReadResult> UringIoEngine::readBatch(const std::vector<std::filesystem::path>& paths) {
+    return std::vector<ReadResult>(paths.size());
+}
+
+#endif // __linux__
@@ -0,0 +1,64 @@
+// src/Storage/UringIoEngine.h
+#ifndef URINGIOENGINE_H
+#define URINGIOENGINE_H
+
+#include "IoEngine.h"
+#include <functional>
+#include <mutex>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Linux io_uring engine, driven through the raw syscalls so no liburing
+// dependency is needed. Each tile becomes one linked SQE chain:
+//   write: OPENAT(tmp) -> WRITE -> RENAMEAT(tmp, final) -> CLOSE
+//   read:  OPENAT -> READ_FIXED (registered buffer) -> CLOSE
+// Files are opened as direct descriptors into a registered file table,
+// so a whole batch costs a single io_uring_enter call.
+class UringIoEngine : public IoEngine {
+public:
+    // Returns nullptr when the kernel lacks the required features (< 5.15)
+    static std::unique_ptr<UringIoEngine> tryCreate();
+    ~UringIoEngine() override;
+
+    std::vector<bool> writeBatch(const std::vector<WriteOp>& ops) override;
+    std::vector<ReadResult> readBatch(const std::vector<std::filesystem::path>& paths) override;
+    const char* name() const override { return "io_uring"; }
+
+private:
+    static constexpr unsigned RING_ENTRIES = 256;
+    static constexpr unsigned FILE_SLOTS = 64;         // direct descriptors
+    static constexpr unsigned READ_BUFFERS = 32;       // registered buffers
+    static constexpr size_t READ_BUFFER_SIZE = 128 * 1024;
+
+    UringIoEngine() = default;
+    bool init();
+
+    io_uring_sqe* nextSqe();
+    // Submits all queued SQEs and waits for the same number of completions
+    bool submitAndReap(unsigned count, const std::function<void(const io_uring_cqe&)>& onCqe);
+
+    std::mutex mutex; // A ring has a single submitter
+
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    size_t sqRingSize = 0;
+    void* cqRing = nullptr;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pendingSubmit = 0;
+
+    std::vector<uint8_t> readArena; // READ_BUFFERS * READ_BUFFER_SIZE, registered
+};
+
+#endif // URINGIOENGINE_H
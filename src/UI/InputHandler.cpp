@@ -26,12 +26,18 @@ void InputHandler::handleEvent(const SDL_Event& event) {
         // Stop panning
         panning = false;
     }
+    else if (event.type == SDL_MOUSEMOTION && !panning) {
+        // Where the next zoom will likely center
+        tileRenderer.noteCursor(event.motion.x, event.motion.y);
+    }
     else if (event.type == SDL_MOUSEMOTION && panning) {
         int deltaX = event.motion.xrel;
         int deltaY = event.motion.yrel;
+        tileRenderer.noteCursor(event.motion.x, event.motion.y);
+        tileRenderer.notePan(deltaX, deltaY);
 
-        // Get current zoom level
-        int zoom = tileRenderer.viewport.zoom;
+        // Get current (fractional) zoom level
+        double zoom = tileRenderer.viewport.zoom;
 
         // Calculate degrees per pixel based on zoom level
         // Longitude scales linearly
@@ -56,28 +62,27 @@ void InputHandler::handleEvent(const SDL_Event& event) {
     }
 
     else if(event.type == SDL_MOUSEWHEEL) {
-        Viewport vp = tileRenderer.viewport;
-        if(event.wheel.y > 0) { // Scroll up to zoom in
-            vp.zoom += 1;
-        }
-        else if(event.wheel.y < 0) { // Scroll down to zoom out
-            vp.zoom -= 1;
+        // One level per notch, animated around the cursor
+        int mouseX = 0, mouseY = 0;
+        SDL_GetMouseState(&mouseX, &mouseY);
+        double delta = event.wheel.y > 0 ? 1.0 : (event.wheel.y < 0 ? -1.0 : 0.0);
+        if (delta == 0.0) {
+            return;
         }
 
-        // Clamp zoom level using std::clamp
-        vp.zoom = std::clamp(vp.zoom, Viewport::MIN_ZOOM, Viewport::MAX_ZOOM);
-
-        if(vp.zoom == Viewport::MIN_ZOOM) {
+        double target = std::clamp(tileRenderer.targetZoom() + delta,
+                                   double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
+        if(target == Viewport::MIN_ZOOM) {
             Utils::logInfo("Minimum zoom level reached");
         }
-        else if(vp.zoom == Viewport::MAX_ZOOM) {
+        else if(target == Viewport::MAX_OVERZOOM) {
             Utils::logInfo("Maximum zoom level reached");
         }
         else {
-            Utils::logInfo("Zoom level set to " + std::to_string(vp.zoom));
+            Utils::logInfo("Zoom level set to " + std::to_string(target));
         }
 
-        tileRenderer.setViewport(vp);
+        tileRenderer.zoomAt(delta, mouseX, mouseY);
     }
 }
 
@@ -0,0 +1,205 @@
+// src/UI/InputRecorder.cpp
+#include "InputRecorder.h"
+#include "../Utils/Utils.h"
+#include "nlohmann/json.hpp"
+#include <fstream>
+
+using json = nlohmann::json;
+
+static const int TRACE_VERSION = 1;
+
+// Events a replay can deliver
+static bool isRecorded(const SDL_Event& e) {
+    switch (e.type) {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEWHEEL:
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        return true;
+    case SDL_WINDOWEVENT:
+        return e.window.event == SDL_WINDOWEVENT_RESIZED;
+    default:
+        return false;
+    }
+}
+
+// Fields that replay does not need are left out
+static json toJson(const InputTrace::Entry& entry) {
+    const SDL_Event& e = entry.event;
+    json j = { { "frame", entry.frame }, { "ms", entry.timeMs } };
+    switch (e.type) {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        j["type"] = e.type == SDL_MOUSEBUTTONDOWN ? "down" : "up";
+        j["button"] = e.button.button;
+        j["clicks"] = e.button.clicks;
+        j["x"] = e.button.x;
+        j["y"] = e.button.y;
+        break;
+    case SDL_MOUSEMOTION:
+        j["type"] = "motion";
+        j["state"] = e.motion.state;
+        j["x"] = e.motion.x;
+        j["y"] = e.motion.y;
+        j["xrel"] = e.motion.xrel;
+        j["yrel"] = e.motion.yrel;
+        break;
+    case SDL_MOUSEWHEEL:
+        j["type"] = "wheel";
+        j["wheelX"] = e.wheel.x;
+        j["wheelY"] = e.wheel.y;
+        j["x"] = entry.mouseX;
+        j["y"] = entry.mouseY;
+        break;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        j["type"] = e.type == SDL_KEYDOWN ? "keydown" : "keyup";
+        j["scancode"] = e.key.keysym.scancode;
+        j["sym"] = e.key.keysym.sym;
+        j["mod"] = e.key.keysym.mod;
+        j["repeat"] = e.key.repeat;
+        break;
+    case SDL_WINDOWEVENT:
+        j["type"] = "resize";
+        j["width"] = e.window.data1;
+        j["height"] = e.window.data2;
+        break;
+    default:
+        break;
+    }
+    return j;
+}
+
+static InputTrace::Entry fromJson(const json& j) {
+    InputTrace::Entry entry{};
+    entry.frame = j.at("frame").get<uint64_t>();
+    entry.timeMs = j.at("ms").get<uint32_t>();
+    SDL_Event& e = entry.event;
+    std::string type = j.at("type").get<std::string>();
+    if (type == "down" || type == "up") {
+        e.type = type == "down" ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        e.button.button = j.at("button").get<Uint8>();
+        e.button.clicks = j.at("clicks").get<Uint8>();
+        e.button.state = type == "down" ? SDL_PRESSED : SDL_RELEASED;
+        e.button.x = entry.mouseX = j.at("x").get<int>();
+        e.button.y = entry.mouseY = j.at("y").get<int>();
+    } else if (type == "motion") {
+        e.type = SDL_MOUSEMOTION;
+        e.motion.state = j.at("state").get<Uint32>();
+        e.motion.x = entry.mouseX = j.at("x").get<int>();
+        e.motion.y = entry.mouseY = j.at("y").get<int>();
+        e.motion.xrel = j.at("xrel").get<int>();
+        e.motion.yrel = j.at("yrel").get<int>();
+    } else if (type == "wheel") {
+        e.type = SDL_MOUSEWHEEL;
+        e.wheel.x = j.at("wheelX").get<int>();
+        e.wheel.y = j.at("wheelY").get<int>();
+        e.wheel.direction = SDL_MOUSEWHEEL_NORMAL;
+        entry.mouseX = j.at("x").get<int>();
+        entry.mouseY = j.at("y").get<int>();
+    } else if (type == "keydown" || type == "keyup") {
+        e.type = type == "keydown" ? SDL_KEYDOWN : SDL_KEYUP;
+        e.key.state = type == "keydown" ? SDL_PRESSED : SDL_RELEASED;
+        e.key.keysym.scancode = static_cast<SDL_Scancode>(j.at("scancode").get<int>());
+        e.key.keysym.sym = j.at("sym").get<SDL_Keycode>();
+        e.key.keysym.mod = j.at("mod").get<Uint16>();
+        e.key.repeat = j.at("repeat").get<Uint8>();
+    } else if (type == "resize") {
+        e.type = SDL_WINDOWEVENT;
+        e.window.event = SDL_WINDOWEVENT_RESIZED;
+        e.window.data1 = j.at("width").get<int>();
+        e.window.data2 = j.at("height").get<int>();
+    } else {
+        throw std::runtime_error("unknown event type " + type);
+    }
+    return entry;
+}
+
+bool InputTrace::save(const std::string& path) const {
+    json j;
+    j["version"] = TRACE_VERSION;
+    j["start"] = { { "lat", start.centerLat }, { "lon", start.centerLon }, { "zoom", start.zoom },
+                   { "width", start.windowWidth }, { "height", start.windowHeight } };
+    j["window"] = { { "width", windowWidth }, { "height", windowHeight } };
+    j["frames"] = frames;
+    j["events"] = json::array();
+    for (const Entry& entry : entries) {
+        j["events"].push_back(toJson(entry));
+    }
+
+    std::ofstream file(path);
+    if (!file || !(file << j.dump(1) << "\n")) {
+        Utils::logError("Cannot write input trace to " + path);
+        return false;
+    }
+    return true;
+}
+
+bool InputTrace::load(const std::string& path, InputTrace& trace, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "Cannot open input trace " + path;
+        return false;
+    }
+    try {
+        json j;
+        file >> j;
+        if (j.at("version").get<int>() != TRACE_VERSION) {
+            error = path + ": unsupported input trace version";
+            return false;
+        }
+        const json& start = j.at("start");
+        trace.start.centerLat = start.at("lat").get<double>();
+        trace.start.centerLon = start.at("lon").get<double>();
+        trace.start.zoom = start.at("zoom").get<double>();
+        trace.start.windowWidth = start.at("width").get<int>();
+        trace.start.windowHeight = start.at("height").get<int>();
+        trace.windowWidth = j.at("window").at("width").get<int>();
+        trace.windowHeight = j.at("window").at("height").get<int>();
+        trace.frames = j.at("frames").get<uint64_t>();
+        trace.entries.clear();
+        for (const json& event : j.at("events")) {
+            trace.entries.push_back(fromJson(event));
+        }
+    } catch (const std::exception& e) {
+        error = path + ": " + e.what();
+        return false;
+    }
+    return true;
+}
+
+void InputRecorder::start(const Viewport& viewport, int windowWidth, int windowHeight) {
+    trace = InputTrace{};
+    trace.start = viewport;
+    trace.windowWidth = windowWidth;
+    trace.windowHeight = windowHeight;
+    frame = 0;
+    startTicks = SDL_GetTicks();
+    recording = true;
+    Utils::logInfo("Recording input");
+}
+
+bool InputRecorder::stop(const std::string& path) {
+    recording = false;
+    trace.frames = frame;
+    if (!trace.save(path)) {
+        return false;
+    }
+    Utils::logInfo("Saved " + std::to_string(trace.entries.size()) + " input events over " +
+                   std::to_string(frame) + " frames to " + path);
+    return true;
+}
+
+void InputRecorder::record(const SDL_Event& event) {
+    if (!recording || !isRecorded(event)) {
+        return;
+    }
+    InputTrace::Entry entry{};
+    entry.frame = frame;
+    entry.timeMs = SDL_GetTicks() - startTicks;
+    SDL_GetMouseState(&entry.mouseX, &entry.mouseY);
+    entry.event = event;
+    trace.entries.push_back(entry);
+}
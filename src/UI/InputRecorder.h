@@ -0,0 +1,55 @@
+// src/UI/InputRecorder.h
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include <SDL2/SDL.h>
+#include "../Rendering/Viewport.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Input events as the UI received them, with the view they started from.
+// Saved as JSON so a session can be replayed (see runReplay).
+struct InputTrace {
+    struct Entry {
+        uint64_t frame;  // Main loop iteration, counted from the start
+        uint32_t timeMs; // Since the start
+        int mouseX;      // Cursor position; wheel events carry none
+        int mouseY;
+        SDL_Event event;
+    };
+
+    Viewport start{};
+    int windowWidth = 0;
+    int windowHeight = 0;
+    uint64_t frames = 0; // Length of the recording
+    std::vector<Entry> entries;
+
+    bool save(const std::string& path) const;
+    static bool load(const std::string& path, InputTrace& trace, std::string& error);
+};
+
+// Records the events passed to UIManager::handleEvent: mouse, wheel,
+// keyboard and window resizes. The main loop calls nextFrame() once per
+// iteration so a replay can deliver each event on the same frame.
+class InputRecorder {
+public:
+    void start(const Viewport& viewport, int windowWidth, int windowHeight);
+    bool stop(const std::string& path); // Saves the trace; false on I/O error
+    bool isRecording() const { return recording; }
+
+    void nextFrame() {
+        if (recording) {
+            frame++;
+        }
+    }
+    void record(const SDL_Event& event);
+
+private:
+    InputTrace trace;
+    bool recording = false;
+    uint64_t frame = 0;
+    Uint32 startTicks = 0;
+};
+
+#endif // INPUTRECORDER_H
@@ -13,6 +13,10 @@ void UIManager::setWindow(SDL_Window* window) {
 }
 
 void UIManager::handleEvent(const SDL_Event& event) {
+    if (inputRecorder) {
+        inputRecorder->record(event);
+    }
+
     // Handle window-resize events first, if any
     if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
         if (window) {
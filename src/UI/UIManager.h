@@ -4,6 +4,7 @@
 #define UIMANAGER_H
 
 #include "Components/UIComponent.h"
+#include "InputRecorder.h"
 #include <vector>
 #include <memory>
 
@@ -24,9 +25,14 @@ public:
     void setWindow(SDL_Window* window);
     SDL_Window* getWindow() const { return window; }
 
+    // Every event handled is passed to the recorder while it records
+    void setInputRecorder(InputRecorder* recorder) { inputRecorder = recorder; }
+    InputRecorder* getInputRecorder() const { return inputRecorder; }
+
 private:
     SDL_Renderer* renderer;
     SDL_Window* window;
+    InputRecorder* inputRecorder = nullptr;
     std::vector<std::shared_ptr<UIComponent>> components;
     
     // New vector to hold components marked for removal
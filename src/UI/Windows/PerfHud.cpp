@@ -0,0 +1,253 @@
+// src/UI/Windows/PerfHud.cpp
+#include "PerfHud.h"
+#include "../../Config/ConfigManager.h"
+#include "../../Utils/Utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const int PANEL_WIDTH = 380;
+static const int PANEL_MARGIN = 8;
+static const int PANEL_TOP = 38;   // Below the toolbar
+static const int PADDING = 8;
+static const int GRAPH_HEIGHT = 60;
+static const double GRAPH_FULL_MS = 33.3; // Frame time at the top of the graph
+
+static Metrics::Counter& lookups(const char* tier, const char* result) {
+    return Metrics::counter("gis_cache_lookups_total", "",
+                            std::string("tier=\"") + tier + "\",result=\"" + result + "\"");
+}
+
+PerfHud::PerfHud(SDL_Renderer* renderer)
+    : renderer(renderer),
+      fetchQueued(Metrics::gauge("gis_fetch_queue_depth", "")),
+      fetchRunning(Metrics::gauge("gis_fetch_running", "")),
+      decodeRunning(Metrics::gauge("gis_decode_running", "")),
+      textureBytes(Metrics::gauge("gis_texture_bytes", "")),
+      decodedBytes(Metrics::gauge("gis_decoded_cache_bytes", "")),
+      upstreamLatency(Metrics::histogram("gis_upstream_latency_seconds", "")),
+      tiers{{ { "mem", lookups("memory", "hit"), lookups("memory", "miss") },
+              { "disk", lookups("disk", "hit"), lookups("disk", "miss") },
+              { "decoded", lookups("decoded", "hit"), lookups("decoded", "miss") },
+              { "tex", lookups("texture", "hit"), lookups("texture", "miss") } }}
+{
+    AppConfig config = ConfigManager::loadConfig();
+    font = TTF_OpenFont(config.fontPath.c_str(), 13);
+    if (!font) {
+        font = TTF_OpenFont("../resources/fonts/WaukeganLdo-ax19.ttf", 13);
+    }
+    if (!font) {
+        Utils::logError("PerfHud: failed to load font: " + std::string(TTF_GetError()));
+    }
+}
+
+PerfHud::~PerfHud() {
+    for (TextLine& line : lines) {
+        if (line.texture) {
+            SDL_DestroyTexture(line.texture);
+        }
+    }
+    if (font) {
+        TTF_CloseFont(font);
+    }
+}
+
+bool PerfHud::handleEvent(const SDL_Event& event) {
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && !event.key.repeat) {
+        setVisible(!visible);
+        return true;
+    }
+    return false;
+}
+
+void PerfHud::setVisible(bool show) {
+    if (show && !visible) {
+        upstreamFilled = 0; // Snapshots taken while hidden are stale
+        lastRefresh = 0;
+    }
+    visible = show;
+    dirty = true;
+}
+
+void PerfHud::update() {
+    if (!visible) {
+        return;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (lastRefresh == 0 || now - lastRefresh >= REFRESH_MS) {
+        lastRefresh = now;
+        refreshText();
+    }
+}
+
+bool PerfHud::needsRedraw() const {
+    return dirty;
+}
+
+void PerfHud::recordFrame(double cpu, double present) {
+    cpuMs[frameHead] = static_cast<float>(cpu);
+    presentMs[frameHead] = static_cast<float>(present);
+    frameHead = (frameHead + 1) % GRAPH_FRAMES;
+    frameCount = std::min(frameCount + 1, GRAPH_FRAMES);
+}
+
+void PerfHud::recordInputLatency(double ms) {
+    lastInputMs = ms;
+    worstInputMs = std::max(worstInputMs, ms);
+}
+
+float PerfHud::framePercentile(double q) {
+    if (frameCount == 0) {
+        return 0.0f;
+    }
+    for (int i = 0; i < frameCount; ++i) {
+        sortScratch[i] = cpuMs[i] + presentMs[i];
+    }
+    int rank = std::min(frameCount - 1, static_cast<int>(q * frameCount));
+    std::nth_element(sortScratch.begin(), sortScratch.begin() + rank, sortScratch.begin() + frameCount);
+    return sortScratch[rank];
+}
+
+void PerfHud::refreshText() {
+    char text[LINE_CHARS];
+
+    double cpuTotal = 0.0, presentTotal = 0.0;
+    for (int i = 0; i < frameCount; ++i) {
+        cpuTotal += cpuMs[i];
+        presentTotal += presentMs[i];
+    }
+    int frames = std::max(frameCount, 1);
+    std::snprintf(text, sizeof(text), "frame  p50 %.1f  p99 %.1f ms   cpu %.1f + present %.1f",
+                  framePercentile(0.5), framePercentile(0.99), cpuTotal / frames, presentTotal / frames);
+    setLine(0, text);
+
+    std::snprintf(text, sizeof(text), "input to present  %.0f ms  (worst %.0f)", lastInputMs, worstInputMs);
+    worstInputMs = 0.0;
+    setLine(1, text);
+
+    std::snprintf(text, sizeof(text), "fetch  %lld queued  %lld running    decode  %lld running",
+                  static_cast<long long>(fetchQueued.value()), static_cast<long long>(fetchRunning.value()),
+                  static_cast<long long>(decodeRunning.value()));
+    setLine(2, text);
+
+    int used = std::snprintf(text, sizeof(text), "hit");
+    for (const TierCounters& tier : tiers) {
+        uint64_t hits = tier.hits.value();
+        uint64_t total = hits + tier.misses.value();
+        if (total == 0) {
+            used += std::snprintf(text + used, sizeof(text) - used, "  %s --", tier.label);
+        } else {
+            used += std::snprintf(text + used, sizeof(text) - used, "  %s %.0f%%", tier.label, 100.0 * hits / total);
+        }
+        used = std::min(used, static_cast<int>(sizeof(text)) - 1);
+    }
+    setLine(3, text);
+
+    std::snprintf(text, sizeof(text), "memory  textures %.1f MB   decoded %.1f MB",
+                  textureBytes.value() / 1048576.0, decodedBytes.value() / 1048576.0);
+    setLine(4, text);
+
+    // Percentiles of the upstream requests since the oldest snapshot kept
+    Metrics::Histogram::Snapshot& slot = upstreamHistory[upstreamHead];
+    upstreamLatency.snapshot(slot);
+    const Metrics::Histogram::Snapshot& oldest =
+        upstreamHistory[upstreamFilled < UPSTREAM_WINDOW ? (upstreamHead - upstreamFilled + UPSTREAM_WINDOW) %
+                                                                UPSTREAM_WINDOW
+                                                          : (upstreamHead + 1) % UPSTREAM_WINDOW];
+    uint64_t requests = 0;
+    for (size_t i = 0; i < upstreamRecent.size(); ++i) {
+        upstreamRecent[i] = slot[i] - oldest[i];
+        requests += upstreamRecent[i];
+    }
+    upstreamHead = (upstreamHead + 1) % UPSTREAM_WINDOW;
+    upstreamFilled = std::min(upstreamFilled + 1, UPSTREAM_WINDOW);
+    if (requests == 0) {
+        std::snprintf(text, sizeof(text), "upstream  no requests in the last 10 s");
+    } else {
+        std::snprintf(text, sizeof(text), "upstream 10s  p50 %.0f  p90 %.0f  p99 %.0f ms  (%llu)",
+                      Metrics::Histogram::quantileMicros(upstreamRecent, 0.5) / 1000.0,
+                      Metrics::Histogram::quantileMicros(upstreamRecent, 0.9) / 1000.0,
+                      Metrics::Histogram::quantileMicros(upstreamRecent, 0.99) / 1000.0,
+                      static_cast<unsigned long long>(requests));
+    }
+    setLine(5, text);
+}
+
+void PerfHud::setLine(int index, const char* text) {
+    TextLine& line = lines[index];
+    if (line.texture && std::strncmp(line.text.data(), text, LINE_CHARS) == 0) {
+        return; // Unchanged: keep the cached texture
+    }
+    std::strncpy(line.text.data(), text, LINE_CHARS - 1);
+    dirty = true;
+
+    if (line.texture) {
+        SDL_DestroyTexture(line.texture);
+        line.texture = nullptr;
+    }
+    if (!font) {
+        return;
+    }
+    SDL_Color color = { 240, 240, 240, 255 };
+    SDL_Surface* surface = TTF_RenderText_Blended(font, line.text.data(), color);
+    if (!surface) {
+        return;
+    }
+    line.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    line.width = surface->w;
+    line.height = surface->h;
+    SDL_FreeSurface(surface);
+}
+
+void PerfHud::render(SDL_Renderer* renderer) {
+    dirty = false;
+    if (!visible) {
+        return;
+    }
+
+    int outputWidth = 0, outputHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+    int lineHeight = font ? TTF_FontLineSkip(font) : 16;
+    SDL_Rect panel = { outputWidth - PANEL_WIDTH - PANEL_MARGIN, PANEL_TOP, PANEL_WIDTH,
+                       PADDING * 3 + GRAPH_HEIGHT + lineHeight * LINES };
+
+    SDL_BlendMode previousBlend;
+    SDL_GetRenderDrawBlendMode(renderer, &previousBlend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 20, 20, 20, 200);
+    SDL_RenderFillRect(renderer, &panel);
+
+    // Frame graph: one column per frame, CPU at the bottom, present on top
+    int graphLeft = panel.x + PADDING + (panel.w - 2 * PADDING - GRAPH_FRAMES) / 2;
+    int graphBottom = panel.y + PADDING + GRAPH_HEIGHT;
+    double scale = GRAPH_HEIGHT / GRAPH_FULL_MS;
+    int first = (frameHead - frameCount + GRAPH_FRAMES) % GRAPH_FRAMES;
+    for (int i = 0; i < frameCount; ++i) {
+        int sample = (first + i) % GRAPH_FRAMES;
+        int x = graphLeft + GRAPH_FRAMES - frameCount + i;
+        int cpuHeight = std::min(GRAPH_HEIGHT, static_cast<int>(cpuMs[sample] * scale + 0.5));
+        int presentHeight = std::min(GRAPH_HEIGHT - cpuHeight, static_cast<int>(presentMs[sample] * scale + 0.5));
+        cpuBars[i] = { x, graphBottom - cpuHeight, 1, cpuHeight };
+        presentBars[i] = { x, graphBottom - cpuHeight - presentHeight, 1, presentHeight };
+    }
+    SDL_SetRenderDrawColor(renderer, 90, 200, 120, 255);
+    SDL_RenderFillRects(renderer, cpuBars.data(), frameCount);
+    SDL_SetRenderDrawColor(renderer, 90, 150, 240, 255);
+    SDL_RenderFillRects(renderer, presentBars.data(), frameCount);
+
+    // 60 Hz budget line
+    int budgetY = graphBottom - static_cast<int>(16.7 * scale + 0.5);
+    SDL_SetRenderDrawColor(renderer, 240, 200, 80, 160);
+    SDL_RenderDrawLine(renderer, graphLeft, budgetY, graphLeft + GRAPH_FRAMES - 1, budgetY);
+
+    int y = graphBottom + PADDING;
+    for (const TextLine& line : lines) {
+        if (line.texture) {
+            SDL_Rect dst = { panel.x + PADDING, y, line.width, line.height };
+            SDL_RenderCopy(renderer, line.texture, nullptr, &dst);
+        }
+        y += lineHeight;
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, previousBlend);
+}
@@ -0,0 +1,92 @@
+// src/UI/Windows/PerfHud.h
+#ifndef PERFHUD_H
+#define PERFHUD_H
+
+#include "../Components/UIComponent.h"
+#include "../../Utils/Metrics.h"
+#include <SDL2/SDL_ttf.h>
+#include <array>
+
+// Performance overlay toggled with F3: a graph of recent frame times split
+// into CPU work and present, input-to-present latency, the fetch and decode
+// pipeline, cache hit ratios, tile memory and upstream latency.
+//
+// Built to stay on in production: samples go into fixed rings, text lines
+// are re-rendered only when their content changes (at most 4 times a
+// second), and drawing a frame allocates nothing.
+class PerfHud : public UIComponent {
+public:
+    explicit PerfHud(SDL_Renderer* renderer);
+    ~PerfHud();
+
+    bool handleEvent(const SDL_Event& event) override;
+    void update() override;
+    void render(SDL_Renderer* renderer) override;
+    bool needsRedraw() const override;
+
+    // Called by the main loop after each presented frame
+    void recordFrame(double cpuMs, double presentMs);
+    void recordInputLatency(double ms);
+
+    bool isVisible() const { return visible; }
+    void setVisible(bool show);
+
+private:
+    static constexpr int GRAPH_FRAMES = 240;
+    static constexpr int LINES = 6;
+    static constexpr int LINE_CHARS = 96;
+    static constexpr Uint32 REFRESH_MS = 250;
+    static constexpr int UPSTREAM_WINDOW = 40; // Refreshes, ~10 s
+
+    struct TextLine {
+        std::array<char, LINE_CHARS> text{};
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    SDL_Renderer* renderer;
+    TTF_Font* font = nullptr;
+    bool visible = false;
+    bool dirty = false;
+    Uint32 lastRefresh = 0;
+
+    // Frame samples, newest at frameHead - 1
+    std::array<float, GRAPH_FRAMES> cpuMs{};
+    std::array<float, GRAPH_FRAMES> presentMs{};
+    std::array<float, GRAPH_FRAMES> sortScratch{};
+    std::array<SDL_Rect, GRAPH_FRAMES> cpuBars{};
+    std::array<SDL_Rect, GRAPH_FRAMES> presentBars{};
+    int frameHead = 0;
+    int frameCount = 0;
+    double lastInputMs = 0.0;
+    double worstInputMs = 0.0; // Since the last refresh
+
+    std::array<TextLine, LINES> lines;
+
+    // Sources, looked up once
+    Metrics::Gauge& fetchQueued;
+    Metrics::Gauge& fetchRunning;
+    Metrics::Gauge& decodeRunning;
+    Metrics::Gauge& textureBytes;
+    Metrics::Gauge& decodedBytes;
+    Metrics::Histogram& upstreamLatency;
+    struct TierCounters {
+        const char* label;
+        Metrics::Counter& hits;
+        Metrics::Counter& misses;
+    };
+    std::array<TierCounters, 4> tiers;
+
+    // Upstream latency snapshots, one per refresh, for recent percentiles
+    std::array<Metrics::Histogram::Snapshot, UPSTREAM_WINDOW> upstreamHistory{};
+    Metrics::Histogram::Snapshot upstreamRecent{};
+    int upstreamHead = 0;
+    int upstreamFilled = 0;
+
+    void refreshText();
+    void setLine(int index, const char* text);
+    float framePercentile(double q);
+};
+
+#endif // PERFHUD_H
@@ -0,0 +1,69 @@
+// src/Utils/BufferPool.h
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+using ByteBuffer = std::vector<uint8_t>;
+using PooledBuffer = std::shared_ptr<ByteBuffer>;
+
+// Pool of reusable byte buffers. Buffers handed out keep their capacity
+// when released, so steady-state downloads never reallocate. Released
+// buffers return to the pool automatically when the last owner drops them,
+// even if that happens after the pool itself is gone.
+class BufferPool {
+public:
+    BufferPool(size_t maxPooled = 64, size_t initialCapacity = 64 * 1024);
+
+    // Returns an empty buffer with at least initialCapacity reserved
+    PooledBuffer acquire();
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ByteBuffer>> free;
+        size_t maxPooled;
+    };
+
+    std::shared_ptr<State> state;
+    size_t initialCapacity;
+};
+
+inline BufferPool::BufferPool(size_t maxPooled, size_t initialCapacity)
+    : state(std::make_shared<State>()), initialCapacity(initialCapacity)
+{
+    state->maxPooled = maxPooled;
+}
+
+inline PooledBuffer BufferPool::acquire()
+{
+    std::unique_ptr<ByteBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->free.empty()) {
+            buffer = std::move(state->free.back());
+            state->free.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer = std::make_unique<ByteBuffer>();
+        buffer->reserve(initialCapacity);
+    }
+    buffer->clear();
+
+    std::weak_ptr<State> weakState = state;
+    return PooledBuffer(buffer.release(), [weakState](ByteBuffer* released) {
+        std::unique_ptr<ByteBuffer> owned(released);
+        if (auto s = weakState.lock()) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (s->free.size() < s->maxPooled) {
+                s->free.push_back(std::move(owned));
+            }
+        }
+    });
+}
+
+#endif // BUFFERPOOL_H
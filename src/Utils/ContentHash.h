@@ -0,0 +1,86 @@
+// src/Utils/ContentHash.h
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 128-bit non-cryptographic content hash used to deduplicate tiles.
+// Two independently seeded 64-bit lanes are mixed word by word, which is
+// fast enough to hash every downloaded tile and wide enough that
+// accidental collisions between tiles are not a practical concern.
+struct ContentHash {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    bool operator==(const ContentHash& other) const {
+        return hi == other.hi && lo == other.lo;
+    }
+    bool operator!=(const ContentHash& other) const {
+        return !(*this == other);
+    }
+
+    std::string toHex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            out[15 - i] = digits[(hi >> (i * 4)) & 0xF];
+            out[31 - i] = digits[(lo >> (i * 4)) & 0xF];
+        }
+        return out;
+    }
+
+    static ContentHash of(const uint8_t* data, size_t size) {
+        const uint64_t K1 = 0x9E3779B185EBCA87ULL;
+        const uint64_t K2 = 0xC2B2AE3D27D4EB4FULL;
+        const uint64_t K3 = 0x165667B19E3779F9ULL;
+        const uint64_t K4 = 0x85EBCA77C2B2AE63ULL;
+
+        uint64_t a = 0x243F6A8885A308D3ULL ^ size;
+        uint64_t b = 0x13198A2E03707344ULL ^ (size * K1);
+
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            a = rotl(a ^ (word * K1), 31) * K2;
+            b = rotl(b ^ (word * K3), 27) * K4 + a;
+        }
+
+        uint64_t tail = 0;
+        for (size_t shift = 0; i < size; ++i, shift += 8) {
+            tail |= static_cast<uint64_t>(data[i]) << shift;
+        }
+        a ^= tail * K1;
+        b ^= tail * K3;
+
+        ContentHash hash;
+        hash.hi = fmix(a + b);
+        hash.lo = fmix(b ^ rotl(a, 17));
+        return hash;
+    }
+
+private:
+    static uint64_t rotl(uint64_t v, int r) {
+        return (v << r) | (v >> (64 - r));
+    }
+
+    // MurmurHash3 finalizer
+    static uint64_t fmix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+};
+
+struct ContentHashHasher {
+    std::size_t operator()(const ContentHash& hash) const {
+        return static_cast<std::size_t>(hash.lo);
+    }
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,91 @@
+// src/Utils/LockProfiler.cpp
+#include "LockProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace LockProfiler {
+
+namespace {
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Site>>& sites() {
+    static auto* registered = new std::vector<std::unique_ptr<Site>>(); // Leaked: locks outlive statics
+    return *registered;
+}
+
+// Shared locks this thread holds, innermost last
+thread_local std::vector<std::pair<const void*, uint64_t>> sharedHolds;
+
+} // namespace
+
+Site& site(const std::string& lock, const char* mode) {
+    std::lock_guard<std::mutex> guard(registryMutex);
+    for (const auto& existing : sites()) {
+        if (existing->lock == lock && std::string(existing->mode) == mode) {
+            return *existing;
+        }
+    }
+    std::string labels = "lock=\"" + lock + "\",mode=\"" + mode + "\"";
+    sites().push_back(std::unique_ptr<Site>(new Site{
+        lock, mode,
+        Metrics::counter("gis_lock_acquisitions_total", "Lock acquisitions", labels),
+        Metrics::counter("gis_lock_contended_total", "Lock acquisitions that had to block", labels),
+        Metrics::counter("gis_lock_wait_nanoseconds_total", "Time spent acquiring locks", labels),
+        Metrics::counter("gis_lock_hold_nanoseconds_total", "Time locks were held", labels),
+        Metrics::histogram("gis_lock_wait_seconds", "Time to acquire a lock", labels),
+        Metrics::histogram("gis_lock_hold_seconds", "Time a lock was held", labels) }));
+    return *sites().back();
+}
+
+void pushSharedHold(const void* mutex, uint64_t ns) {
+    sharedHolds.emplace_back(mutex, ns);
+}
+
+uint64_t popSharedHold(const void* mutex) {
+    for (auto it = sharedHolds.rbegin(); it != sharedHolds.rend(); ++it) {
+        if (it->first == mutex) {
+            uint64_t ns = it->second;
+            sharedHolds.erase(std::next(it).base());
+            return ns;
+        }
+    }
+    return nowNs(); // Unlocked on another thread; hold time unknown
+}
+
+std::string report() {
+    if (!enabled) {
+        return "";
+    }
+    std::vector<Site*> sorted;
+    {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        for (const auto& s : sites()) {
+            if (s->acquisitions.value() > 0) {
+                sorted.push_back(s.get());
+            }
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Site* a, const Site* b) { return a->waitNs.value() > b->waitNs.value(); });
+
+    std::string text;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-32s %-9s %11s %9s %11s %9s %9s %11s %9s %9s\n", "lock", "mode", "acquired",
+                  "contended", "wait ms", "mean us", "p99 us", "hold ms", "mean us", "p99 us");
+    text += line;
+    for (const Site* s : sorted) {
+        double n = static_cast<double>(s->acquisitions.value());
+        std::snprintf(line, sizeof(line), "%-32s %-9s %11llu %8.2f%% %11.1f %9.2f %9.0f %11.1f %9.2f %9.0f\n",
+                      s->lock.c_str(), s->mode, static_cast<unsigned long long>(s->acquisitions.value()),
+                      100.0 * s->contended.value() / n, s->waitNs.value() / 1e6, s->waitNs.value() / n / 1e3,
+                      s->wait.quantileMicros(0.99), s->holdNs.value() / 1e6, s->holdNs.value() / n / 1e3,
+                      s->hold.quantileMicros(0.99));
+        text += line;
+    }
+    return text;
+}
+
+} // namespace LockProfiler
@@ -0,0 +1,195 @@
+// src/Utils/LockProfiler.h
+#ifndef LOCKPROFILER_H
+#define LOCKPROFILER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include "Metrics.h"
+
+#ifndef GIS_LOCK_PROFILING
+#define GIS_LOCK_PROFILING 0
+#endif
+
+// Named mutexes that report how long threads wait for and hold each lock.
+//
+// Built with -DGIS_LOCK_PROFILING=ON, every acquisition is timed and
+// recorded per lock name and mode (exclusive or shared) in the metrics
+// registry: gis_lock_acquisitions_total, gis_lock_contended_total, the
+// gis_lock_wait_seconds and gis_lock_hold_seconds histograms, and exact
+// gis_lock_{wait,hold}_nanoseconds_total sums. LockProfiler::report()
+// summarizes them. Otherwise ProfiledMutex and ProfiledSharedMutex are
+// std::mutex and std::shared_mutex and the name is ignored.
+namespace LockProfiler {
+
+constexpr bool enabled = GIS_LOCK_PROFILING != 0;
+
+// Statistics of one lock name in one mode
+struct Site {
+    std::string lock;
+    const char* mode;
+    Metrics::Counter& acquisitions;
+    Metrics::Counter& contended; // Had to block
+    Metrics::Counter& waitNs;
+    Metrics::Counter& holdNs;
+    Metrics::Histogram& wait;
+    Metrics::Histogram& hold;
+
+    void acquired(bool blocked, uint64_t waitedNs) {
+        acquisitions.add();
+        if (blocked) {
+            contended.add();
+        }
+        waitNs.add(waitedNs);
+        wait.observeMicros(waitedNs / 1000);
+    }
+    void released(uint64_t heldNs) {
+        holdNs.add(heldNs);
+        hold.observeMicros(heldNs / 1000);
+    }
+};
+
+// Registered once per name and mode; mutexes with the same name share it
+Site& site(const std::string& lock, const char* mode);
+
+// One line per lock and mode, most time spent waiting first. Empty when
+// profiling is compiled out.
+std::string report();
+
+inline uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Shared holders are many, so their acquisition times live with the thread
+void pushSharedHold(const void* mutex, uint64_t ns);
+uint64_t popSharedHold(const void* mutex);
+
+} // namespace LockProfiler
+
+#if GIS_LOCK_PROFILING
+
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const std::string& name) : stats(LockProfiler::site(name, "exclusive")) {}
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock() {
+        uint64_t start = LockProfiler::nowNs();
+        bool blocked = !mutex.try_lock();
+        if (blocked) {
+            mutex.lock();
+        }
+        acquiredAt = LockProfiler::nowNs();
+        stats.acquired(blocked, acquiredAt - start);
+    }
+    bool try_lock() {
+        if (!mutex.try_lock()) {
+            return false;
+        }
+        acquiredAt = LockProfiler::nowNs();
+        stats.acquired(false, 0);
+        return true;
+    }
+    void unlock() {
+        uint64_t held = LockProfiler::nowNs() - acquiredAt;
+        mutex.unlock();
+        stats.released(held);
+    }
+
+    // Waiting on a condition releases the lock through unlock(), so time
+    // asleep counts as neither waiting for the lock nor holding it
+    using Lock = std::unique_lock<ProfiledMutex>;
+    using Condition = std::condition_variable_any;
+
+private:
+    std::mutex mutex;
+    LockProfiler::Site& stats;
+    uint64_t acquiredAt = 0;
+};
+
+class ProfiledSharedMutex {
+public:
+    explicit ProfiledSharedMutex(const std::string& name)
+        : exclusiveStats(LockProfiler::site(name, "exclusive")), sharedStats(LockProfiler::site(name, "shared")) {}
+
+    ProfiledSharedMutex(const ProfiledSharedMutex&) = delete;
+    ProfiledSharedMutex& operator=(const ProfiledSharedMutex&) = delete;
+
+    void lock() {
+        uint64_t start = LockProfiler::nowNs();
+        bool blocked = !mutex.try_lock();
+        if (blocked) {
+            mutex.lock();
+        }
+        acquiredAt = LockProfiler::nowNs();
+        exclusiveStats.acquired(blocked, acquiredAt - start);
+    }
+    bool try_lock() {
+        if (!mutex.try_lock()) {
+            return false;
+        }
+        acquiredAt = LockProfiler::nowNs();
+        exclusiveStats.acquired(false, 0);
+        return true;
+    }
+    void unlock() {
+        uint64_t held = LockProfiler::nowNs() - acquiredAt;
+        mutex.unlock();
+        exclusiveStats.released(held);
+    }
+
+    void lock_shared() {
+        uint64_t start = LockProfiler::nowNs();
+        bool blocked = !mutex.try_lock_shared();
+        if (blocked) {
+            mutex.lock_shared();
+        }
+        uint64_t now = LockProfiler::nowNs();
+        LockProfiler::pushSharedHold(this, now);
+        sharedStats.acquired(blocked, now - start);
+    }
+    bool try_lock_shared() {
+        if (!mutex.try_lock_shared()) {
+            return false;
+        }
+        LockProfiler::pushSharedHold(this, LockProfiler::nowNs());
+        sharedStats.acquired(false, 0);
+        return true;
+    }
+    void unlock_shared() {
+        uint64_t held = LockProfiler::nowNs() - LockProfiler::popSharedHold(this);
+        mutex.unlock_shared();
+        sharedStats.released(held);
+    }
+
+private:
+    std::shared_mutex mutex;
+    LockProfiler::Site& exclusiveStats;
+    LockProfiler::Site& sharedStats;
+    uint64_t acquiredAt = 0;
+};
+
+#else
+
+class ProfiledMutex : public std::mutex {
+public:
+    explicit ProfiledMutex(const std::string&) {}
+
+    using Lock = std::unique_lock<std::mutex>;
+    using Condition = std::condition_variable;
+};
+
+class ProfiledSharedMutex : public std::shared_mutex {
+public:
+    explicit ProfiledSharedMutex(const std::string&) {}
+};
+
+#endif // GIS_LOCK_PROFILING
+
+#endif // LOCKPROFILER_H
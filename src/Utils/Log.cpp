@@ -0,0 +1,406 @@
+// src/Utils/Log.cpp
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Log {
+
+namespace {
+
+// Lines queued per thread before they are dropped
+constexpr size_t RING_SLOTS = 256;
+
+// How long a queued line may wait when nothing forces a drain
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(50);
+
+struct Slot {
+    int64_t timeUs; // Wall clock
+    LogLevel level;
+    uint32_t length;
+    char text[LINE_CHARS];
+};
+
+// Single producer (the owning thread), single consumer (whoever holds the
+// drain mutex). head and tail count every line ever queued and written.
+struct Ring {
+    std::unique_ptr<Slot[]> slots{new Slot[RING_SLOTS]};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> retired{false}; // Thread exited; removed once empty
+    std::string threadName;           // Guarded by the state mutex
+};
+
+struct State;
+
+// Buffers for one batch of lines; only used under the sink mutex
+struct Batch {
+    std::string out;
+    std::string err;
+    std::string file;
+
+    void add(State& st, int64_t timeUs, LogLevel level, std::string_view text, const std::string& thread);
+    void write(State& st);
+};
+
+struct State {
+    std::mutex mutex; // Rings, names, writer start and stop
+    std::vector<std::shared_ptr<Ring>> rings;
+    uint32_t nextThread = 1;
+    std::thread writer;
+    std::condition_variable wake;
+    bool started = false;
+    bool stopping = false;
+    std::atomic<bool> stopped{false};
+    std::atomic<uint64_t> dropped{0};
+
+    std::mutex drainMutex; // One consumer at a time
+
+    std::mutex sinkMutex; // Everything below
+    bool console = true;
+    FILE* file = nullptr;
+    std::string filePath;
+    uint64_t fileBytes = 0;
+    uint64_t maxFileBytes = 0;
+    int keepFiles = 0;
+    uint64_t reportedDrops = 0;
+    Batch batch;
+
+    // Scratch for drain(), kept to reuse its capacity; under drainMutex
+    struct Pending {
+        const Slot* slot;
+        const std::string* thread;
+    };
+    std::vector<Pending> pending;
+    std::vector<std::pair<std::shared_ptr<Ring>, uint64_t>> taken;
+    std::vector<std::string> names;
+};
+
+State& state() {
+    static State* instance = new State(); // Never destroyed; threads may log during exit
+    return *instance;
+}
+
+// Releases the ring when the thread exits, after the writer has caught up.
+// Lines logged later in the exit (from other thread_local destructors) are
+// written directly.
+struct RingHandle {
+    std::shared_ptr<Ring> ring;
+    ~RingHandle();
+};
+
+thread_local RingHandle localRing;
+thread_local bool threadExiting = false;
+thread_local char localName[32] = "";
+
+RingHandle::~RingHandle() {
+    threadExiting = true;
+    if (ring) {
+        ring->retired.store(true, std::memory_order_release);
+    }
+}
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+    case DEBUG: return "DEBUG";
+    case INFO: return "INFO";
+    default: return "ERROR";
+    }
+}
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void drainLoop();
+void shutdown();
+
+Ring* threadRing() {
+    if (!localRing.ring) {
+        auto ring = std::make_shared<Ring>();
+        State& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        ring->threadName = localName[0] ? localName : "thread " + std::to_string(st.nextThread);
+        ++st.nextThread;
+        st.rings.push_back(ring);
+        if (!st.started) {
+            st.started = true;
+            st.writer = std::thread(drainLoop);
+            std::atexit(shutdown);
+        }
+        localRing.ring = std::move(ring);
+    }
+    return localRing.ring.get();
+}
+
+// "2026-01-31 12:00:00.123"
+void appendTimestamp(std::string& out, int64_t timeUs) {
+    static thread_local int64_t cachedSecond = -1;
+    static thread_local char cachedText[24];
+    int64_t second = timeUs / 1000000;
+    if (second != cachedSecond) {
+        std::time_t t = static_cast<std::time_t>(second);
+        std::tm local;
+        localtime_r(&t, &local);
+        std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &local);
+        cachedSecond = second;
+    }
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(timeUs / 1000 % 1000));
+    out += cachedText;
+    out += millis;
+}
+
+// Starts a new file once the current one is full: path -> path.1 -> path.2 ...
+void rotateIfFull(State& st) {
+    if (!st.file || st.fileBytes < st.maxFileBytes) {
+        return;
+    }
+    std::fclose(st.file);
+    st.file = nullptr;
+    if (st.keepFiles > 0) {
+        std::remove((st.filePath + "." + std::to_string(st.keepFiles)).c_str());
+        for (int i = st.keepFiles - 1; i >= 1; --i) {
+            std::rename((st.filePath + "." + std::to_string(i)).c_str(),
+                        (st.filePath + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(st.filePath.c_str(), (st.filePath + ".1").c_str());
+    }
+    st.file = std::fopen(st.filePath.c_str(), "w");
+    st.fileBytes = 0;
+}
+
+void Batch::add(State& st, int64_t timeUs, LogLevel level, std::string_view text, const std::string& thread) {
+    if (st.console) {
+        std::string& stream = level == ERROR ? err : out;
+        stream += levelName(level);
+        stream += ": ";
+        stream += text;
+        stream += '\n';
+    }
+    if (st.file) {
+        appendTimestamp(file, timeUs);
+        file += ' ';
+        file += levelName(level);
+        file += " [";
+        file += thread;
+        file += "] ";
+        file += text;
+        file += '\n';
+    }
+}
+
+void Batch::write(State& st) {
+    if (!out.empty()) {
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+        out.clear();
+    }
+    if (!err.empty()) {
+        std::fwrite(err.data(), 1, err.size(), stderr);
+        std::fflush(stderr);
+        err.clear();
+    }
+    if (!file.empty() && st.file) {
+        std::fwrite(file.data(), 1, file.size(), st.file);
+        std::fflush(st.file);
+        st.fileBytes += file.size();
+        rotateIfFull(st);
+    }
+    file.clear();
+}
+
+// Writes everything queued so far, oldest first across threads
+void drain() {
+    State& st = state();
+    std::lock_guard<std::mutex> drainLock(st.drainMutex);
+
+    auto& pending = st.pending;
+    auto& taken = st.taken;
+    auto& names = st.names;
+    pending.clear();
+    taken.clear();
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        names.resize(st.rings.size());
+        for (size_t i = 0; i < st.rings.size(); ++i) {
+            names[i] = st.rings[i]->threadName;
+        }
+        for (size_t i = 0; i < st.rings.size(); ++i) {
+            Ring& ring = *st.rings[i];
+            uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+            uint64_t head = ring.head.load(std::memory_order_acquire);
+            for (uint64_t n = tail; n < head; ++n) {
+                pending.push_back({ &ring.slots[n % RING_SLOTS], &names[i] });
+            }
+            taken.emplace_back(st.rings[i], head);
+        }
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const State::Pending& a, const State::Pending& b) {
+        return a.slot->timeUs < b.slot->timeUs;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(st.sinkMutex);
+        Batch& batch = st.batch;
+        for (const State::Pending& p : pending) {
+            batch.add(st, p.slot->timeUs, p.slot->level, std::string_view(p.slot->text, p.slot->length), *p.thread);
+        }
+        uint64_t dropped = st.dropped.load(std::memory_order_relaxed);
+        if (dropped != st.reportedDrops) {
+            std::string note = "Log: dropped " + std::to_string(dropped - st.reportedDrops) +
+                               " lines, the writer fell behind";
+            batch.add(st, nowUs(), ERROR, note, "log writer");
+            st.reportedDrops = dropped;
+        }
+        batch.write(st);
+    }
+
+    // Hand the slots back, and forget the rings of exited threads
+    std::lock_guard<std::mutex> lock(st.mutex);
+    for (auto& [ring, head] : taken) {
+        ring->tail.store(head, std::memory_order_release);
+    }
+    st.rings.erase(std::remove_if(st.rings.begin(), st.rings.end(),
+                                  [](const std::shared_ptr<Ring>& ring) {
+                                      return ring->retired.load(std::memory_order_acquire) &&
+                                             ring->tail.load(std::memory_order_relaxed) ==
+                                                 ring->head.load(std::memory_order_acquire);
+                                  }),
+                   st.rings.end());
+    taken.clear();
+}
+
+void drainLoop() {
+    State& st = state();
+    std::unique_lock<std::mutex> lock(st.mutex);
+    while (!st.stopping) {
+        st.wake.wait_for(lock, DRAIN_INTERVAL);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void shutdown() {
+    State& st = state();
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.stopping = true;
+    }
+    st.wake.notify_all();
+    if (st.writer.joinable()) {
+        st.writer.join();
+    }
+    st.stopped.store(true, std::memory_order_release);
+    drain();
+}
+
+// Bypasses the rings: a full ring, or a line logged after shutdown
+void writeDirect(LogLevel level, std::string_view text) {
+    State& st = state();
+    std::string thread = localName[0] ? localName : "unnamed";
+    std::lock_guard<std::mutex> lock(st.sinkMutex);
+    st.batch.add(st, nowUs(), level, text, thread);
+    st.batch.write(st);
+}
+
+} // namespace
+
+void Line::append(double v) {
+    char digits[32];
+    int n = std::snprintf(digits, sizeof(digits), "%g", v);
+    append(std::string_view(digits, static_cast<size_t>(std::max(n, 0))));
+}
+
+void submit(LogLevel level, std::string_view text) {
+    State& st = state();
+    if (st.stopped.load(std::memory_order_acquire) || threadExiting) {
+        writeDirect(level, text);
+        return;
+    }
+
+    Ring* ring = threadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_SLOTS) {
+        if (level == ERROR) {
+            writeDirect(level, text);
+        } else {
+            st.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    Slot& slot = ring->slots[head % RING_SLOTS];
+    slot.timeUs = nowUs();
+    slot.level = level;
+    slot.length = static_cast<uint32_t>(std::min(text.size(), LINE_CHARS));
+    text.copy(slot.text, slot.length);
+    ring->head.store(head + 1, std::memory_order_release);
+
+    // Errors go out promptly; everything else waits for the next interval
+    // or a full ring
+    if (level == ERROR || head + 1 - ring->tail.load(std::memory_order_relaxed) >= RING_SLOTS / 2) {
+        st.wake.notify_one();
+    }
+}
+
+bool setFile(const std::string& path, uint64_t maxBytes, int keep) {
+    State& st = state();
+    flush();
+    std::lock_guard<std::mutex> lock(st.sinkMutex);
+    if (st.file) {
+        std::fclose(st.file);
+        st.file = nullptr;
+    }
+    st.filePath = path;
+    st.maxFileBytes = std::max<uint64_t>(maxBytes, 4096);
+    st.keepFiles = std::max(keep, 0);
+    if (path.empty()) {
+        return true;
+    }
+    st.file = std::fopen(path.c_str(), "a");
+    if (!st.file) {
+        std::fprintf(stderr, "ERROR: Cannot open log file %s\n", path.c_str());
+        return false;
+    }
+    std::fseek(st.file, 0, SEEK_END);
+    long size = std::ftell(st.file);
+    st.fileBytes = size > 0 ? static_cast<uint64_t>(size) : 0;
+    rotateIfFull(st);
+    return true;
+}
+
+void setConsole(bool enabled) {
+    State& st = state();
+    flush();
+    std::lock_guard<std::mutex> lock(st.sinkMutex);
+    st.console = enabled;
+}
+
+void setThreadName(const std::string& name) {
+    std::snprintf(localName, sizeof(localName), "%s", name.c_str());
+    if (localRing.ring) {
+        std::lock_guard<std::mutex> lock(state().mutex);
+        localRing.ring->threadName = name;
+    }
+}
+
+void flush() {
+    drain();
+}
+
+uint64_t droppedCount() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace Log
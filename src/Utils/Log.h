@@ -0,0 +1,128 @@
+// src/Utils/Log.h
+#ifndef LOG_H
+#define LOG_H
+
+#include "Utils.h"
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Asynchronous logging.
+//
+// LOG_DEBUG/LOG_INFO/LOG_ERROR take the message as a list of pieces
+// instead of a concatenated string:
+//
+//     LOG_INFO("Fetched tile", Log::kv("z", z), Log::kv("x", x), Log::kv("y", y));
+//
+// The pieces are only evaluated and formatted when the level is enabled,
+// into a fixed buffer on the stack. The finished line is copied into a
+// ring buffer owned by the calling thread, and a background thread writes
+// the rings out, one write and flush per batch. Nothing in that path
+// allocates or takes a lock, so a fetch worker never waits on a slow
+// terminal. When a ring is full, debug and info lines are dropped and
+// counted; errors are written directly instead.
+//
+// Statements below GIS_LOG_MIN_LEVEL (0 debug, 1 info, 2 error) are
+// removed at compile time, arguments and all.
+#ifndef GIS_LOG_MIN_LEVEL
+#define GIS_LOG_MIN_LEVEL 0
+#endif
+
+#define GIS_LOG(level, ...)                                                                   \
+    do {                                                                                      \
+        if (static_cast<int>(level) >= GIS_LOG_MIN_LEVEL && Utils::currentLogLevel <= (level)) { \
+            ::Log::write((level), __VA_ARGS__);                                               \
+        }                                                                                     \
+    } while (0)
+
+#define LOG_DEBUG(...) GIS_LOG(DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) GIS_LOG(INFO, __VA_ARGS__)
+#define LOG_ERROR(...) GIS_LOG(ERROR, __VA_ARGS__)
+
+namespace Log {
+
+// Longest line kept; longer ones are cut
+constexpr size_t LINE_CHARS = 480;
+
+// A structured field, written as " key=value" after the message
+template <class T>
+struct Field {
+    const char* key;
+    const T& value;
+};
+
+template <class T>
+Field<T> kv(const char* key, const T& value) {
+    return { key, value };
+}
+
+// A line being formatted on the stack
+class Line {
+public:
+    void append(std::string_view text) {
+        size_t n = text.size() < LINE_CHARS - length ? text.size() : LINE_CHARS - length;
+        text.copy(buffer + length, n);
+        length += n;
+    }
+    void append(const char* text) { append(std::string_view(text ? text : "(null)")); }
+    void append(const std::string& text) { append(std::string_view(text)); }
+    void append(char c) { append(std::string_view(&c, 1)); }
+    void append(bool b) { append(std::string_view(b ? "true" : "false")); }
+    void append(double v);
+
+    template <class T, class = std::enable_if_t<std::is_integral_v<T>>>
+    void append(T v) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), v);
+        append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+    }
+
+    template <class T>
+    void append(const Field<T>& field) {
+        append(' ');
+        append(field.key);
+        append('=');
+        append(field.value);
+    }
+
+    std::string_view text() const { return std::string_view(buffer, length); }
+
+private:
+    char buffer[LINE_CHARS];
+    size_t length = 0;
+};
+
+// Queues a finished line; use the LOG_ macros rather than calling this
+void submit(LogLevel level, std::string_view text);
+
+template <class... Pieces>
+void write(LogLevel level, const Pieces&... pieces) {
+    Line line;
+    (line.append(pieces), ...);
+    submit(level, line.text());
+}
+
+// Also writes every line to path, with a timestamp and the thread name.
+// When the file passes maxBytes it is renamed to path.1 (path.1 to path.2
+// and so on, keeping the newest keep files) and a new one is started.
+// An empty path closes the file. False if it cannot be opened.
+bool setFile(const std::string& path, uint64_t maxBytes = 10 << 20, int keep = 5);
+
+// Turns the stdout/stderr output off, e.g. when a file is the only sink
+void setConsole(bool enabled);
+
+// Names the calling thread in the log file
+void setThreadName(const std::string& name);
+
+// Blocks until every line submitted so far has been written
+void flush();
+
+// Lines dropped because their thread's ring was full
+uint64_t droppedCount();
+
+} // namespace Log
+
+#endif // LOG_H
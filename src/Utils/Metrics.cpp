@@ -0,0 +1,238 @@
+// src/Utils/Metrics.cpp
+#include "Metrics.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace Metrics {
+
+namespace {
+
+// Values below 8 get a bucket each; above, 8 buckets per power of two
+constexpr int SUB_BITS = 3;
+constexpr uint64_t SUB_COUNT = 1 << SUB_BITS;
+
+size_t bucketIndex(uint64_t v) {
+    if (v < SUB_COUNT) {
+        return static_cast<size_t>(v);
+    }
+    int exponent = 63 - __builtin_clzll(v);
+    uint64_t mantissa = (v >> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+    size_t index = static_cast<size_t>(exponent - SUB_BITS + 1) * SUB_COUNT + mantissa;
+    return std::min(index, Histogram::BUCKETS - 1);
+}
+
+// Exported bucket bounds: powers of two from 64 us to about 67 s
+constexpr int FIRST_BOUND_EXPONENT = 6;
+constexpr int LAST_BOUND_EXPONENT = 26;
+
+enum class Type { Counter, Gauge, Histogram };
+
+struct Family {
+    Type type;
+    std::string help;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, Family> families;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry(); // Never destroyed; metrics outlive statics
+    return *instance;
+}
+
+Family& family(Registry& reg, const std::string& name, const std::string& help, Type type) {
+    auto it = reg.families.find(name);
+    if (it == reg.families.end()) {
+        it = reg.families.emplace(name, Family{type, help, {}, {}, {}}).first;
+    } else if (it->second.type != type) {
+        throw std::logic_error("Metric " + name + " registered with two types");
+    } else if (it->second.help.empty()) {
+        it->second.help = help;
+    }
+    return it->second;
+}
+
+template <class Metric>
+Metric& lookup(std::map<std::string, std::unique_ptr<Metric>>& series, const std::string& labels) {
+    std::unique_ptr<Metric>& metric = series[labels];
+    if (!metric) {
+        metric = std::make_unique<Metric>();
+    }
+    return *metric;
+}
+
+std::string seriesName(const std::string& name, const std::string& labels, const std::string& extra = "") {
+    std::string all = labels.empty() ? extra : (extra.empty() ? labels : labels + "," + extra);
+    return all.empty() ? name : name + "{" + all + "}";
+}
+
+std::string formatSeconds(double seconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", seconds);
+    return text;
+}
+
+} // namespace
+
+void Histogram::observeMicros(uint64_t us) {
+    buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(us, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::bucketLower(size_t index) {
+    if (index < SUB_COUNT) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / SUB_COUNT) + SUB_BITS - 1;
+    uint64_t mantissa = index % SUB_COUNT;
+    return (SUB_COUNT + mantissa) << (exponent - SUB_BITS);
+}
+
+double Histogram::quantileMicros(double q) const {
+    Snapshot counts;
+    snapshot(counts);
+    return quantileMicros(counts, q);
+}
+
+void Histogram::snapshot(Snapshot& counts) const {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] = bucketCount(i);
+    }
+}
+
+double Histogram::quantileMicros(const Snapshot& counts, double q) {
+    uint64_t n = 0;
+    for (uint64_t c : counts) {
+        n += c;
+    }
+    if (n == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t upper = i + 1 < BUCKETS ? bucketLower(i + 1) : bucketLower(i) * 2;
+            return (bucketLower(i) + upper) / 2.0;
+        }
+    }
+    return static_cast<double>(bucketLower(BUCKETS - 1));
+}
+
+Counter& counter(const std::string& name, const std::string& help, const std::string& labels) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return lookup(family(reg, name, help, Type::Counter).counters, labels);
+}
+
+Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return lookup(family(reg, name, help, Type::Gauge).gauges, labels);
+}
+
+Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return lookup(family(reg, name, help, Type::Histogram).histograms, labels);
+}
+
+std::string prometheusText() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::string out;
+    for (const auto& [name, fam] : reg.families) {
+        static const char* typeNames[] = { "counter", "gauge", "histogram" };
+        out += "# HELP " + name + " " + fam.help + "\n";
+        out += "# TYPE " + name + " " + typeNames[static_cast<int>(fam.type)] + "\n";
+
+        for (const auto& [labels, metric] : fam.counters) {
+            out += seriesName(name, labels) + " " + std::to_string(metric->value()) + "\n";
+        }
+        for (const auto& [labels, metric] : fam.gauges) {
+            out += seriesName(name, labels) + " " + std::to_string(metric->value()) + "\n";
+        }
+        for (const auto& [labels, metric] : fam.histograms) {
+            // Fine buckets end exactly on powers of two, so each exported
+            // bound is a whole number of them
+            uint64_t cumulative = 0;
+            size_t fine = 0;
+            for (int e = FIRST_BOUND_EXPONENT; e <= LAST_BOUND_EXPONENT; ++e) {
+                uint64_t bound = uint64_t(1) << e;
+                while (fine < Histogram::BUCKETS && Histogram::bucketLower(fine) < bound) {
+                    cumulative += metric->bucketCount(fine++);
+                }
+                out += seriesName(name + "_bucket", labels, "le=\"" + formatSeconds(bound / 1e6) + "\"") + " " +
+                       std::to_string(cumulative) + "\n";
+            }
+            // Read the total last so +Inf never trails the finite buckets
+            uint64_t count = metric->count();
+            while (fine < Histogram::BUCKETS) {
+                cumulative += metric->bucketCount(fine++);
+            }
+            out += seriesName(name + "_bucket", labels, "le=\"+Inf\"") + " " +
+                   std::to_string(std::max(count, cumulative)) + "\n";
+            out += seriesName(name + "_sum", labels) + " " + formatSeconds(metric->sumMicros() / 1e6) + "\n";
+            out += seriesName(name + "_count", labels) + " " + std::to_string(std::max(count, cumulative)) + "\n";
+        }
+    }
+    return out;
+}
+
+bool writePrometheusFile(const std::string& path) {
+    std::string text = prometheusText();
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            Utils::logError("Cannot write metrics to " + temporary);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        Utils::logError("Cannot write metrics to " + path + ": " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+FileExporter::FileExporter(std::string path, std::chrono::seconds interval)
+    : path(std::move(path)), interval(std::max(interval, std::chrono::seconds(1)))
+{
+    worker = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wake.wait_for(lock, this->interval, [this] { return stopping; });
+            lock.unlock();
+            writePrometheusFile(this->path);
+            lock.lock();
+        }
+    });
+}
+
+FileExporter::~FileExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+} // namespace Metrics
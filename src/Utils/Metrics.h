@@ -0,0 +1,112 @@
+// src/Utils/Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Process-wide metrics, written out in the Prometheus text format.
+//
+// Metrics are registered once by name and label set (e.g.
+// counter("gis_tile_requests_total", "...", "outcome=\"disk\"")) and
+// live for the whole process, so callers keep the returned reference.
+// Updating one is a relaxed atomic operation; only registration and
+// exposition take a lock.
+namespace Metrics {
+
+class Counter {
+public:
+    void add(uint64_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> count{0};
+};
+
+class Gauge {
+public:
+    void set(int64_t v) { current.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { current.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> current{0};
+};
+
+// Latency histogram in microseconds with log-linear buckets: eight per
+// power of two, so quantiles are within about 6% from 1 us to 12 days.
+// Exported in seconds against power-of-two bucket bounds.
+class Histogram {
+public:
+    void observeMicros(uint64_t us);
+    void observe(std::chrono::steady_clock::duration d) {
+        observeMicros(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count()));
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sumMicros() const { return sum.load(std::memory_order_relaxed); }
+
+    // Counts of the fine buckets, for exposition and quantiles
+    static constexpr size_t BUCKETS = 320;
+    static uint64_t bucketLower(size_t index);
+    uint64_t bucketCount(size_t index) const { return buckets[index].load(std::memory_order_relaxed); }
+
+    // Approximate q-quantile (0..1) in microseconds; 0 when empty
+    double quantileMicros(double q) const;
+
+    // Bucket counts at one moment. The difference of two snapshots gives
+    // quantiles over the time between them.
+    using Snapshot = std::array<uint64_t, BUCKETS>;
+    void snapshot(Snapshot& counts) const;
+    static double quantileMicros(const Snapshot& counts, double q);
+
+private:
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+// Finds or registers a metric. labels is the inside of the braces, already
+// formatted: name="value",other="value". Readers that only look a metric
+// up may leave help empty. Registering an existing name with another type
+// throws std::logic_error.
+Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+// Every registered metric in the Prometheus text exposition format
+std::string prometheusText();
+
+// Writes prometheusText() to path through a temporary file and a rename,
+// so readers such as node_exporter's textfile collector never see a
+// partial file. False on I/O error.
+bool writePrometheusFile(const std::string& path);
+
+// Rewrites a metrics file every interval on a background thread, and once
+// more when destroyed
+class FileExporter {
+public:
+    FileExporter(std::string path, std::chrono::seconds interval);
+    ~FileExporter();
+
+    FileExporter(const FileExporter&) = delete;
+    FileExporter& operator=(const FileExporter&) = delete;
+
+private:
+    std::string path;
+    std::chrono::seconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+};
+
+} // namespace Metrics
+
+#endif // METRICS_H
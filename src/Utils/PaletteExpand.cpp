@@ -0,0 +1,84 @@
+// src/Utils/PaletteExpand.cpp
+#include "PaletteExpand.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PALETTE_EXPAND_X86 1
+#endif
+
+namespace PaletteExpand {
+
+static void expandScalar(const uint8_t* indices, size_t count, const uint32_t* palette, uint32_t* out) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        out[i]     = palette[indices[i]];
+        out[i + 1] = palette[indices[i + 1]];
+        out[i + 2] = palette[indices[i + 2]];
+        out[i + 3] = palette[indices[i + 3]];
+    }
+    for (; i < count; ++i) {
+        out[i] = palette[indices[i]];
+    }
+}
+
+#ifdef PALETTE_EXPAND_X86
+__attribute__((target("avx2")))
+static void expandAvx2(const uint8_t* indices, size_t count, const uint32_t* palette, uint32_t* out) {
+    const int* table = reinterpret_cast<const int*>(palette);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+        __m256i lo = _mm256_cvtepu8_epi32(bytes);
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_i32gather_epi32(table, lo, 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 8), _mm256_i32gather_epi32(table, hi, 4));
+    }
+    expandScalar(indices + i, count - i, palette, out + i);
+}
+#endif
+
+bool hasAvx2() {
+#ifdef PALETTE_EXPAND_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void expandIndexed(const uint8_t* indices, size_t count, const uint32_t* palette, uint32_t* out) {
+#ifdef PALETTE_EXPAND_X86
+    if (hasAvx2()) {
+        expandAvx2(indices, count, palette, out);
+        return;
+    }
+#endif
+    expandScalar(indices, count, palette, out);
+}
+
+void expandRuns(const uint8_t* runs, size_t runCount, const uint32_t* palette,
+                uint8_t* dst, int width, int height, int pitch) {
+    int x = 0;
+    int y = 0;
+    uint32_t* row = reinterpret_cast<uint32_t*>(dst);
+    for (size_t r = 0; r < runCount && y < height; ++r) {
+        size_t length = static_cast<size_t>(runs[r * 3]) | (static_cast<size_t>(runs[r * 3 + 1]) << 8);
+        uint32_t pixel = palette[runs[r * 3 + 2]];
+
+        // A run may wrap across several rows
+        while (length > 0 && y < height) {
+            size_t span = std::min(length, static_cast<size_t>(width - x));
+            std::fill_n(row + x, span, pixel);
+            length -= span;
+            x += static_cast<int>(span);
+            if (x == width) {
+                x = 0;
+                ++y;
+                row = reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * pitch);
+            }
+        }
+    }
+}
+
+} // namespace PaletteExpand
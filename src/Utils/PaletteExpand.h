@@ -0,0 +1,23 @@
+// src/Utils/PaletteExpand.h
+#ifndef PALETTEEXPAND_H
+#define PALETTEEXPAND_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PaletteExpand {
+
+// Expands count 8-bit palette indices to 32-bit pixels via palette lookup.
+// Uses an AVX2 gather kernel when the CPU supports it.
+void expandIndexed(const uint8_t* indices, size_t count, const uint32_t* palette, uint32_t* out);
+
+// Expands run-length encoded indices (3-byte runs: length lo, length hi,
+// index) into rows of width pixels with the given destination pitch.
+void expandRuns(const uint8_t* runs, size_t runCount, const uint32_t* palette,
+                uint8_t* dst, int width, int height, int pitch);
+
+bool hasAvx2();
+
+} // namespace PaletteExpand
+
+#endif // PALETTEEXPAND_H
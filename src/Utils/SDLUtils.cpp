@@ -1,6 +1,7 @@
 // src/Utils/SDLUtils.cpp
 #include "SDLUtils.h"
 #include "../Utils/Utils.h"
+#include "../Decoding/SdlImageDecoder.h"
 #include <SDL2/SDL_image.h>
 
 bool SDLUtils::initializeSDL() {
@@ -9,13 +10,18 @@ bool SDLUtils::initializeSDL() {
         return false;
     }
 
-    // Initialize SDL_image with PNG support
-    int imgFlags = IMG_INIT_PNG;
-    if (!(IMG_Init(imgFlags) & imgFlags)) {
+    // Initialize SDL_image; PNG is required, JPEG/WebP sources need the others
+    int imgFlags = IMG_INIT_PNG | IMG_INIT_JPG | IMG_INIT_WEBP;
+    int initialized = IMG_Init(imgFlags);
+    if (!(initialized & IMG_INIT_PNG)) {
         Utils::logError("IMG_Init failed: " + std::string(IMG_GetError()));
         SDL_Quit();
         return false;
     }
+    if ((initialized & imgFlags) != imgFlags) {
+        Utils::logError("SDL_image lacks JPEG or WebP support; such tiles will fail to decode");
+    }
+    SdlImageDecoder::install();
 
     return true;
 }
@@ -5,58 +5,128 @@
 #include <vector>
 #include <thread>
 #include <queue>
+#include <deque>
+#include <cstdint>
 #include <future>
 #include <functional>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <algorithm>
+#include <string>
+#include "LockProfiler.h"
+#include "Log.h"
+#include "Trace.h"
 
 class ThreadPool {
 public:
-    ThreadPool(size_t numThreads);
+    // Workers appear in traces as "<name> <n>"
+    ThreadPool(size_t numThreads, const std::string& name = "worker");
     ~ThreadPool();
 
+    // Runs the normal tasks still queued, drops the background ones and
+    // joins the workers; enqueueing afterwards throws. The destructor calls
+    // it. Owners whose tasks use their other members call it first.
+    void shutdown();
+
     // Enqueue a task and return a future
     template<class F, class... Args>
     auto enqueue(F&& f, Args&&... args) 
         -> std::future<typename std::result_of<F(Args...)>::type>;
 
+    // Enqueue a background task. It only starts when no normal task is
+    // waiting, never occupies more than half the workers, and is dropped
+    // if the pool shuts down before it starts.
+    template<class F, class... Args>
+    auto enqueueLow(F&& f, Args&&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    // Identifies background tasks for promote(); chosen by the caller,
+    // never zero
+    using Tag = uint64_t;
+
+    // enqueueLow for a task that may be promoted later
+    template<class F, class... Args>
+    auto enqueueLowTagged(Tag tag, F&& f, Args&&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    // Moves the oldest waiting background task with this tag to the back of
+    // the normal queue, ahead of every other background task. Returns false
+    // if none is waiting (it already started, or was never queued).
+    bool promote(Tag tag);
+
 private:
+    struct LowTask {
+        Tag tag;
+        std::function<void()> run;
+    };
+
     // Workers
     std::vector<std::thread> workers;
 
-    // Task queue
+    // Task queues
     std::queue<std::function<void()>> tasks;
+    std::deque<LowTask> lowTasks;
+    size_t runningLow = 0;
+    size_t maxRunningLow;
 
-    // Synchronization
-    std::mutex queueMutex;
-    std::condition_variable condition;
+    static constexpr Tag UNTAGGED = 0;
+
+    // Wraps a call in a packaged task; the future is its result
+    template<class F, class... Args>
+    static auto package(std::function<void()>& run, F&& f, Args&&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    void push(std::function<void()> run, bool low, Tag tag);
+
+    // Synchronization; pools share lock statistics by name
+    ProfiledMutex queueMutex;
+    ProfiledMutex::Condition condition;
     std::atomic<bool> stop;
 };
 
 // Constructor
-inline ThreadPool::ThreadPool(size_t numThreads)
-    : stop(false)
+inline ThreadPool::ThreadPool(size_t numThreads, const std::string& name)
+    : maxRunningLow(std::max<size_t>(1, numThreads / 2)), queueMutex("ThreadPool(" + name + ")"), stop(false)
 {
     for(size_t i = 0;i<numThreads;++i)
         workers.emplace_back(
-            [this]
+            [this, threadName = name + " " + std::to_string(i + 1)]
             {
+                Log::setThreadName(threadName);
+                Trace::setThreadName(threadName);
                 for(;;)
                 {
                     std::function<void()> task;
+                    bool low = false;
 
                     {
-                        std::unique_lock<std::mutex> lock(this->queueMutex);
+                        ProfiledMutex::Lock lock(this->queueMutex);
                         this->condition.wait(lock, 
-                            [this]{ return this->stop.load() || !this->tasks.empty(); });
+                            [this]{
+                                return this->stop.load() || !this->tasks.empty() ||
+                                       (!this->lowTasks.empty() && this->runningLow < this->maxRunningLow);
+                            });
                         if(this->stop.load() && this->tasks.empty())
                             return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
+                        if(!this->tasks.empty()) {
+                            task = std::move(this->tasks.front());
+                            this->tasks.pop();
+                        } else {
+                            task = std::move(this->lowTasks.front().run);
+                            this->lowTasks.pop_front();
+                            this->runningLow++;
+                            low = true;
+                        }
                     }
 
                     task();
+
+                    if(low) {
+                        ProfiledMutex::Lock lock(this->queueMutex);
+                        this->runningLow--;
+                        this->condition.notify_one();
+                    }
                 }
             }
         );
@@ -65,35 +135,99 @@ inline ThreadPool::ThreadPool(size_t numThreads)
 // Destructor
 inline ThreadPool::~ThreadPool()
 {
-    stop.store(true);
+    shutdown();
+}
+
+inline void ThreadPool::shutdown()
+{
+    {
+        // Under the lock, or a worker between checking the predicate and
+        // sleeping would miss the notification and never exit
+        ProfiledMutex::Lock lock(queueMutex);
+        stop.store(true);
+    }
     condition.notify_all();
     for(std::thread &worker: workers)
-        worker.join();
+        if(worker.joinable())
+            worker.join();
+
+    ProfiledMutex::Lock lock(queueMutex);
+    lowTasks.clear();
 }
 
 // Enqueue method
 template<class F, class... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args) 
     -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    std::function<void()> run;
+    auto res = package(run, std::forward<F>(f), std::forward<Args>(args)...);
+    push(std::move(run), false, UNTAGGED);
+    return res;
+}
+
+template<class F, class... Args>
+auto ThreadPool::enqueueLow(F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    return enqueueLowTagged(UNTAGGED, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class F, class... Args>
+auto ThreadPool::enqueueLowTagged(Tag tag, F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    std::function<void()> run;
+    auto res = package(run, std::forward<F>(f), std::forward<Args>(args)...);
+    push(std::move(run), true, tag);
+    return res;
+}
+
+inline bool ThreadPool::promote(Tag tag)
+{
+    if(tag == UNTAGGED)
+        return false;
+    {
+        ProfiledMutex::Lock lock(queueMutex);
+        auto it = std::find_if(lowTasks.begin(), lowTasks.end(),
+                               [tag](const LowTask& task) { return task.tag == tag; });
+        if(it == lowTasks.end())
+            return false;
+        tasks.push(std::move(it->run));
+        lowTasks.erase(it);
+    }
+    condition.notify_one();
+    return true;
+}
+
+template<class F, class... Args>
+auto ThreadPool::package(std::function<void()>& run, F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using return_type = typename std::result_of<F(Args...)>::type;
 
     auto task = std::make_shared< std::packaged_task<return_type()> >(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
+    run = [task](){ (*task)(); };
+    return task->get_future();
+}
 
-    std::future<return_type> res = task->get_future();
+inline void ThreadPool::push(std::function<void()> run, bool low, Tag tag)
+{
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
+        ProfiledMutex::Lock lock(queueMutex);
 
         // Don't allow enqueueing after stopping the pool
         if(stop.load())
             throw std::runtime_error("enqueue on stopped ThreadPool");
 
-        tasks.emplace([task](){ (*task)(); });
+        if(low)
+            lowTasks.push_back({ tag, std::move(run) });
+        else
+            tasks.push(std::move(run));
     }
     condition.notify_one();
-    return res;
 }
 
 #endif // THREADPOOL_H
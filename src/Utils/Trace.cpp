@@ -0,0 +1,214 @@
+// src/Utils/Trace.cpp
+#include "Trace.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace {
+
+namespace {
+
+// Spans kept per thread; older ones are overwritten
+constexpr size_t RING_SIZE = 16384;
+
+struct Event {
+    const char* name;
+    const char* category;
+    uint64_t startNs;
+    uint64_t endNs;
+    int32_t z, x, y;
+    int64_t value;
+};
+
+// Written only by its thread. head counts every span ever recorded, so a
+// reader can tell which slots may have been overwritten while it copied.
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{new Event[RING_SIZE]};
+    std::atomic<uint64_t> head{0};
+    uint32_t tid = 0;
+    std::string name; // Guarded by the registry mutex
+};
+
+// Buffers outlive their threads so spans of finished workers still dump
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid = 1;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry(); // Never destroyed; threads may outlive statics
+    return *instance;
+}
+
+std::atomic<uint64_t> startedAt{0};
+
+thread_local ThreadBuffer* localBuffer = nullptr;
+thread_local std::string localName;
+
+ThreadBuffer* threadBuffer() {
+    if (!localBuffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer->tid = reg.nextTid++;
+        buffer->name = localName.empty() ? "thread " + std::to_string(buffer->tid) : localName;
+        reg.buffers.push_back(buffer);
+        localBuffer = buffer.get();
+    }
+    return localBuffer;
+}
+
+void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void start() {
+    startedAt.store(nowNs(), std::memory_order_relaxed);
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+void setThreadName(const std::string& name) {
+    localName = name;
+    if (localBuffer) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        localBuffer->name = name;
+    }
+}
+
+void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs,
+            int z, int x, int y, int64_t value) {
+    if (!enabled()) {
+        return;
+    }
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[index % RING_SIZE] = { name, category, startNs, std::max(startNs, endNs), z, x, y, value };
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+bool writeJson(const std::string& path) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> names;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffers = reg.buffers;
+        for (const auto& buffer : buffers) {
+            names.push_back(buffer->name);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Utils::logError("Cannot write trace to " + path);
+        return false;
+    }
+
+    uint64_t base = startedAt.load(std::memory_order_relaxed);
+    size_t written = 0;
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CustomGIS\"}}";
+
+    std::vector<Event> copy(RING_SIZE);
+    char line[512];
+    for (size_t b = 0; b < buffers.size(); ++b) {
+        ThreadBuffer& buffer = *buffers[b];
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(buffer.tid) +
+               ",\"args\":{\"name\":\"";
+        appendEscaped(out, names[b]);
+        out += "\"}}";
+
+        // Copy without stopping the writer, then drop the slots it may have
+        // overwritten meanwhile
+        uint64_t head = buffer.head.load(std::memory_order_acquire);
+        uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+        for (uint64_t i = first; i < head; ++i) {
+            copy[i - first] = buffer.events[i % RING_SIZE];
+        }
+        // The writer may be filling slot headAfter, which holds span
+        // headAfter - RING_SIZE, so that one is dropped too
+        uint64_t headAfter = buffer.head.load(std::memory_order_acquire);
+        uint64_t valid = headAfter + 1 > RING_SIZE ? headAfter + 1 - RING_SIZE : 0;
+
+        for (uint64_t i = std::max(first, valid); i < head; ++i) {
+            const Event& ev = copy[i - first];
+            if (ev.startNs < base) {
+                continue;
+            }
+            int n = std::snprintf(line, sizeof(line),
+                                  ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                                  "\"ts\":%.3f,\"dur\":%.3f",
+                                  ev.name, ev.category, buffer.tid, (ev.startNs - base) / 1000.0,
+                                  (ev.endNs - ev.startNs) / 1000.0);
+            out.append(line, static_cast<size_t>(n));
+
+            if (ev.z >= 0 || ev.value >= 0) {
+                out += ",\"args\":{";
+                if (ev.z >= 0) {
+                    n = std::snprintf(line, sizeof(line), "\"tile\":\"%d/%d/%d\"", ev.z, ev.x, ev.y);
+                    out.append(line, static_cast<size_t>(n));
+                }
+                if (ev.value >= 0) {
+                    n = std::snprintf(line, sizeof(line), "%s\"value\":%lld", ev.z >= 0 ? "," : "",
+                                      static_cast<long long>(ev.value));
+                    out.append(line, static_cast<size_t>(n));
+                }
+                out += "}";
+            }
+            // Spans of the same tile are chained into one flow across threads
+            if (ev.z >= 0) {
+                uint64_t flow = (static_cast<uint64_t>(ev.z) << 48) ^ (static_cast<uint64_t>(ev.x) << 24) ^
+                                static_cast<uint64_t>(ev.y);
+                n = std::snprintf(line, sizeof(line), ",\"bind_id\":\"0x%llx\",\"flow_in\":true,\"flow_out\":true",
+                                  static_cast<unsigned long long>(flow));
+                out.append(line, static_cast<size_t>(n));
+            }
+            out += "}";
+            ++written;
+        }
+
+        if (out.size() > (1 << 20)) {
+            file << out;
+            out.clear();
+        }
+    }
+    out += "\n]}\n";
+    file << out;
+    file.close();
+    if (!file) {
+        Utils::logError("Cannot write trace to " + path);
+        return false;
+    }
+
+    Utils::logInfo("Wrote " + std::to_string(written) + " trace spans from " + std::to_string(buffers.size()) +
+                   " threads to " + path);
+    return true;
+}
+
+} // namespace Trace
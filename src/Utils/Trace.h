@@ -0,0 +1,70 @@
+// src/Utils/Trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Span tracing for the tile pipeline, written out in the Chrome trace event
+// format (chrome://tracing, ui.perfetto.dev).
+//
+// Every thread records finished spans into its own fixed-size ring buffer
+// without locking; writeJson() copies the buffers out at any time. Spans
+// carrying a tile are linked by flow arrows, so one tile can be followed
+// from the fetch queue through download, cache write, decode and upload.
+// While tracing is off a span costs one relaxed atomic load.
+namespace Trace {
+
+namespace detail {
+inline std::atomic<bool> enabled{false};
+}
+
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+// Steady clock in nanoseconds, the time base of every span
+uint64_t nowNs();
+
+// Starts recording; spans recorded before the last start() are not written
+void start();
+void stop();
+
+// Names the calling thread in the trace
+void setThreadName(const std::string& name);
+
+// Records a span [startNs, endNs) on the calling thread. name and category
+// must outlive the process (string literals). z < 0 means no tile; value,
+// when not negative, is written as an argument (a count, a status code).
+void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs,
+            int z = -1, int x = 0, int y = 0, int64_t value = -1);
+
+// Writes the spans recorded since start() as trace JSON; false on I/O error
+bool writeJson(const std::string& path);
+
+// Records the enclosing block as a span
+class Scope {
+public:
+    Scope(const char* name, const char* category, int z = -1, int x = 0, int y = 0)
+        : name(name), category(category), z(z), x(x), y(y), startNs(enabled() ? nowNs() : 0) {}
+    ~Scope() {
+        if (startNs != 0) {
+            record(name, category, startNs, nowNs(), z, x, y, value);
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void setValue(int64_t v) { value = v; }
+
+private:
+    const char* name;
+    const char* category;
+    int z, x, y;
+    int64_t value = -1;
+    uint64_t startNs;
+};
+
+} // namespace Trace
+
+#endif // TRACE_H
@@ -3,6 +3,7 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 
 enum LogLevel {
@@ -11,25 +12,31 @@ enum LogLevel {
     ERROR
 };
 
+namespace Log {
+void submit(LogLevel level, std::string_view text); // Log.h
+}
+
+// Lines are written asynchronously by Log; hot paths should use the
+// LOG_ macros from Log.h, which skip formatting when the level is off
 class Utils {
 public:
     static LogLevel currentLogLevel;
 
     static void logInfo(const std::string& message) {
         if(currentLogLevel <= INFO) {
-            std::cout << "INFO: " << message << std::endl;
+            Log::submit(INFO, message);
         }
     }
 
     static void logError(const std::string& message) {
         if(currentLogLevel <= ERROR) {
-            std::cerr << "ERROR: " << message << std::endl;
+            Log::submit(ERROR, message);
         }
     }
 
     static void logDebug(const std::string& message) {
         if(currentLogLevel <= DEBUG) {
-            std::cout << "DEBUG: " << message << std::endl;
+            Log::submit(DEBUG, message);
         }
     }
 };
@@ -8,13 +8,61 @@
 #include "UI/UIManager.h"
 #include "UI/Windows/Toolbar.h"
 #include "UI/Windows/LayerWindow.h"
+#include "UI/Windows/PerfHud.h"
 #include "Config/ConfigManager.h" // Make sure to include ConfigManager
 #include "UI/Windows//Settings/SettingsWindow.h"    // Include SettingsWindow if needed
 #include "nlohmann/json.hpp"      // Include JSON library
 #include <SDL2/SDL_ttf.h> // Include SDL_ttf
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include "Utils/Log.h"
+#include "Utils/Metrics.h"
 #include "Utils/Utils.h"
 
+// Usage: CustomGIS [--replay input.json [--headless] [--report report.json]]
+//
+// F10 records the input of a session to input-<time>.json; --replay plays
+// such a recording back and prints a JSON report of frame times, tile
+// traffic and the time to a fully loaded view. --headless replays without
+// a visible window, using the software renderer.
 int main(int argc, char* argv[]) {
+    std::string replayPath, reportPath;
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            reportPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else {
+            std::fprintf(stderr, "Usage: CustomGIS [--replay input.json [--headless] [--report report.json]]\n");
+            return 2;
+        }
+    }
+
+    InputTrace replayTrace;
+    if (!replayPath.empty()) {
+        std::string error;
+        if (!InputTrace::load(replayPath, replayTrace, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+    if (headless) {
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    }
+
+    AppConfig config = ConfigManager::loadConfig();
+    if (!config.logFile.empty()) {
+        Log::setFile(config.logFile, static_cast<uint64_t>(std::max(config.logFileMB, 1)) << 20,
+                     config.logFilesKept);
+    }
+
     // Initialize SDL and SDL_image
     if (!SDLUtils::initializeSDL()) {
         return 1;
@@ -65,11 +113,38 @@ int main(int argc, char* argv[]) {
     std::shared_ptr<Toolbar> toolbar = std::make_shared<Toolbar>(renderer, uiManager);
     uiManager.addComponent(toolbar);
 
-    // Run the main loop
-    runMainLoop(window, renderer, uiManager, *mapWindow);
+    // Performance overlay (F3), drawn over everything else
+    std::shared_ptr<PerfHud> perfHud = std::make_shared<PerfHud>(renderer);
+    uiManager.addComponent(perfHud);
+
+    // Metrics for fleet monitoring, e.g. via node_exporter's textfile collector
+    std::unique_ptr<Metrics::FileExporter> metricsExporter;
+    if (!config.metricsFile.empty()) {
+        metricsExporter = std::make_unique<Metrics::FileExporter>(
+            config.metricsFile, std::chrono::seconds(config.metricsIntervalSeconds));
+    }
+
+    // Run the main loop, or replay a recorded session
+    InputRecorder inputRecorder;
+    uiManager.setInputRecorder(&inputRecorder);
+    int status = 0;
+    if (replayPath.empty()) {
+        runMainLoop(window, renderer, uiManager, *mapWindow, *perfHud);
+    } else {
+        ReplayReport report;
+        runReplay(window, renderer, uiManager, *mapWindow, *perfHud, replayTrace, report);
+        std::string json = report.toJson();
+        std::fputs(json.c_str(), stdout);
+        if (!reportPath.empty() && !(std::ofstream(reportPath) << json)) {
+            Utils::logError("Cannot write replay report to " + reportPath);
+            status = 1;
+        }
+        status = report.aborted ? 1 : status;
+    }
+    metricsExporter.reset();
 
     // Cleanup and exit
     SDLUtils::cleanup(window, renderer);
     TTF_Quit(); // Quit SDL_ttf
-    return 0;
+    return status;
 }
@@ -0,0 +1,175 @@
+// tools/ExportTool.cpp
+//
+// Exports a map of a bounding box at a zoom level to a PNG or BigTIFF file,
+// e.g. 30000 x 30000 pixels for print, in bounded memory.
+//
+// Usage:
+//   CustomGIS-export --bbox minLon,minLat,maxLon,maxLat --zoom z -o out.png|out.tif
+//                    [--format png|tiff] [--threads N] [--fetch-threads N] [--strip rows]
+//                    [--timeout ms] [--source name | --url template] [--verbose]
+//                    [--trace trace.json]
+//
+// The format follows the file extension unless --format is given. Tiles
+// come from the disk cache where possible (seed the area with
+// CustomGIS-seed first for large exports). Ctrl-C stops the export and
+// removes the partial file. --trace writes the spans of every tile and
+// strip once the export ends.
+
+#include "../src/Rendering/MapExporter.h"
+#include "../src/Config/ConfigManager.h"
+#include "../src/Utils/Trace.h"
+#include "../src/Utils/Utils.h"
+#include "ToolSupport.h"
+#include <csignal>
+#include <cstdio>
+
+static std::atomic<bool> interrupted(false);
+
+static void onSignal(int) {
+    interrupted = true;
+}
+
+static void usage() {
+    std::fprintf(stderr,
+        "Usage: CustomGIS-export --bbox minLon,minLat,maxLon,maxLat --zoom z -o out.png|out.tif\n"
+        "                        [--format png|tiff] [--threads N] [--fetch-threads N] [--strip rows]\n"
+        "                        [--timeout ms] [--source name | --url template] [--verbose]\n"
+        "                        [--trace trace.json]\n");
+}
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static void printProgress(const ExportProgress& p) {
+    double percent = 100.0 * p.rowsDone / p.height;
+    double rate = p.elapsedSeconds > 0.0 ? p.rowsDone / p.elapsedSeconds : 0.0;
+    std::string eta = rate > 0.0 ? ToolSupport::formatDuration((p.height - p.rowsDone) / rate) : "--";
+    std::fprintf(stderr, "\r%dx%d  row %d/%d (%5.1f%%)  %.0f rows/s  fallback %d  missing %d  ETA %s   ",
+                 p.width, p.height, p.rowsDone, p.height, percent, rate, p.tilesFallback, p.tilesMissing,
+                 eta.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    ExportOptions options;
+    options.zoom = -1.0;
+    std::string output, format, sourceName, urlTemplate, tracePath;
+    bool haveBox = false;
+    size_t fetchThreads = 16;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--bbox") {
+                std::vector<double> box = ToolSupport::parseNumbers(value(), ',');
+                if (box.size() != 4) {
+                    throw std::runtime_error("--bbox needs minLon,minLat,maxLon,maxLat");
+                }
+                options.minLon = box[0];
+                options.minLat = box[1];
+                options.maxLon = box[2];
+                options.maxLat = box[3];
+                haveBox = true;
+            } else if (arg == "--zoom") {
+                options.zoom = std::stod(value());
+            } else if (arg == "-o" || arg == "--output") {
+                output = value();
+            } else if (arg == "--format") {
+                format = value();
+            } else if (arg == "--threads") {
+                options.threads = std::max(1, std::stoi(value()));
+            } else if (arg == "--fetch-threads") {
+                fetchThreads = std::max(1, std::stoi(value()));
+            } else if (arg == "--strip") {
+                options.stripHeight = std::max(1, std::stoi(value()));
+            } else if (arg == "--timeout") {
+                options.tileTimeoutMs = std::stoi(value());
+            } else if (arg == "--source") {
+                sourceName = value();
+            } else if (arg == "--url") {
+                urlTemplate = value();
+            } else if (arg == "--verbose") {
+                Utils::currentLogLevel = INFO;
+            } else if (arg == "--trace") {
+                tracePath = value();
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage();
+        return 2;
+    }
+    if (!haveBox || options.zoom < 0.0 || output.empty()) {
+        usage();
+        return 2;
+    }
+
+    if (format.empty()) {
+        format = endsWith(output, ".tif") || endsWith(output, ".tiff") ? "tiff" : "png";
+    }
+    if (format != "png" && format != "tiff") {
+        std::fprintf(stderr, "Unknown format %s (png or tiff)\n", format.c_str());
+        return 2;
+    }
+    options.format = format == "tiff" ? ExportFormat::BigTiff : ExportFormat::Png;
+
+    int width, height;
+    if (!MapExporter::imageSize(options, width, height)) {
+        std::fprintf(stderr, "Bounding box is empty or too large at zoom %.2f\n", options.zoom);
+        return 2;
+    }
+
+    AppConfig config = ConfigManager::loadConfig();
+    TileSource source;
+    std::string error;
+    if (!ToolSupport::selectTileSource(config, sourceName, urlTemplate, source, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    if (!tracePath.empty()) {
+        Trace::start();
+    }
+
+    bool ok;
+    ExportProgress last;
+    {
+        TileFetcher fetcher(fetchThreads, 4096 /* cacheSize */, source);
+        auto decodedTiles = std::make_shared<DecodedTileCache>(
+            static_cast<size_t>(std::max(config.decodedTileCacheMB, 1)) * 1024 * 1024);
+        StaticMapRenderer renderer(fetcher, decodedTiles);
+        MapExporter exporter(renderer);
+        ok = exporter.run(options, output, interrupted, [&](const ExportProgress& progress) {
+            last = progress;
+            printProgress(progress);
+        }, error);
+    }
+    std::fprintf(stderr, "\n");
+    if (!tracePath.empty()) {
+        Trace::writeJson(tracePath);
+    }
+
+    if (!ok) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return interrupted ? 130 : 1;
+    }
+    std::fprintf(stderr, "Wrote %s (%dx%d) in %s", output.c_str(), width, height,
+                 ToolSupport::formatDuration(last.elapsedSeconds).c_str());
+    if (last.tilesMissing > 0 || last.tilesFallback > 0) {
+        std::fprintf(stderr, "; %d tile draws blank and %d from lower zoom levels", last.tilesMissing,
+                     last.tilesFallback);
+    }
+    std::fprintf(stderr, "\n");
+    return 0;
+}
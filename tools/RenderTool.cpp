@@ -0,0 +1,239 @@
+// tools/RenderTool.cpp
+//
+// Renders static map images to PNG without a window, using the viewer's
+// tile layout, fetcher and caches.
+//
+// Usage:
+//   CustomGIS-render (--center lat,lon --zoom z | --bbox minLon,minLat,maxLon,maxLat)
+//                    [--size WxH] -o out.png
+//   CustomGIS-render --batch file [--jobs N]
+//   common options: [--threads N] [--timeout ms] [--source name | --url template] [--verbose]
+//                   [--trace trace.json]
+//
+// A batch file has one image per line, either
+//   out.png center lat,lon zoom WxH
+//   out.png bbox minLon,minLat,maxLon,maxLat WxH
+// Blank lines and lines starting with # are skipped. Batch images are
+// rendered --jobs at a time and share every cache. --trace writes the
+// spans of every tile (see Utils/Trace.h) once all images are done.
+
+#include "../src/Rendering/StaticMapRenderer.h"
+#include "../src/Encoding/PngWriter.h"
+#include "../src/Config/ConfigManager.h"
+#include "../src/Utils/Trace.h"
+#include "../src/Utils/Utils.h"
+#include "ToolSupport.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+struct RenderJob {
+    std::string output;
+    Viewport view;
+};
+
+static void usage() {
+    std::fprintf(stderr,
+        "Usage: CustomGIS-render (--center lat,lon --zoom z | --bbox minLon,minLat,maxLon,maxLat)\n"
+        "                        [--size WxH] -o out.png\n"
+        "       CustomGIS-render --batch file [--jobs N]\n"
+        "       common options: [--threads N] [--timeout ms] [--source name | --url template] [--verbose]\n"
+        "                       [--trace trace.json]\n");
+}
+
+static Viewport centerView(const std::string& center, double zoom, int width, int height) {
+    std::vector<double> latLon = ToolSupport::parseNumbers(center, ',');
+    if (latLon.size() != 2) {
+        throw std::runtime_error("Center must be lat,lon: " + center);
+    }
+    Viewport vp;
+    vp.centerLat = latLon[0];
+    vp.centerLon = latLon[1];
+    vp.zoom = std::clamp(zoom, double(Viewport::MIN_ZOOM), double(Viewport::MAX_OVERZOOM));
+    vp.windowWidth = width;
+    vp.windowHeight = height;
+    return vp;
+}
+
+static Viewport boundsView(const std::string& bbox, int width, int height) {
+    std::vector<double> box = ToolSupport::parseNumbers(bbox, ',');
+    if (box.size() != 4) {
+        throw std::runtime_error("Bounding box must be minLon,minLat,maxLon,maxLat: " + bbox);
+    }
+    return StaticMapRenderer::fitBounds(box[0], box[1], box[2], box[3], width, height);
+}
+
+static std::vector<RenderJob> readBatch(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<RenderJob> jobs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string output, kind;
+        if (!(fields >> output) || output[0] == '#') {
+            continue;
+        }
+        fields >> kind;
+        std::string where, zoom, size;
+        int width = 0, height = 0;
+        try {
+            if (kind == "center" && (fields >> where >> zoom >> size) && ToolSupport::parseSize(size, width, height)) {
+                jobs.push_back({ output, centerView(where, std::stod(zoom), width, height) });
+                continue;
+            }
+            if (kind == "bbox" && (fields >> where >> size) && ToolSupport::parseSize(size, width, height)) {
+                jobs.push_back({ output, boundsView(where, width, height) });
+                continue;
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+        throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected "
+                                 "'out.png center lat,lon zoom WxH' or 'out.png bbox minLon,minLat,maxLon,maxLat WxH'");
+    }
+    return jobs;
+}
+
+static bool writeFile(const std::string& path, const ByteBuffer& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<RenderJob> jobs;
+    std::string center, bbox, output, batch, sourceName, urlTemplate;
+    double zoom = -1.0;
+    int width = 512, height = 512;
+    size_t jobsAtOnce = std::max(1u, std::thread::hardware_concurrency());
+    size_t fetchThreads = 8;
+    int timeoutMs = 10000;
+    std::string tracePath;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--center") {
+                center = value();
+            } else if (arg == "--zoom") {
+                zoom = std::stod(value());
+            } else if (arg == "--bbox") {
+                bbox = value();
+            } else if (arg == "--size") {
+                if (!ToolSupport::parseSize(value(), width, height)) {
+                    throw std::runtime_error("--size needs WxH");
+                }
+            } else if (arg == "-o" || arg == "--output") {
+                output = value();
+            } else if (arg == "--batch") {
+                batch = value();
+            } else if (arg == "--jobs") {
+                jobsAtOnce = std::max(1, std::stoi(value()));
+            } else if (arg == "--threads") {
+                fetchThreads = std::max(1, std::stoi(value()));
+            } else if (arg == "--timeout") {
+                timeoutMs = std::stoi(value());
+            } else if (arg == "--source") {
+                sourceName = value();
+            } else if (arg == "--url") {
+                urlTemplate = value();
+            } else if (arg == "--verbose") {
+                Utils::currentLogLevel = INFO;
+            } else if (arg == "--trace") {
+                tracePath = value();
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+
+        if (!batch.empty()) {
+            jobs = readBatch(batch);
+        } else if (!output.empty() && !center.empty() && zoom >= 0.0) {
+            jobs.push_back({ output, centerView(center, zoom, width, height) });
+        } else if (!output.empty() && !bbox.empty()) {
+            jobs.push_back({ output, boundsView(bbox, width, height) });
+        } else {
+            usage();
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage();
+        return 2;
+    }
+
+    AppConfig config = ConfigManager::loadConfig();
+    TileSource source;
+    std::string error;
+    if (!ToolSupport::selectTileSource(config, sourceName, urlTemplate, source, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    TileFetcher fetcher(fetchThreads, 4096 /* cacheSize */, source);
+    auto decodedTiles = std::make_shared<DecodedTileCache>(
+        static_cast<size_t>(std::max(config.decodedTileCacheMB, 1)) * 1024 * 1024);
+    StaticMapRenderer renderer(fetcher, decodedTiles);
+
+    if (!tracePath.empty()) {
+        Trace::start();
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failedImages(0);
+    std::atomic<size_t> incompleteImages(0);
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](size_t index) {
+        Trace::setThreadName("render job " + std::to_string(index + 1));
+        StaticMapRenderer::Image image;
+        ByteBuffer png;
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const RenderJob& job = jobs[i];
+            StaticMapRenderer::Stats stats = renderer.render(job.view, image, timeoutMs);
+            if (!PngWriter::encode(image.pixels.data(), image.width, image.height, image.width, false, png) ||
+                !writeFile(job.output, png)) {
+                Utils::logError("Failed to write " + job.output);
+                failedImages++;
+                continue;
+            }
+            if (stats.missing > 0 || stats.fallbacks > 0) {
+                incompleteImages++;
+                Utils::logError(job.output + ": " + std::to_string(stats.missing) + " of " +
+                                std::to_string(stats.tiles) + " tiles missing, " +
+                                std::to_string(stats.fallbacks) + " drawn from lower zoom");
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < std::min(jobsAtOnce, jobs.size()); ++t) {
+        workers.emplace_back(worker, t);
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%zu images in %.2f s (%.1f images/s), %zu incomplete, %zu failed\n",
+                 jobs.size(), seconds, jobs.size() / seconds, incompleteImages.load(), failedImages.load());
+    if (!tracePath.empty()) {
+        Trace::writeJson(tracePath);
+    }
+    return failedImages > 0 ? 1 : 0;
+}
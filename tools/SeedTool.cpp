@@ -0,0 +1,204 @@
+// tools/SeedTool.cpp
+//
+// Fills the tile cache of a tile source (see TileSource::cacheDir, relative
+// to the working directory, as for the viewer) for an area and zoom range
+// so the map works offline.
+//
+// Usage:
+//   CustomGIS-seed (--bbox minLon,minLat,maxLon,maxLat | --polygon "lon,lat;lon,lat;..." |
+//                   --geojson file) --zoom min[-max]
+//                  [--threads N] [--rate tilesPerSecond] [--state file] [--fresh]
+//                  [--source name | --url template] [--verbose]
+//
+// Tiles come from the first configured tile source unless --source picks
+// another one by name or --url gives a template such as
+// http://127.0.0.1:8080/{z}/{x}/{y}.png (useful against a local stand-in).
+// Ctrl-C stops after the requests in flight; running the same command
+// again resumes from the checkpoint in --state (by default
+// seed-state.json in the source's cache directory).
+
+#include "../src/Seeding/TileSeeder.h"
+#include "../src/Config/ConfigManager.h"
+#include "../src/Utils/Utils.h"
+#include "ToolSupport.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
+static std::atomic<bool> interrupted(false);
+
+// Public OpenStreetMap servers forbid bulk downloads beyond a trickle
+static const double OSM_MAX_TILES_PER_SECOND = 1.0;
+
+static void onSignal(int) {
+    interrupted = true;
+}
+
+static void usage() {
+    std::fprintf(stderr,
+        "Usage: CustomGIS-seed (--bbox minLon,minLat,maxLon,maxLat | --polygon \"lon,lat;lon,lat;...\" |\n"
+        "                       --geojson file) --zoom min[-max]\n"
+        "                      [--threads N] [--rate tilesPerSecond] [--state file] [--fresh]\n"
+        "                      [--source name | --url template] [--verbose]\n");
+}
+
+static SeedArea::Ring parseRing(const std::string& text) {
+    SeedArea::Ring ring;
+    std::stringstream stream(text);
+    std::string point;
+    while (std::getline(stream, point, ';')) {
+        std::vector<double> lonLat = ToolSupport::parseNumbers(point, ',');
+        if (lonLat.size() != 2) {
+            throw std::runtime_error("Polygon points must be lon,lat: " + point);
+        }
+        ring.emplace_back(lonLat[0], lonLat[1]);
+    }
+    return ring;
+}
+
+static void printProgress(const SeedProgress& p) {
+    double rate = p.elapsedSeconds > 0.0 ? (p.downloaded + p.failed) / p.elapsedSeconds : 0.0;
+    double percent = p.total > 0 ? 100.0 * p.done / p.total : 100.0;
+    std::string eta = rate > 0.0 ? ToolSupport::formatDuration((p.total - p.done) / rate) : "--";
+    std::fprintf(stderr, "\rz%-2d %zu/%zu (%5.1f%%)  downloaded %zu  skipped %zu  failed %zu  %.1f tiles/s  ETA %s   ",
+                 p.zoom, p.done, p.total, percent, p.downloaded, p.skipped, p.failed, rate, eta.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    std::optional<SeedArea> area;
+    SeedOptions options;
+    options.minZoom = -1;
+    size_t threads = 4;
+    bool rateGiven = false;
+    bool fresh = false;
+    bool stateGiven = false;
+    std::string sourceName;
+    std::string urlTemplate;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--bbox") {
+                std::vector<double> box = ToolSupport::parseNumbers(value(), ',');
+                if (box.size() != 4) {
+                    throw std::runtime_error("--bbox needs minLon,minLat,maxLon,maxLat");
+                }
+                area = SeedArea::fromBoundingBox(box[0], box[1], box[2], box[3]);
+            } else if (arg == "--polygon") {
+                area = SeedArea::fromPolygon(parseRing(value()));
+            } else if (arg == "--geojson") {
+                std::string path = value();
+                std::ifstream file(path);
+                if (!file) {
+                    throw std::runtime_error("Cannot open " + path);
+                }
+                std::stringstream text;
+                text << file.rdbuf();
+                area = SeedArea::fromGeoJson(text.str());
+            } else if (arg == "--zoom") {
+                std::string range = value();
+                size_t dash = range.find('-');
+                options.minZoom = std::stoi(range.substr(0, dash));
+                options.maxZoom = dash == std::string::npos ? options.minZoom : std::stoi(range.substr(dash + 1));
+            } else if (arg == "--threads") {
+                threads = std::max(1, std::stoi(value()));
+            } else if (arg == "--rate") {
+                options.maxTilesPerSecond = std::stod(value());
+                rateGiven = true;
+            } else if (arg == "--state") {
+                options.statePath = value();
+                stateGiven = true;
+            } else if (arg == "--fresh") {
+                fresh = true;
+            } else if (arg == "--source") {
+                sourceName = value();
+            } else if (arg == "--url") {
+                urlTemplate = value();
+            } else if (arg == "--verbose") {
+                Utils::currentLogLevel = INFO;
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage();
+        return 2;
+    }
+
+    if (!area || options.minZoom < 0 || options.maxZoom < options.minZoom || options.maxZoom > 24) {
+        usage();
+        return 2;
+    }
+
+    // Pick the tile source
+    AppConfig config = ConfigManager::loadConfig();
+    TileSource source;
+    std::string error;
+    if (!ToolSupport::selectTileSource(config, sourceName, urlTemplate, source, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    bool publicOsm = std::any_of(source.mirrors.begin(), source.mirrors.end(), [](const std::string& url) {
+        return url.find("tile.openstreetmap.org") != std::string::npos;
+    });
+    if (publicOsm && (!rateGiven || options.maxTilesPerSecond <= 0.0 ||
+                      options.maxTilesPerSecond > OSM_MAX_TILES_PER_SECOND)) {
+        std::fprintf(stderr, "Source %s is the public OpenStreetMap server, whose usage policy forbids bulk "
+                     "downloads; limiting to %.0f tile/s. Seed large areas from your own tile server.\n",
+                     source.name.c_str(), OSM_MAX_TILES_PER_SECOND);
+        options.maxTilesPerSecond = OSM_MAX_TILES_PER_SECOND;
+    }
+
+    // Checkpoints are per source, like the tiles they describe
+    if (!stateGiven) {
+        options.statePath = source.cacheDir() / "seed-state.json";
+    }
+    if (fresh) {
+        std::error_code ec;
+        std::filesystem::remove(options.statePath, ec);
+    }
+    if (!options.statePath.parent_path().empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options.statePath.parent_path(), ec);
+    }
+    options.maxInFlight = threads * 2;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    bool complete;
+    SeedProgress last;
+    {
+        TileFetcher fetcher(threads, 1024 /* cacheSize */, source);
+        TileSeeder seeder(fetcher, *area, options);
+        complete = seeder.run(interrupted, [&](const SeedProgress& progress) {
+            last = progress;
+            printProgress(progress);
+        });
+    } // Fetcher shutdown flushes the cache writer
+    std::fprintf(stderr, "\n");
+
+    if (interrupted) {
+        std::fprintf(stderr, "Interrupted; run the same command again to resume (%s)\n",
+                     options.statePath.string().c_str());
+        return 130;
+    }
+    std::fprintf(stderr, "Done in %s: %zu downloaded, %zu already present, %zu failed\n",
+                 ToolSupport::formatDuration(last.elapsedSeconds).c_str(), last.downloaded, last.skipped, last.failed);
+    if (!complete) {
+        std::fprintf(stderr, "Run again to retry the failed tiles\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// tools/ServeTool.cpp
+//
+// Shares the tile cache of one tile source (see TileSource::cacheDir,
+// relative to the working directory) with other viewers over HTTP.
+//
+// Usage:
+//   CustomGIS-serve [--listen host:port] [--offline] [--waiters N] [--threads N]
+//                   [--source name | --url template] [--verbose] [--trace trace.json]
+//                   [--log file]
+//
+// Tiles are served as http://host:port/{z}/{x}/{y}.png (the extension is
+// ignored; the cached format is sent). Tiles missing from the cache are
+// fetched from the tile source once and then served to every client that
+// asked, unless --offline is given. Point other viewers at the server with
+// a tile source entry such as
+//   { "name": "Site cache", "urls": ["http://gis-cache:8080/{z}/{x}/{y}.png"] }
+// and run this tool with --listen 0.0.0.0:8080 to accept them. With
+// --trace, the spans of the tiles fetched upstream are written on exit.
+// --log also writes the log to a file, rotated every 10 MB (five kept).
+
+#include "../src/Networking/Tiles/TileServer.h"
+#include "../src/Config/ConfigManager.h"
+#include "../src/Utils/Log.h"
+#include "../src/Utils/Trace.h"
+#include "../src/Utils/Utils.h"
+#include "ToolSupport.h"
+#include <csignal>
+#include <cstdio>
+
+static TileServer* runningServer = nullptr;
+
+static void onSignal(int) {
+    if (runningServer) {
+        runningServer->stop();
+    }
+}
+
+static void usage() {
+    std::fprintf(stderr,
+        "Usage: CustomGIS-serve [--listen host:port] [--offline] [--waiters N] [--threads N]\n"
+        "                       [--source name | --url template] [--verbose] [--trace trace.json]\n"
+        "                       [--log file]\n");
+}
+
+int main(int argc, char* argv[]) {
+    TileServerOptions options;
+    std::string sourceName, urlTemplate;
+    size_t fetchThreads = 8;
+    std::string tracePath;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--listen") {
+                std::string listen = value();
+                size_t colon = listen.rfind(':');
+                if (colon == std::string::npos) {
+                    throw std::runtime_error("--listen needs host:port");
+                }
+                options.host = listen.substr(0, colon);
+                options.port = std::stoi(listen.substr(colon + 1));
+            } else if (arg == "--offline") {
+                options.upstream = false;
+            } else if (arg == "--waiters") {
+                options.upstreamWaiters = std::max(1, std::stoi(value()));
+            } else if (arg == "--threads") {
+                fetchThreads = std::max(1, std::stoi(value()));
+            } else if (arg == "--source") {
+                sourceName = value();
+            } else if (arg == "--url") {
+                urlTemplate = value();
+            } else if (arg == "--verbose") {
+                Utils::currentLogLevel = INFO;
+            } else if (arg == "--trace") {
+                tracePath = value();
+            } else if (arg == "--log") {
+                if (!Log::setFile(value())) {
+                    return 1;
+                }
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage();
+        return 2;
+    }
+
+    AppConfig config = ConfigManager::loadConfig();
+    TileSource source;
+    std::string error;
+    if (!ToolSupport::selectTileSource(config, sourceName, urlTemplate, source, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    TileFetcher fetcher(fetchThreads, 4096 /* cacheSize */, source);
+    TileServer server(fetcher, options);
+    if (!server.start(error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "Serving %s on http://%s:%d/{z}/{x}/{y}.png%s\n", fetcher.getCacheDir().c_str(),
+                 options.host.c_str(), options.port,
+                 options.upstream ? (", misses from " + source.name).c_str() : " (offline)");
+
+    if (!tracePath.empty()) {
+        Trace::start();
+    }
+    runningServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    server.run();
+    runningServer = nullptr;
+    Log::flush(); // Keep queued lines ahead of the summary
+
+    const TileServer::Stats& stats = server.stats();
+    std::fprintf(stderr, "\n%llu requests on %llu connections: %llu from cache, %llu not modified, "
+                 "%llu fetched upstream (%llu coalesced), %llu failed\n",
+                 (unsigned long long)stats.requests, (unsigned long long)stats.connections,
+                 (unsigned long long)stats.hits, (unsigned long long)stats.notModified,
+                 (unsigned long long)stats.upstreamFetches, (unsigned long long)stats.coalesced,
+                 (unsigned long long)stats.failures);
+    if (!tracePath.empty()) {
+        Trace::writeJson(tracePath);
+    }
+    return 0;
+}
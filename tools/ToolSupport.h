@@ -0,0 +1,77 @@
+// tools/ToolSupport.h
+//
+// Command line helpers shared by the headless tools.
+
+#ifndef TOOLSUPPORT_H
+#define TOOLSUPPORT_H
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/Config/ConfigManager.h"
+
+namespace ToolSupport {
+
+// Splits "a,b,c" into numbers; throws std::invalid_argument on bad input
+inline std::vector<double> parseNumbers(const std::string& text, char separator) {
+    std::vector<double> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, separator)) {
+        values.push_back(std::stod(item));
+    }
+    return values;
+}
+
+// Parses "WxH"; returns false if malformed
+inline bool parseSize(const std::string& text, int& width, int& height) {
+    size_t x = text.find('x');
+    if (x == std::string::npos) {
+        return false;
+    }
+    try {
+        width = std::stoi(text.substr(0, x));
+        height = std::stoi(text.substr(x + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return width > 0 && height > 0;
+}
+
+// Tile source for a tool run: a --url template, else the configured source
+// named by --source, else the first configured one. Returns false (with
+// error set) if the named source does not exist.
+inline bool selectTileSource(const AppConfig& config, const std::string& name, const std::string& urlTemplate,
+                             TileSource& source, std::string& error) {
+    source = config.tileSources.empty() ? TileSource::openStreetMap() : config.tileSources.front();
+    if (!urlTemplate.empty()) {
+        source = { "command line", { urlTemplate }, source.formats };
+    } else if (!name.empty()) {
+        auto it = std::find_if(config.tileSources.begin(), config.tileSources.end(),
+                               [&](const TileSource& s) { return s.name == name; });
+        if (it == config.tileSources.end()) {
+            error = "No tile source named " + name + " in config/settings.json";
+            return false;
+        }
+        source = *it;
+    }
+    return true;
+}
+
+// "1h05m" or "3m07s"
+inline std::string formatDuration(double seconds) {
+    long s = static_cast<long>(seconds);
+    char text[32];
+    if (s >= 3600) {
+        std::snprintf(text, sizeof(text), "%ldh%02ldm", s / 3600, (s / 60) % 60);
+    } else {
+        std::snprintf(text, sizeof(text), "%ldm%02lds", s / 60, s % 60);
+    }
+    return text;
+}
+
+} // namespace ToolSupport
+
+#endif // TOOLSUPPORT_H